@@ -0,0 +1,65 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of the FoldConstant pass on a model whose weights are constants.
+see README.md for the usage of this script.
+
+Every layer transposes its weight and computes a quantization scale from
+constants, which are folded. The layers have the same shapes, so the folded
+calls share their compiled kernels, or with --distinct-shapes they all have
+different shapes, so every folded call is compiled.
+"""
+import argparse
+import time
+
+import numpy as np
+
+import tvm
+from tvm import relay
+
+
+def model(num_layers, hidden, distinct_shapes):
+    """A chain of dense layers with constant weights."""
+    x = relay.var("x", shape=(1, hidden))
+    out = x
+    in_dim = hidden
+    for i in range(num_layers):
+        out_dim = hidden + i if distinct_shapes else hidden
+        weight = relay.const(np.random.uniform(size=(in_dim, out_dim)).astype("float32"))
+        scale = relay.const(np.random.uniform(size=(out_dim,)).astype("float32"))
+        scale = relay.cast(relay.round(scale * relay.const(127.0)), "int8")
+        out = relay.nn.dense(out, relay.transpose(weight))
+        out = out * relay.cast(scale, "float32")
+        in_dim = out_dim
+    return tvm.IRModule.from_expr(relay.Function([x], out))
+
+
+def main():
+    mod = relay.transform.InferType()(model(args.layers, args.hidden, args.distinct_shapes))
+    start = time.time()
+    relay.transform.FoldConstant()(mod)
+    print("FoldConstant on %d layers: %.2f s" % (args.layers, time.time() - start))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--layers", type=int, default=200)
+    parser.add_argument("--hidden", type=int, default=256)
+    parser.add_argument(
+        "--distinct-shapes", action="store_true", help="Give every layer different shapes."
+    )
+    args = parser.parse_args()
+    main()
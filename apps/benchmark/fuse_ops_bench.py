@@ -0,0 +1,123 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Memory traffic and run time of the operators fused by FuseOps, with and without its cost
+model. see README.md for the usage of this script.
+
+The traffic of a model is the bytes read and written by its fused functions, counting every
+argument and result once. It ignores the intermediate tensors kept inside a function and the
+operators recomputed there, so the script also compiles both versions and times them.
+"""
+import argparse
+
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.contrib import graph_executor
+from tvm.relay import testing
+
+
+def tensor_bytes(ty):
+    """Return the size of a tensor or tuple type in bytes."""
+    if isinstance(ty, relay.TupleType):
+        return sum(tensor_bytes(field) for field in ty.fields)
+    bits = tvm.runtime.DataType(ty.dtype).bits
+    return int(np.prod([int(dim) for dim in ty.shape])) * bits // 8
+
+
+def memory_traffic(mod):
+    """Return the number of fused functions of mod and the bytes they move."""
+    calls = []
+
+    def visit(expr):
+        if isinstance(expr, relay.Call) and isinstance(expr.op, relay.Function):
+            calls.append(expr)
+
+    relay.analysis.post_order_visit(mod["main"], visit)
+    moved = 0
+    for call in calls:
+        moved += sum(tensor_bytes(arg.checked_type) for arg in call.args)
+        moved += tensor_bytes(call.checked_type)
+    return len(calls), moved
+
+
+def fuse(mod, config):
+    """Simplify the batch norms of mod and fuse its operators for the CPU."""
+    seq = tvm.transform.Sequential(
+        [
+            relay.transform.InferType(),
+            relay.transform.SimplifyInference(),
+            relay.transform.FuseOps(fuse_opt_level=2),
+            relay.transform.InferType(),
+        ]
+    )
+    # The cost model only fuses two anchor operators for the CPU.
+    with tvm.target.Target("llvm"), tvm.transform.PassContext(opt_level=3, config=config):
+        return seq(mod)
+
+
+def run_time(mod, params, config):
+    """Compile mod for the CPU and return its mean run time in milliseconds."""
+    with tvm.transform.PassContext(opt_level=3, config=config):
+        lib = relay.build(mod, "llvm", params=params)
+    dev = tvm.cpu()
+    module = graph_executor.GraphModule(lib["default"](dev))
+    timer = module.module.time_evaluator("run", dev, number=args.number, repeat=args.repeat)
+    return timer().mean * 1e3
+
+
+def main():
+    models = {
+        "resnet-%d" % args.layers: testing.resnet.get_workload(
+            num_layers=args.layers, batch_size=args.batch
+        ),
+        "mobilenet": testing.mobilenet.get_workload(batch_size=args.batch),
+    }
+    cost_model = {
+        "relay.FuseOps.cost_model": True,
+        "relay.FuseOps.flops_per_byte": args.flops_per_byte,
+    }
+    print("%-12s %36s %36s %8s" % ("model", "greedy", "cost model", "saved"))
+    for name, (mod, params) in models.items():
+        greedy_funcs, greedy_bytes = memory_traffic(fuse(mod, {}))
+        cost_funcs, cost_bytes = memory_traffic(fuse(mod, cost_model))
+        greedy_ms = run_time(mod, params, {})
+        cost_ms = run_time(mod, params, cost_model)
+        print(
+            "%-12s %4d funcs %10.2f MB %8.2f ms %4d funcs %10.2f MB %8.2f ms %7.1f%%"
+            % (
+                name,
+                greedy_funcs,
+                greedy_bytes / 2 ** 20,
+                greedy_ms,
+                cost_funcs,
+                cost_bytes / 2 ** 20,
+                cost_ms,
+                100 * (greedy_bytes - cost_bytes) / greedy_bytes,
+            )
+        )
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--layers", type=int, default=50, help="The number of ResNet layers.")
+    parser.add_argument("--batch", type=int, default=1)
+    parser.add_argument("--flops-per-byte", type=int, default=4)
+    parser.add_argument("--number", type=int, default=10, help="The runs per measurement.")
+    parser.add_argument("--repeat", type=int, default=3, help="The number of measurements.")
+    args = parser.parse_args()
+    main()
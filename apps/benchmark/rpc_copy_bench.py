@@ -0,0 +1,67 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of array copies through an RPC server on the local host.
+see README.md for the usage of this script.
+"""
+import argparse
+
+import numpy as np
+
+import tvm
+from tvm import rpc
+
+from util import measure
+
+
+def main():
+    server = rpc.Server(host="127.0.0.1")
+    remote = rpc.connect("127.0.0.1", server.port)
+    dev = remote.cpu(0)
+    size = args.megabytes << 18
+    dense = np.random.uniform(size=size).astype("float32")
+    sparse = np.zeros(size, dtype="float32")
+    sparse[:: args.sparse_stride] = 1.0
+    remote_arr = tvm.nd.empty((size,), "float32", dev)
+
+    configs = [
+        ("single copy", 0, 1, False),
+        ("chunked", args.chunk_bytes, args.max_inflight, False),
+        ("chunked, compressed", args.chunk_bytes, args.max_inflight, True),
+    ]
+    for name, chunk_bytes, max_inflight, compress in configs:
+        remote.set_copy_options(chunk_bytes, max_inflight, compress)
+        for data_name, data in [("dense", dense), ("sparse", sparse)]:
+            upload = measure(lambda: remote_arr.copyfrom(data), args.repeat)
+            download = measure(remote_arr.numpy, args.repeat)
+            upload_rate = args.megabytes / upload * 1000
+            download_rate = args.megabytes / download * 1000
+            print(
+                "%-24s %-8s upload %8.2f MB/s  download %8.2f MB/s"
+                % (name, data_name, upload_rate, download_rate)
+            )
+    server.terminate()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--megabytes", type=int, default=256, help="The size of the array.")
+    parser.add_argument("--chunk-bytes", type=int, default=4 << 20)
+    parser.add_argument("--max-inflight", type=int, default=4)
+    parser.add_argument("--sparse-stride", type=int, default=64, help="Stride of the nonzeros.")
+    parser.add_argument("--repeat", type=int, default=5)
+    args = parser.parse_args()
+    main()
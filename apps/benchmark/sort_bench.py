@@ -0,0 +1,66 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of the CPU kernels of tvm.contrib.sort.
+see README.md for the usage of this script.
+
+Every kernel is run with one thread and with the whole thread pool, next to
+the stable sort of numpy.
+"""
+import argparse
+import multiprocessing
+
+import numpy as np
+
+import tvm
+
+from util import measure
+
+
+def main():
+    dev = tvm.cpu(0)
+    shape = (args.rows, args.size)
+    data_np = np.random.uniform(size=shape).astype(args.dtype)
+    data = tvm.nd.array(data_np, dev)
+    indices = tvm.nd.empty(shape, "int32", dev)
+    topk_values = tvm.nd.empty((args.rows, args.k), args.dtype, dev)
+    topk_indices = tvm.nd.empty((args.rows, args.k), "int32", dev)
+    argsort = tvm.get_global_func("tvm.contrib.sort.argsort")
+    topk = tvm.get_global_func("tvm.contrib.sort.topk")
+    config_threadpool = tvm.get_global_func("runtime.config_threadpool")
+
+    numpy_time = measure(lambda: np.argsort(data_np, axis=1, kind="stable"), args.repeat)
+    print("%-24s %.2f ms" % ("numpy argsort", numpy_time))
+    for nthreads in [1, args.threads]:
+        config_threadpool(1, nthreads)
+        sort_time = measure(lambda: argsort(data, indices, 1, False), args.repeat)
+        topk_time = measure(
+            lambda: topk(data, topk_values, topk_indices, args.k, 1, "both", False), args.repeat
+        )
+        print("%-24s %.2f ms" % ("argsort, %d threads" % nthreads, sort_time))
+        print("%-24s %.2f ms" % ("topk, %d threads" % nthreads, topk_time))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--rows", type=int, default=64)
+    parser.add_argument("--size", type=int, default=100000, help="The length of the rows.")
+    parser.add_argument("--k", type=int, default=100)
+    parser.add_argument("--dtype", default="float32")
+    parser.add_argument("--threads", type=int, default=multiprocessing.cpu_count())
+    parser.add_argument("--repeat", type=int, default=5)
+    args = parser.parse_args()
+    main()
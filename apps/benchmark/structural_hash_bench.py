@@ -0,0 +1,121 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of tvm.ir.structural_hash on a BERT-large Relay module.
+see README.md for the usage of this script.
+
+Every encoder layer is a global function of the module, called by main.
+"""
+import argparse
+import math
+
+import tvm
+from tvm import relay
+
+from util import measure
+
+
+def encoder_layer(seq_len, hidden, heads, ffn):
+    """An encoder layer of BERT, taking the weights as parameters."""
+    params = []
+    x = relay.var("x", shape=(seq_len, hidden))
+    params.append(x)
+
+    def dense(data, in_dim, out_dim, name):
+        weight = relay.var(name + "_weight", shape=(out_dim, in_dim))
+        bias = relay.var(name + "_bias", shape=(out_dim,))
+        params.extend([weight, bias])
+        return relay.nn.bias_add(relay.nn.dense(data, weight), bias)
+
+    def layer_norm(data, name):
+        gamma = relay.var(name + "_gamma", shape=(hidden,))
+        beta = relay.var(name + "_beta", shape=(hidden,))
+        params.extend([gamma, beta])
+        return relay.nn.layer_norm(data, gamma, beta)
+
+    head_dim = hidden // heads
+
+    def split_heads(data):
+        data = relay.reshape(data, (seq_len, heads, head_dim))
+        return relay.transpose(data, (1, 0, 2))
+
+    query = split_heads(dense(x, hidden, hidden, "query"))
+    key = split_heads(dense(x, hidden, hidden, "key"))
+    value = split_heads(dense(x, hidden, hidden, "value"))
+    scores = relay.nn.batch_matmul(query, key) * relay.const(1.0 / math.sqrt(head_dim))
+    probs = relay.nn.softmax(scores)
+    context = relay.nn.batch_matmul(probs, relay.transpose(value, (0, 2, 1)))
+    context = relay.reshape(relay.transpose(context, (1, 0, 2)), (seq_len, hidden))
+    attention = layer_norm(x + dense(context, hidden, hidden, "attention"), "attention_norm")
+
+    inter = dense(attention, hidden, ffn, "intermediate")
+    inter = inter * relay.const(0.5) * (relay.const(1.0) + relay.erf(inter / relay.const(2 ** 0.5)))
+    out = layer_norm(attention + dense(inter, ffn, hidden, "output"), "output_norm")
+    return relay.Function(params, out)
+
+
+def bert_module(num_layers, seq_len, hidden, heads, ffn):
+    """A module with BERT encoder layers, each of them a global function."""
+    mod = tvm.IRModule()
+    x = relay.var("x", shape=(seq_len, hidden))
+    main_params = [x]
+    out = x
+    for i in range(num_layers):
+        layer = encoder_layer(seq_len, hidden, heads, ffn)
+        gv = relay.GlobalVar("encoder_layer_%d" % i)
+        mod[gv] = layer
+        weights = [
+            relay.var("layer%d_%s" % (i, p.name_hint), p.type_annotation)
+            for p in layer.params[1:]
+        ]
+        main_params.extend(weights)
+        out = relay.Call(gv, [out] + weights)
+    mod["main"] = relay.Function(main_params, out)
+    return relay.transform.InferType()(mod)
+
+
+def main():
+    mod = bert_module(args.layers, args.seq_len, args.hidden, args.heads, args.ffn)
+    if args.fuse:
+        mod = relay.transform.FuseOps(fuse_opt_level=2)(mod)
+    funcs = [func for _, func in mod.functions.items()]
+
+    tvm.ir.set_structural_hash_cache(0)
+    per_func = measure(lambda: [tvm.ir.structural_hash(f) for f in funcs], args.repeat)
+    module = measure(lambda: tvm.ir.structural_hash(mod), args.repeat)
+    print("%-40s %.2f ms" % ("functions one by one, no cache", per_func))
+    print("%-40s %.2f ms" % ("module, no cache", module))
+
+    tvm.ir.set_structural_hash_cache(args.cache_capacity)
+    first = measure(lambda: tvm.ir.structural_hash(mod), 1)
+    cached = measure(lambda: tvm.ir.structural_hash(mod), args.repeat)
+    tvm.ir.set_structural_hash_cache(0)
+    print("%-40s %.2f ms" % ("module, cache filled", first))
+    print("%-40s %.2f ms" % ("module, cache hit", cached))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--layers", type=int, default=24)
+    parser.add_argument("--seq-len", type=int, default=128)
+    parser.add_argument("--hidden", type=int, default=1024)
+    parser.add_argument("--heads", type=int, default=16)
+    parser.add_argument("--ffn", type=int, default=4096)
+    parser.add_argument("--fuse", action="store_true", help="Fuse the operators first.")
+    parser.add_argument("--repeat", type=int, default=10)
+    parser.add_argument("--cache-capacity", type=int, default=1 << 16)
+    args = parser.parse_args()
+    main()
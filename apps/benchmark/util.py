@@ -17,6 +17,8 @@
 """Utility for benchmark"""
 
 import sys
+import timeit
+
 from tvm import relay
 from tvm.relay import testing
 
@@ -99,3 +101,21 @@ def print_progress(msg):
     """
     sys.stdout.write(msg + "\r")
     sys.stdout.flush()
+
+
+def measure(func, repeat):
+    """Measure the mean time of a function without arguments
+
+    Parameters
+    ----------
+    func: Callable
+        The function to run
+    repeat: int
+        The number of calls measured
+
+    Returns
+    -------
+    time: float
+        The mean time of a call in milliseconds
+    """
+    return timeit.timeit(func, number=repeat) * 1000 / repeat
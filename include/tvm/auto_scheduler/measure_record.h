@@ -28,8 +28,10 @@
 #include <tvm/auto_scheduler/measure.h>
 
 #include <fstream>
+#include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace tvm {
 namespace auto_scheduler {
@@ -96,6 +98,10 @@ class RecordReaderNode : public Object {
  private:
   /*! \brief A string storing the current line. */
   std::string cur_line_;
+  /*! \brief Whether the file is a binary record store. */
+  bool binary_{false};
+
+  friend class RecordReader;
 };
 
 /*!
@@ -113,6 +119,137 @@ class RecordReader : public ObjectRef {
   TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(RecordReader, ObjectRef, RecordReaderNode);
 };
 
+/*!
+ * \brief A binary file of measure records, indexed by workload key.
+ *
+ *  The file starts with a magic number and is only ever appended to. Every
+ *  record is framed by a small header holding its workload key, target, mean
+ *  cost and error number, followed by the json encoding of the record. Opening
+ *  a store reads the headers and skips the payloads, so a query only parses
+ *  the records it returns, and the best record of a workload is found through
+ *  the index without scanning the file.
+ *
+ *  RecordToFile, RecordReader and SaveRecords use this format for files that
+ *  start with the magic number, or new files whose name ends with ".bin".
+ */
+class RecordStoreNode : public Object {
+ public:
+  /*! \brief The name of the file. */
+  String filename;
+
+  void VisitAttrs(tvm::AttrVisitor* v) { v->Visit("filename", &filename); }
+
+  /*!
+   * \brief Append records to the file and the index.
+   * \param inputs The MeasureInputs to be written.
+   * \param results The MeasureResults to be written.
+   */
+  void Append(const Array<MeasureInput>& inputs, const Array<MeasureResult>& results);
+
+  /*!
+   * \brief Read the records of a workload, in the order they were written.
+   * \param workload_key The workload key.
+   * \param target The target string of the records, empty for every target.
+   * \return The MeasureInputs and MeasureResults found.
+   */
+  std::pair<Array<MeasureInput>, Array<MeasureResult>> Query(const std::string& workload_key,
+                                                             const std::string& target) const;
+
+  /*!
+   * \brief Read the valid record of a workload with the lowest mean cost.
+   * \param workload_key The workload key.
+   * \param target The target string of the record, empty for every target.
+   * \return The MeasureInput and MeasureResult in arrays, empty if there is no
+   *  valid record.
+   */
+  std::pair<Array<MeasureInput>, Array<MeasureResult>> QueryBest(const std::string& workload_key,
+                                                                 const std::string& target) const;
+
+  /*!
+   * \brief Read the best valid record of each workload key and target.
+   * \return The MeasureInputs and MeasureResults, ordered by workload key and target.
+   */
+  std::pair<Array<MeasureInput>, Array<MeasureResult>> ReadBest() const;
+
+  /*! \return The number of records in the file. */
+  size_t NumRecords() const { return entries_.size(); }
+
+  /*! \brief Read the index of the file, creating an empty store if it does not exist. */
+  void Open();
+
+  static constexpr const char* _type_key = "auto_scheduler.RecordStore";
+  TVM_DECLARE_FINAL_OBJECT_INFO(RecordStoreNode, Object);
+
+ private:
+  /*! \brief The index entry of a record. */
+  struct Entry {
+    /*! \brief The target string. */
+    std::string target;
+    /*! \brief The mean cost, infinite for failed measurements. */
+    double cost;
+    /*! \brief The offset of the json payload in the file. */
+    uint64_t offset;
+    /*! \brief The size of the json payload. */
+    uint32_t size;
+  };
+
+  /*! \brief Add a record to the index. */
+  void AddEntry(const std::string& workload_key, Entry entry);
+  /*! \brief Parse the records at the given entries. */
+  std::pair<Array<MeasureInput>, Array<MeasureResult>> Read(
+      const std::vector<size_t>& indices) const;
+
+  /*! \brief The entries of the records, in file order. */
+  std::vector<Entry> entries_;
+  /*! \brief The entries of each workload key. */
+  std::map<std::string, std::vector<size_t>> by_workload_;
+  /*! \brief The best valid entry of each workload key and target. */
+  std::map<std::pair<std::string, std::string>, size_t> best_;
+  /*! \brief The end of the last whole record indexed, appends check the file from there. */
+  uint64_t end_offset_{0};
+};
+
+/*!
+ * \brief Managed reference to RecordStoreNode.
+ * \sa RecordStoreNode
+ */
+class RecordStore : public ObjectRef {
+ public:
+  /*!
+   * \brief The constructor, reading the index of the file.
+   * \param filename The name of the file
+   */
+  explicit RecordStore(String filename);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(RecordStore, ObjectRef, RecordStoreNode);
+};
+
+/*!
+ * \brief Check whether a file is a binary record store, see RecordStoreNode.
+ * \param filename The name of the file.
+ * \return Whether the file starts with the magic number of a store, or does not
+ *  exist and has the ".bin" extension.
+ */
+bool IsRecordStore(const std::string& filename);
+
+/*!
+ * \brief Append measure records to a binary record store without reading its index.
+ * \param filename The name of the file, created if it does not exist.
+ * \param inputs The MeasureInputs to be written.
+ * \param results The MeasureResults to be written.
+ */
+void AppendRecordStore(const std::string& filename, const Array<MeasureInput>& inputs,
+                       const Array<MeasureResult>& results);
+
+/*!
+ * \brief Convert a record file between the json and the binary format. The
+ *  format of each file is told by IsRecordStore, and out_file is replaced
+ *  by the records of in_file.
+ * \param in_file The name of the input file.
+ * \param out_file The name of the output file.
+ */
+void ConvertRecordFile(const std::string& in_file, const std::string& out_file);
+
 /*!
  * \brief Append measure records to an output stream.
  * \param os A pointer to a output stream.
@@ -29,6 +29,10 @@
 
 #include <string>
 
+namespace dmlc {
+class Stream;
+}  // namespace dmlc
+
 namespace tvm {
 /*!
  * \brief save the node as well as all the node it depends on as json.
@@ -47,5 +51,25 @@ TVM_DLL std::string SaveJSON(const runtime::ObjectRef& node);
  */
 TVM_DLL runtime::ObjectRef LoadJSON(std::string json_str);
 
+/*!
+ * \brief Save the node as well as all the nodes it depends on in binary form.
+ *
+ *  The fields are written in the order of VisitAttrs without their names, and
+ *  the NDArrays as raw bytes, so the result is much smaller and faster to
+ *  load than json. It can only be loaded by the same version of TVM, json
+ *  should be used to keep objects across versions.
+ *
+ * \param strm The stream to write to.
+ * \param node The node to save.
+ */
+TVM_DLL void SaveBinary(dmlc::Stream* strm, const runtime::ObjectRef& node);
+
+/*!
+ * \brief Load a node saved by SaveBinary, reading the stream as it goes.
+ * \param strm The stream to read from.
+ * \return The loaded node.
+ */
+TVM_DLL runtime::ObjectRef LoadBinary(dmlc::Stream* strm);
+
 }  // namespace tvm
 #endif  // TVM_NODE_SERIALIZATION_H_
@@ -81,6 +81,29 @@ class StructuralHash : public BaseValueHash {
    * \return The hash value.
    */
   TVM_DLL size_t operator()(const ObjectRef& key) const;
+  /*!
+   * \brief Compute structural hashing value for an object.
+   * \param key The left operand.
+   * \param map_free_vars Whether to map free variables by their occurence number.
+   * \return The hash value.
+   */
+  TVM_DLL size_t operator()(const ObjectRef& key, bool map_free_vars) const;
+  /*!
+   * \brief Set the number of hash values kept by the process-wide hash cache.
+   *
+   *  The cache is off by default. When it is on, the hash of every large
+   *  enough object hashed from the root is kept, as is the hash of every large
+   *  enough subtree that does not depend on its context (it contains no
+   *  variables or graph nodes), and later hashes look them up instead of
+   *  walking the objects again. The cache holds a reference to the objects,
+   *  so CopyOnWrite copies them rather than mutating them in place. Objects
+   *  mutated without CopyOnWrite must not be hashed while the cache is on,
+   *  IRModules are never cached for this reason.
+   *
+   * \param capacity The number of hash values, the cache is cleared when it is
+   *  full. 0 disables and clears the cache.
+   */
+  TVM_DLL static void SetCacheCapacity(size_t capacity);
 };
 
 /*!
@@ -187,6 +210,8 @@ class SHashReducer {
 
   /*! \return Get the internal handler. */
   Handler* operator->() const { return handler_; }
+  /*! \return Whether free variables are mapped by their occurence number. */
+  bool map_free_vars() const { return map_free_vars_; }
 
  private:
   /*! \brief Internal class pointer. */
@@ -147,6 +147,11 @@ constexpr const char* kPartitionedFromPattern = "PartitionedFromPattern";
 
 /*! \brief Mark the function as only composed of reshape operations. */
 constexpr const char* kReshapeOnly = "relay.reshape_only";
+/*!
+ * \brief Mark the primitive function in which the cost model of FuseOps fused the producer
+ *  of the anchor op.
+ */
+constexpr const char* kFusedProducer = "relay.fused_producer";
 }  // namespace attr
 
 }  // namespace relay
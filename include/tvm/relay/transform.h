@@ -437,6 +437,18 @@ TVM_DLL Pass SimplifyExpr();
  */
 TVM_DLL Pass ManifestAlloc(Target target_host, Map<tvm::Integer, tvm::Target> targets);
 
+/*!
+ * \brief Reuse the storage allocated by ManifestAlloc across tensors whose
+ * lifetimes do not overlap.
+ *
+ * Symbolically sized storage is only planned when the pass config
+ * "relay.CoalesceStorage.dim_upper_bound" bounds every dynamic dimension, and
+ * is allocated on its own at runtime when it exceeds the bound.
+ *
+ * \return The pass.
+ */
+TVM_DLL Pass CoalesceStorage();
+
 }  // namespace transform
 
 /*!
@@ -64,26 +64,69 @@ class ThreadGroup {
   enum AffinityMode : int {
     kBig = 1,
     kLittle = -1,
+    /*! \brief The CPUs of a NUMA node, one per physical core first. */
+    kNumaNode = 2,
+    /*! \brief One CPU per physical core, skipping the SMT siblings. */
+    kPhysical = 3,
   };
 
   /*!
    * \brief configure the CPU id affinity
    *
-   * \param mode The preferred CPU type (1 = big, -1 = little).
-   * \param nthreads The number of threads to use (0 = use all).
+   * \param mode The preferred CPU type (1 = big, -1 = little, 2 = a NUMA
+   *        node, 3 = physical cores).
+   * \param nthreads The number of threads to use (0 = use all, which is one
+   *        per physical core for kNumaNode and kPhysical).
    * \param exclude_worker0 Whether to use the main thread as a worker.
    *        If  `true`, worker0 will not be launched in a new thread and
    *        `worker_callback` will only be called for values >= 1. This
    *        allows use of the main thread as a worker.
+   * \param numa_node The node used by kNumaNode.
    *
    * \return The number of workers to use.
    */
-  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0);
+  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0, int numa_node = 0);
+
+  /*!
+   * \brief Bind the threads to a range of the CPUs, in the order used by kBig.
+   *
+   * \param first The index of the first CPU of the range, wrapping around.
+   * \param nthreads The number of CPUs, and of threads to use.
+   * \param exclude_worker0 Whether to use the main thread as a worker, it is
+   *        then bound to the whole range.
+   *
+   * \return The number of workers to use.
+   */
+  int ConfigureCores(int first, int nthreads, bool exclude_worker0);
 
  private:
   Impl* impl_;
 };
 
+/*! \brief A logical CPU of the system. */
+struct CPUInfo {
+  /*! \brief The id of the CPU. */
+  unsigned int id;
+  /*! \brief The socket holding the CPU. */
+  int package;
+  /*! \brief The NUMA node of the CPU. */
+  int numa_node;
+  /*! \brief The id of the first CPU of the physical core, shared by the SMT siblings. */
+  unsigned int core;
+};
+
+/*!
+ * \brief Get the logical CPUs of the system, read from /sys on Linux. On
+ *  other systems all CPUs are distinct cores of node 0.
+ * \return The CPUs, sorted by id.
+ */
+const std::vector<CPUInfo>& CPUTopology();
+
+/*!
+ * \return The number of NUMA nodes of the system.
+ */
+int NumNumaNodes();
+
 /*!
  * \brief Platform-agnostic no-op.
  */
@@ -102,6 +145,52 @@ int MaxConcurrency();
  */
 void ResetThreadPool();
 
+/*!
+ * \brief Bind the thread pool of the calling thread, and the calling thread
+ *  itself, to the CPUs of a NUMA node.
+ *
+ *  Unless TVM_THREAD_POOL_SHARED is set, every thread launching parallel
+ *  jobs has its own pool. Threads bound to different nodes thus run their
+ *  parallel operators independently, for instance one model replica per
+ *  socket in one process.
+ *
+ * \param numa_node The node.
+ * \param nthreads The number of threads to use (0 = one per physical core of the node).
+ * \return The number of threads used.
+ */
+int BindThreadPoolToNumaNode(int numa_node, int nthreads = 0);
+
+/*!
+ * \brief Bound the number of threads used by the parallel launches of the
+ *  calling thread, including the calling thread itself.
+ *
+ *  This lets several threads run parallel operators side by side, each on
+ *  its own share of the cores.
+ *
+ * \param nthreads The maximum number of threads, or 0 to remove the bound.
+ */
+void SetLaunchConcurrency(int nthreads);
+
+/*!
+ * \return The bound set by SetLaunchConcurrency on the calling thread, 0 if unbounded.
+ */
+int GetLaunchConcurrency();
+
+/*!
+ * \brief Bind the thread pool of the calling thread, and the calling thread
+ *  itself, to nthreads CPUs starting at the first-th CPU used by default.
+ *
+ *  Threads bound to disjoint ranges run their parallel operators side by side
+ *  without competing for cores. A process-wide pool, when TVM_THREAD_POOL_SHARED
+ *  is set, already splits its workers between the launching threads, and is
+ *  left as is.
+ *
+ * \param first The index of the first CPU.
+ * \param nthreads The number of CPUs and of threads to use.
+ * \return The number of threads used, 0 when the pool is shared.
+ */
+int BindThreadPoolToCores(int first, int nthreads);
+
 }  // namespace threading
 }  // namespace runtime
 }  // namespace tvm
@@ -50,6 +50,7 @@ struct Buffer {
 enum AllocatorType {
   kNaive = 1,
   kPooled,
+  kBestFit,
 };
 
 class Allocator {
@@ -80,6 +81,16 @@ class Allocator {
    *  \return The amount of memory currently allocated.
    */
   virtual size_t UsedMemory() const = 0;
+  /*! \brief The amount of memory handed out to live buffers, which excludes the
+   *   memory cached for reuse. Defaults to UsedMemory for allocators not tracking it.
+   *  \return The amount of memory handed out.
+   */
+  virtual size_t AllocatedMemory() const { return UsedMemory(); }
+  /*! \brief The largest amount of memory handed out at once. Defaults to UsedMemory
+   *   for allocators not tracking it.
+   *  \return The peak amount of memory handed out.
+   */
+  virtual size_t PeakMemory() const { return UsedMemory(); }
 
  private:
   AllocatorType type_;
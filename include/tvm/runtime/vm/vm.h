@@ -176,6 +176,22 @@ class VirtualMachine : public runtime::ModuleNode {
    */
   virtual void LoadExecutable(const Executable* exec);
 
+  /*!
+   * \brief Create an execution context for concurrent requests.
+   *
+   *  The context shares the executable, the loaded kernels, the devices, the
+   *  allocators and the constants of this VM, and owns only its call frames,
+   *  registers and inputs. Contexts can run concurrently with each other and
+   *  with this VM, so many requests can be served from one loaded model
+   *  without duplicating its constants in device memory.
+   *
+   * \param sptr_to_self The pointer to this VM, kept alive by the context.
+   * \return The new execution context.
+   * \note The VM must be initialized, and must not be running while the
+   *  context is created.
+   */
+  ObjectPtr<VirtualMachine> CreateContext(const ObjectPtr<Object>& sptr_to_self);
+
  protected:
   /*! \brief Push a call frame on to the call stack. */
   void PushFrame(Index arg_count, Index ret_pc, const VMFunction& vm_func);
@@ -196,9 +212,9 @@ class VirtualMachine : public runtime::ModuleNode {
   /*!
    * \brief Read a VM register.
    * \param reg The register to read from.
-   * \return The read object.
+   * \return The read object, valid until the frame stack is modified.
    */
-  inline ObjectRef ReadRegister(RegName reg) const;
+  inline const ObjectRef& ReadRegister(RegName reg) const;
 
   /*!
    * \brief Read a VM register and cast it to int32_t
@@ -284,6 +300,8 @@ class VirtualMachine : public runtime::ModuleNode {
    * object to avoid rellocation of constants during inference.
    */
   std::vector<ObjectRef> const_pool_;
+  /*! \brief The VM whose loaded state this execution context shares, if any. */
+  ObjectPtr<Object> parent_;
 };
 
 }  // namespace vm
@@ -59,13 +59,34 @@ TVM_DLL std::vector<std::vector<int>> rr_partitioner(int begin, int end, int ste
  * \param end The end index of this parallel loop(exclusive).
  * \param f The task function to be excuted. Assert to take an int index as input with no output.
  * \param step The traversal step to the index.
- * \param partitioner A partition function to split tasks to different threads. Use Round-robin
- * partitioner by default.
- * \note 1. Currently do not support nested parallel_for; 2. The order of execution in each thread
- * is not guaranteed, the for loop task should be thread independent and thread safe.
+ * \param partitioner A partition function to split tasks to different threads. By default the
+ * loop is split dynamically into chunks that idle threads pick up.
+ * \note 1. The loop runs on a persistent pool of compiler threads shared by all callers, nested
+ * parallel_for is supported; 2. The order of execution in each thread is not guaranteed, the for
+ * loop task should be thread independent and thread safe.
  */
 TVM_DLL void parallel_for(int begin, int end, const std::function<void(int)>& f, int step = 1,
-                          const PartitionerFuncType partitioner = rr_partitioner);
+                          const PartitionerFuncType partitioner = nullptr);
+
+/*!
+ * \brief An API to launch fix amount of threads to run the specific functor in parallel.
+ * Different from `parallel_for`, the partition is determined dynamically on the fly,
+ * i.e. any time when a thread is idle, it fetches the next task to run.
+ * The behavior is similar to dynamic scheduling in OpenMP:
+ *
+ *   \#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+ *   for (int i = 0; i < 10; i++) {
+ *     a[i] = i;
+ *   }
+ *
+ * \param begin The start index of this parallel loop (inclusive).
+ * \param end The end index of this parallel loop (exclusive).
+ * \param num_threads The maximum number of threads taking part in the loop.
+ * \param f The task function to be executed. Takes the id of the thread running the task, which
+ * is in [0, num_threads), and the index of the task.
+ */
+TVM_DLL void parallel_for_dynamic(int begin, int end, int num_threads,
+                                  const std::function<void(int thread_id, int task_id)>& f);
 
 }  // namespace support
 }  // namespace tvm
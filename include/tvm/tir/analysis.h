@@ -187,6 +187,19 @@ TVM_DLL size_t CalculateExprComplexity(const PrimExpr& expr);
 TVM_DLL size_t CalculateWorkspaceBytes(const PrimFunc& func,
                                        const Integer& workspace_byte_alignment);
 
+/*!
+ * \brief Calculate the sizes of the global allocations inside the TIR PrimFunc, which its kernel
+ *  requests from the workspace pool at run time. Allocations with a dynamic size are skipped.
+ * \param func The TIR PrimFunc.
+ * \param workspace_byte_alignment The byte alignment required for each allocated tensor.
+ * \param in_parallel_loop Whether to collect the allocations inside parallel loops, which the
+ *  threads running the loop request, instead of the other ones.
+ * \return The byte aligned sizes, in the order of the allocations.
+ */
+TVM_DLL Array<Integer> CalculateWorkspaceAllocations(const PrimFunc& func,
+                                                     const Integer& workspace_byte_alignment,
+                                                     bool in_parallel_loop);
+
 /*!
  * \brief Detect the lowest common ancestor(LCA) of buffer access, including both high-level
  *        access(BufferLoad, BufferStore) and low-level access(Load, Store and opaque access).
@@ -37,6 +37,8 @@ logger = logging.getLogger("auto_scheduler")
 class RecordToFile(MeasureCallback):
     """
     A measurement callback that writes measurement records into a file.
+    The records are appended to a binary :code:`RecordStore` if the file is one,
+    or does not exist yet and has the ".bin" extension.
 
     Parameters
     ----------
@@ -54,7 +56,7 @@ class RecordToFile(MeasureCallback):
 @tvm._ffi.register_object("auto_scheduler.RecordReader")
 class RecordReader(Object):
     """
-    Reader of the json log file.
+    Reader of the json log file, or of a binary :code:`RecordStore`.
 
     Parameters
     ----------
@@ -134,6 +136,138 @@ class RecordReader(Object):
             yield ret[0], ret[1]  # (input, result)
 
 
+@tvm._ffi.register_object("auto_scheduler.RecordStore")
+class RecordStore(Object):
+    """
+    An append-only binary file of measurement records, indexed by workload key.
+
+    Opening a store only reads the small header in front of each record, so a
+    query parses the records it returns and nothing else, and the best record
+    of a workload is looked up in the index. Files in this format are also read
+    by :code:`RecordReader` and :code:`load_records`, and written by
+    :code:`RecordToFile` and :code:`save_records`.
+
+    Parameters
+    ----------
+    filename : str
+        File name of the store, created if it does not exist.
+    """
+
+    def __init__(self, filename):
+        dirname = os.path.dirname(os.path.abspath(filename))
+        if not os.path.exists(dirname):
+            os.makedirs(dirname)
+        self.__init_handle_by_constructor__(_ffi_api.RecordStore, filename)
+
+    def __len__(self):
+        return _ffi_api.RecordStoreNumRecords(self)
+
+    def append(self, inputs, results):
+        """Append records to the store.
+
+        Parameters
+        ----------
+        inputs: List[MeasureInput]
+            The MeasureInputs to be written.
+        results: List[MeasureResult]
+            The MeasureResults to be written.
+        """
+        _ffi_api.RecordStoreAppend(self, inputs, results)
+
+    def query(self, workload_key, target=None):
+        """Read the records of a workload, in the order they were written.
+
+        Parameters
+        ----------
+        workload_key : str
+            The workload key of the compute declaration.
+        target : Optional[Union[str, tvm.target.Target]]
+            The target the records were measured on, compared in its canonical
+            form. With `None`, this returns the records of all targets.
+
+        Returns
+        -------
+        logs : List[Tuple[MeasureInput, MeasureResult]]
+        """
+        inputs, results = _ffi_api.RecordStoreQuery(
+            self, workload_key, str(target) if target else ""
+        )
+        return list(zip(inputs, results))
+
+    def query_best(self, workload_key, target=None):
+        """Read the valid record of a workload with the lowest mean cost.
+
+        Parameters
+        ----------
+        workload_key : str
+            The workload key of the compute declaration.
+        target : Optional[Union[str, tvm.target.Target]]
+            The target the record was measured on, compared in its canonical
+            form. With `None`, this returns the best record of all targets.
+
+        Returns
+        -------
+        input : Optional[MeasureInput]
+            The best MeasureInput, None if there is no valid record.
+        result : Optional[MeasureResult]
+            The best MeasureResult, None if there is no valid record.
+        """
+        inputs, results = _ffi_api.RecordStoreQueryBest(
+            self, workload_key, str(target) if target else ""
+        )
+        if not inputs:
+            return None, None
+        return inputs[0], results[0]
+
+    def best_records(self):
+        """Read the best valid record of each workload and target.
+
+        Returns
+        -------
+        logs : List[Tuple[MeasureInput, MeasureResult]]
+        """
+        inputs, results = _ffi_api.RecordStoreReadBest(self)
+        return list(zip(inputs, results))
+
+
+def is_record_store(filename):
+    """
+    Check whether a file is a binary :code:`RecordStore`.
+
+    Parameters
+    ----------
+    filename : str
+        The file name.
+
+    Returns
+    -------
+    ret : bool
+        Whether the file starts with the magic number of a store, or does not
+        exist yet and has the ".bin" extension.
+    """
+    return bool(_ffi_api.IsRecordStore(filename))
+
+
+def convert_record_file(in_file, out_file):
+    """
+    Convert a record file between the json format and the binary format of
+    :code:`RecordStore`. The format of each file is told by :code:`is_record_store`,
+    so a json log is converted to a store by writing it to a ".bin" file, and back.
+    An existing out_file is overwritten.
+
+    Parameters
+    ----------
+    in_file : str
+        The filename of input.
+    out_file : str
+        The filename of output.
+    """
+    dirname = os.path.dirname(os.path.abspath(out_file))
+    if not os.path.exists(dirname):
+        os.makedirs(dirname)
+    _ffi_api.ConvertRecordFile(in_file, out_file)
+
+
 def load_record_from_string(record):
     """
     Load the measure record from string.
@@ -237,7 +371,11 @@ def load_best_record(filename, workload_key=None, target=None, include_compatibl
     result : auto_scheduler.measure.MeasureResult
         The best State's MeasureResult from this log fine.
     """
-    log_reader = RecordReader(filename)
+    if workload_key is not None and not include_compatible and is_record_store(filename):
+        # Only the records of this workload need to be read.
+        log_reader = RecordStore(filename).query(workload_key)
+    else:
+        log_reader = RecordReader(filename)
     best_cost = 1e30
     best_inp = None
     best_res = None
@@ -344,7 +482,7 @@ def distill_record_file(in_file, out_file):
 def main():
     """The main function for CLI."""
     parser = argparse.ArgumentParser()
-    parser.add_argument("--mode", choices=["distill"], default="distill")
+    parser.add_argument("--mode", choices=["distill", "convert"], default="distill")
     parser.add_argument("-i", "--input", type=str, help="input file")
     parser.add_argument("-o", "--output", type=str, default=None, help="output file")
 
@@ -355,12 +493,18 @@ def main():
     if args.mode == "distill":
         args.output = args.output or args.input + ".best.json"
         distill_record_file(args.input, args.output)
+    elif args.mode == "convert":
+        if args.output is None:
+            args.output = args.input + (".json" if is_record_store(args.input) else ".bin")
+        convert_record_file(args.input, args.output)
 
 
 """
 Usage:
 * Distill the best entries from a large log file
 e.g. python -m tvm.auto_scheduler.measure_record --mode distill -i input.json
+* Convert a log file to a binary record store or back
+e.g. python -m tvm.auto_scheduler.measure_record --mode convert -i input.json -o input.bin
 """
 if __name__ == "__main__":
     main()
@@ -30,10 +30,12 @@ of the DispatchContext base class.
 
 from __future__ import absolute_import as _abs
 
+import hashlib
 import logging
 
 import numpy as np
 
+import tvm._ffi
 from .space import FallbackConfigEntity
 from .. import env as _env
 
@@ -144,6 +146,18 @@ class DispatchContext(object):
         """
         raise NotImplementedError()
 
+    def fingerprint(self):
+        """
+        Describe the configs this context selects, for the caches of compiled functions.
+
+        Returns
+        -------
+        fingerprint : str or None
+            A string that changes whenever the selected configs may change, None when
+            the selection cannot be described.
+        """
+        return None
+
     def __enter__(self):
         self._old_ctx = DispatchContext.current
         DispatchContext.current = self
@@ -196,6 +210,7 @@ class ApplyHistoryBest(DispatchContext):
         self.best_by_targetkey = {}
         self.best_by_model = {}
         self._best_user_defined = {}
+        self._fingerprint = None
 
         if records:
             self.load(records)
@@ -251,6 +266,7 @@ class ApplyHistoryBest(DispatchContext):
                 if np.mean(other_res.costs) > np.mean(res.costs):
                     best_by_model[key] = (inp, res)
 
+        self._fingerprint = None
         logger.debug("Finish loading %d records", counter)
 
     def _query_inside(self, target, workload):
@@ -290,6 +306,17 @@ class ApplyHistoryBest(DispatchContext):
         for k in target.keys:
             key = (k, workload)
             self._best_user_defined[key] = cfg
+        self._fingerprint = None
+
+    def fingerprint(self):
+        if self._fingerprint is None:
+            entries = ["%s %s" % (key, inp.config) for key, (inp, _) in self.best_by_model.items()]
+            entries += [
+                "%s %s" % (key, inp.config) for key, (inp, _) in self.best_by_targetkey.items()
+            ]
+            entries += ["user %s %s" % (key, cfg) for key, cfg in self._best_user_defined.items()]
+            self._fingerprint = _hash_entries(entries)
+        return self._fingerprint
 
 
 class FallbackContext(DispatchContext):
@@ -303,6 +330,8 @@ class FallbackContext(DispatchContext):
     def __init__(self):
         super(FallbackContext, self).__init__()
         self.memory = {}
+        # the keys set by update, the other configs only depend on their workload
+        self._updated = set()
 
     def _query_inside(self, target, workload):
         key = (str(target), workload)
@@ -337,15 +366,48 @@ class FallbackContext(DispatchContext):
         key = (str(target), workload)
         if key in self.memory:
             del self.memory[key]
+        self._updated.discard(key)
 
     def update(self, target, workload, cfg):
         key = (str(target), workload)
         self.memory[key] = cfg
+        self._updated.add(key)
+
+    def fingerprint(self):
+        return _hash_entries(["%s %s" % (key, self.memory[key]) for key in self._updated])
 
 
 DispatchContext.current = FallbackContext()
 
 
+def _hash_entries(entries):
+    """Hash a collection of strings regardless of their order."""
+    return hashlib.sha256("\n".join(sorted(entries)).encode("utf-8")).hexdigest()
+
+
+@tvm._ffi.register_func("autotvm.dispatch_context_fingerprint")
+def dispatch_context_fingerprint():
+    """Describe the configs selected by the current dispatch contexts.
+
+    The compile cache of the Relay backend keys its entries with it.
+
+    Returns
+    -------
+    fingerprint : str
+        The fingerprints of the chain of contexts, empty when one of them cannot be
+        described.
+    """
+    parts = []
+    context = DispatchContext.current
+    while context is not None:
+        part = context.fingerprint()
+        if part is None:
+            return ""
+        parts.append("%s %s" % (type(context).__name__, part))
+        context = context._old_ctx
+    return ";".join(parts)
+
+
 def clear_fallback_cache(target, workload):
     """Clear fallback cache. Pass the same argument as _query_inside to this function
     to clean the cache.
@@ -205,6 +205,18 @@ class GraphModule(object):
             self.set_input(**input_dict)
         self._run()
 
+    def set_num_streams(self, num_streams):
+        """Run independent operators of the graph concurrently
+
+        Parameters
+        ----------
+        num_streams : int
+            The number of threads running operators, including the caller of
+            run. 1 runs the operators in order. Only graphs running entirely
+            on CPU use more than one stream.
+        """
+        self.module["set_num_streams"](num_streams)
+
     def get_num_outputs(self):
         """Get the number of outputs from the graph
 
@@ -282,6 +294,20 @@ class GraphModule(object):
         """
         self._load_params(bytearray(params_bytes))
 
+    def load_params_from_file(self, path):
+        """Load parameters from a file holding a serialized parameter dict.
+
+        The parameters of a file saved with ``save_param_dict(params, aligned=True)``
+        refer to a memory mapping of the file when they live on CPU, so that
+        modules loading the same file, in any process, share their memory.
+
+        Parameters
+        ----------
+        path : str
+            The path of the parameters file.
+        """
+        self.module["load_params_from_file"](path)
+
     def share_params(self, other, params_bytes):
         """Share parameters from pre-existing GraphExecutor instance.
 
@@ -0,0 +1,144 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Pipeline executor running several graph executors as the stages of a pipeline."""
+import tvm._ffi
+from tvm._ffi.base import string_types
+from tvm.runtime.container import ShapeTuple
+
+from . import graph_executor
+
+
+def create(libs, devices, connections, queue_size=2):
+    """Create a pipeline executor from the compiled stages and their wiring.
+
+    Parameters
+    ----------
+    libs : list of GraphExecutorFactoryModule or tvm.runtime.Module
+        The compiled stages, as returned by relay.build, in pipeline order.
+
+    devices : Device or list of Device
+        The device of each stage, or one device for every stage.
+
+    connections : list of tuple
+        The wiring of the pipeline, as ``((src_stage, src_index), (dst_stage, dst_index))``.
+        The source is an output of a stage, or with stage -1, an input of the
+        pipeline. The destination is an input of a stage, given by index or name,
+        or with stage -1, an output of the pipeline. Connections between stages
+        go from an earlier to a later stage.
+
+    queue_size : int
+        The number of inputs waiting in front of each stage.
+
+    Returns
+    -------
+    pipeline_module : PipelineModule
+        Runtime pipeline module.
+    """
+    if not isinstance(devices, (list, tuple)):
+        devices = [devices] * len(libs)
+    assert len(devices) == len(libs), "Expected a device for each stage"
+    stages = [lib["default"](dev) for lib, dev in zip(libs, devices)]
+
+    wiring = []
+    for (src_stage, src_index), (dst_stage, dst_index) in connections:
+        if isinstance(dst_index, string_types):
+            name = dst_index
+            dst_index = stages[dst_stage]["get_input_index"](name)
+            if dst_index < 0:
+                raise RuntimeError(
+                    "Could not find '%s' in the inputs of stage %d" % (name, dst_stage)
+                )
+        wiring += [src_stage, src_index, dst_stage, dst_index]
+
+    fcreate = tvm._ffi.get_global_func("tvm.pipeline_executor.create")
+    return PipelineModule(fcreate(ShapeTuple(wiring), queue_size, *stages), stages)
+
+
+class PipelineModule(object):
+    """Wrapper runtime module of the pipeline executor.
+
+    The stages run on their own threads. Inputs given to :py:meth:`submit` flow
+    through the stages while the next inputs are submitted, and the outputs are
+    collected in submission order with :py:meth:`get_output`.
+
+    Parameters
+    ----------
+    module : tvm.runtime.Module
+        The internal tvm module that holds the actual pipeline functions.
+
+    stages : list of tvm.runtime.Module
+        The graph executor modules of the stages.
+
+    Examples
+    --------
+
+    .. code-block:: python
+
+        # the output of the first stage feeds the input "x" of the second one
+        pipe = pipeline_executor.create(
+            [lib0, lib1],
+            tvm.cpu(0),
+            [((-1, 0), (0, "x")), ((0, 0), (1, "x")), ((1, 0), (-1, 0))],
+        )
+        for data in batches:
+            pipe.submit(data)
+        outputs = [pipe.get_output() for _ in batches]
+    """
+
+    def __init__(self, module, stages):
+        self.module = module
+        self.stages = [graph_executor.GraphModule(stage) for stage in stages]
+        self._submit = module["submit"]
+        self._get_output = module["get_output"]
+        self._num_pending = module["num_pending"]
+        self._get_num_inputs = module["get_num_inputs"]
+        self._get_num_outputs = module["get_num_outputs"]
+
+    def submit(self, *inputs):
+        """Submit the inputs of the pipeline, waiting while the first stage is busy.
+
+        The arrays are read in place and must not change until the outputs are collected.
+
+        Parameters
+        ----------
+        inputs : list of NDArray
+            The inputs of the pipeline.
+        """
+        self._submit(*inputs)
+
+    def get_output(self):
+        """Get the outputs of the oldest submitted inputs, waiting for them.
+
+        Returns
+        -------
+        outputs : list of NDArray
+            The outputs of the pipeline.
+        """
+        return list(self._get_output())
+
+    @property
+    def num_pending(self):
+        """The number of submitted inputs whose outputs were not collected."""
+        return self._num_pending()
+
+    def get_num_inputs(self):
+        """Get the number of inputs of the pipeline"""
+        return self._get_num_inputs()
+
+    def get_num_outputs(self):
+        """Get the number of outputs of the pipeline"""
+        return self._get_num_outputs()
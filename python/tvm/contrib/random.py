@@ -112,4 +112,19 @@ def normal(loc, scale, size):
     )
 
 
+def seed(seed):
+    """Seed the random number generator of the calling thread.
+
+    The following draws of randint, uniform, normal and random_fill on
+    this thread use the sequence of this seed, whatever the number of
+    threads filling the tensors.
+
+    Parameters
+    ----------
+    seed : int
+        The seed of the random number generator.
+    """
+    tvm.get_global_func("tvm.contrib.random.seed")(int(seed))
+
+
 tvm._ffi._init_api("tvm.contrib.random")
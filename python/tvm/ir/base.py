@@ -157,6 +157,50 @@ def save_json(node):
     return tvm.runtime._ffi_node_api.SaveJSON(node)
 
 
+def save_binary(node, path=None):
+    """Save tvm object in binary form.
+
+    The binary form is smaller and faster to load than json, with the NDArrays
+    stored as raw bytes, but it can only be loaded by the same version of TVM.
+
+    Parameters
+    ----------
+    node : Object
+        A TVM object to be saved.
+
+    path : Optional[str]
+        The file to write to. The object is returned as bytes when it is None.
+
+    Returns
+    -------
+    data : Optional[bytearray]
+        The saved bytes if path is None.
+    """
+    if path is not None:
+        tvm.runtime._ffi_node_api.SaveBinaryToFile(node, path)
+        return None
+    return tvm.runtime._ffi_node_api.SaveBinary(node)
+
+
+def load_binary(data):
+    """Load tvm object saved by save_binary.
+
+    Parameters
+    ----------
+    data : Union[bytes, bytearray, str]
+        The saved bytes, or the path of the file they were saved to. A file is
+        read as it goes, without holding its content in memory.
+
+    Returns
+    -------
+    node : Object
+        The loaded tvm node.
+    """
+    if isinstance(data, str):
+        return tvm.runtime._ffi_node_api.LoadBinaryFromFile(data)
+    return tvm.runtime._ffi_node_api.LoadBinary(bytearray(data))
+
+
 def structural_equal(lhs, rhs, map_free_vars=False):
     """Check structural equality of lhs and rhs.
 
@@ -277,3 +321,21 @@ def structural_hash(node, map_free_vars=False):
     structrual_equal
     """
     return tvm.runtime._ffi_node_api.StructuralHash(node, map_free_vars)
+
+
+def set_structural_hash_cache(capacity):
+    """Set the number of hash values kept by the process-wide structural hash cache.
+
+    The cache is off by default. When it is on, structural_hash keeps the hash
+    of the large objects it is called on, and of the large subtrees that do not
+    contain variables, so hashing them again does not walk them. The cache holds
+    references to the objects, which are copied rather than mutated by copy on
+    write afterwards.
+
+    Parameters
+    ----------
+    capacity : int
+        The number of hash values, the cache is cleared when it is full.
+        0 disables and clears the cache.
+    """
+    tvm.runtime._ffi_node_api.StructuralHashSetCacheCapacity(capacity)
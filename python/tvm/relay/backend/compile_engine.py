@@ -465,3 +465,23 @@ def get():
         The compile engine.
     """
     return _backend._CompileEngineGlobal()
+
+
+def compile_cache_stats():
+    """Get the statistics of the on-disk compile cache in this process.
+
+    The cache is enabled by setting the ``relay.backend.compile_cache_dir``
+    option of the PassContext to a directory, shared by the processes using it.
+
+    Returns
+    -------
+    stats : Dict[str, int]
+        The number of functions found in the cache as ``hits``, and the number
+        of functions lowered and added to the cache as ``misses``.
+    """
+    return {str(k): int(v) for k, v in _backend._CompileCacheStats().items()}
+
+
+def reset_compile_cache_stats():
+    """Reset the statistics of the on-disk compile cache."""
+    _backend._ResetCompileCacheStats()
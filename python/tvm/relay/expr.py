@@ -547,7 +547,8 @@ class StorageInfo(Node):
     The static storage information produced by memory planning.
     Contains the storage ids where expressions are stored, the
     type of the "virtual devices" the expressions are stored on,
-    and the sizes of each storage element."""
+    the sizes of each storage element and, when the storages are
+    packed into arenas, the byte offset of each element."""
 
     @property
     def storage_ids(self):
@@ -560,3 +561,7 @@ class StorageInfo(Node):
     @property
     def storage_sizes(self):
         return _ffi_api.StorageInfoStorageSizes(self)
+
+    @property
+    def storage_offsets(self):
+        return _ffi_api.StorageInfoStorageOffsets(self)
@@ -271,6 +271,15 @@ def FoldConstant():
 def FuseOps(fuse_opt_level=-1):
     """Fuse operators in an expr to a larger operator according to some rules.
 
+    The pass context config "relay.FuseOps.max_depth" bounds the number of operators in a
+    fused function. Setting "relay.FuseOps.cost_model" also fuses operators into the conv2d,
+    dense, pooling or reduction operator consuming them, when the memory traffic saved is worth
+    recomputing them, at "relay.FuseOps.flops_per_byte" operations per byte (4 by default,
+    0 only fuses the operators that are not recomputed). Elementwise and injective operators
+    are inlined into the consumer. When the current target is a CPU, a conv2d or dense with its
+    elementwise operators is also fused into the conv2d or dense consuming it, and the fused
+    function computes both a few rows at a time.
+
     Parameters
     ----------
     fuse_opt_level : int
@@ -297,6 +306,20 @@ def DefuseOps():
     return _ffi_api.DefuseOps()
 
 
+def CoalesceStorage():
+    """Reuse the storage allocated for the VM across tensors whose lifetimes do
+    not overlap. Storage with a symbolic size is only planned when the pass
+    config "relay.CoalesceStorage.dim_upper_bound" bounds every dynamic
+    dimension, and is allocated on its own at runtime when it exceeds the bound.
+
+    Returns
+    -------
+    ret : tvm.transform.Pass
+        The registered pass for storage coalescing.
+    """
+    return _ffi_api.CoalesceStorage()
+
+
 def CombineParallelConv2D(min_num_branches=3):
     """Combine multiple conv2d operators into one.
 
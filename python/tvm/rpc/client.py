@@ -92,6 +92,25 @@ class RPCSession(object):
         dev._rpc_sess = self
         return dev
 
+    def set_copy_options(self, chunk_bytes=0, max_inflight=4, compress=False):
+        """Set how arrays are copied to and from the remote.
+
+        Parameters
+        ----------
+        chunk_bytes : int, optional
+            Split the copies in chunks of at most this many bytes, which bounds
+            the memory the server uses for a copy. 0 splits them only as
+            required by the remote.
+
+        max_inflight : int, optional
+            The number of chunks sent before waiting for the reply of the first one.
+
+        compress : bool, optional
+            Encode the runs of zero bytes of the arrays copied to the remote,
+            if the remote supports it.
+        """
+        _ffi_api.SetCopyOptions(self._sess, chunk_bytes, max_inflight, compress)
+
     def upload(self, data, target=None):
         """Upload file to remote runtime temp folder
 
@@ -19,7 +19,7 @@
 from . import _ffi_api, ndarray
 
 
-def save_param_dict(params):
+def save_param_dict(params, aligned=False):
     """Save parameter dictionary to binary bytes.
 
     The result binary bytes can be loaded by the
@@ -30,6 +30,11 @@ def save_param_dict(params):
     params : dict of str to NDArray
         The parameter dictionary.
 
+    aligned : bool
+        Whether to align the data of each tensor, so that a file holding the
+        bytes can be mapped in memory by :py:func:`load_param_dict_from_file`
+        or the GraphModule API "load_params_from_file" without copies.
+
     Returns
     -------
     param_bytes: bytearray
@@ -48,6 +53,8 @@ def save_param_dict(params):
        tvm.runtime.load_param_dict(param_bytes)
     """
     transformed = {k: ndarray.array(v) for (k, v) in params.items()}
+    if aligned:
+        return _ffi_api.SaveParamsAligned(transformed)
     return _ffi_api.SaveParams(transformed)
 
 
@@ -67,3 +74,22 @@ def load_param_dict(param_bytes):
     if isinstance(param_bytes, (bytes, str)):
         param_bytes = bytearray(param_bytes)
     return _ffi_api.LoadParams(param_bytes)
+
+
+def load_param_dict_from_file(path):
+    """Load parameter dictionary from a file.
+
+    A file saved with ``save_param_dict(params, aligned=True)`` is mapped in
+    memory and the parameters refer to the mapping without copies.
+
+    Parameters
+    ----------
+    path: str
+        The path of the parameters file.
+
+    Returns
+    -------
+    params : dict of str to NDArray
+        The parameter dictionary.
+    """
+    return _ffi_api.LoadParamsFromFile(path)
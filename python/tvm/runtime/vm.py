@@ -288,17 +288,23 @@ class VirtualMachine(object):
     device : tvm.runtime.Device or List[tvm.runtime.Device]
         The device to deploy the module
 
-    memory_cfg : str or Dict[tvm.runtime.Device, str], optional
+    memory_cfg : str or Dict[tvm.runtime.Device, Union[str, int]], optional
         Config the type of memory allocator. The allocator type can be ["naive",
-        "pooled"]. If memory_cfg is None, all devices will use pooled allocator
+        "pooled", "best_fit"]. If memory_cfg is None, all devices will use pooled allocator
         by default. If memory_cfg is string, all devices will use the specified
         allocator type. If memory_cfg is a dict, each device uses the allocator
-        type specified in the dict, or pooled allocator if not specified in the
-        dict.
+        type specified in the dict, either by name or as one of the *_ALLOCATOR
+        constants, or pooled allocator if not specified in the dict.
     """
 
     NAIVE_ALLOCATOR = 1
     POOLED_ALLOCATOR = 2
+    BEST_FIT_ALLOCATOR = 3
+    ALLOCATOR_TYPES = {
+        "naive": NAIVE_ALLOCATOR,
+        "pooled": POOLED_ALLOCATOR,
+        "best_fit": BEST_FIT_ALLOCATOR,
+    }
 
     def __init__(self, exe, device, memory_cfg=None):
         """
@@ -338,7 +344,12 @@ class VirtualMachine(object):
         if not isinstance(exe, Executable):
             exe = Executable(exe)
 
-        self.module = exe.mod["vm_load_executable"]()
+        self._bind(exe.mod["vm_load_executable"](), exe)
+        self._setup_device(device, memory_cfg)
+
+    def _bind(self, module, exe):
+        """Bind the wrapper to a VM runtime module."""
+        self.module = module
         self._exec = exe
         self._init = self.module["init"]
         self._invoke = self.module["invoke"]
@@ -346,7 +357,22 @@ class VirtualMachine(object):
         self._get_output = self.module["get_output"]
         self._get_num_outputs = self.module["get_num_outputs"]
         self._set_input = self.module["set_input"]
-        self._setup_device(device, memory_cfg)
+
+    def create_context(self):
+        """Create an execution context for serving requests concurrently.
+
+        The context shares the loaded kernels, devices, allocators and constants
+        of this VM but has its own registers and inputs, so each thread can run
+        requests on its own context without loading the executable again.
+
+        Returns
+        -------
+        context : VirtualMachine
+            A VM wrapper object over the new execution context.
+        """
+        context = VirtualMachine.__new__(VirtualMachine)
+        context._bind(self.module["create_context"](), self._exec)
+        return context
 
     def _setup_device(self, dev, memory_cfg):
         """Init devices and allocators."""
@@ -367,9 +393,8 @@ class VirtualMachine(object):
         if memory_cfg is None:
             memory_cfg = {}
         elif isinstance(memory_cfg, str):
-            assert memory_cfg in ["naive", "pooled"]
-            if memory_cfg == "naive":
-                default_alloc_type = VirtualMachine.NAIVE_ALLOCATOR
+            assert memory_cfg in VirtualMachine.ALLOCATOR_TYPES
+            default_alloc_type = VirtualMachine.ALLOCATOR_TYPES[memory_cfg]
             memory_cfg = {}
         elif not isinstance(memory_cfg, dict):
             raise TypeError(
@@ -381,6 +406,8 @@ class VirtualMachine(object):
             init_args.append(device.device_type % RPC_SESS_MASK)
             init_args.append(device.device_id)
             alloc_type = memory_cfg[device] if device in memory_cfg else default_alloc_type
+            if isinstance(alloc_type, str):
+                alloc_type = VirtualMachine.ALLOCATOR_TYPES[alloc_type]
             init_args.append(alloc_type)
         self._init(*init_args)
 
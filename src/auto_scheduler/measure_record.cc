@@ -28,7 +28,12 @@
 #include <tvm/auto_scheduler/transform_step.h>
 #include <tvm/runtime/registry.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -309,6 +314,7 @@ namespace auto_scheduler {
 
 TVM_REGISTER_OBJECT_TYPE(RecordToFileNode);
 TVM_REGISTER_OBJECT_TYPE(RecordReaderNode);
+TVM_REGISTER_NODE_TYPE(RecordStoreNode);
 
 RecordToFile::RecordToFile(String filename) {
   auto node = make_object<RecordToFileNode>();
@@ -351,14 +357,381 @@ void ReadMeasureRecord(const std::string& str, MeasureInputNode* inp, MeasureRes
 
 void RecordToFileNode::Callback(const SearchPolicy& policy, const Array<MeasureInput>& inputs,
                                 const Array<MeasureResult>& results) {
+  if (IsRecordStore(filename)) {
+    AppendRecordStore(filename, inputs, results);
+    return;
+  }
   std::ofstream ofs(filename, std::ofstream::app);
   WriteMeasureRecords(&ofs, inputs, results);
 }
 
+/*! \brief The magic number at the start of a binary record store. */
+constexpr uint64_t kRecordStoreMagic = 0x3153524f43455254;  // "TRECORS1"
+
+/*! \brief The header in front of every record of a binary record store. */
+struct RecordFrameHeader {
+  /*! \brief The size of the workload key following the header. */
+  uint32_t key_size;
+  /*! \brief The size of the target string following the workload key. */
+  uint32_t target_size;
+  /*! \brief The size of the json payload following the target string. */
+  uint32_t payload_size;
+  /*! \brief The error number of the measurement. */
+  int32_t error_no;
+  /*! \brief The mean cost of the measurement, infinite if it failed. */
+  double cost;
+};
+
+/*!
+ * \brief Read the next record frame of a binary record store.
+ * \param is The input stream, positioned at a frame.
+ * \param header The header of the frame.
+ * \param key The workload key.
+ * \param target The target string.
+ * \param payload The json payload, skipped when nullptr.
+ * \return Whether a whole frame was read.
+ */
+bool ReadRecordFrame(std::istream* is, RecordFrameHeader* header, std::string* key,
+                     std::string* target, std::string* payload) {
+  if (!is->read(reinterpret_cast<char*>(header), sizeof(*header))) return false;
+  key->resize(header->key_size);
+  target->resize(header->target_size);
+  if (!is->read(&(*key)[0], key->size()) || !is->read(&(*target)[0], target->size())) {
+    return false;
+  }
+  if (payload != nullptr) {
+    payload->resize(header->payload_size);
+    return static_cast<bool>(is->read(&(*payload)[0], payload->size()));
+  }
+  return static_cast<bool>(is->seekg(header->payload_size, std::ios::cur));
+}
+
+/*! \brief Called with the key, target, header and payload offset of a record frame. */
+using RecordFrameCallback =
+    std::function<void(const std::string&, const std::string&, const RecordFrameHeader&, uint64_t)>;
+
+/*!
+ * \brief Read the record frames of a binary record store up to the end of the file.
+ * \param is The input stream, positioned at a frame.
+ * \param file_size The size of the file.
+ * \param on_read Called for each whole record, may be nullptr.
+ * \return The end of the last whole record, where a partial record left by an interrupted
+ *  writer starts if there is one.
+ */
+uint64_t ScanRecordFrames(std::istream* is, uint64_t file_size, RecordFrameCallback on_read) {
+  RecordFrameHeader header;
+  std::string key, target;
+  uint64_t end = static_cast<uint64_t>(is->tellg());
+  while (end < file_size) {
+    if (!ReadRecordFrame(is, &header, &key, &target, nullptr) ||
+        static_cast<uint64_t>(is->tellg()) > file_size) {
+      break;
+    }
+    end = static_cast<uint64_t>(is->tellg());
+    if (on_read != nullptr) {
+      on_read(key, target, header, end - header.payload_size);
+    }
+  }
+  return end;
+}
+
+/*!
+ * \brief Remove the partial record an interrupted writer left at the end of a record store.
+ * \param filename The name of the file.
+ * \param scan_from The offset of a frame, the records in front of it are known to be whole.
+ */
+void RepairRecordStore(const std::string& filename, uint64_t scan_from) {
+  std::ifstream ifs(filename, std::ifstream::binary);
+  if (!ifs) return;
+  ifs.seekg(0, std::ios::end);
+  uint64_t file_size = static_cast<uint64_t>(ifs.tellg());
+  if (file_size <= sizeof(kRecordStoreMagic)) return;
+  ifs.seekg(std::max<uint64_t>(scan_from, sizeof(kRecordStoreMagic)));
+  uint64_t end = ScanRecordFrames(&ifs, file_size, nullptr);
+  if (end == file_size) return;
+  // The records appended after the partial record would be unreadable.
+  LOG(WARNING) << "Remove the truncated record at the end of " << filename;
+  std::string data(end, '\0');
+  ifs.clear();
+  ifs.seekg(0, std::ios::beg);
+  ICHECK(ifs.read(&data[0], data.size())) << "Failed to read " << filename;
+  ifs.close();
+  std::ofstream ofs(filename, std::ofstream::binary | std::ofstream::trunc);
+  ICHECK(ofs.write(data.data(), data.size())) << "Failed to write " << filename;
+}
+
+/*!
+ * \brief Append records to a binary record store.
+ * \param filename The name of the file, created if it does not exist.
+ * \param inputs The MeasureInputs to be written.
+ * \param results The MeasureResults to be written.
+ * \param scan_from The offset of a frame, the records in front of it are known to be whole.
+ * \param on_write Called for each record written, may be nullptr.
+ * \return The end of the file after the records.
+ */
+uint64_t WriteRecordFrames(const std::string& filename, const Array<MeasureInput>& inputs,
+                           const Array<MeasureResult>& results, uint64_t scan_from,
+                           RecordFrameCallback on_write) {
+  ICHECK_EQ(inputs.size(), results.size());
+  RepairRecordStore(filename, scan_from);
+  std::ofstream ofs(filename, std::ofstream::app | std::ofstream::binary);
+  ICHECK(ofs) << "Cannot open " << filename;
+  ofs.seekp(0, std::ios::end);
+  uint64_t pos = static_cast<uint64_t>(ofs.tellp());
+  if (pos == 0) {
+    ofs.write(reinterpret_cast<const char*>(&kRecordStoreMagic), sizeof(kRecordStoreMagic));
+    pos += sizeof(kRecordStoreMagic);
+  }
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    std::ostringstream os;
+    WriteMeasureRecords(&os, {inputs[i]}, {results[i]});
+    std::string payload = os.str();
+    payload.pop_back();  // the line break
+    std::string key = inputs[i]->task->workload_key;
+    std::string target = inputs[i]->task->target->str();
+    const MeasureResultNode* res = results[i].get();
+
+    RecordFrameHeader header;
+    header.key_size = static_cast<uint32_t>(key.size());
+    header.target_size = static_cast<uint32_t>(target.size());
+    header.payload_size = static_cast<uint32_t>(payload.size());
+    header.error_no = res->error_no;
+    header.cost = std::numeric_limits<double>::infinity();
+    if (res->error_no == 0 && !res->costs.empty()) {
+      double sum = 0;
+      for (const auto& x : res->costs) {
+        sum += Downcast<FloatImm>(x)->value;
+      }
+      header.cost = sum / res->costs.size();
+    }
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.write(key.data(), key.size());
+    ofs.write(target.data(), target.size());
+    pos += sizeof(header) + key.size() + target.size();
+    ofs.write(payload.data(), payload.size());
+    if (on_write != nullptr) {
+      on_write(key, target, header, pos);
+    }
+    pos += payload.size();
+  }
+  ICHECK(ofs) << "Failed to write " << filename;
+  return pos;
+}
+
+bool IsRecordStore(const std::string& filename) {
+  std::ifstream ifs(filename, std::ifstream::binary);
+  if (ifs) {
+    uint64_t magic = 0;
+    ifs.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    if (ifs.gcount() != 0) {
+      return ifs.gcount() == sizeof(magic) && magic == kRecordStoreMagic;
+    }
+  }
+  const std::string ext = ".bin";
+  return filename.size() >= ext.size() &&
+         filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+void AppendRecordStore(const std::string& filename, const Array<MeasureInput>& inputs,
+                       const Array<MeasureResult>& results) {
+  WriteRecordFrames(filename, inputs, results, 0, nullptr);
+}
+
+RecordStore::RecordStore(String filename) {
+  auto node = make_object<RecordStoreNode>();
+  node->filename = std::move(filename);
+  node->Open();
+  data_ = std::move(node);
+}
+
+void RecordStoreNode::Open() {
+  entries_.clear();
+  by_workload_.clear();
+  best_.clear();
+  end_offset_ = 0;
+
+  std::ifstream ifs(filename, std::ifstream::binary);
+  if (!ifs) {
+    std::ofstream ofs(filename, std::ofstream::binary);
+    ICHECK(ofs) << "Cannot create " << filename;
+    ofs.write(reinterpret_cast<const char*>(&kRecordStoreMagic), sizeof(kRecordStoreMagic));
+    return;
+  }
+  ifs.seekg(0, std::ios::end);
+  uint64_t file_size = static_cast<uint64_t>(ifs.tellg());
+  ifs.seekg(0, std::ios::beg);
+  uint64_t magic = 0;
+  ifs.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+  if (file_size == 0) {
+    return;
+  }
+  ICHECK(ifs && magic == kRecordStoreMagic) << filename << " is not a record store";
+
+  end_offset_ = ScanRecordFrames(&ifs, file_size,
+                                 [this](const std::string& key, const std::string& target,
+                                        const RecordFrameHeader& header, uint64_t offset) {
+                                   Entry entry;
+                                   entry.target = target;
+                                   entry.cost = header.error_no == 0
+                                                    ? header.cost
+                                                    : std::numeric_limits<double>::infinity();
+                                   entry.offset = offset;
+                                   entry.size = header.payload_size;
+                                   AddEntry(key, std::move(entry));
+                                 });
+  if (end_offset_ < file_size) {
+    // A writer was interrupted in the middle of a record, the next append removes it.
+    LOG(WARNING) << "Skip the truncated record at the end of " << filename;
+  }
+}
+
+void RecordStoreNode::AddEntry(const std::string& workload_key, Entry entry) {
+  size_t index = entries_.size();
+  if (std::isfinite(entry.cost)) {
+    auto ret = best_.emplace(std::make_pair(workload_key, entry.target), index);
+    if (!ret.second && entry.cost < entries_[ret.first->second].cost) {
+      ret.first->second = index;
+    }
+  }
+  by_workload_[workload_key].push_back(index);
+  entries_.push_back(std::move(entry));
+}
+
+void RecordStoreNode::Append(const Array<MeasureInput>& inputs,
+                             const Array<MeasureResult>& results) {
+  end_offset_ = WriteRecordFrames(filename, inputs, results, end_offset_,
+                                 [this](const std::string& key, const std::string& target,
+                                        const RecordFrameHeader& header, uint64_t offset) {
+                                   Entry entry;
+                                   entry.target = target;
+                                   entry.cost = header.cost;
+                                   entry.offset = offset;
+                                   entry.size = header.payload_size;
+                                   AddEntry(key, std::move(entry));
+                                 });
+}
+
+std::pair<Array<MeasureInput>, Array<MeasureResult>> RecordStoreNode::Read(
+    const std::vector<size_t>& indices) const {
+  Array<MeasureInput> inputs;
+  Array<MeasureResult> results;
+  if (indices.empty()) {
+    return std::make_pair(inputs, results);
+  }
+  std::ifstream ifs(filename, std::ifstream::binary);
+  ICHECK(ifs) << "Cannot open " << filename;
+  std::string payload, log_version;
+  for (size_t index : indices) {
+    const Entry& entry = entries_[index];
+    payload.resize(entry.size);
+    ifs.seekg(entry.offset);
+    ICHECK(ifs.read(&payload[0], payload.size())) << "Failed to read " << filename;
+    auto inp = make_object<MeasureInputNode>();
+    auto res = make_object<MeasureResultNode>();
+    ReadMeasureRecord(payload, inp.get(), res.get(), &log_version);
+    inputs.push_back(MeasureInput(inp));
+    results.push_back(MeasureResult(res));
+  }
+  return std::make_pair(inputs, results);
+}
+
+/*!
+ * \brief Get the canonical string of a target, which the records are indexed by.
+ * \param target A target string, empty for every target.
+ */
+std::string CanonicalTargetString(const std::string& target) {
+  return target.empty() ? target : Target(target)->str();
+}
+
+std::pair<Array<MeasureInput>, Array<MeasureResult>> RecordStoreNode::Query(
+    const std::string& workload_key, const std::string& target_str) const {
+  std::string target = CanonicalTargetString(target_str);
+  std::vector<size_t> indices;
+  auto it = by_workload_.find(workload_key);
+  if (it != by_workload_.end()) {
+    for (size_t index : it->second) {
+      if (target.empty() || entries_[index].target == target) {
+        indices.push_back(index);
+      }
+    }
+  }
+  return Read(indices);
+}
+
+std::pair<Array<MeasureInput>, Array<MeasureResult>> RecordStoreNode::QueryBest(
+    const std::string& workload_key, const std::string& target_str) const {
+  std::string target = CanonicalTargetString(target_str);
+  std::vector<size_t> indices;
+  if (!target.empty()) {
+    auto it = best_.find(std::make_pair(workload_key, target));
+    if (it != best_.end()) {
+      indices.push_back(it->second);
+    }
+  } else {
+    // The entries of a workload key are adjacent in the map, one per target.
+    for (auto it = best_.lower_bound(std::make_pair(workload_key, std::string()));
+         it != best_.end() && it->first.first == workload_key; ++it) {
+      if (indices.empty() || entries_[it->second].cost < entries_[indices[0]].cost) {
+        indices.assign(1, it->second);
+      }
+    }
+  }
+  return Read(indices);
+}
+
+std::pair<Array<MeasureInput>, Array<MeasureResult>> RecordStoreNode::ReadBest() const {
+  std::vector<size_t> indices;
+  indices.reserve(best_.size());
+  for (const auto& kv : best_) {
+    indices.push_back(kv.second);
+  }
+  return Read(indices);
+}
+
+void ConvertRecordFile(const std::string& in_file, const std::string& out_file) {
+  bool binary_in = IsRecordStore(in_file);
+  bool binary_out = IsRecordStore(out_file);
+  {
+    // Replace the records of an existing output file.
+    std::ofstream ofs(out_file, std::ofstream::trunc);
+    ICHECK(ofs) << "Cannot create " << out_file;
+  }
+  if (binary_in && !binary_out) {
+    // The payloads are json records already, copy them without parsing.
+    std::ifstream ifs(in_file, std::ifstream::binary);
+    ICHECK(ifs) << "Cannot open " << in_file;
+    std::ofstream ofs(out_file, std::ofstream::app);
+    ifs.seekg(sizeof(kRecordStoreMagic));
+    RecordFrameHeader header;
+    std::string key, target, payload;
+    while (ReadRecordFrame(&ifs, &header, &key, &target, &payload)) {
+      ofs << payload << "\n";
+    }
+    return;
+  }
+  RecordReader reader(in_file);
+  while (true) {
+    auto records = reader->ReadLines(1024);
+    if (records.first.empty()) break;
+    if (binary_out) {
+      AppendRecordStore(out_file, records.first, records.second);
+    } else {
+      std::ofstream ofs(out_file, std::ofstream::app);
+      WriteMeasureRecords(&ofs, records.first, records.second);
+    }
+  }
+}
+
 RecordReader::RecordReader(String filename) {
   auto node = make_object<RecordReaderNode>();
   node->filename = filename;
-  node->infile.open(filename, std::ifstream::in);
+  node->binary_ = IsRecordStore(filename);
+  if (node->binary_) {
+    node->infile.open(filename, std::ifstream::in | std::ifstream::binary);
+    node->infile.seekg(sizeof(kRecordStoreMagic));
+  } else {
+    node->infile.open(filename, std::ifstream::in);
+  }
   data_ = std::move(node);
 }
 
@@ -367,6 +740,16 @@ RecordReaderNode::~RecordReaderNode() { infile.close(); }
 bool RecordReaderNode::ReadNext(MeasureInputNode* inp, MeasureResultNode* res) {
   std::string log_version;
 
+  if (binary_) {
+    RecordFrameHeader header;
+    std::string key, target;
+    if (!ReadRecordFrame(&infile, &header, &key, &target, &cur_line_)) {
+      return false;
+    }
+    ReadMeasureRecord(cur_line_, inp, res, &log_version);
+    return true;
+  }
+
   while (std::getline(infile, cur_line_)) {
     if (cur_line_[0] == '#' || cur_line_[0] == ' ') {
       // skip comment lines begin with '#' or ' '
@@ -446,10 +829,53 @@ TVM_REGISTER_GLOBAL("auto_scheduler.WriteMeasureRecords")
 
 TVM_REGISTER_GLOBAL("auto_scheduler.SaveRecords")
     .set_body_typed([](String filename, Array<MeasureInput> in, Array<MeasureResult> res) {
+      if (IsRecordStore(filename)) {
+        AppendRecordStore(filename, in, res);
+        return;
+      }
       std::ofstream ofs(filename, std::ofstream::app);
       WriteMeasureRecords(&ofs, in, res);
     });
 
+TVM_REGISTER_GLOBAL("auto_scheduler.IsRecordStore").set_body_typed([](const String& filename) {
+  return IsRecordStore(filename);
+});
+
+TVM_REGISTER_GLOBAL("auto_scheduler.ConvertRecordFile")
+    .set_body_typed([](const String& in_file, const String& out_file) {
+      ConvertRecordFile(in_file, out_file);
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStore").set_body_typed([](const String& filename) {
+  return RecordStore(filename);
+});
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStoreAppend")
+    .set_body_typed([](RecordStore store, Array<MeasureInput> in, Array<MeasureResult> res) {
+      store->Append(in, res);
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStoreQuery")
+    .set_body_typed([](RecordStore store, const String& workload_key, const String& target) {
+      const auto& res = store->Query(workload_key, target);
+      return Array<ObjectRef>{res.first, res.second};
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStoreQueryBest")
+    .set_body_typed([](RecordStore store, const String& workload_key, const String& target) {
+      const auto& res = store->QueryBest(workload_key, target);
+      return Array<ObjectRef>{res.first, res.second};
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStoreReadBest").set_body_typed([](RecordStore store) {
+  const auto& res = store->ReadBest();
+  return Array<ObjectRef>{res.first, res.second};
+});
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStoreNumRecords").set_body_typed([](RecordStore store) {
+  return static_cast<int64_t>(store->NumRecords());
+});
+
 TVM_REGISTER_GLOBAL("auto_scheduler.SerializeMeasureInput")
     .set_body_typed([](const MeasureInput& input) {
       std::ostringstream os;
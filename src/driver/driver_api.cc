@@ -25,14 +25,20 @@
 #include <tvm/driver/driver_api.h>
 #include <tvm/ir/transform.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
 #include <tvm/target/codegen.h>
 #include <tvm/te/operation.h>
 #include <tvm/tir/analysis.h>
+#include <tvm/tir/builtin.h>
+#include <tvm/tir/stmt_functor.h>
 #include <tvm/tir/transform.h>
 
 #include <algorithm>
 #include <mutex>
 #include <stack>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace tvm {
 
@@ -43,6 +49,7 @@ TVM_REGISTER_PASS_CONFIG_OPTION("tir.instrument_bound_checkers", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("tir.disable_assert", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("tir.disable_vectorize", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("tir.add_lower_pass", Array<Array<ObjectRef>>);
+TVM_REGISTER_PASS_CONFIG_OPTION("tir.llvm_codegen_partitions", Integer);
 
 using runtime::PackedFunc;
 using runtime::TVMArgs;
@@ -447,6 +454,72 @@ std::pair<IRModule, IRModule> SplitDevHostFuncs(IRModule mod_mixed, const Target
   return {mhost, mdevice};
 }
 
+/*!
+ * \brief Generate the code of the host module.
+ *
+ *  With "tir.llvm_codegen_partitions" set to k > 1, an LLVM host module is split
+ *  into k modules generated on different threads, the first one importing the
+ *  others. The functions are then only found through the imports, so the split
+ *  is made only when no function depends on being in the same module as another.
+ */
+runtime::Module BuildHostModule(const IRModule& mhost_all, const Target& target_host,
+                                const transform::PassContext& pass_ctx, bool has_device_modules) {
+  int num_parts = pass_ctx->GetConfig<Integer>("tir.llvm_codegen_partitions", Integer(1)).value();
+  bool splittable = num_parts > 1 && target_host->kind->name == "llvm" && !has_device_modules &&
+                    pass_ctx->instruments.size() == 0 &&
+                    !target_host->GetAttr<Bool>("system-lib").value_or(Bool(false)) &&
+                    !target_host->GetAttr<Bool>("link-params").value_or(Bool(false));
+  std::vector<std::pair<std::string, GlobalVar>> funcs;
+  std::unordered_set<std::string> symbols;
+  for (const auto& kv : mhost_all->functions) {
+    if (!splittable) break;
+    if (const auto* f = kv.second.as<tir::PrimFuncNode>()) {
+      if (f->HasNonzeroAttr(tir::attr::kIsEntryFunc)) splittable = false;
+      funcs.emplace_back(kv.first->name_hint, kv.first);
+      symbols.insert(f->GetAttr<String>(tvm::attr::kGlobalSymbol).value_or(kv.first->name_hint));
+    }
+  }
+  // Functions calling each other through extern calls must stay together.
+  for (const auto& kv : mhost_all->functions) {
+    if (!splittable) break;
+    if (const auto* f = kv.second.as<tir::PrimFuncNode>()) {
+      tir::PostOrderVisit(f->body, [&](const ObjectRef& node) {
+        const auto* call = node.as<tir::CallNode>();
+        if (call != nullptr && call->op.same_as(tir::builtin::call_extern()) &&
+            call->args.size() != 0) {
+          const auto* name = call->args[0].as<tir::StringImmNode>();
+          if (name != nullptr && symbols.count(name->value)) splittable = false;
+        }
+      });
+    }
+  }
+  num_parts = std::min(num_parts, static_cast<int>(funcs.size()));
+  if (!splittable || num_parts <= 1) {
+    return codegen::Build(mhost_all, target_host);
+  }
+
+  // Deal the functions in the order of their names, the split is the same on every build.
+  std::sort(funcs.begin(), funcs.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+  std::vector<IRModule> parts;
+  for (int i = 0; i < num_parts; ++i) {
+    parts.push_back(IRModule(Map<GlobalVar, BaseFunc>()));
+  }
+  for (size_t i = 0; i < funcs.size(); ++i) {
+    parts[i % num_parts]->Add(funcs[i].second, mhost_all->Lookup(funcs[i].second));
+  }
+  std::vector<runtime::Module> modules(num_parts);
+  support::parallel_for(0, num_parts, [&](int i) {
+    // The code generator reads its configuration from the current pass context.
+    With<transform::PassContext> pass_ctx_scope(pass_ctx);
+    modules[i] = codegen::Build(parts[i], target_host);
+  });
+  for (int i = 1; i < num_parts; ++i) {
+    modules[0].Import(modules[i]);
+  }
+  return modules[0];
+}
+
 // Can we make this take one annotated IRModule?
 //
 // Build for heterogeneous execution.
@@ -498,7 +571,8 @@ runtime::Module build(const Map<Target, IRModule>& inputs_arg, const Target& tar
     }
   }
 
-  runtime::Module mhost = codegen::Build(mhost_all, target_host);
+  runtime::Module mhost =
+      BuildHostModule(mhost_all, target_host, pass_ctx, !device_modules.empty());
   // Import all modules
   for (const auto& it : device_modules) {
     if (it.operator->()) {
@@ -23,7 +23,9 @@
  */
 #include <tvm/ir/module.h>
 #include <tvm/node/structural_equal.h>
+#include <tvm/node/structural_hash.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
 // NOTE: reverse dependency on relay.
 // These dependencies do not happen at the interface-level,
 // and are only used in minimum cases where they are clearly marked.
@@ -105,7 +107,23 @@ void IRModuleNode::SHashReduce(SHashReducer hash_reduce) const {
   for (const auto& kv : this->functions) {
     temp.emplace_back(kv.first->name_hint, kv.second);
   }
-  reduce_temp();
+  std::sort(temp.begin(), temp.end(),
+            [](const KV& lhs, const KV& rhs) { return lhs.first < rhs.first; });
+  // Each function is hashed on its own, numbering its variables from zero,
+  // which lets the functions of a large module be hashed in parallel.
+  std::vector<size_t> func_hashes(temp.size());
+  bool map_free_vars = hash_reduce.map_free_vars();
+  auto hash_func = [&](int i) { func_hashes[i] = StructuralHash()(temp[i].second, map_free_vars); };
+  if (temp.size() > 1) {
+    support::parallel_for(0, static_cast<int>(temp.size()), hash_func);
+  } else if (temp.size() == 1) {
+    hash_func(0);
+  }
+  hash_reduce(static_cast<uint64_t>(temp.size()));
+  for (size_t i = 0; i < temp.size(); ++i) {
+    hash_reduce(temp[i].first);
+    hash_reduce->SHashReduceHashedValue(func_hashes[i]);
+  }
 
   temp.clear();
   for (const auto& kv : this->type_definitions) {
@@ -31,9 +31,13 @@
 #include <tvm/runtime/registry.h>
 
 #include <cctype>
+#include <fstream>
 #include <map>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
+#include "../runtime/file_utils.h"
 #include "../runtime/object_internal.h"
 #include "../support/base64.h"
 
@@ -99,9 +103,11 @@ class NodeIndexer : public AttrVisitor {
     ICHECK(node->IsInstance<Object>());
 
     if (node_index_.count(node)) return;
-    ICHECK_EQ(node_index_.size(), node_list_.size());
-    node_index_[node] = node_list_.size();
-    node_list_.push_back(node);
+    if (post_order_) {
+      ICHECK(visiting_.insert(node).second) << "Cyclic reference detected when saving " << node;
+    } else {
+      AddIndex(node);
+    }
 
     if (node->IsInstance<ArrayNode>()) {
       ArrayNode* n = static_cast<ArrayNode*>(node);
@@ -129,7 +135,25 @@ class NodeIndexer : public AttrVisitor {
         reflection_->VisitAttrs(node, this);
       }
     }
+    if (post_order_) {
+      AddIndex(node);
+    }
   }
+
+  /*!
+   * \brief Whether to index the children of a node before the node, which is
+   *  set for the binary format so it can be loaded in one pass.
+   */
+  bool post_order_{false};
+
+ private:
+  void AddIndex(Object* node) {
+    ICHECK_EQ(node_index_.size(), node_list_.size());
+    node_index_[node] = node_list_.size();
+    node_list_.push_back(node);
+  }
+
+  std::unordered_set<Object*> visiting_;
 };
 
 // use map so attributes are ordered.
@@ -594,7 +618,327 @@ ObjectRef LoadJSON(std::string json_str) {
   return ObjectRef(nodes.at(jgraph.root));
 }
 
+/*! \brief The magic number at the start of the binary format. */
+constexpr uint64_t kTVMObjectBinaryMagic = 0x31424a424f4d5654;  // "TVMOBJB1"
+static_assert(kTVMObjectBinaryMagic != runtime::kTVMNDArrayListMagic &&
+                  kTVMObjectBinaryMagic != runtime::kTVMNDArrayListAlignedMagic,
+              "The object binary format must not be mistaken for a parameter file");
+
+/*! \brief The kinds of nodes in the binary format. */
+enum class BinaryNodeKind : uint8_t {
+  kReprBytes = 0,
+  kArray = 1,
+  kStrMap = 2,
+  kMap = 3,
+  kAttrs = 4,
+};
+
+// Write the fields of a node to the binary format.
+class BinaryAttrWriter : public AttrVisitor {
+ public:
+  dmlc::Stream* strm_;
+  const std::unordered_map<Object*, size_t>* node_index_;
+  const std::unordered_map<DLTensor*, size_t>* tensor_index_;
+  // The number of fields written, checked by the reader.
+  uint32_t num_fields_{0};
+
+  void Visit(const char* key, double* value) final { Write(*value); }
+  void Visit(const char* key, int64_t* value) final { Write(*value); }
+  void Visit(const char* key, uint64_t* value) final { Write(*value); }
+  void Visit(const char* key, int* value) final { Write(static_cast<int32_t>(*value)); }
+  void Visit(const char* key, bool* value) final { Write(static_cast<uint8_t>(*value)); }
+  void Visit(const char* key, std::string* value) final { Write(*value); }
+  void Visit(const char* key, void** value) final {
+    LOG(FATAL) << "not allowed to serialize a pointer";
+  }
+  void Visit(const char* key, DataType* value) final {
+    DLDataType dtype = *value;
+    Write(dtype.code);
+    Write(dtype.bits);
+    Write(dtype.lanes);
+  }
+  void Visit(const char* key, runtime::NDArray* value) final {
+    Write(static_cast<uint64_t>(
+        tensor_index_->at(const_cast<DLTensor*>((*value).operator->()))));
+  }
+  void Visit(const char* key, ObjectRef* value) final {
+    Write(static_cast<uint64_t>(node_index_->at(const_cast<Object*>(value->get()))));
+  }
+
+ private:
+  template <typename T>
+  void Write(const T& value) {
+    strm_->Write(value);
+    ++num_fields_;
+  }
+};
+
+// Read the fields of a node from the binary format.
+class BinaryAttrReader : public AttrVisitor {
+ public:
+  dmlc::Stream* strm_;
+  const std::vector<ObjectPtr<Object>>* node_list_;
+  const std::vector<runtime::NDArray>* tensor_list_;
+  // The index of the node being read, which only refers to nodes before it.
+  size_t node_index_;
+  uint32_t num_fields_{0};
+
+  void Visit(const char* key, double* value) final { Read(key, value); }
+  void Visit(const char* key, int64_t* value) final { Read(key, value); }
+  void Visit(const char* key, uint64_t* value) final { Read(key, value); }
+  void Visit(const char* key, int* value) final {
+    int32_t v;
+    Read(key, &v);
+    *value = v;
+  }
+  void Visit(const char* key, bool* value) final {
+    uint8_t v;
+    Read(key, &v);
+    *value = v != 0;
+  }
+  void Visit(const char* key, std::string* value) final { Read(key, value); }
+  void Visit(const char* key, void** value) final {
+    LOG(FATAL) << "not allowed to deserialize a pointer";
+  }
+  void Visit(const char* key, DataType* value) final {
+    DLDataType dtype;
+    Read(key, &dtype.code);
+    Read(key, &dtype.bits);
+    Read(key, &dtype.lanes);
+    *value = DataType(dtype);
+  }
+  void Visit(const char* key, runtime::NDArray* value) final {
+    uint64_t index;
+    Read(key, &index);
+    ICHECK_LT(index, tensor_list_->size());
+    *value = tensor_list_->at(index);
+  }
+  void Visit(const char* key, ObjectRef* value) final {
+    uint64_t index;
+    Read(key, &index);
+    ICHECK_LT(index, node_index_) << "Invalid reference in field " << key;
+    *value = ObjectRef(node_list_->at(index));
+  }
+
+ private:
+  template <typename T>
+  void Read(const char* key, T* value) {
+    ICHECK(strm_->Read(value)) << "BinaryReader: cannot read field " << key;
+    ++num_fields_;
+  }
+};
+
+void SaveBinary(dmlc::Stream* strm, const ObjectRef& root) {
+  ReflectionVTable* reflection = ReflectionVTable::Global();
+  NodeIndexer indexer;
+  indexer.post_order_ = true;
+  indexer.MakeIndex(const_cast<Object*>(root.get()));
+
+  // header
+  strm->Write(kTVMObjectBinaryMagic);
+  strm->Write(std::string(TVM_VERSION));
+  std::vector<std::string> type_keys;
+  std::unordered_map<uint32_t, uint32_t> type_ids;
+  for (Object* n : indexer.node_list_) {
+    if (n != nullptr && type_ids.emplace(n->type_index(), type_keys.size()).second) {
+      type_keys.push_back(n->GetTypeKey());
+    }
+  }
+  strm->Write(type_keys);
+  // tensors
+  strm->Write(static_cast<uint64_t>(indexer.tensor_list_.size()));
+  for (DLTensor* tensor : indexer.tensor_list_) {
+    runtime::SaveDLTensor(strm, tensor);
+  }
+  // nodes, the children of a node are before it, node 0 is None.
+  strm->Write(static_cast<uint64_t>(indexer.node_list_.size()));
+  strm->Write(static_cast<uint64_t>(indexer.node_index_.at(const_cast<Object*>(root.get()))));
+  std::string repr_bytes;
+  for (size_t i = 1; i < indexer.node_list_.size(); ++i) {
+    Object* node = indexer.node_list_[i];
+    strm->Write(type_ids.at(node->type_index()));
+    auto index_of = [&](const ObjectRef& ref) {
+      return static_cast<uint64_t>(indexer.node_index_.at(const_cast<Object*>(ref.get())));
+    };
+    if (reflection->GetReprBytes(node, &repr_bytes)) {
+      strm->Write(BinaryNodeKind::kReprBytes);
+      strm->Write(repr_bytes);
+    } else if (node->IsInstance<ArrayNode>()) {
+      ArrayNode* n = static_cast<ArrayNode*>(node);
+      strm->Write(BinaryNodeKind::kArray);
+      strm->Write(static_cast<uint64_t>(n->size()));
+      for (const auto& sp : *n) {
+        strm->Write(index_of(sp));
+      }
+    } else if (node->IsInstance<MapNode>()) {
+      MapNode* n = static_cast<MapNode*>(node);
+      bool is_str_map = std::all_of(n->begin(), n->end(), [](const auto& v) {
+        return v.first->template IsInstance<StringObj>();
+      });
+      strm->Write(is_str_map ? BinaryNodeKind::kStrMap : BinaryNodeKind::kMap);
+      strm->Write(static_cast<uint64_t>(n->size()));
+      for (const auto& kv : *n) {
+        if (is_str_map) {
+          strm->Write(std::string(Downcast<String>(kv.first)));
+        } else {
+          strm->Write(index_of(kv.first));
+        }
+        strm->Write(index_of(kv.second));
+      }
+    } else {
+      strm->Write(BinaryNodeKind::kAttrs);
+      BinaryAttrWriter writer;
+      writer.strm_ = strm;
+      writer.node_index_ = &indexer.node_index_;
+      writer.tensor_index_ = &indexer.tensor_index_;
+      reflection->VisitAttrs(node, &writer);
+      strm->Write(writer.num_fields_);
+    }
+  }
+}
+
+ObjectRef LoadBinary(dmlc::Stream* strm) {
+  ReflectionVTable* reflection = ReflectionVTable::Global();
+  uint64_t magic;
+  std::string version;
+  ICHECK(strm->Read(&magic) && magic == kTVMObjectBinaryMagic)
+      << "BinaryReader: the stream does not hold a binary TVM object";
+  ICHECK(strm->Read(&version));
+  ICHECK_EQ(version, TVM_VERSION) << "BinaryReader: the object was saved by TVM " << version
+                                  << ", the binary format can only be loaded by the same version";
+  std::vector<std::string> type_keys;
+  ICHECK(strm->Read(&type_keys));
+
+  uint64_t num_tensors;
+  ICHECK(strm->Read(&num_tensors));
+  std::vector<runtime::NDArray> tensors(num_tensors);
+  for (auto& tensor : tensors) {
+    ICHECK(tensor.Load(strm)) << "BinaryReader: cannot read tensor";
+  }
+
+  uint64_t num_nodes, root;
+  ICHECK(strm->Read(&num_nodes) && strm->Read(&root));
+  ICHECK_LT(root, num_nodes);
+  std::vector<ObjectPtr<Object>> nodes(num_nodes, nullptr);
+  BinaryAttrReader reader;
+  reader.strm_ = strm;
+  reader.node_list_ = &nodes;
+  reader.tensor_list_ = &tensors;
+  auto read_index = [&](size_t i) {
+    uint64_t index;
+    ICHECK(strm->Read(&index));
+    ICHECK_LT(index, i) << "BinaryReader: invalid reference in node " << i;
+    return ObjectRef(nodes[index]);
+  };
+  std::string repr_bytes;
+  for (size_t i = 1; i < num_nodes; ++i) {
+    uint32_t type_id;
+    BinaryNodeKind kind;
+    ICHECK(strm->Read(&type_id) && strm->Read(&kind)) << "BinaryReader: cannot read node " << i;
+    ICHECK_LT(type_id, type_keys.size());
+    const std::string& type_key = type_keys[type_id];
+    uint64_t size;
+    switch (kind) {
+      case BinaryNodeKind::kReprBytes: {
+        ICHECK(strm->Read(&repr_bytes));
+        nodes[i] = reflection->CreateInitObject(type_key, repr_bytes);
+        break;
+      }
+      case BinaryNodeKind::kArray: {
+        ICHECK(strm->Read(&size));
+        std::vector<ObjectRef> container;
+        container.reserve(size);
+        for (uint64_t j = 0; j < size; ++j) {
+          container.push_back(read_index(i));
+        }
+        Array<ObjectRef> array(container);
+        nodes[i] = runtime::ObjectInternal::MoveObjectPtr(&array);
+        break;
+      }
+      case BinaryNodeKind::kStrMap:
+      case BinaryNodeKind::kMap: {
+        ICHECK(strm->Read(&size));
+        std::unordered_map<ObjectRef, ObjectRef, ObjectHash, ObjectEqual> container;
+        for (uint64_t j = 0; j < size; ++j) {
+          ObjectRef key;
+          if (kind == BinaryNodeKind::kStrMap) {
+            std::string str;
+            ICHECK(strm->Read(&str));
+            key = String(str);
+          } else {
+            key = read_index(i);
+          }
+          container[key] = read_index(i);
+        }
+        Map<ObjectRef, ObjectRef> map(container);
+        nodes[i] = runtime::ObjectInternal::MoveObjectPtr(&map);
+        break;
+      }
+      case BinaryNodeKind::kAttrs: {
+        nodes[i] = reflection->CreateInitObject(type_key);
+        reader.node_index_ = i;
+        reader.num_fields_ = 0;
+        reflection->VisitAttrs(nodes[i].get(), &reader);
+        uint32_t num_fields;
+        ICHECK(strm->Read(&num_fields));
+        ICHECK_EQ(num_fields, reader.num_fields_)
+            << "BinaryReader: the fields of " << type_key << " do not match the saved ones";
+        break;
+      }
+      default:
+        LOG(FATAL) << "BinaryReader: unknown node kind " << static_cast<int>(kind);
+    }
+  }
+  return ObjectRef(nodes[root]);
+}
+
 TVM_REGISTER_GLOBAL("node.SaveJSON").set_body_typed(SaveJSON);
 
 TVM_REGISTER_GLOBAL("node.LoadJSON").set_body_typed(LoadJSON);
+
+TVM_REGISTER_GLOBAL("node.SaveBinary").set_body([](TVMArgs args, TVMRetValue* rv) {
+  ObjectRef node = args[0];
+  std::string data;
+  dmlc::MemoryStringStream strm(&data);
+  SaveBinary(&strm, node);
+  TVMByteArray arr;
+  arr.data = data.c_str();
+  arr.size = data.length();
+  *rv = arr;
+});
+
+TVM_REGISTER_GLOBAL("node.LoadBinary").set_body_typed([](std::string data) {
+  dmlc::MemoryStringStream strm(&data);
+  return LoadBinary(&strm);
+});
+
+// A stream reading or writing a file through its buffer.
+class BinaryFileStream : public dmlc::Stream {
+ public:
+  BinaryFileStream(const std::string& path, std::ios::openmode mode)
+      : fs_(path, mode | std::ios::binary) {
+    ICHECK(fs_) << "Cannot open " << path;
+  }
+  size_t Read(void* ptr, size_t size) final {
+    fs_.read(static_cast<char*>(ptr), size);
+    return static_cast<size_t>(fs_.gcount());
+  }
+  void Write(const void* ptr, size_t size) final {
+    fs_.write(static_cast<const char*>(ptr), size);
+    ICHECK(fs_) << "Failed to write the stream";
+  }
+
+ private:
+  std::fstream fs_;
+};
+
+TVM_REGISTER_GLOBAL("node.SaveBinaryToFile").set_body_typed([](ObjectRef node, String path) {
+  BinaryFileStream strm(path, std::ios::out | std::ios::trunc);
+  SaveBinary(&strm, node);
+});
+
+TVM_REGISTER_GLOBAL("node.LoadBinaryFromFile").set_body_typed([](String path) {
+  BinaryFileStream strm(path, std::ios::in);
+  return LoadBinary(&strm);
+});
 }  // namespace tvm
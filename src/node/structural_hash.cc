@@ -28,6 +28,8 @@
 #include <tvm/runtime/registry.h>
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
 
 #include "../support/str_escape.h"
@@ -45,6 +47,89 @@ void ReflectionVTable::SHashReduce(const Object* self, SHashReducer reducer) con
   fshash_reduce_[tindex](self, reducer);
 }
 
+/*!
+ * \brief The process-wide cache of hash values, see StructuralHash::SetCacheCapacity.
+ *
+ *  An entry keeps a reference to its object, so the address of a cached
+ *  object is not reused while the entry lives.
+ */
+class SHashCache {
+ public:
+  static SHashCache* Global() {
+    static SHashCache* inst = new SHashCache();
+    return inst;
+  }
+
+  bool enabled() const { return capacity_.load(std::memory_order_relaxed) != 0; }
+
+  void SetCapacity(size_t capacity) {
+    std::unordered_map<const Object*, Entry> dropped;
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    if (capacity == 0) entries_.swap(dropped);
+  }
+
+  /*!
+   * \brief Look up the hash of an object.
+   * \param object The object.
+   * \param map_free_vars Whether free variables are mapped.
+   * \param root Whether the object is hashed from the root, where the hash of
+   *  objects depending on their context can be used.
+   * \param hash The hash value found.
+   * \return Whether a hash value was found.
+   */
+  bool Lookup(const Object* object, bool map_free_vars, bool root, size_t* hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(object);
+    if (it == entries_.end()) return false;
+    const Entry& entry = it->second;
+    if (entry.context_free || (root && entry.has_hash[map_free_vars])) {
+      *hash = entry.hash[map_free_vars];
+      return true;
+    }
+    return false;
+  }
+
+  /*!
+   * \brief Add the hash of an object.
+   * \param object The object.
+   * \param map_free_vars Whether free variables are mapped.
+   * \param hash The hash value.
+   * \param context_free Whether the hash does not depend on the context of the
+   *  object, it is then valid for both values of map_free_vars.
+   */
+  void Insert(const ObjectRef& object, bool map_free_vars, size_t hash, bool context_free) {
+    std::unordered_map<const Object*, Entry> dropped;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0) return;
+    if (entries_.size() >= capacity_ && !entries_.count(object.get())) {
+      // Destroy the old entries after unlocking, they may free large objects.
+      entries_.swap(dropped);
+    }
+    Entry& entry = entries_[object.get()];
+    entry.object = object;
+    entry.context_free = context_free;
+    for (int i = 0; i < 2; ++i) {
+      if (context_free || i == static_cast<int>(map_free_vars)) {
+        entry.hash[i] = hash;
+        entry.has_hash[i] = true;
+      }
+    }
+  }
+
+ private:
+  struct Entry {
+    ObjectRef object;
+    size_t hash[2] = {0, 0};
+    bool has_hash[2] = {false, false};
+    bool context_free{false};
+  };
+
+  std::atomic<size_t> capacity_{0};
+  std::mutex mutex_;
+  std::unordered_map<const Object*, Entry> entries_;
+};
+
 // Hash handler that handles free vars
 // by assigning an unique counter in the order of their ocurrence.
 //
@@ -54,6 +139,18 @@ void ReflectionVTable::SHashReduce(const Object* self, SHashReducer reducer) con
 
 class VarCountingSHashHandler : public SHashReducer::Handler {
  public:
+  /*! \brief The hash of an object and what it was computed from. */
+  struct Result {
+    /*! \brief The hash value. */
+    size_t hash;
+    /*!
+     * \brief Whether the hash does not depend on the free variables and graph
+     *  nodes visited before, so it is the same wherever the object is hashed.
+     */
+    bool context_free;
+    /*! \brief The number of objects visited to compute the hash. */
+    size_t num_nodes;
+  };
   /*! \brief Pending reduce tasks. */
   struct Task {
     /*!
@@ -72,10 +169,19 @@ class VarCountingSHashHandler : public SHashReducer::Handler {
     bool graph_node_hash{false};
     /*! \brief whether to map the free variables. */
     bool map_free_vars;
+    /*! \brief Whether the hash does not depend on the context, see Result. */
+    bool context_free{true};
+    /*! \brief The number of objects visited to compute the hash. */
+    size_t num_nodes{0};
 
     Task() = default;
     explicit Task(ObjectRef object, size_t reduced_hash, bool map_free_vars)
         : object(object), reduced_hash(reduced_hash), map_free_vars(map_free_vars) {}
+    explicit Task(const Result& result)
+        : reduced_hash(result.hash),
+          map_free_vars(false),
+          context_free(result.context_free),
+          num_nodes(result.num_nodes) {}
   };
 
   VarCountingSHashHandler() {}
@@ -89,7 +195,7 @@ class VarCountingSHashHandler : public SHashReducer::Handler {
   bool LookupHashedValue(const ObjectRef& key, size_t* hash_value) final {
     auto it = hash_memo_.find(key);
     if (it != hash_memo_.end()) {
-      hash_value[0] = it->second;
+      hash_value[0] = it->second.hash;
       return true;
     }
     return false;
@@ -110,6 +216,7 @@ class VarCountingSHashHandler : public SHashReducer::Handler {
       size_t value = std::hash<const runtime::Object*>()(var);
       pending_tasks_.emplace_back(Task(ObjectRef(nullptr), value, false));
     }
+    pending_tasks_.back().context_free = false;
   }
 
   void SHashReduce(const ObjectRef& object, bool map_free_vars) final {
@@ -122,7 +229,7 @@ class VarCountingSHashHandler : public SHashReducer::Handler {
     }
     auto it = hash_memo_.find(object);
     if (it != hash_memo_.end()) {
-      pending_tasks_.emplace_back(Task(ObjectRef(nullptr), it->second, false));
+      pending_tasks_.emplace_back(Task(it->second));
     } else {
       // Push a pending task with initial value.
       pending_tasks_.emplace_back(Task(object, object->GetTypeKeyHash(), map_free_vars));
@@ -143,7 +250,7 @@ class VarCountingSHashHandler : public SHashReducer::Handler {
     this->RunTasks();
 
     ICHECK_EQ(result_stack_.size(), 1U);
-    size_t ret = result_stack_.back();
+    size_t ret = result_stack_.back().hash;
     result_stack_.pop_back();
     return ret;
   }
@@ -154,24 +261,27 @@ class VarCountingSHashHandler : public SHashReducer::Handler {
    */
   void PopTaskStack() {
     const auto& entry = task_stack_.back();
-    result_stack_.push_back(entry.reduced_hash);
+    result_stack_.push_back(Result{entry.reduced_hash, entry.context_free, entry.num_nodes});
     task_stack_.pop_back();
   }
   /*!
    * \brief Compute the reduced hash value for the task.
    * \param task The indicated task.
    */
-  size_t ReduceHash(const Task& task) {
+  Result ReduceHash(const Task& task) {
     size_t stack_begin = task.result_stack_index;
     ICHECK_LE(stack_begin, result_stack_.size());
 
     // combine in the reverse order of the stack.
-    size_t reduced_hash = task.reduced_hash;
+    Result reduced{task.reduced_hash, true, 1};
     for (size_t i = result_stack_.size(); i != stack_begin; --i) {
-      reduced_hash = support::HashCombine(reduced_hash, result_stack_[i - 1]);
+      const Result& child = result_stack_[i - 1];
+      reduced.hash = support::HashCombine(reduced.hash, child.hash);
+      reduced.context_free = reduced.context_free && child.context_free;
+      reduced.num_nodes += child.num_nodes;
     }
     result_stack_.resize(stack_begin);
-    return reduced_hash;
+    return reduced;
   }
   // run the tasks.
   void RunTasks() {
@@ -180,22 +290,27 @@ class VarCountingSHashHandler : public SHashReducer::Handler {
       auto& entry = task_stack_.back();
       if (entry.children_expanded) {
         // reduce hash
-        entry.reduced_hash = ReduceHash(entry);
+        Result result = ReduceHash(entry);
         // When all the children has expanded and visited.
-        // entry.reduced_hash contains the reduced hash result.
+        // result contains the reduced hash result.
         auto it = hash_memo_.find(entry.object);
         if (it != hash_memo_.end()) {
           // use the pre-computed hash for the object.
-          entry.reduced_hash = it->second;
+          result = it->second;
         } else {
           // Append the graph node counter to the hash
           // so that we can distinguish DAG from trees.
           if (entry.graph_node_hash) {
-            entry.reduced_hash = support::HashCombine(entry.reduced_hash,
-                                                      std::hash<size_t>()(graph_node_counter_++));
+            result.hash =
+                support::HashCombine(result.hash, std::hash<size_t>()(graph_node_counter_++));
+            result.context_free = false;
           }
-          hash_memo_[entry.object] = entry.reduced_hash;
+          hash_memo_[entry.object] = result;
+          this->UpdateCache(entry, result);
         }
+        entry.reduced_hash = result.hash;
+        entry.context_free = result.context_free;
+        entry.num_nodes = result.num_nodes;
         // send value to parent.
         this->PopTaskStack();
       } else if (!entry.object.defined()) {
@@ -204,8 +319,19 @@ class VarCountingSHashHandler : public SHashReducer::Handler {
       } else {
         // check if there are already hash for object.
         auto it = hash_memo_.find(entry.object);
+        size_t cached_hash;
         if (it != hash_memo_.end()) {
-          entry.reduced_hash = it->second;
+          entry.reduced_hash = it->second.hash;
+          entry.context_free = it->second.context_free;
+          entry.num_nodes = it->second.num_nodes;
+          this->PopTaskStack();
+        } else if (cache_->enabled() && cache_->Lookup(entry.object.get(), entry.map_free_vars,
+                                                       task_stack_.size() == 1, &cached_hash)) {
+          // Only context free hashes are found below the root, so they do not
+          // need the counters to be advanced.
+          entry.reduced_hash = cached_hash;
+          entry.num_nodes = 1;
+          hash_memo_[entry.object] = Result{cached_hash, true, 1};
           this->PopTaskStack();
         } else {
           // NOTE: important to modify entry before visit.
@@ -228,6 +354,18 @@ class VarCountingSHashHandler : public SHashReducer::Handler {
     }
   }
 
+  // Keep the hash of a large object in the cache if it can be reused.
+  void UpdateCache(const Task& task, const Result& result) {
+    // Small objects are cheaper to hash again than to look up.
+    constexpr size_t kMinCachedNodes = 16;
+    if (!cache_->enabled() || result.num_nodes < kMinCachedNodes) return;
+    bool root = task_stack_.size() == 1;
+    if (!result.context_free && !root) return;
+    static const uint32_t module_tindex = Object::TypeKey2Index("IRModule");
+    if (task.object->type_index() == module_tindex) return;
+    cache_->Insert(task.object, task.map_free_vars, result.hash, result.context_free);
+  }
+
   // The default equal as registered in the structural equal vtable.
   void DispatchSHash(const ObjectRef& object, bool map_free_vars) {
     ICHECK(object.defined());
@@ -246,11 +384,13 @@ class VarCountingSHashHandler : public SHashReducer::Handler {
   // Internal task stack to executed the task
   std::vector<Task> task_stack_;
   // Internal stack to store the result poped from the task stack.
-  std::vector<size_t> result_stack_;
+  std::vector<Result> result_stack_;
   // reflection vtable
   ReflectionVTable* vtable_ = ReflectionVTable::Global();
+  // the process-wide hash cache
+  SHashCache* cache_ = SHashCache::Global();
   // map from lhs to rhs
-  std::unordered_map<ObjectRef, size_t, ObjectPtrHash, ObjectPtrEqual> hash_memo_;
+  std::unordered_map<ObjectRef, Result, ObjectPtrHash, ObjectPtrEqual> hash_memo_;
 };
 
 TVM_REGISTER_GLOBAL("node.StructuralHash")
@@ -259,10 +399,23 @@ TVM_REGISTER_GLOBAL("node.StructuralHash")
       return static_cast<int64_t>(hashed_value);
     });
 
+TVM_REGISTER_GLOBAL("node.StructuralHashSetCacheCapacity").set_body_typed([](int64_t capacity) {
+  ICHECK_GE(capacity, 0);
+  StructuralHash::SetCacheCapacity(static_cast<size_t>(capacity));
+});
+
 size_t StructuralHash::operator()(const ObjectRef& object) const {
   return VarCountingSHashHandler().Hash(object, false);
 }
 
+size_t StructuralHash::operator()(const ObjectRef& object, bool map_free_vars) const {
+  return VarCountingSHashHandler().Hash(object, map_free_vars);
+}
+
+void StructuralHash::SetCacheCapacity(size_t capacity) {
+  SHashCache::Global()->SetCapacity(capacity);
+}
+
 // SEQualReduce traits for runtime containers.
 struct StringObjTrait {
   static constexpr const std::nullptr_t VisitAttrs = nullptr;
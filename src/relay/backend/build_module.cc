@@ -391,8 +391,13 @@ class RelayBuildModule : public runtime::ModuleNode {
       relay_module = RunDeviceAnnotationPass(relay_module, fallback_dev->value);
     }
 
-    // Fuse the operations if it is needed.
-    relay_module = transform::FuseOps()(relay_module);
+    // Fuse the operations if it is needed, the cost model of FuseOps depends on the target.
+    if (targets.size() == 1) {
+      With<Target> tctx((*targets.begin()).second);
+      relay_module = transform::FuseOps()(relay_module);
+    } else {
+      relay_module = transform::FuseOps()(relay_module);
+    }
 
     // Do layout rewrite for auto-scheduler.
     if (backend::IsAutoSchedulerEnabled() && targets.size() == 1) {
@@ -307,6 +307,9 @@ class GraphExecutorCodegen : public backend::MemoizedExprTranslator<std::vector<
       storage_ids.push_back(v);
     }
     node->attrs_["storage_id"] = std::move(storage_ids);
+    if (!storage_info->storage_offsets.empty()) {
+      node->attrs_["storage_offset"] = storage_info->storage_offsets;
+    }
     // type
     std::vector<int64_t> device_types;
     for (auto v : storage_info->device_types) {
@@ -429,6 +432,25 @@ class GraphExecutorCodegen : public backend::MemoizedExprTranslator<std::vector<
       return AddNode(node, GetRef<Expr>(op));
     }
 
+    // Record the workspace allocations of the kernel, which the executor reserves before the
+    // first run. Those inside parallel loops are made by the threads running the loop.
+    auto it = function_metadata_.find(func_name);
+    if (it != function_metadata_.end()) {
+      for (bool in_parallel_loop : {false, true}) {
+        std::string sizes;
+        for (const auto& kv : (*it).second->tir_primfuncs) {
+          Integer alignment = kv.first->GetAttr<Integer>("workspace_byte_alignment").value_or(16);
+          for (const Integer& size :
+               tir::CalculateWorkspaceAllocations(kv.second, alignment, in_parallel_loop)) {
+            sizes += (sizes.empty() ? "" : ",") + std::to_string(size->value);
+          }
+        }
+        if (!sizes.empty()) {
+          attrs[in_parallel_loop ? "parallel_workspace_bytes" : "workspace_bytes"] = sizes;
+        }
+      }
+    }
+
     // Compute the operator name, because we used the get unique name when generating the kernel.
     auto op_name = _GetUniqueName(func_name);
     auto node = GraphOpNode::make_node_ptr(op_name, GraphAttrs(), func_name, inputs, attrs);
@@ -513,6 +535,7 @@ class GraphExecutorCodegen : public backend::MemoizedExprTranslator<std::vector<
     size_t num_entry = 0;
     ShapeVector shapes;
     std::vector<size_t> storage_ids;
+    std::vector<size_t> storage_offsets;
     std::vector<size_t> device_types;
     std::vector<std::string> dltypes;
     std::vector<size_t> node_row_ptr{0};
@@ -527,6 +550,10 @@ class GraphExecutorCodegen : public backend::MemoizedExprTranslator<std::vector<
       shapes.insert(shapes.end(), shape_vec.begin(), shape_vec.end());
       dltypes.insert(dltypes.end(), dtype_vec.begin(), dtype_vec.end());
       storage_ids.insert(storage_ids.end(), storage_id.begin(), storage_id.end());
+      if (node->attrs_.count("storage_offset")) {
+        const auto& offsets = dmlc::get<std::vector<int64_t>>(node->attrs_["storage_offset"]);
+        storage_offsets.insert(storage_offsets.end(), offsets.begin(), offsets.end());
+      }
       if (node->attrs_.count("device_index")) {
         const auto& dev_types = dmlc::get<std::vector<int64_t>>(node->attrs_["device_index"]);
         device_types.insert(device_types.end(), dev_types.begin(), dev_types.end());
@@ -542,6 +569,11 @@ class GraphExecutorCodegen : public backend::MemoizedExprTranslator<std::vector<
     attrs["shape"].emplace_back(shapes);
     attrs["storage_id"].emplace_back(std::string("list_int"));
     attrs["storage_id"].emplace_back(storage_ids);
+    if (storage_offsets.size()) {
+      ICHECK_EQ(storage_offsets.size(), storage_ids.size());
+      attrs["storage_offset"].emplace_back(std::string("list_int"));
+      attrs["storage_offset"].emplace_back(storage_offsets);
+    }
     if (device_types.size()) {
       attrs["device_index"].emplace_back(std::string("list_int"));
       attrs["device_index"].emplace_back(device_types);
@@ -27,8 +27,14 @@
 #include <tvm/relay/expr.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/transform.h>
+#include <tvm/runtime/device_api.h>
 #include <tvm/tir/op.h>
 
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <vector>
+
 #include "../../support/arena.h"
 #include "./utils.h"
 
@@ -51,6 +57,14 @@ struct StorageToken {
   int device_type{0};
   /*! \brief The storage id */
   int64_t storage_id{-1};
+  /*! \brief The step allocating the token, for the offset planner. */
+  int alloc_step{0};
+  /*! \brief The step releasing the token, for the offset planner. */
+  int free_step{std::numeric_limits<int>::max()};
+  /*! \brief The byte offset in the arena, for the offset planner. */
+  size_t offset{0};
+  /*! \brief Whether the token is placed in the arena of its device. */
+  bool in_arena{false};
 };
 
 std::ostream& operator<<(std::ostream& os, StorageToken tok) {
@@ -201,15 +215,29 @@ class StorageAllocaInit : protected StorageAllocaBaseVisitor {
   Map<Expr, Integer> node_device_map_;
 };
 
+/*!
+ * \brief Storage allocator.
+ *
+ *  By default every storage token is its own allocation, and a token freed by
+ *  the operators is reused for a later tensor of a similar size. With offsets,
+ *  the allocator instead records when each intermediate tensor is live, and
+ *  packs all of them into one arena per device, placing each tensor at an
+ *  offset that no tensor live at the same time overlaps.
+ */
 class StorageAllocator : public StorageAllocaBaseVisitor {
  public:
+  explicit StorageAllocator(bool use_offsets = false) : use_offsets_(use_offsets) {}
+
   /*!
    * \return totoal number of bytes allocated
    */
   size_t TotalAllocBytes() const {
     size_t total = 0;
     for (const auto* p : data_) {
-      total += p->max_bytes;
+      if (!p->in_arena) total += p->max_bytes;
+    }
+    for (const auto& kv : arena_bytes_) {
+      total += kv.second;
     }
     return total;
   }
@@ -218,6 +246,9 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
   StaticMemoryPlan Plan(const Function& func) {
     prototype_ = StorageAllocaInit(&arena_).GetInitTokenMap(func);
     this->Run(func);
+    if (use_offsets_) {
+      this->PackArenas();
+    }
 
     // The value of smap contains two integer arrays where the first array
     // contains the planned storage ids and the second holds the device types.
@@ -229,6 +260,7 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
       std::vector<int64_t> storage_ids;
       std::vector<DLDeviceType> device_types;
       std::vector<int64_t> sid_sizes_byte;
+      std::vector<int64_t> sid_offsets;
 
       for (StorageToken* tok : kv.second) {
         if (tok->device_type) {
@@ -238,8 +270,12 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
         storage_ids.push_back(tok->storage_id);
         device_types.push_back(static_cast<DLDeviceType>(tok->device_type));
         sid_sizes_byte.push_back(GetMemorySize(tok));
+        if (use_offsets_) {
+          sid_offsets.push_back(static_cast<int64_t>(tok->offset));
+        }
       }
-      auto storage_info = backend::StorageInfo(storage_ids, device_types, sid_sizes_byte);
+      auto storage_info =
+          backend::StorageInfo(storage_ids, device_types, sid_sizes_byte, sid_offsets);
       smap.Set(GetRef<Expr>(kv.first), storage_info);
     }
     // Either all or none of the nodes should be annotated.
@@ -309,6 +345,7 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
     //
     // TODO(tvm-team) Update checks of flat memory enablement when we support
     // opaque-nd memory planning to skip this path.
+    ++step_;
     if (IsReshape(op)) {
       // TODO(@electriclilies, jroesch): This check is failing because the size of args is 3
       // I can't figure out where the extra args are coming from, I assume it must be related
@@ -384,6 +421,13 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
   StorageToken* Request(StorageToken* prototype) {
     // calculate the size;
     size_t size = GetMemorySize(prototype);
+    if (use_offsets_) {
+      // Every tensor gets a token, PackArenas places them.
+      StorageToken* tok = this->Alloc(prototype, size);
+      tok->alloc_step = step_;
+      tok->in_arena = true;
+      return tok;
+    }
     // search memory block in [size / match_range_, size * match_range_)
     if (match_range_ == 0) {
       return this->Alloc(prototype, size);
@@ -438,15 +482,87 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
     ICHECK_GE(tok->storage_id, 0);
     ICHECK_GE(tok->ref_counter, 0);
     if (tok->ref_counter == 0) {
-      free_.insert({tok->max_bytes, tok});
+      if (use_offsets_) {
+        tok->free_step = step_;
+      } else {
+        free_.insert({tok->max_bytes, tok});
+      }
     }
   }
+  /*!
+   * \brief Place the arena tokens of each device in one storage.
+   *
+   *  The tokens are placed from the largest to the smallest. Each one goes to
+   *  the smallest gap left between the tokens placed so far that are live at the
+   *  same time, or after all of them if no gap is large enough. The storage ids
+   *  are renumbered, each arena taking the id of its first token.
+   */
+  void PackArenas() {
+    std::map<int, std::vector<StorageToken*>> groups;
+    for (StorageToken* tok : data_) {
+      if (tok->in_arena) groups[tok->device_type].push_back(tok);
+    }
+    for (auto& kv : groups) {
+      std::vector<StorageToken*>& toks = kv.second;
+      std::stable_sort(toks.begin(), toks.end(), [](StorageToken* lhs, StorageToken* rhs) {
+        return lhs->max_bytes > rhs->max_bytes;
+      });
+      std::vector<StorageToken*> placed;
+      size_t arena_bytes = 0;
+      for (StorageToken* tok : toks) {
+        std::vector<StorageToken*> live;
+        for (StorageToken* other : placed) {
+          if (other->alloc_step <= tok->free_step && tok->alloc_step <= other->free_step) {
+            live.push_back(other);
+          }
+        }
+        std::sort(live.begin(), live.end(),
+                  [](StorageToken* lhs, StorageToken* rhs) { return lhs->offset < rhs->offset; });
+        size_t best_offset = 0, best_gap = std::numeric_limits<size_t>::max();
+        size_t cursor = 0;
+        for (StorageToken* other : live) {
+          size_t begin = AlignUp(cursor);
+          if (other->offset >= begin + tok->max_bytes && other->offset - begin < best_gap) {
+            best_offset = begin;
+            best_gap = other->offset - begin;
+          }
+          cursor = std::max(cursor, other->offset + other->max_bytes);
+        }
+        tok->offset = best_gap == std::numeric_limits<size_t>::max() ? AlignUp(cursor) : best_offset;
+        arena_bytes = std::max(arena_bytes, tok->offset + tok->max_bytes);
+        placed.push_back(tok);
+      }
+      arena_bytes_[kv.first] = arena_bytes;
+    }
+    std::map<int, int64_t> arena_ids;
+    int64_t num_storages = 0;
+    for (StorageToken* tok : data_) {
+      if (!tok->in_arena) {
+        tok->storage_id = num_storages++;
+      } else if (arena_ids.count(tok->device_type)) {
+        tok->storage_id = arena_ids[tok->device_type];
+      } else {
+        tok->storage_id = arena_ids[tok->device_type] = num_storages++;
+      }
+    }
+  }
+  /*! \brief Round an offset up to the alignment of the allocations. */
+  static size_t AlignUp(size_t offset) {
+    size_t align = runtime::kAllocAlignment;
+    return (offset + align - 1) / align * align;
+  }
 
  private:
   // allocator
   support::Arena arena_;
   // scale used for rough match
   size_t match_range_{16};
+  // whether tokens are packed into arenas at offsets
+  bool use_offsets_;
+  // the number of calls visited
+  int step_{0};
+  // the size of the arena of each device type
+  std::map<int, size_t> arena_bytes_;
   // free list of storage entry
   std::multimap<size_t, StorageToken*> free_;
   // all the storage resources available
@@ -455,9 +571,23 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
   std::unordered_map<const ExprNode*, std::vector<StorageToken*> > prototype_;
 };
 
-StaticMemoryPlan GraphPlanMemory(const Function& func) { return StorageAllocator().Plan(func); }
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.GraphPlanMemory.use_offsets", Bool);
+
+StaticMemoryPlan GraphPlanMemory(const Function& func) {
+  bool use_offsets = transform::PassContext::Current()
+                         ->GetConfig<Bool>("relay.GraphPlanMemory.use_offsets", Bool(false))
+                         .value();
+  return StorageAllocator(use_offsets).Plan(func);
+}
 
 TVM_REGISTER_GLOBAL("relay.backend.GraphPlanMemory").set_body_typed(GraphPlanMemory);
 
+TVM_REGISTER_GLOBAL("relay.backend.GraphPlanMemoryTotalBytes")
+    .set_body_typed([](const Function& func, bool use_offsets) {
+      StorageAllocator allocator(use_offsets);
+      allocator.Plan(func);
+      return static_cast<int64_t>(allocator.TotalAllocBytes());
+    });
+
 }  // namespace relay
 }  // namespace tvm
@@ -32,6 +32,10 @@
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/object.h>
 
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "../transforms/pass_utils.h"
 #include "compile_engine.h"
 #include "te_compiler.h"
@@ -115,16 +119,71 @@ TVM_STATIC_IR_FUNCTOR(ReprPrinter, vtable)
       p->stream << "ConstructorValueObj(" << node->tag << "," << node->fields << ")";
     });
 
+/*!
+ * \brief The numbering of the variables bound in the frames of a function.
+ *
+ * A variable gets the next slot the first time it is bound in a frame of the
+ * function, so the frames of later calls are flat arrays indexed by slot.
+ */
+struct FrameLayout {
+  /*! \brief The slot of each variable. */
+  std::unordered_map<const VarNode*, size_t> slots;
+  /*! \brief The variables, in slot order. */
+  std::vector<Var> vars;
+
+  /*! \return The slot of var, numbering it if it has none. */
+  size_t Slot(const Var& var) {
+    auto it = slots.find(var.get());
+    if (it != slots.end()) {
+      return it->second;
+    }
+    slots.emplace(var.get(), vars.size());
+    vars.push_back(var);
+    return vars.size() - 1;
+  }
+};
+
 /*!
  * \brief A stack frame in the Relay interpreter.
  *
  * Contains a mapping from relay::Var to relay::ObjectRef.
  */
 struct Frame {
-  /*! \brief The set of local variables and arguments for the frame. */
-  tvm::Map<Var, ObjectRef> locals;
+  /*! \brief The numbering of the variables of the frame. */
+  FrameLayout* layout;
+  /*! \brief The local variables and arguments for the frame, by slot. */
+  std::vector<ObjectRef> locals;
+
+  explicit Frame(FrameLayout* layout) : layout(layout), locals(layout->vars.size()) {}
+
+  void Set(const Var& var, ObjectRef value) {
+    size_t slot = layout->Slot(var);
+    if (slot >= locals.size()) {
+      locals.resize(layout->vars.size());
+    }
+    locals[slot] = std::move(value);
+  }
+
+  /*! \return The value of var, nullptr if it is not bound in the frame. */
+  const ObjectRef* Find(const Var& var) const {
+    auto it = layout->slots.find(var.get());
+    if (it == layout->slots.end() || it->second >= locals.size() ||
+        !locals[it->second].defined()) {
+      return nullptr;
+    }
+    return &locals[it->second];
+  }
 
-  explicit Frame(tvm::Map<Var, ObjectRef> locals) : locals(locals) {}
+  /*! \return The bound variables of the frame and their values. */
+  tvm::Map<Var, ObjectRef> ToMap() const {
+    tvm::Map<Var, ObjectRef> map;
+    for (size_t i = 0; i < locals.size(); ++i) {
+      if (locals[i].defined()) {
+        map.Set(layout->vars[i], locals[i]);
+      }
+    }
+    return map;
+  }
 };
 
 /*!
@@ -134,17 +193,20 @@ struct Frame {
  * a function call.
  */
 struct Stack {
+  /*! \brief The numbering of the variables bound outside of any function. */
+  FrameLayout global_layout;
   /*! \brief The stack frames. */
   std::vector<Frame> frames;
-  Stack() : frames() { frames.push_back(Frame({})); }
+  Stack() : frames() { frames.emplace_back(&global_layout); }
+  Stack(const Stack&) = delete;
+  Stack& operator=(const Stack&) = delete;
 
   Frame& current_frame() { return frames.back(); }
 
   ObjectRef Lookup(const Var& local) {
     for (auto frame = frames.rbegin(); frame != frames.rend(); frame++) {
-      auto elem = frame->locals.find(local);
-      if (elem != frame->locals.end()) {
-        return (*elem).second;
+      if (const ObjectRef* value = frame->Find(local)) {
+        return *value;
       }
     }
 
@@ -158,7 +220,7 @@ struct Stack {
    */
   struct LocalFrame {
     Stack& st;
-    explicit LocalFrame(Stack& st, const Frame& fr) : st(st) { st.frames.push_back(fr); }
+    explicit LocalFrame(Stack& st, Frame fr) : st(st) { st.frames.push_back(std::move(fr)); }
     ~LocalFrame() { st.frames.pop_back(); }
   };
 };
@@ -218,12 +280,12 @@ class Interpreter : public ExprFunctor<ObjectRef(const Expr& n)>,
       : mod_(mod), device_(device), target_(target), debug_op_(Op::Get("debug")) {}
 
   template <typename T>
-  T WithFrame(const Frame& fr, const std::function<T()>& f) {
-    Stack::LocalFrame lf(stack_, fr);
+  T WithFrame(Frame fr, const std::function<T()>& f) {
+    Stack::LocalFrame lf(stack_, std::move(fr));
     return f();
   }
 
-  void extend(const Var& id, ObjectRef v) { stack_.current_frame().locals.Set(id, v); }
+  void extend(const Var& id, ObjectRef v) { stack_.current_frame().Set(id, std::move(v)); }
 
   ObjectRef Lookup(const Var& local) { return stack_.Lookup(local); }
 
@@ -232,7 +294,15 @@ class Interpreter : public ExprFunctor<ObjectRef(const Expr& n)>,
   ObjectRef VisitExpr_(const VarNode* var_node) final { return Lookup(GetRef<Var>(var_node)); }
 
   ObjectRef VisitExpr_(const GlobalVarNode* op) final {
-    return Eval(mod_->Lookup(GetRef<GlobalVar>(op)));
+    // The global functions have no free variables, so their closures are made once.
+    auto gv = GetRef<GlobalVar>(op);
+    auto it = global_closures_.find(gv);
+    if (it != global_closures_.end()) {
+      return it->second;
+    }
+    ObjectRef closure = Eval(mod_->Lookup(gv));
+    global_closures_.emplace(gv, closure);
+    return closure;
   }
 
   ObjectRef VisitExpr_(const OpNode* id) override {
@@ -258,7 +328,11 @@ class Interpreter : public ExprFunctor<ObjectRef(const Expr& n)>,
 
   ObjectRef MakeClosure(const Function& func, Var letrec_name = Var()) {
     tvm::Map<Var, ObjectRef> captured_mod;
-    Array<Var> free_vars = FreeVars(func);
+    auto it = free_vars_.find(func);
+    if (it == free_vars_.end()) {
+      it = free_vars_.emplace(func, FreeVars(func)).first;
+    }
+    const Array<Var>& free_vars = it->second;
 
     for (const auto& var : free_vars) {
       // Evaluate the free var (which could be a function call) if it hasn't
@@ -284,8 +358,21 @@ class Interpreter : public ExprFunctor<ObjectRef(const Expr& n)>,
   }
 
   Array<Shape> ComputeDynamicShape(const Function& func, const Array<ObjectRef>& args) {
-    CCacheKey key(func, Target("llvm"));
-    auto cfunc = compiler_->LowerShapeFunc(key);
+    auto it = shape_funcs_.find(func);
+    if (it == shape_funcs_.end()) {
+      CCacheKey key(func, Target("llvm"));
+      auto cfunc = compiler_->LowerShapeFunc(key);
+      Module m;
+      if (const auto* f = runtime::Registry::Get("relay.backend.build")) {
+        m = (*f)(cfunc->funcs, cfunc->target);
+      } else {
+        m = build(cfunc->funcs, cfunc->target, Target(nullptr));
+      }
+      PackedFunc shape_func = m.GetFunction(cfunc->prim_fn_var->name_hint);
+      it = shape_funcs_.emplace(func, std::make_pair(cfunc, shape_func)).first;
+    }
+    const CachedFunc& cfunc = it->second.first;
+    const PackedFunc& shape_func = it->second.second;
     size_t arity = cfunc->inputs.size() + cfunc->outputs.size();
 
     std::vector<TVMValue> values(arity);
@@ -373,15 +460,7 @@ class Interpreter : public ExprFunctor<ObjectRef(const Expr& n)>,
     }
     ICHECK_EQ(cfunc->outputs.size(), out_cnt) << "Shape function output sizes mismatch";
 
-    PackedFunc shape_func;
-    Module m;
     TVMRetValue rv;
-    if (const auto* f = runtime::Registry::Get("relay.backend.build")) {
-      m = (*f)(cfunc->funcs, cfunc->target);
-    } else {
-      m = build(cfunc->funcs, cfunc->target, Target(nullptr));
-    }
-    shape_func = m.GetFunction(cfunc->prim_fn_var->name_hint);
     shape_func.CallPacked(TVMArgs(values.data(), codes.data(), arity), &rv);
 
     // Get output shapes
@@ -484,7 +563,12 @@ class Interpreter : public ExprFunctor<ObjectRef(const Expr& n)>,
       out_shapes = ComputeDynamicShape(func, args);
     }
 
-    PackedFunc packed_func = compiler_->JIT(CCacheKey(func, target_));
+    // Lower each call site once, the compiler cache hashes the function structurally.
+    auto it = prim_funcs_.find(func);
+    if (it == prim_funcs_.end()) {
+      it = prim_funcs_.emplace(func, compiler_->JIT(CCacheKey(func, target_))).first;
+    }
+    const PackedFunc& packed_func = it->second;
     TVMRetValue rv;
     if (const TupleTypeNode* rtype = func->body->checked_type().as<TupleTypeNode>()) {
       ICHECK(!is_dyn || out_shapes.size() == rtype->fields.size());
@@ -524,26 +608,26 @@ class Interpreter : public ExprFunctor<ObjectRef(const Expr& n)>,
     }
     auto func = closure->func;
     // Allocate a frame with the parameters and free variables.
-    tvm::Map<Var, ObjectRef> locals;
+    Frame frame(&layouts_[func]);
 
     ICHECK_EQ(func->params.size(), args.size());
 
     for (size_t i = 0; i < func->params.size(); i++) {
-      ICHECK_EQ(locals.count(func->params[i]), 0);
-      locals.Set(func->params[i], args[i]);
+      ICHECK(frame.Find(func->params[i]) == nullptr);
+      frame.Set(func->params[i], args[i]);
     }
 
     // Add the var to value mappings from the Closure's environment.
     for (auto it = closure->env.begin(); it != closure->env.end(); ++it) {
-      ICHECK_EQ(locals.count((*it).first), 0);
-      locals.Set((*it).first, (*it).second);
+      ICHECK(frame.Find((*it).first) == nullptr);
+      frame.Set((*it).first, (*it).second);
     }
 
     if (bind.defined()) {
-      locals.Set(bind, RecClosure(closure, bind));
+      frame.Set(bind, RecClosure(closure, bind));
     }
 
-    return WithFrame<ObjectRef>(Frame(locals), [&]() { return Eval(func->body); });
+    return WithFrame<ObjectRef>(std::move(frame), [&]() { return Eval(func->body); });
   }
 
   ObjectRef VisitExpr_(const CallNode* call) final {
@@ -691,9 +775,8 @@ class Interpreter : public ExprFunctor<ObjectRef(const Expr& n)>,
 
   InterpreterState get_state(Expr e = Expr()) const {
     InterpreterStateObj::Stack stack;
-    for (auto fr : this->stack_.frames) {
-      InterpreterStateObj::Frame frame = fr.locals;
-      stack.push_back(frame);
+    for (const auto& fr : this->stack_.frames) {
+      stack.push_back(fr.ToMap());
     }
     auto state = InterpreterState(e, stack);
     return state;
@@ -713,6 +796,17 @@ class Interpreter : public ExprFunctor<ObjectRef(const Expr& n)>,
   TECompiler compiler_;
   // Cache ops that need to be frequently used later to reduce lookup overhead.
   const Op& debug_op_;
+  // The numbering of the variables of each function called.
+  std::unordered_map<Function, FrameLayout, ObjectPtrHash, ObjectPtrEqual> layouts_;
+  // The free variables of each function turned into a closure.
+  std::unordered_map<Function, Array<Var>, ObjectPtrHash, ObjectPtrEqual> free_vars_;
+  // The closures of the global functions.
+  std::unordered_map<GlobalVar, ObjectRef, ObjectPtrHash, ObjectPtrEqual> global_closures_;
+  // The compiled primitive functions, by call site.
+  std::unordered_map<Function, PackedFunc, ObjectPtrHash, ObjectPtrEqual> prim_funcs_;
+  // The lowered and compiled shape functions of the dynamic primitive functions.
+  std::unordered_map<Function, std::pair<CachedFunc, PackedFunc>, ObjectPtrHash, ObjectPtrEqual>
+      shape_funcs_;
 };
 
 TypedPackedFunc<ObjectRef(Expr)> CreateInterpreter(IRModule mod, Device device, Target target) {
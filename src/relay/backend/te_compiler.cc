@@ -30,12 +30,15 @@
 #include <tvm/relay/op_attr_types.h>
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
 #include <tvm/te/operation.h>
 #include <tvm/te/schedule.h>
 #include <tvm/te/schedule_pass.h>
 #include <tvm/topi/tags.h>
 
+#include <exception>
 #include <functional>
+#include <future>
 #include <limits>
 #include <mutex>
 #include <tuple>
@@ -59,6 +62,8 @@ using namespace tvm::relay::transform;
 
 TVM_REGISTER_OBJECT_TYPE(TECompilerNode);
 
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.parallel_lowering", Bool);
+
 class TECompilerImpl : public TECompilerNode {
  public:
   // Lower the function.
@@ -171,52 +176,191 @@ class TECompilerImpl : public TECompilerNode {
  private:
   // implement lowered func
   CCacheValue LowerInternal(const CCacheKey& key, std::function<String(String)> mangle_fn) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
     CCacheValue value;
     auto it = cache_.find(key);
     if (it != cache_.end()) {
       it->second->use_count += 1;
-      if (it->second->cached_func.defined()) return it->second;
       value = it->second;
     } else {
       value = CCacheValue(make_object<CCacheValueNode>());
       value->use_count = 1;
       cache_[key] = value;
     }
+    // Wait for the thread working on the same function, rethrowing its error.
+    for (auto in_flight = in_flight_.find(key); in_flight != in_flight_.end();
+         in_flight = in_flight_.find(key)) {
+      std::shared_future<void> future = in_flight->second;
+      lock.unlock();
+      future.get();
+      lock.lock();
+    }
+    if (value->cached_func.defined()) return value;
     cur_ccache_key_ = key;
 
+    CachedFunc cfunc;
+    CompileCacheEntry entry;
+    auto prepared = prepared_.find(key);
+    if (prepared != prepared_.end()) {
+      cfunc = prepared->second.first;
+      entry = prepared->second.second;
+      prepared_.erase(prepared);
+    }
+    // Lower without the lock, so that other functions are lowered at the same time.
+    std::promise<void> done;
+    in_flight_[key] = done.get_future().share();
+    lock.unlock();
+    try {
+      if (!cfunc.defined()) {
+        cfunc = CreateSchedule(key, mangle_fn, &entry);
+      }
+      if (NeedsLowerSchedule(key, cfunc)) {
+        // Enforce use the target.
+        With<Target> target_scope(key->target);
+        LowerSchedule(cfunc);
+        SaveCachedFunc(key, entry, cfunc);
+      }
+    } catch (...) {
+      lock.lock();
+      in_flight_.erase(key);
+      done.set_exception(std::current_exception());
+      throw;
+    }
+    lock.lock();
+    value->cached_func = cfunc;
+    in_flight_.erase(key);
+    done.set_value();
+    return value;
+  }
+
+  void Prepare(const CCacheKey& key, const String mod_name) final {
+    auto mangle_fn = [mod_name](String name) { return runtime::get_name_mangled(mod_name, name); };
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cache_.count(key)) return;
+    CCacheValue value = CCacheValue(make_object<CCacheValueNode>());
+    value->use_count = 0;
+    cache_[key] = value;
+    std::promise<void> done;
+    in_flight_[key] = done.get_future().share();
+    lock.unlock();
+    CachedFunc cfunc;
+    CompileCacheEntry entry;
+    try {
+      cfunc = CreateSchedule(key, mangle_fn, &entry);
+    } catch (...) {
+      lock.lock();
+      in_flight_.erase(key);
+      done.set_exception(std::current_exception());
+      throw;
+    }
+    lock.lock();
+    if (NeedsLowerSchedule(key, cfunc)) {
+      prepared_[key] = {cfunc, entry};
+    } else {
+      value->cached_func = cfunc;
+    }
+    in_flight_.erase(key);
+    done.set_value();
+  }
+
+  void LowerPrepared() final {
+    std::vector<std::pair<CCacheValue, std::pair<CachedFunc, CompileCacheEntry>>> work;
+    std::vector<CCacheKey> keys;
+    std::vector<std::promise<void>> done;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& kv : prepared_) {
+        keys.push_back(kv.first);
+        work.emplace_back(cache_.at(kv.first), kv.second);
+      }
+      prepared_.clear();
+      done.resize(keys.size());
+      for (size_t i = 0; i < keys.size(); ++i) {
+        in_flight_[keys[i]] = done[i].get_future().share();
+      }
+    }
+    // The workers lower under the pass context of the caller, its configuration
+    // decides the lowering passes.
+    using tvm::transform::PassContext;
+    PassContext pass_ctx = PassContext::Current();
+    std::vector<std::exception_ptr> errors(work.size());
+    support::parallel_for(0, static_cast<int>(work.size()), [&](int i) {
+      try {
+        With<PassContext> pass_ctx_scope(pass_ctx);
+        With<Target> target_scope(keys[i]->target);
+        LowerSchedule(work[i].second.first);
+        SaveCachedFunc(keys[i], work[i].second.second, work[i].second.first);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < work.size(); ++i) {
+      in_flight_.erase(keys[i]);
+      if (errors[i]) {
+        done[i].set_exception(errors[i]);
+      } else {
+        work[i].first->cached_func = work[i].second.first;
+        done[i].set_value();
+      }
+    }
+    for (const auto& error : errors) {
+      if (error) std::rethrow_exception(error);
+    }
+  }
+
+  // Create the schedule of the function, or the whole result for external functions and
+  // functions found in the on-disk cache. Entry is set to the on-disk cache entry of the
+  // function and the name given to the renamer.
+  CachedFunc CreateSchedule(const CCacheKey& key, std::function<String(String)> mangle_fn,
+                            CompileCacheEntry* entry) {
     // No need to lower external functions for now. We will invoke the external
     // codegen tool once and lower all functions together.
     if (key->source_func->GetAttr<String>(attr::kCompiler).defined()) {
       auto ir_module = IRModule();
       const auto name_node = key->source_func->GetAttr<String>(tvm::attr::kGlobalSymbol);
       ICHECK(name_node.defined()) << "External function has not been attached a name yet.";
-      auto func_name = GetUniqueName(name_node.value(), &name_map_);
+      auto func_name = GetUniqueFuncName(name_node.value());
       auto target = Target("ext_dev");
       auto global_var = GlobalVar(func_name);
       global_var->checked_type_ = key->source_func->checked_type();
-      value->cached_func = CachedFunc(target, global_var, {}, {}, te::Schedule(), {}, ir_module);
-      return value;
+      return CachedFunc(target, global_var, {}, {}, te::Schedule(), {}, ir_module);
     }
 
+    auto renamer = [&](std::string candidate) {
+      entry->name = candidate;
+      auto mangled = mangle_fn(candidate);
+      return GetUniqueFuncName(mangled);
+    };
+    if (NeedsLowerSchedule(key)) {
+      // The entry depends on the pass and dispatch contexts of this thread.
+      *entry = GetCompileCacheEntry(key);
+      CachedFunc cfunc = LoadCachedFunc(key, *entry, renamer);
+      if (cfunc.defined()) return cfunc;
+    }
     // Enforce use the target.
     With<Target> target_scope(key->target);
+    return PrimFuncFor(key->source_func, key->target, renamer);
+  }
 
-    ICHECK(!value->cached_func.defined());
-    auto cfunc = PrimFuncFor(key->source_func, key->target, [&](std::string name) {
-      auto mangled = mangle_fn(name);
-      return GetUniqueName(mangled, &name_map_);
-    });
-
+  // Whether the schedule of the function is lowered to TIR.
+  static bool NeedsLowerSchedule(const CCacheKey& key) {
+    if (key->source_func->GetAttr<String>(attr::kCompiler).defined()) return false;
     // Skip lowering for device copy node.
     const Expr body = (key->source_func)->body;
     if (const CallNode* call_node = body.as<CallNode>()) {
-      if (call_node->attrs.as<DeviceCopyAttrs>()) {
-        value->cached_func = cfunc;
-        return value;
-      }
+      if (call_node->attrs.as<DeviceCopyAttrs>()) return false;
     }
+    return true;
+  }
 
+  // Whether the created function still needs to be lowered to TIR.
+  static bool NeedsLowerSchedule(const CCacheKey& key, const CachedFunc& cfunc) {
+    return NeedsLowerSchedule(key) && cfunc->funcs->functions.empty();
+  }
+
+  // Lower the schedule of the function under the current target.
+  static void LowerSchedule(const CachedFunc& cfunc) {
     // NOTE: array will copy on write.
     Array<te::Tensor> all_args = Array<te::Tensor>(cfunc->inputs);
     for (te::Tensor arg : cfunc->outputs) {
@@ -226,8 +370,11 @@ class TECompilerImpl : public TECompilerNode {
     std::unordered_map<te::Tensor, tir::Buffer> binds;
     auto func_name = cfunc->prim_fn_var->name_hint;
     cfunc->funcs->Update(tvm::LowerSchedule(cfunc->schedule, all_args, func_name, binds));
-    value->cached_func = cfunc;
-    return value;
+  }
+
+  std::string GetUniqueFuncName(const std::string& name) {
+    std::lock_guard<std::mutex> lock(name_mutex_);
+    return GetUniqueName(name, &name_map_);
   }
 
   // implement lowered shape func
@@ -252,7 +399,7 @@ class TECompilerImpl : public TECompilerNode {
     using tvm::transform::PassContext;
     With<PassContext> fresh_pass_ctx_scope(PassContext::Create());
     auto cached_func = ShapeFuncFor(key->source_func, key->target, [&](std::string name) {
-      return GetUniqueName(name, &name_map_);
+      return GetUniqueFuncName(name);
     });
 
     value->cached_func = cached_func;
@@ -271,10 +418,16 @@ class TECompilerImpl : public TECompilerNode {
 
   /*! \brief compiler cache lock*/
   std::mutex mutex_;
+  /*! \brief the lock of name_map_ */
+  std::mutex name_mutex_;
   /*! \brief internal name map to get an unique name */
   std::unordered_map<std::string, int> name_map_;
   /*! \brief internal compiler cache */
   std::unordered_map<CCacheKey, CCacheValue> cache_;
+  /*! \brief the functions being lowered, completed once they are in the cache */
+  std::unordered_map<CCacheKey, std::shared_future<void>> in_flight_;
+  /*! \brief the functions created by Prepare and not lowered yet, with their cache entry */
+  std::unordered_map<CCacheKey, std::pair<CachedFunc, CompileCacheEntry>> prepared_;
   /*! \brief internal compiler cache for shape funcs */
   std::unordered_map<CCacheKey, CCacheValue> shape_func_cache_;
   /*! \brief the cache key of the function that is being lowered currently*/
@@ -305,14 +458,27 @@ std::tuple<bool, int, int> IsDeviceCopy(const Function& func) {
 
 class LowerTensorExpr : public ExprMutator {
  public:
+  /*!
+   * \param prepare Only create the schedules of the primitive functions with
+   *  TECompilerNode::Prepare, leaving the function unchanged.
+   */
   LowerTensorExpr(const IRModule& module, const TargetMap& targets, const DeviceMap& device_ctx_map,
-                  ProcessFn process_fn, const String& module_name, TECompiler compiler)
+                  ProcessFn process_fn, const String& module_name, TECompiler compiler,
+                  bool prepare = false)
       : module_(module),
         targets_(targets),
         device_context_map_(device_ctx_map),
         process_fn(process_fn),
         module_name_(module_name),
-        compiler_(compiler) {}
+        compiler_(compiler),
+        prepare_(prepare) {}
+
+  /*! \brief Create the schedules of the primitive functions called by func and lower them. */
+  void Prepare(const Function& func) {
+    ICHECK(prepare_);
+    VisitExpr(func);
+    compiler_->LowerPrepared();
+  }
 
   Expr VisitExpr_(const CallNode* call) override {
     Call expr = GetRef<Call>(call);
@@ -327,7 +493,7 @@ class LowerTensorExpr : public ExprMutator {
     if (!func->HasNonzeroAttr(attr::kPrimitive)) {
       // Provide a callback hook which allows one-level up code generators to
       // act when we process a function.
-      this->process_fn(func);
+      if (!prepare_) this->process_fn(func);
       return ExprMutator::VisitExpr_(call);
     }
 
@@ -342,6 +508,10 @@ class LowerTensorExpr : public ExprMutator {
     if (func->GetAttr<String>(attr::kCompiler).defined()) {
       target = Target("ext_dev");
       CCacheKey key = CCacheKey(func, target);
+      if (prepare_) {
+        compiler_->Prepare(key, module_name_);
+        return std::move(expr);
+      }
       CachedFunc ext_func = compiler_->Lower(key, module_name_);
       ICHECK(ext_func.defined()) << "Lowering returned undefined function for "
                                  << ext_func->prim_fn_var->name_hint;
@@ -409,6 +579,10 @@ class LowerTensorExpr : public ExprMutator {
     }
 
     CCacheKey key = CCacheKey(func, target);
+    if (prepare_) {
+      compiler_->Prepare(key, module_name_);
+      return std::move(expr);
+    }
     CachedFunc lowered_func = compiler_->Lower(key, module_name_);
 
     Map<GlobalVar, tir::PrimFunc> prim_fns;
@@ -453,6 +627,7 @@ class LowerTensorExpr : public ExprMutator {
   ProcessFn process_fn;
   String module_name_;
   TECompiler compiler_;
+  bool prepare_;
 };
 
 /*!
@@ -690,6 +865,17 @@ void UpdateFunctionMetadata(Function relay_func,
   function_metadata.Set(prim_fn_var.value()->name_hint, fi);
 }
 
+/*!
+ * \brief Whether the primitive functions can be lowered on several threads.
+ *  Pass instruments and lowering passes may be Python functions, which only
+ *  run on the calling thread.
+ */
+bool ParallelLoweringEnabled(const PassContext& ctx) {
+  if (!ctx->GetConfig<Bool>("relay.backend.parallel_lowering", Bool(true)).value()) return false;
+  if (ctx->instruments.size() != 0) return false;
+  return !ctx->GetConfig<Array<Array<ObjectRef>>>("tir.add_lower_pass").defined();
+}
+
 LoweredModule LowerTE(const IRModule& module, TargetMap targets, DeviceMap device_context_map,
                       backend::StaticMemoryPlan memory_plan, const String& module_name,
                       std::function<void(Function)> process_fn) {
@@ -700,6 +886,14 @@ LoweredModule LowerTE(const IRModule& module, TargetMap targets, DeviceMap devic
 
   auto pass = CreateFunctionPass(
       [=](Function func, IRModule module, PassContext ctx) {
+        if (ParallelLoweringEnabled(ctx)) {
+          // Create the schedules in the order of the sequential lowering, which
+          // names the functions, then lower them all at once. The lowering
+          // below only collects the results from the cache.
+          LowerTensorExpr prepare_te(module, targets, device_context_map, process_fn,
+                                     module_name, compiler, true);
+          prepare_te.Prepare(func);
+        }
         LowerTensorExpr lower_te(module, targets, device_context_map, process_fn, module_name,
                                  compiler);
         return Downcast<Function>(lower_te.VisitExpr(func));
@@ -96,6 +96,21 @@ class TECompilerNode : public Object {
    */
   virtual CachedFunc Lower(const CCacheKey& key, const String mod_name) = 0;
 
+  /*!
+   * \brief Create the schedule of a function without lowering it, which is
+   *  left to LowerPrepared. Names are given in the order of the calls, the
+   *  same as if the functions were lowered one by one.
+   * \param key The key to the cached function.
+   * \param mod_name The module name used to mangle the function name.
+   */
+  virtual void Prepare(const CCacheKey& key, const String mod_name) = 0;
+
+  /*!
+   * \brief Lower the functions created by Prepare concurrently. Lower returns
+   *  them from the cache afterwards.
+   */
+  virtual void LowerPrepared() = 0;
+
   /* Return all functions which have been lowered by the compiler, keyed by target. */
   virtual Map<String, IRModule> GetLoweredFunctions() = 0;
 
@@ -20,9 +20,12 @@
 #include "./te_compiler_cache.h"
 
 #include <tvm/driver/driver_api.h>
+#include <tvm/ir/transform.h>
 #include <tvm/ir/type_functor.h>
+#include <tvm/node/serialization.h>
 #include <tvm/relay/analysis.h>
 #include <tvm/relay/attrs/device_copy.h>
+#include <tvm/relay/attrs/nn.h>
 #include <tvm/relay/expr.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/op.h>
@@ -32,11 +35,25 @@
 #include <tvm/te/operation.h>
 #include <tvm/te/schedule.h>
 #include <tvm/te/schedule_pass.h>
+#include <tvm/tir/data_layout.h>
 #include <tvm/topi/tags.h>
 
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
 #include <functional>
+#include <iterator>
 #include <limits>
+#include <map>
 #include <mutex>
+#include <random>
+#include <sstream>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -138,6 +155,7 @@ class ScheduleBuilder : public backend::MemoizedExprTranslator<Array<te::Tensor>
       memo_[param] = inputs;
     }
     readable_name_stream_ << "fused";
+    fused_producer_ = prim_func->HasNonzeroAttr(attr::kFusedProducer);
     auto outputs = this->VisitExpr(prim_func->body);
     auto candidate_name = readable_name_stream_.str();
     constexpr static size_t kMaxFuncNameLength = 80;
@@ -183,10 +201,25 @@ class ScheduleBuilder : public backend::MemoizedExprTranslator<Array<te::Tensor>
         }
       }
 
+      // The TOPI schedules handle a single anchor, tile several ones across the layers.
+      if (!schedule.defined() && num_anchors_ > 1) {
+        schedule = CrossLayerSchedule(tensor_outs);
+      }
       // Use TOPI schdule if user specificed, or the function has no auto_scheduler schedule.
       if (!schedule.defined()) {
         ICHECK(anchor_implementation_.defined());
         schedule = anchor_implementation_.Schedule(anchor_attrs_, tensor_outs, target_);
+        if (fused_producer_) {
+          // The TOPI schedules expect the inputs of the anchor as is, inline the ops fused
+          // before it by the cost model of FuseOps.
+          for (const te::Operation& op : anchor_producers_) {
+            const auto* compute = op.as<te::ComputeOpNode>();
+            if (compute != nullptr && compute->reduce_axis.empty() && schedule->Contain(op) &&
+                !schedule[op]->is_output) {
+              schedule[op].compute_inline();
+            }
+          }
+        }
       }
       for (const auto& scalar : scalars_) {
         if (schedule->Contain(scalar)) {
@@ -270,15 +303,20 @@ class ScheduleBuilder : public backend::MemoizedExprTranslator<Array<te::Tensor>
 
     int op_pattern = fpattern[op];
     if (!use_auto_scheduler_ && op_pattern >= kCommReduce) {
-      ICHECK(!anchor_op_.defined() || anchor_op_pattern_ < kCommReduce)
+      ICHECK(fused_producer_ || !anchor_op_.defined() || anchor_op_pattern_ < kCommReduce)
           << "Cannot apply TOPI schedule to a primitive function with two complicated ops"
           << " anchor=" << anchor_op_ << " current=" << op;
+      ++num_anchors_;
     }
     if (op_pattern >= anchor_op_pattern_) {
       anchor_op_ = op;
       anchor_attrs_ = call_node->attrs;
       anchor_op_pattern_ = op_pattern;
       anchor_implementation_ = impl;
+      anchor_producers_ = visited_ops_;
+    }
+    for (const te::Tensor& tensor : outputs) {
+      if (tensor->op.defined()) visited_ops_.push_back(tensor->op);
     }
     if (outputs.size() != 1) {
       const auto* tuple_type = call_node->checked_type().as<TupleTypeNode>();
@@ -298,6 +336,66 @@ class ScheduleBuilder : public backend::MemoizedExprTranslator<Array<te::Tensor>
     return outputs;
   }
 
+  /*!
+   * \brief Schedule a function in which FuseOps fused several anchor ops, such as conv2d ->
+   *  conv2d. The rows of the output are computed in parallel, each computing the rows of the
+   *  anchors it needs, so the intermediate tensors stay in small per-row buffers.
+   */
+  te::Schedule CrossLayerSchedule(const Array<te::Tensor>& outs) {
+    ICHECK_EQ(target_->kind->device_type, kDLCPU)
+        << "Functions fused from several anchor ops are only supported on CPU, anchor="
+        << anchor_op_;
+    Array<te::Operation> out_ops;
+    for (const te::Tensor& tensor : outs) {
+      out_ops.push_back(tensor->op);
+    }
+    te::Schedule s = te::create_schedule(out_ops);
+    for (te::Stage stage : s->stages) {
+      const auto* compute = stage->op.as<te::ComputeOpNode>();
+      if (compute != nullptr && compute->reduce_axis.empty() && !stage->is_output) {
+        stage.compute_inline();
+      }
+    }
+    const auto* out = outs[0]->op.as<te::ComputeOpNode>();
+    if (outs.size() != 1 || out == nullptr) return s;
+    // The batch and row axes of the output, from the layout of the last anchor.
+    int batch_axis = -1, row_axis = 0;
+    if (const auto* attrs = anchor_attrs_.as<Conv2DAttrs>()) {
+      tir::Layout layout(attrs->out_layout.empty() ? attrs->data_layout : attrs->out_layout);
+      batch_axis = layout.IndexOf(tir::LayoutAxis::Get('N'));
+      row_axis = layout.IndexOf(tir::LayoutAxis::Get('H'));
+    } else if (anchor_attrs_.as<BatchMatmulAttrs>()) {
+      batch_axis = 0;
+      row_axis = 1;
+    }
+    int ndim = static_cast<int>(out->axis.size());
+    if (row_axis < 0 || row_axis >= ndim || batch_axis >= ndim) return s;
+    te::Stage out_stage = s[outs[0]->op];
+    tir::IterVar rows = out->axis[row_axis];
+    if (batch_axis >= 0 && batch_axis != row_axis) {
+      Array<tir::IterVar> order{out->axis[batch_axis], out->axis[row_axis]};
+      for (int i = 0; i < ndim; ++i) {
+        if (i != batch_axis && i != row_axis) order.push_back(out->axis[i]);
+      }
+      out_stage.reorder(order);
+      out_stage.fuse(out->axis[batch_axis], out->axis[row_axis], &rows);
+    } else if (row_axis != 0) {
+      Array<tir::IterVar> order{out->axis[row_axis]};
+      for (int i = 0; i < ndim; ++i) {
+        if (i != row_axis) order.push_back(out->axis[i]);
+      }
+      out_stage.reorder(order);
+    }
+    out_stage.parallel(rows);
+    for (te::Stage stage : s->stages) {
+      const auto* compute = stage->op.as<te::ComputeOpNode>();
+      if (compute != nullptr && !compute->reduce_axis.empty() && !stage->is_output) {
+        stage.compute_at(out_stage, rows);
+      }
+    }
+    return s;
+  }
+
   Array<te::Tensor> VisitExpr_(const FunctionNode* op) final {
     LOG(FATAL) << "Primitive Functions can not contain nested functions.";
     return Array<te::Tensor>();
@@ -336,6 +434,14 @@ class ScheduleBuilder : public backend::MemoizedExprTranslator<Array<te::Tensor>
   Attrs anchor_attrs_;
   int anchor_op_pattern_{0};
   OpImplementation anchor_implementation_;
+  /*! \brief Whether FuseOps fused the producers of the anchor with its cost model. */
+  bool fused_producer_{false};
+  /*! \brief The number of ops with reduction in the function. */
+  int num_anchors_{0};
+  /*! \brief The ops computed before the anchor. */
+  Array<te::Operation> anchor_producers_;
+  /*! \brief The ops computed so far. */
+  Array<te::Operation> visited_ops_;
   std::ostringstream readable_name_stream_;
   Array<te::Operation> scalars_;
   bool use_auto_scheduler_;
@@ -689,6 +795,153 @@ std::string GetUniqueName(std::string name, std::unordered_map<std::string, int>
   return name;
 }
 
+/*! \brief The pass config option enabling the on-disk compile cache. */
+constexpr const char* kCompileCacheDir = "relay.backend.compile_cache_dir";
+
+TVM_REGISTER_PASS_CONFIG_OPTION(kCompileCacheDir, String);
+
+/*! \brief The statistics of the on-disk compile cache in this process. */
+static std::atomic<int64_t> compile_cache_hits{0};
+static std::atomic<int64_t> compile_cache_misses{0};
+
+/*! \brief Whether a pass config value holds passes, whose bodies SaveJSON does not keep. */
+static bool HoldsPass(const ObjectRef& value) {
+  if (value->IsInstance<transform::PassNode>()) return true;
+  if (const auto* array = value.as<ArrayNode>()) {
+    for (const ObjectRef& elem : *array) {
+      if (elem.defined() && HoldsPass(elem)) return true;
+    }
+  }
+  return false;
+}
+
+CompileCacheEntry GetCompileCacheEntry(const CCacheKey& key) {
+  CompileCacheEntry entry;
+  transform::PassContext pass_ctx = transform::PassContext::Current();
+  Optional<String> dir = pass_ctx->GetConfig<String>(kCompileCacheDir);
+  if (!dir.defined() || dir.value().empty() || backend::IsAutoSchedulerEnabled()) return entry;
+  std::ostringstream os;
+  os << "version " << TVM_VERSION << "\n"
+     << "target " << key->target->str() << "\n"
+     << "opt_level " << pass_ctx->opt_level << "\n";
+  for (const String& name : pass_ctx->required_pass) {
+    os << "required_pass " << name << "\n";
+  }
+  for (const String& name : pass_ctx->disabled_pass) {
+    os << "disabled_pass " << name << "\n";
+  }
+  // Sort the options so that the header does not depend on their order.
+  std::map<std::string, std::string> config;
+  for (const auto& kv : pass_ctx->config) {
+    if (kv.first == kCompileCacheDir) continue;
+    // Custom passes, such as tir.add_lower_pass, would all be saved alike.
+    if (HoldsPass(kv.second)) return entry;
+    config[kv.first] = SaveJSON(kv.second);
+  }
+  for (const auto& kv : config) {
+    os << kv.first << " " << kv.second << "\n";
+  }
+  // AutoTVM picks the configs of the tunable ops from the dispatch context of the caller.
+  if (const auto* fdispatch = runtime::Registry::Get("autotvm.dispatch_context_fingerprint")) {
+    std::string dispatch = (*fdispatch)();
+    if (dispatch.empty()) return entry;
+    os << "autotvm " << dispatch << "\n";
+  }
+  entry.header = os.str();
+  size_t hash = dmlc::HashCombine(tvm::StructuralHash()(key->source_func),
+                                  std::hash<std::string>()(entry.header));
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.json", static_cast<unsigned long long>(hash));
+  entry.path = std::string(dir.value()) + "/" + name;
+  return entry;
+}
+
+CachedFunc LoadCachedFunc(const CCacheKey& key, const CompileCacheEntry& entry,
+                          std::function<std::string(std::string)> renamer) {
+  if (entry.path.empty()) return CachedFunc();
+  Map<String, ObjectRef> saved;
+  std::ifstream fs(entry.path, std::ios::in);
+  if (fs) {
+    std::string json((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
+    try {
+      saved = Downcast<Map<String, ObjectRef>>(LoadJSON(json));
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "Ignoring the unreadable compile cache entry " << entry.path << ": "
+                   << e.what();
+    }
+  }
+  // Entries of different functions with the same hash are told apart by their source.
+  if (!saved.count("header") || Downcast<String>(saved["header"]) != entry.header ||
+      !saved.count("inputs") || !tvm::StructuralEqual()(saved["source"], key->source_func)) {
+    ++compile_cache_misses;
+    return CachedFunc();
+  }
+  ++compile_cache_hits;
+
+  std::string name = renamer(Downcast<String>(saved["name"]));
+  auto prim_fn_var = GlobalVar(name);
+  prim_fn_var->checked_type_ = key->source_func->checked_type();
+  IRModule saved_funcs = Downcast<IRModule>(saved["funcs"]);
+  ICHECK_EQ(saved_funcs->functions.size(), 1U);
+  auto prim_func = Downcast<tir::PrimFunc>((*saved_funcs->functions.begin()).second);
+  prim_func = WithAttr(std::move(prim_func), tvm::attr::kGlobalSymbol, String(name));
+  IRModule funcs = IRModule(Map<GlobalVar, BaseFunc>({{GlobalVar(name), prim_func}}));
+  return CachedFunc(key->target, prim_fn_var, Downcast<Array<te::Tensor>>(saved["inputs"]),
+                    Downcast<Array<te::Tensor>>(saved["outputs"]), te::Schedule(), {}, funcs);
+}
+
+void SaveCachedFunc(const CCacheKey& key, const CompileCacheEntry& entry, const CachedFunc& cfunc) {
+  if (entry.path.empty() || cfunc->funcs->functions.size() != 1) return;
+  const std::string& path = entry.path;
+  std::string dir = path.substr(0, path.rfind('/'));
+#if defined(_WIN32)
+  _mkdir(dir.c_str());
+#else
+  mkdir(dir.c_str(), 0777);
+#endif
+  // The outputs are saved as placeholders, their computation is lowered already.
+  Array<te::Tensor> outputs;
+  for (const te::Tensor& output : cfunc->outputs) {
+    outputs.push_back(te::placeholder(output->shape, output->dtype, output->op->name));
+  }
+  Map<String, ObjectRef> saved;
+  saved.Set("header", String(entry.header));
+  saved.Set("source", key->source_func);
+  saved.Set("name", String(entry.name));
+  saved.Set("inputs", cfunc->inputs);
+  saved.Set("outputs", outputs);
+  saved.Set("funcs", cfunc->funcs);
+  // Write to a file of our own and rename it, readers only see complete entries.
+  std::ostringstream tmp_path;
+  tmp_path << path << "." << std::hex << std::random_device()() << std::random_device()()
+           << ".tmp";
+  {
+    std::ofstream fs(tmp_path.str(), std::ios::out);
+    fs << SaveJSON(saved);
+    if (!fs) {
+      LOG(WARNING) << "Cannot write the compile cache entry " << tmp_path.str();
+      std::remove(tmp_path.str().c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_path.str().c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Cannot write the compile cache entry " << path;
+    std::remove(tmp_path.str().c_str());
+  }
+}
+
+TVM_REGISTER_GLOBAL("relay.backend._CompileCacheStats").set_body_typed([]() {
+  Map<String, Integer> stats;
+  stats.Set("hits", Integer(static_cast<int>(compile_cache_hits.load())));
+  stats.Set("misses", Integer(static_cast<int>(compile_cache_misses.load())));
+  return stats;
+});
+
+TVM_REGISTER_GLOBAL("relay.backend._ResetCompileCacheStats").set_body_typed([]() {
+  compile_cache_hits = 0;
+  compile_cache_misses = 0;
+});
+
 }  // namespace tec
 }  // namespace relay
 }  // namespace tvm
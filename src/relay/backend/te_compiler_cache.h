@@ -215,6 +215,55 @@ CachedFunc ShapeFuncFor(const Function& prim_func, const Target& target,
 
 std::string GetUniqueName(std::string name, std::unordered_map<std::string, int>* name_map);
 
+/*! \brief The on-disk compile cache entry of a function. */
+struct CompileCacheEntry {
+  /*! \brief The path of the entry, empty when the cache is not used for the function. */
+  std::string path;
+  /*! \brief What the lowering depends on besides the function. */
+  std::string header;
+  /*! \brief The name given to the renamer when the function was created. */
+  std::string name;
+};
+
+/*!
+ * \brief Get the on-disk compile cache entry of a function.
+ *
+ *  The cache is enabled by setting "relay.backend.compile_cache_dir" in the
+ *  pass context, and is shared by the processes using the same directory. An
+ *  entry holds the lowered TIR of a primitive function, keyed by the function,
+ *  the target, the pass context, the AutoTVM dispatch context and the TVM
+ *  version. The cache is not used while the auto-scheduler is enabled, under a
+ *  dispatch context whose configs cannot be described, or when the pass
+ *  context holds custom passes.
+ *
+ *  Must be called from the thread lowering under the pass context, as the
+ *  dispatch context is asked to the frontend.
+ *
+ * \param key The key of the function.
+ * \return The entry, with an empty path when the cache is not used.
+ */
+CompileCacheEntry GetCompileCacheEntry(const CCacheKey& key);
+
+/*!
+ * \brief Load a lowered function from the on-disk compile cache.
+ * \param key The key of the function.
+ * \param entry The entry of the function.
+ * \param renamer Make the name of the function from the name it was saved with.
+ * \return The function with its funcs, inputs and outputs populated, undefined
+ *  when there is no entry for key. The outputs only hold the shapes and types
+ *  of the results, and the schedule is undefined.
+ */
+CachedFunc LoadCachedFunc(const CCacheKey& key, const CompileCacheEntry& entry,
+                          std::function<std::string(std::string)> renamer);
+
+/*!
+ * \brief Save a lowered function to the on-disk compile cache.
+ * \param key The key of the function.
+ * \param entry The entry of the function, ignored if its path is empty.
+ * \param cfunc The lowered function.
+ */
+void SaveCachedFunc(const CCacheKey& key, const CompileCacheEntry& entry, const CachedFunc& cfunc);
+
 // implementations
 inline size_t CCacheKeyNode::Hash() const {
   if (hash_ != 0) return hash_;
@@ -31,11 +31,13 @@ namespace backend {
 TVM_REGISTER_NODE_TYPE(StorageInfoNode);
 
 StorageInfo::StorageInfo(std::vector<int64_t> storage_ids, std::vector<DLDeviceType> device_types,
-                         std::vector<int64_t> storage_sizes_in_bytes) {
+                         std::vector<int64_t> storage_sizes_in_bytes,
+                         std::vector<int64_t> storage_offsets) {
   auto n = make_object<StorageInfoNode>();
   n->storage_ids = std::move(storage_ids);
   n->device_types = std::move(device_types);
   n->storage_sizes_in_bytes = std::move(storage_sizes_in_bytes);
+  n->storage_offsets = std::move(storage_offsets);
   data_ = std::move(n);
 }
 
@@ -63,6 +65,14 @@ TVM_REGISTER_GLOBAL("relay.ir.StorageInfoStorageSizes").set_body_typed([](Storag
   return storage_sizes_in_bytes;
 });
 
+TVM_REGISTER_GLOBAL("relay.ir.StorageInfoStorageOffsets").set_body_typed([](StorageInfo si) {
+  Array<tvm::Integer> storage_offsets;
+  for (auto offset : si->storage_offsets) {
+    storage_offsets.push_back(offset);
+  }
+  return storage_offsets;
+});
+
 TVM_REGISTER_NODE_TYPE(StaticMemoryPlanNode);
 
 StaticMemoryPlan::StaticMemoryPlan(Map<Expr, StorageInfo> expr_to_storage_info) {
@@ -57,6 +57,8 @@ class StorageInfoNode : public Object {
   std::vector<DLDeviceType> device_types;
   /* \brief The sizes of each storage element. */
   std::vector<int64_t> storage_sizes_in_bytes;
+  /* \brief The byte offset of each element in its storage, empty if all are zero. */
+  std::vector<int64_t> storage_offsets;
 
   // TODO(@jroesch): expose the fields
   void VisitAttrs(AttrVisitor* v) {}
@@ -69,7 +71,8 @@ class StorageInfoNode : public Object {
 class StorageInfo : public ObjectRef {
  public:
   StorageInfo(std::vector<int64_t> storage_ids, std::vector<DLDeviceType> device_types,
-              std::vector<int64_t> storage_sizes_in_bytes);
+              std::vector<int64_t> storage_sizes_in_bytes,
+              std::vector<int64_t> storage_offsets = {});
   TVM_DEFINE_OBJECT_REF_METHODS(StorageInfo, ObjectRef, StorageInfoNode);
 };
 
@@ -1002,11 +1002,8 @@ transform::Sequential MemoryOpt(tvm::Target host_target, TargetsMap targets) {
   // Fuse the shape functions.
   pass_seqs.push_back(transform::FuseOps());
 
-  // TODO(mbrookhart, jroesch, masahi): this pass is very slow, and is
-  // incomplete to provide memory resuse optimizations. Disable it until we can
-  // rewrite it in C++ and complete it.
-  // // Perform memory planning in order to coalesce/reduce allocations.
-  // pass_seqs.push_back(transform::MemoryPlan());
+  // Reuse storage across allocations whose lifetimes do not overlap.
+  pass_seqs.push_back(transform::CoalesceStorage());
 
   // Compute away constant computation introduced by coalescing allocations.
   pass_seqs.push_back(transform::FoldConstant());
@@ -0,0 +1,325 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/relay/transforms/coalesce_storage.cc
+ * \brief Reuse the storage allocated by the VM dialect across values whose
+ * lifetimes do not overlap.
+ *
+ * After ManifestAlloc every intermediate tensor of a VM function is backed by
+ * its own `memory.alloc_storage`. This pass computes, for every let-chain, the
+ * live range of each storage (including all tensors and values that may alias
+ * it) and greedily assigns storages with disjoint live ranges to a shared
+ * allocation whose size is the maximum of its members. Storages with a
+ * symbolic size take part only when "relay.CoalesceStorage.dim_upper_bound"
+ * bounds every dynamic dimension. The bound is an assumption, so such a
+ * storage compares its actual size with the shared allocation at runtime and
+ * is allocated on its own when it does not fit.
+ */
+
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/attrs/memory.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/op.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/logging.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../op/memory/memory.h"
+#include "pattern_utils.h"
+
+namespace tvm {
+namespace relay {
+
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.CoalesceStorage.dim_upper_bound", Integer);
+
+class StorageCoalescer : public ExprMutator {
+ public:
+  explicit StorageCoalescer(int64_t dim_upper_bound) : dim_upper_bound_(dim_upper_bound) {}
+
+  Expr VisitExpr_(const FunctionNode* func) final {
+    // Primitive functions are lowered separately and never allocate storage.
+    if (func->HasNonzeroAttr(attr::kPrimitive)) {
+      return GetRef<Function>(func);
+    }
+    return ExprMutator::VisitExpr_(func);
+  }
+
+  Expr VisitExpr_(const LetNode* let) final {
+    // Flatten the let-chain iteratively to avoid deep recursion on long programs.
+    std::vector<std::pair<Var, Expr>> bindings;
+    Expr body = GetRef<Let>(let);
+    while (const auto* node = body.as<LetNode>()) {
+      bindings.emplace_back(node->var, VisitExpr(node->value));
+      body = node->body;
+    }
+    body = VisitExpr(body);
+    return Plan(bindings, body);
+  }
+
+ private:
+  /*! \brief A storage allocation found in the current let-chain. */
+  struct StorageInfo {
+    /*! \brief The binding index of the allocation. */
+    size_t def;
+    /*! \brief The last binding index at which the storage may be live. */
+    size_t last_use;
+    /*! \brief The size in bytes, or the upper bound of a symbolic size; -1 if unknown. */
+    int64_t size;
+    /*! \brief Whether the size is only known through an upper bound. */
+    bool dynamic;
+    int64_t alignment;
+    const AllocStorageAttrs* attrs;
+    /*! \brief The index of the slot the storage is assigned to. */
+    int slot{-1};
+  };
+
+  /*! \brief A planned allocation shared by storages with disjoint live ranges. */
+  struct Slot {
+    size_t leader;
+    size_t last_use;
+    int64_t size;
+    int num_members;
+  };
+
+  static bool IsOp(const Expr& expr, const Op& op) {
+    const auto* call = expr.as<CallNode>();
+    return call != nullptr && call->op.same_as(op);
+  }
+
+  static int64_t ConstantInt(const Expr& expr) {
+    const auto* constant = expr.as<ConstantNode>();
+    if (constant == nullptr || !constant->is_scalar()) return -1;
+    auto value = TryToScalar(constant->data);
+    return value ? static_cast<int64_t>(value.value()) : -1;
+  }
+
+  /*! \brief Upper bound of the bytes needed by an allocated tensor, or -1 if unbounded. */
+  int64_t TensorBytesBound(const AllocTensorAttrs* attrs) const {
+    int64_t elems = 1;
+    for (const auto& dim : attrs->assert_shape) {
+      if (const auto* imm = dim.as<IntImmNode>()) {
+        elems *= imm->value;
+      } else if (dim_upper_bound_ > 0) {
+        elems *= dim_upper_bound_;
+      } else {
+        return -1;
+      }
+    }
+    return elems * ((attrs->dtype.bits() * attrs->dtype.lanes() + 7) / 8);
+  }
+
+  Expr Plan(const std::vector<std::pair<Var, Expr>>& bindings, const Expr& body) {
+    static const Op& alloc_storage_op = Op::Get("memory.alloc_storage");
+    static const Op& alloc_tensor_op = Op::Get("memory.alloc_tensor");
+    static const Op& invoke_tvm_op = Op::Get("vm.invoke_tvm_op");
+    static const Op& shape_of_op = Op::Get("vm.shape_of");
+    static const Op& less_equal_op = Op::Get("less_equal");
+
+    std::vector<StorageInfo> storages;
+    // The storages each variable may alias.
+    std::unordered_map<const VarNode*, std::vector<size_t>> aliases;
+
+    auto extend = [&](const Expr& expr, size_t index, std::vector<size_t>* alias) {
+      for (const Var& var : FreeVars(expr)) {
+        auto it = aliases.find(var.get());
+        if (it == aliases.end()) continue;
+        for (size_t sid : it->second) {
+          storages[sid].last_use = std::max(storages[sid].last_use, index);
+          if (alias != nullptr) alias->push_back(sid);
+        }
+      }
+    };
+
+    for (size_t i = 0; i < bindings.size(); ++i) {
+      const Var& var = bindings[i].first;
+      const Expr& value = bindings[i].second;
+      if (IsOp(value, alloc_storage_op)) {
+        const auto* call = value.as<CallNode>();
+        StorageInfo info;
+        info.def = i;
+        info.last_use = i;
+        info.size = ConstantInt(call->args[0]);
+        info.dynamic = info.size < 0;
+        info.alignment = ConstantInt(call->args[1]);
+        info.attrs = call->attrs.as<AllocStorageAttrs>();
+        aliases[var.get()] = {storages.size()};
+        storages.push_back(info);
+        continue;
+      }
+      if (IsOp(value, alloc_tensor_op)) {
+        const auto* call = value.as<CallNode>();
+        std::vector<size_t> alias;
+        extend(value, i, &alias);
+        // The bound of a symbolic storage comes from the tensors placed in it.
+        const auto* attrs = call->attrs.as<AllocTensorAttrs>();
+        int64_t offset = ConstantInt(call->args[1]);
+        for (size_t sid : alias) {
+          if (!storages[sid].dynamic) continue;
+          int64_t bound = offset == 0 ? TensorBytesBound(attrs) : -1;
+          storages[sid].size = bound < 0 ? -1 : std::max(storages[sid].size, bound);
+          if (bound < 0) storages[sid].alignment = -1;
+        }
+        aliases[var.get()] = std::move(alias);
+        continue;
+      }
+      if (IsOp(value, invoke_tvm_op) || IsOp(value, shape_of_op)) {
+        // Kernels read their inputs and write their outputs in place; the result
+        // does not hold a reference to either.
+        extend(value, i, nullptr);
+        continue;
+      }
+      // Anything else (tuples, closures, calls, control flow, references) may
+      // retain its operands, so the bound variable conservatively aliases them.
+      std::vector<size_t> alias;
+      extend(value, i, &alias);
+      bool escapes = false;
+      PostOrderVisit(value, [&escapes](const Expr& e) {
+        if (e.as<RefCreateNode>() || e.as<RefWriteNode>()) escapes = true;
+      });
+      if (escapes) {
+        for (size_t sid : alias) storages[sid].last_use = bindings.size();
+      }
+      if (!alias.empty()) aliases[var.get()] = std::move(alias);
+    }
+    // Values reachable from the result outlive the let-chain.
+    extend(body, bindings.size(), nullptr);
+
+    // Greedily place every storage into the best fitting slot that is dead by
+    // the time the storage is allocated.
+    std::vector<Slot> slots;
+    bool changed = false;
+    for (size_t sid = 0; sid < storages.size(); ++sid) {
+      StorageInfo& info = storages[sid];
+      if (info.size < 0 || info.alignment <= 0 || info.attrs == nullptr) continue;
+      int best = -1;
+      for (size_t k = 0; k < slots.size(); ++k) {
+        const Slot& slot = slots[k];
+        const StorageInfo& leader = storages[slot.leader];
+        if (slot.last_use >= info.def || leader.alignment != info.alignment ||
+            leader.attrs->device_type != info.attrs->device_type ||
+            leader.attrs->device_id != info.attrs->device_id) {
+          continue;
+        }
+        if (best == -1) {
+          best = static_cast<int>(k);
+          continue;
+        }
+        // Prefer the smallest slot that fits, otherwise the largest one.
+        int64_t best_size = slots[best].size;
+        bool fits = slot.size >= info.size;
+        bool best_fits = best_size >= info.size;
+        if ((fits && (!best_fits || slot.size < best_size)) ||
+            (!fits && !best_fits && slot.size > best_size)) {
+          best = static_cast<int>(k);
+        }
+      }
+      if (best == -1) {
+        info.slot = static_cast<int>(slots.size());
+        slots.push_back(Slot{sid, info.last_use, info.size, 1});
+      } else {
+        Slot& slot = slots[best];
+        info.slot = best;
+        slot.last_use = info.last_use;
+        slot.size = std::max(slot.size, info.size);
+        slot.num_members += 1;
+        changed = true;
+      }
+    }
+
+    // Rebuild the let-chain: the leader of each shared slot allocates the
+    // planned size and the other members are replaced by the leader. A
+    // symbolic member only uses the shared allocation when its size fits.
+    std::unordered_map<Var, Expr, ObjectPtrHash, ObjectPtrEqual> subst;
+    std::vector<Var> slot_vars(slots.size());
+    size_t sid = 0;
+    std::vector<std::pair<Var, Expr>> planned;
+    planned.reserve(bindings.size());
+    for (const auto& binding : bindings) {
+      Expr value = binding.second;
+      if (changed && IsOp(value, alloc_storage_op)) {
+        size_t cur = sid++;
+        const StorageInfo& info = storages[cur];
+        if (info.slot != -1 && slots[info.slot].num_members > 1) {
+          const Slot& slot = slots[info.slot];
+          const auto* call = value.as<CallNode>();
+          Expr slot_size = MakeConstantScalar(DataType::Int(64), slot.size);
+          if (slot.leader == cur) {
+            Expr shared = Call(call->op, {slot_size, call->args[1]}, call->attrs, call->type_args,
+                               call->span);
+            slot_vars[info.slot] =
+                info.dynamic ? Var(binding.first->name_hint() + "_shared", Type(nullptr))
+                             : binding.first;
+            planned.emplace_back(slot_vars[info.slot], shared);
+            if (!info.dynamic) continue;
+          }
+          if (!info.dynamic) {
+            subst[binding.first] = slot_vars[info.slot];
+            planned.emplace_back(binding.first, Expr());
+            continue;
+          }
+          value = If(Call(less_equal_op, {call->args[0], slot_size}), slot_vars[info.slot], value);
+        }
+      } else if (!subst.empty()) {
+        value = Bind(value, subst);
+      }
+      planned.emplace_back(binding.first, value);
+    }
+    if (!changed) {
+      Expr ret = body;
+      for (auto it = bindings.rbegin(); it != bindings.rend(); ++it) {
+        ret = Let(it->first, it->second, ret);
+      }
+      return ret;
+    }
+    Expr ret = subst.empty() ? body : Bind(body, subst);
+    for (auto it = planned.rbegin(); it != planned.rend(); ++it) {
+      if (!it->second.defined()) continue;
+      ret = Let(it->first, it->second, ret);
+    }
+    return ret;
+  }
+
+  /*! \brief The assumed upper bound of every dynamic dimension, 0 if unknown. */
+  int64_t dim_upper_bound_;
+};
+
+namespace transform {
+
+Pass CoalesceStorage() {
+  runtime::TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func =
+      [=](Function f, IRModule m, PassContext pc) {
+        auto dim_upper_bound =
+            pc->GetConfig("relay.CoalesceStorage.dim_upper_bound", Integer(0));
+        return Downcast<Function>(StorageCoalescer(dim_upper_bound.value()->value).Mutate(f));
+      };
+  return CreateFunctionPass(pass_func, 0, "CoalesceStorage", {"InferType"});
+}
+
+TVM_REGISTER_GLOBAL("relay._transform.CoalesceStorage").set_body_typed(CoalesceStorage);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
@@ -30,6 +30,11 @@
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/object.h>
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../backend/te_compiler.h"
 #include "pattern_utils.h"
 
 namespace tvm {
@@ -82,7 +87,8 @@ class ConstantFolder : public MixedModeMutator {
         shape_of_op_(Op::Get("shape_of")),
         vm_shape_of_op_(Op::Get("vm.shape_of")),
         cast_op_(Op::Get("cast")),
-        ndarray_size_op_(Op::Get("ndarray_size")) {}
+        ndarray_size_op_(Op::Get("ndarray_size")),
+        target_("llvm") {}
 
   using MixedModeMutator::VisitExpr_;
 
@@ -209,6 +215,23 @@ class ConstantFolder : public MixedModeMutator {
   const Op& vm_shape_of_op_;
   const Op& cast_op_;
   const Op& ndarray_size_op_;
+  // The target the constants are evaluated on.
+  Target target_;
+
+  /*! \brief A compiled kernel evaluating a call to an operator. */
+  struct Kernel {
+    /*! \brief The kernel, nullptr when the call is left to the interpreter. */
+    PackedFunc func;
+    /*! \brief The types of the outputs. */
+    std::vector<TensorType> outputs;
+    /*! \brief Whether the call returns a tuple. */
+    bool returns_tuple{false};
+  };
+  // The kernels, keyed by the primitive function of the call, which holds the
+  // operator, its attributes and the types of the arguments.
+  std::unordered_map<Function, Kernel, StructuralHash, StructuralEqual> kernels_;
+  // The compiler of the kernels.
+  tec::TECompiler compiler_;
 
   // Convert value to expression.
   Expr ObjectToExpr(const ObjectRef& value) {
@@ -227,8 +250,116 @@ class ConstantFolder : public MixedModeMutator {
       return Expr();
     }
   }
+  // Get the kernel of a call to an operator, taking the tensors and the
+  // tuples of tensors of the call as arguments.
+  const Kernel& GetKernel(const Function& func) {
+    auto it = kernels_.find(func);
+    if (it != kernels_.end()) return it->second;
+    Kernel& kernel = kernels_[func];
+    IRModule mod = transform::InferType()(IRModule::FromExpr(func));
+    Function typed = Downcast<Function>(mod->Lookup("main"));
+    Type ret_type = typed->body->checked_type();
+    if (const auto* tuple_type = ret_type.as<TupleTypeNode>()) {
+      kernel.returns_tuple = true;
+      for (const Type& field : tuple_type->fields) {
+        if (!field.as<TensorTypeNode>()) return kernel;
+        kernel.outputs.push_back(Downcast<TensorType>(field));
+      }
+    } else if (ret_type.as<TensorTypeNode>()) {
+      kernel.outputs.push_back(Downcast<TensorType>(ret_type));
+    } else {
+      return kernel;
+    }
+    for (const TensorType& output : kernel.outputs) {
+      for (const PrimExpr& dim : output->shape) {
+        // Outputs with a dynamic shape need the shape functions of the interpreter.
+        if (!dim.as<IntImmNode>()) {
+          kernel.outputs.clear();
+          return kernel;
+        }
+      }
+    }
+    kernel.func = compiler_->JIT(tec::CCacheKey(typed, target_));
+    return kernel;
+  }
+
+  // Evaluate a call to an operator on constants, or tuples of constants, with
+  // a compiled kernel. Calls which only differ by the data of their constants
+  // share their kernel. Return an undefined Expr when the call is left to the
+  // interpreter.
+  Expr EvaluateWithKernel(const Call& call) {
+    static auto fstrategy = Op::GetAttrMap<FTVMStrategy>("FTVMStrategy");
+    if (!fstrategy.count(Downcast<Op>(call->op))) return Expr();
+    Array<Var> params;
+    Array<Expr> args;
+    std::vector<runtime::NDArray> inputs;
+    for (const Expr& arg : call->args) {
+      Type type;
+      if (const auto* constant = arg.as<ConstantNode>()) {
+        type = constant->tensor_type();
+        inputs.push_back(constant->data);
+      } else if (const auto* tuple = arg.as<TupleNode>()) {
+        Array<Type> fields;
+        for (const Expr& field : tuple->fields) {
+          const auto* constant = field.as<ConstantNode>();
+          if (constant == nullptr) return Expr();
+          fields.push_back(constant->tensor_type());
+          inputs.push_back(constant->data);
+        }
+        type = TupleType(fields);
+      } else {
+        return Expr();
+      }
+      params.push_back(Var("p" + std::to_string(params.size()), type));
+      args.push_back(params.back());
+    }
+    Function func(params, Call(call->op, args, call->attrs, call->type_args), Type(), {});
+    func = WithAttr(std::move(func), attr::kPrimitive, tvm::Integer(1));
+
+    // use a fresh build context
+    // in case we are already in a build context.
+    With<transform::PassContext> fresh_build_ctx(transform::PassContext::Create());
+    const Kernel& kernel = GetKernel(func);
+    if (kernel.func == nullptr) return Expr();
+
+    Device dev{kDLCPU, 0};
+    std::vector<runtime::NDArray> outputs;
+    for (const TensorType& output : kernel.outputs) {
+      std::vector<int64_t> shape;
+      for (const PrimExpr& dim : output->shape) {
+        shape.push_back(dim.as<IntImmNode>()->value);
+      }
+      outputs.push_back(runtime::NDArray::Empty(shape, output->dtype, dev));
+    }
+    size_t num_args = inputs.size() + outputs.size();
+    std::vector<TVMValue> values(num_args);
+    std::vector<int> codes(num_args);
+    runtime::TVMArgsSetter setter(values.data(), codes.data());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      setter(i, inputs[i]);
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      setter(inputs.size() + i, outputs[i]);
+    }
+    TVMRetValue rv;
+    kernel.func.CallPacked(TVMArgs(values.data(), codes.data(), num_args), &rv);
+
+    if (!kernel.returns_tuple) return Constant(outputs[0]);
+    Array<Expr> fields;
+    for (const runtime::NDArray& output : outputs) {
+      fields.push_back(Constant(output));
+    }
+    return Tuple(fields);
+  }
+
   // Constant evaluate an expression.
   Expr ConstEvaluate(Expr expr) {
+    if (const auto* call = expr.as<CallNode>()) {
+      if (call->op.as<OpNode>()) {
+        Expr result = EvaluateWithKernel(GetRef<Call>(call));
+        if (result.defined()) return result;
+      }
+    }
     std::vector<transform::Pass> passes = {transform::FuseOps(0), transform::ToANormalForm(),
                                            transform::InferType()};
     Function func;
@@ -250,13 +381,12 @@ class ConstantFolder : public MixedModeMutator {
     Device dev;
     dev.device_type = kDLCPU;
     dev.device_id = 0;
-    Target target = Target("llvm");
     // use a fresh build context
     // in case we are already in a build context.
     // needed for both execution and creation(due to JIT)
     With<PassContext> fresh_build_ctx(PassContext::Create());
 
-    FInterpreter executor = CreateInterpreter(mod, dev, target);
+    FInterpreter executor = CreateInterpreter(mod, dev, target_);
     return ObjectToExpr(executor(expr));
   }
 
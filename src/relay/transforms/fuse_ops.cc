@@ -28,8 +28,12 @@
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/op_attr_types.h>
 #include <tvm/relay/transform.h>
+#include <tvm/target/target.h>
+#include <tvm/tir/data_layout.h>
 #include <tvm/tir/op.h>
 
+#include <algorithm>
+
 #include "../../support/arena.h"
 #include "pass_utils.h"
 #include "pattern_utils.h"
@@ -75,15 +79,31 @@ namespace relay {
       will still run correctly.
   - CommitFuse: mark all the nodes between source and post-dominator as the same group.
   - We use an Union-Find data structure to manage the groups.
+
+  With relay.FuseOps.cost_model set, a last phase also fuses a group into the compute-heavy
+  op (conv2d, dense, pooling, reduction) consuming it, which the rules above refuse. The
+  fusion is only made when the memory traffic saved, the store and load of the intermediate
+  tensor, outweighs the recomputation at relay.FuseOps.flops_per_byte operations per byte:
+  - A group without anchor is inlined into the consumer and recomputed for every read.
+  - On CPU, a group with anchor (conv2d -> conv2d, dense -> dense) is computed a few rows at
+    a time inside the row loop of the consumer, and only the rows overlapping between two
+    iterations are recomputed.
+  The fused functions carry the attribute relay.fused_producer, which tells the schedule
+  builder to inline the producers, or to tile the anchors across the layers.
 */
 using support::LinkedList;
 using support::LinkNode;
 
 constexpr uint32_t kMaxFusedOps = 256;
 
+/*! \brief The default machine balance of the fusion cost model, in operations per byte. */
+constexpr int kFlopsPerByte = 4;
+
 static const Op& stop_fusion_op = Op::Get("annotation.stop_fusion");
 
 TVM_REGISTER_PASS_CONFIG_OPTION("relay.FuseOps.max_depth", Integer);
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.FuseOps.cost_model", Bool);
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.FuseOps.flops_per_byte", Integer);
 
 /*!
  * \brief Indexed data flow graph in forward direction.
@@ -507,8 +527,19 @@ DominatorTree DominatorTree::PostDom(support::Arena* arena, const IndexedForward
  */
 class GraphPartitioner {
  public:
-  explicit GraphPartitioner(support::Arena* arena, int opt_level, size_t max_fuse_depth)
-      : arena_(arena), opt_level_(opt_level), max_fuse_depth_(max_fuse_depth) {}
+  /*!
+   * \param flops_per_byte The machine balance of the fusion cost model, negative to only
+   *  fuse by the patterns of the ops.
+   * \param fuse_anchors Whether the cost model may fuse a group with anchor into a conv2d or
+   *  dense op, which only the CPU schedule builder supports.
+   */
+  explicit GraphPartitioner(support::Arena* arena, int opt_level, size_t max_fuse_depth,
+                            int flops_per_byte = -1, bool fuse_anchors = false)
+      : arena_(arena),
+        opt_level_(opt_level),
+        max_fuse_depth_(max_fuse_depth),
+        flops_per_byte_(flops_per_byte),
+        fuse_anchors_(fuse_anchors) {}
   /*!
    * \brief Group as a union find data structure.
    */
@@ -548,6 +579,8 @@ class GraphPartitioner {
      * \brief The number of nodes belonging to this group
      */
     uint32_t num_nodes{1};
+    /*! \brief Whether the cost model fused a producer group into the anchor. */
+    bool fused_producer{false};
   };
   /*!
    * \brief Partition a graph.
@@ -562,6 +595,10 @@ class GraphPartitioner {
   int opt_level_;
   /*! \brief The maximum number of operations in one fused function */
   size_t max_fuse_depth_;
+  /*! \brief The machine balance of the fusion cost model, negative when it is disabled. */
+  int flops_per_byte_;
+  /*! \brief Whether the cost model may fuse two anchors. */
+  bool fuse_anchors_;
   /*! \brief The internal groups. */
   std::vector<Group*> groups_;
   /*! \brief internal field used for deduplication */
@@ -623,11 +660,15 @@ class GraphPartitioner {
     // update the number of nodes of the parent group
     parent->num_nodes += child->num_nodes;
     child->parent = parent;
+    parent->fused_producer = parent->fused_producer || child->fused_producer;
     // update anchor ref and pattern
     if (child->anchor_ref != nullptr) {
-      ICHECK(parent->anchor_ref == nullptr);
-      parent->anchor_ref = child->anchor_ref;
-      parent->pattern = CombinePattern(child->pattern, parent->pattern);
+      // Only the cost model fuses an anchor into another one, the consumer stays the anchor.
+      ICHECK(parent->anchor_ref == nullptr || parent->fused_producer);
+      if (parent->anchor_ref == nullptr) {
+        parent->anchor_ref = child->anchor_ref;
+        parent->pattern = CombinePattern(child->pattern, parent->pattern);
+      }
     }
   }
   // Internal implelementation of CommitFuse
@@ -682,6 +723,205 @@ class GraphPartitioner {
     return target->FindRoot()->num_nodes + CountNodesUptoSink_(child, dom_parent);
   }
 
+  /*! \brief The extent of a constant dimension of the type of expr, negative when unknown. */
+  static double ConstDim(const Expr& expr, int axis) {
+    const auto* ttype = expr->checked_type().as<TensorTypeNode>();
+    if (ttype == nullptr || axis < 0 || axis >= static_cast<int>(ttype->shape.size())) {
+      return -1;
+    }
+    const auto* value = tir::as_const_int(ttype->shape[axis]);
+    return value != nullptr ? static_cast<double>(*value) : -1;
+  }
+
+  /*! \brief The product of constant values, negative when one is not constant. */
+  static double ConstProduct(const Array<IndexExpr>& values) {
+    double result = 1;
+    for (const auto& value : values) {
+      const auto* v = tir::as_const_int(value);
+      if (v == nullptr || *v <= 0) return -1;
+      result *= static_cast<double>(*v);
+    }
+    return result;
+  }
+
+  /*!
+   * \brief The extent of an axis of the kernel of a conv2d, including its sub-axis in the
+   *  packed layouts, negative when it is unknown.
+   */
+  static double KernelDim(const CallNode* call, const Conv2DAttrs* attrs, char axis) {
+    tir::Layout layout(attrs->kernel_layout);
+    double extent = ConstDim(call->args[1], layout.IndexOf(tir::LayoutAxis::Get(axis)));
+    int sub_axis = layout.IndexOf(tir::LayoutAxis::Get(axis).ToSubordinate());
+    if (sub_axis >= 0) extent *= ConstDim(call->args[1], sub_axis);
+    return extent;
+  }
+
+  /*!
+   * \brief Estimate the operations of a conv2d or dense op per element of its output.
+   * \return The operations, negative when they are unknown.
+   */
+  static double EstimateFlopsPerElement(const CallNode* call) {
+    static const Op& conv2d_op = Op::Get("nn.conv2d");
+    static const Op& conv2d_nchwc_op = Op::Get("nn.contrib_conv2d_NCHWc");
+    static const Op& dense_op = Op::Get("nn.dense");
+    static const Op& batch_matmul_op = Op::Get("nn.batch_matmul");
+
+    if (call->op == conv2d_op || call->op == conv2d_nchwc_op) {
+      // A multiply and an add for each weight of an output channel.
+      const auto* attrs = call->attrs.as<Conv2DAttrs>();
+      const auto* wtype = call->args[1]->checked_type().as<TensorTypeNode>();
+      if (attrs == nullptr || wtype == nullptr) return -1;
+      double weights = ConstProduct(wtype->shape);
+      double out_channels = KernelDim(call, attrs, 'O');
+      if (weights <= 0 || out_channels <= 0) return -1;
+      return 2 * weights / out_channels;
+    }
+    if (call->op == dense_op) {
+      double k = ConstDim(call->args[1], 1);
+      return k > 0 ? 2 * k : -1;
+    }
+    if (call->op == batch_matmul_op) {
+      double k = ConstDim(call->args[1], 2);
+      return k > 0 ? 2 * k : -1;
+    }
+    return -1;
+  }
+
+  /*!
+   * \brief Estimate how many times a conv2d or dense op, tiled by rows of its output, needs
+   *  each row of its data input. Rows shared by the windows of consecutive output rows are
+   *  computed again for each of them.
+   * \return The reuse, negative when it is unknown or the op is not a conv2d or dense.
+   */
+  static double EstimateRowReuse(const CallNode* call) {
+    static const Op& conv2d_op = Op::Get("nn.conv2d");
+    static const Op& conv2d_nchwc_op = Op::Get("nn.contrib_conv2d_NCHWc");
+    static const Op& dense_op = Op::Get("nn.dense");
+    static const Op& batch_matmul_op = Op::Get("nn.batch_matmul");
+
+    if (call->op == conv2d_op || call->op == conv2d_nchwc_op) {
+      const auto* attrs = call->attrs.as<Conv2DAttrs>();
+      if (attrs == nullptr || attrs->strides.size() != 2 || attrs->dilation.size() != 2) {
+        return -1;
+      }
+      double kernel_h = KernelDim(call, attrs, 'H');
+      const auto* stride_h = tir::as_const_int(attrs->strides[0]);
+      const auto* dilation_h = tir::as_const_int(attrs->dilation[0]);
+      if (kernel_h <= 0 || stride_h == nullptr || dilation_h == nullptr || *stride_h <= 0) {
+        return -1;
+      }
+      double window = (kernel_h - 1) * static_cast<double>(*dilation_h) + 1;
+      return std::max(window / static_cast<double>(*stride_h), 1.0);
+    }
+    if (call->op == dense_op || call->op == batch_matmul_op) {
+      // Each output row reads its own input row.
+      return 1;
+    }
+    return -1;
+  }
+
+  /*!
+   * \brief Estimate how many times a compute-heavy op reads each element of its data input.
+   * \return The reuse, negative when it is unknown.
+   */
+  static double EstimateReuse(const CallNode* call) {
+    static const Op& conv2d_op = Op::Get("nn.conv2d");
+    static const Op& conv2d_nchwc_op = Op::Get("nn.contrib_conv2d_NCHWc");
+    static const Op& dense_op = Op::Get("nn.dense");
+    static const Op& batch_matmul_op = Op::Get("nn.batch_matmul");
+    static const Op& max_pool2d_op = Op::Get("nn.max_pool2d");
+    static const Op& avg_pool2d_op = Op::Get("nn.avg_pool2d");
+    static const Op& global_max_pool2d_op = Op::Get("nn.global_max_pool2d");
+    static const Op& global_avg_pool2d_op = Op::Get("nn.global_avg_pool2d");
+
+    if (call->op == conv2d_op || call->op == conv2d_nchwc_op) {
+      // Each input element is read by (out_channels / groups) * kernel_size / strides
+      // outputs, that is the number of weights per input channel over the strides.
+      const auto* attrs = call->attrs.as<Conv2DAttrs>();
+      const auto* wtype = call->args[1]->checked_type().as<TensorTypeNode>();
+      if (attrs == nullptr || wtype == nullptr) return -1;
+      tir::Layout layout(attrs->data_layout);
+      double channels = ConstDim(call->args[0], layout.IndexOf(tir::LayoutAxis::Get('C')));
+      int sub_channel_axis = layout.IndexOf(tir::LayoutAxis::Get('c'));
+      if (sub_channel_axis >= 0) channels *= ConstDim(call->args[0], sub_channel_axis);
+      double weights = ConstProduct(wtype->shape);
+      double strides = ConstProduct(attrs->strides);
+      if (channels <= 0 || weights <= 0 || strides <= 0) return -1;
+      return std::max(weights / channels / strides, 1.0);
+    }
+    if (call->op == dense_op) {
+      return ConstDim(call->args[1], 0);
+    }
+    if (call->op == batch_matmul_op) {
+      return ConstDim(call->args[1], 1);
+    }
+    if (call->op == max_pool2d_op || call->op == avg_pool2d_op) {
+      Array<IndexExpr> pool_size, strides;
+      if (const auto* attrs = call->attrs.as<MaxPool2DAttrs>()) {
+        pool_size = attrs->pool_size;
+        strides = attrs->strides;
+      } else if (const auto* attrs = call->attrs.as<AvgPool2DAttrs>()) {
+        pool_size = attrs->pool_size;
+        strides = attrs->strides;
+      } else {
+        return -1;
+      }
+      double window = ConstProduct(pool_size);
+      double stride = ConstProduct(strides);
+      if (window <= 0 || stride <= 0) return -1;
+      return std::max(window / stride, 1.0);
+    }
+    if (call->op == global_max_pool2d_op || call->op == global_avg_pool2d_op) {
+      return 1;
+    }
+    return -1;
+  }
+
+  /*!
+   * \brief Decide with the cost model whether to fuse a group into the compute-heavy op
+   *  consuming its output.
+   * \param producer The output node of the group.
+   * \param consumer The op consuming it.
+   */
+  bool FusionPays(IndexedForwardGraph::Node* producer, IndexedForwardGraph::Node* consumer) {
+    if (!consumer->ref->IsInstance<CallNode>()) return false;
+    const auto* call = static_cast<const CallNode*>(consumer->ref);
+    if (call->args.empty()) return false;
+    // Only fuse into the data input, the one the schedules of the ops inline into.
+    if (call->args[0].get() != producer->ref) return false;
+    for (auto link = producer->outputs.head; link != nullptr; link = link->next) {
+      if (link->value.node != consumer) return false;
+    }
+    for (size_t i = 1; i < call->args.size(); ++i) {
+      if (call->args[i].get() == producer->ref) return false;
+    }
+    Group* group = groups_[producer->index]->FindRoot();
+    // The reads of each element of the intermediate tensor, and the operations to compute it,
+    // about one per node.
+    double reuse, flops = group->num_nodes;
+    if (group->anchor_ref != nullptr) {
+      // Tile across the layers, a group fused from anchors already would recompute again.
+      if (!fuse_anchors_ || group->fused_producer) return false;
+      if (!group->anchor_ref->IsInstance<CallNode>()) return false;
+      reuse = EstimateRowReuse(call);
+      const auto* anchor = static_cast<const CallNode*>(group->anchor_ref);
+      double anchor_flops = EstimateFlopsPerElement(anchor);
+      if (anchor_flops < 0) return false;
+      flops += anchor_flops - 1;
+    } else {
+      reuse = consumer->pattern == kCommReduce ? 1 : EstimateReuse(call);
+    }
+    if (reuse < 0) return false;
+    const auto* ttype = call->args[0]->checked_type().as<TensorTypeNode>();
+    if (ttype == nullptr) return false;
+    double bytes = ttype->dtype.bytes() * ttype->dtype.lanes();
+    // Per element of the intermediate tensor: fusing saves its store and load, and runs the
+    // producer again for every read after the first.
+    double saved = 2 * bytes * flops_per_byte_;
+    double recomputed = (reuse - 1) * flops;
+    return recomputed <= saved;
+  }
+
   // Initialize the groups.
   void InitGroups(const IndexedForwardGraph& graph) {
     groups_.resize(graph.post_dfs_order.size());
@@ -717,6 +957,22 @@ class GraphPartitioner {
       if (CountFusedNodesWithNewChild(graph_node, dom_node->parent->gnode) > max_fuse_depth_)
         continue;
 
+      if (phase == 3) {
+        // Fuse the output of a group into the compute-heavy op consuming it.
+        Group* root = group_node->FindRoot();
+        if (root->root_ref != graph_node->ref) continue;
+        if (root->pattern > kInjective && root->pattern != kOutEWiseFusable) continue;
+        IndexedForwardGraph::Node* consumer = dom_node->parent->gnode;
+        if (consumer->pattern != kOutEWiseFusable && consumer->pattern != kCommReduce) continue;
+        Group* consumer_root = groups_[dom_parent_gindex]->FindRoot();
+        if (root == consumer_root) continue;
+        if (FusionPays(graph_node, consumer)) {
+          consumer_root->fused_producer = true;
+          CommitFuse(graph_node, consumer);
+        }
+        continue;
+      }
+
       if (phase == 2) {
         // Fuse injective ops into intermediate tuples, if any
         if (group_node->pattern > kInjective) continue;
@@ -799,8 +1055,9 @@ std::vector<GraphPartitioner::Group*> GraphPartitioner::Partition(
   if (opt_level_ == 0) return std::move(groups_);
   // get post dominator tree
   auto post_dom_tree = DominatorTree::PostDom(arena_, graph);
-  // run fusion algorithm.
-  for (int phase = 0; phase < 3; ++phase) {
+  // run fusion algorithm, the last phase is the cost model.
+  int num_phases = flops_per_byte_ >= 0 ? 4 : 3;
+  for (int phase = 0; phase < num_phases; ++phase) {
     this->RunFuse(graph, post_dom_tree, phase);
   }
   return std::move(groups_);
@@ -809,10 +1066,13 @@ std::vector<GraphPartitioner::Group*> GraphPartitioner::Partition(
 class FuseMutator : private MixedModeMutator {
  public:
   // Run the transform
-  Expr Transform(const Expr& body, int fuse_opt_level, size_t max_fuse_depth) {
+  Expr Transform(const Expr& body, int fuse_opt_level, size_t max_fuse_depth,
+                 int flops_per_byte = -1, bool fuse_anchors = false) {
     // setup the group map.
     auto graph = IndexedForwardGraph::Create(&arena_, body);
-    auto groups = GraphPartitioner(&arena_, fuse_opt_level, max_fuse_depth).Partition(graph);
+    auto groups = GraphPartitioner(&arena_, fuse_opt_level, max_fuse_depth, flops_per_byte,
+                                   fuse_anchors)
+                      .Partition(graph);
     for (size_t nid = 0; nid < graph.post_dfs_order.size(); ++nid) {
       ICHECK(graph.post_dfs_order[nid]->ref != nullptr);
       gmap_[graph.post_dfs_order[nid]->ref] = groups[nid];
@@ -981,6 +1241,9 @@ class FuseMutator : private MixedModeMutator {
     if (visitor.has_call && visitor.reshape_only) {
       func = WithAttr(std::move(func), attr::kReshapeOnly, tvm::Integer(visitor.reshape_only));
     }
+    if (group->fused_producer) {
+      func = WithAttr(std::move(func), attr::kFusedProducer, tvm::Integer(1));
+    }
     return Call(func, ginfo.arguments, Attrs());
   }
 
@@ -1015,8 +1278,10 @@ class FuseMutator : private MixedModeMutator {
   }
 };
 
-Expr FuseOps(const Expr& expr, int fuse_opt_level, size_t max_fuse_depth, const IRModule& module) {
-  return FuseMutator().Transform(expr, fuse_opt_level, max_fuse_depth);
+Expr FuseOps(const Expr& expr, int fuse_opt_level, size_t max_fuse_depth, int flops_per_byte,
+             bool fuse_anchors, const IRModule& module) {
+  return FuseMutator().Transform(expr, fuse_opt_level, max_fuse_depth, flops_per_byte,
+                                 fuse_anchors);
 }
 
 namespace transform {
@@ -1026,7 +1291,18 @@ Pass FuseOps(int fuse_opt_level) {
       [=](Function f, IRModule m, PassContext pc) {
         int opt_level = fuse_opt_level == -1 ? pc->opt_level : fuse_opt_level;
         auto max_fuse_depth = pc->GetConfig("relay.FuseOps.max_depth", Integer(kMaxFusedOps));
-        return Downcast<Function>(FuseOps(f, opt_level, max_fuse_depth.value(), m));
+        bool cost_model = pc->GetConfig("relay.FuseOps.cost_model", Bool(false)).value();
+        int flops_per_byte = -1;
+        if (cost_model) {
+          flops_per_byte =
+              pc->GetConfig("relay.FuseOps.flops_per_byte", Integer(kFlopsPerByte)).value()->value;
+          ICHECK_GE(flops_per_byte, 0) << "relay.FuseOps.flops_per_byte must not be negative";
+        }
+        // The schedule builder only tiles two anchors across the layers on CPU.
+        Target target = Target::Current(true);
+        bool fuse_anchors = target.defined() && target->kind->device_type == kDLCPU;
+        return Downcast<Function>(
+            FuseOps(f, opt_level, max_fuse_depth.value(), flops_per_byte, fuse_anchors, m));
       };
   return CreateFunctionPass(pass_func, 1, "FuseOps", {"InferType"});
 }
@@ -27,7 +27,7 @@
 
 #include <algorithm>
 
-#include "mt_random_engine.cc"
+#include "random_engine.cc"
 
 #define DLPACK_INTEGER_TYPE_SWITCH(type, DType, ...)    \
   if (type.code == kDLInt && type.bits == 32) {         \
@@ -91,9 +91,9 @@ TVM_REGISTER_GLOBAL("tvm.contrib.random.randint").set_body([](TVMArgs args, TVMR
 
     if (out->device.device_type == kDLCPU) {
       // file the data with random byte
-      std::generate_n(static_cast<DType*>(out->data), size, [&]() {
-        unsigned rint = entry->random_engine.GetRandInt();
-        return low + rint % (high - low);
+      DType* data = static_cast<DType*>(out->data);
+      entry->random_engine.Generate(size, [&](int64_t i, uint64_t bits) {
+        data[i] = low + static_cast<int64_t>(bits % static_cast<uint64_t>(high - low));
       });
     } else {
       LOG(FATAL) << "Do not support random.randint on this device yet";
@@ -117,6 +117,10 @@ TVM_REGISTER_GLOBAL("tvm.contrib.random.normal").set_body([](TVMArgs args, TVMRe
   entry->random_engine.SampleNormal(out, loc, scale);
 });
 
+TVM_REGISTER_GLOBAL("tvm.contrib.random.seed").set_body_typed([](int64_t seed) {
+  RandomThreadLocalEntry::ThreadLocal()->random_engine.Seed(static_cast<unsigned>(seed));
+});
+
 TVM_REGISTER_GLOBAL("tvm.contrib.random.random_fill").set_body([](TVMArgs args, TVMRetValue* ret) {
   RandomThreadLocalEntry* entry = RandomThreadLocalEntry::ThreadLocal();
   DLTensor* out = args[0];
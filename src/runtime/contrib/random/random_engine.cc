@@ -0,0 +1,309 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file random/random_engine.cc
+ * \brief Counter based random engine
+ */
+#include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/logging.h>
+#include <tvm/runtime/ndarray.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <utility>
+
+#include "../3rdparty/compiler-rt/builtin_fp16.h"
+
+namespace tvm {
+namespace contrib {
+
+/*! \brief M_PI is not defined by every C++ standard library. */
+constexpr double kPi = 3.14159265358979323846;
+
+/*!
+ * \brief The Threefry-4x64 block function with 20 rounds, as computed by
+ *  _threefry in python/tvm/topi/random/kernel.py for the Relay random ops.
+ * \param key The key.
+ * \param counter The counter.
+ * \param out The 4 random words.
+ */
+inline void Threefry4x64(const uint64_t key[4], const uint64_t counter[4], uint64_t out[4]) {
+  static constexpr int kRotations[8][2] = {{14, 16}, {52, 57}, {23, 40}, {5, 37},
+                                           {25, 33}, {46, 12}, {58, 22}, {32, 32}};
+  uint64_t full_key[5] = {key[0], key[1], key[2], key[3], 0x1BD11BDAA9FC1A22ull};
+  for (int i = 0; i < 4; ++i) {
+    full_key[4] ^= key[i];
+  }
+  uint64_t x[4] = {counter[0], counter[1], counter[2], counter[3]};
+  for (int s = 0; s < 5; ++s) {
+    for (int i = 0; i < 4; ++i) {
+      x[i] += full_key[(s + i) % 5];
+    }
+    x[3] += s;
+    for (int r = 0; r < 4; ++r) {
+      const int* rotation = kRotations[(s * 4 + r) % 8];
+      x[0] += x[1];
+      x[1] = ((x[1] << rotation[0]) | (x[1] >> (64 - rotation[0]))) ^ x[0];
+      x[2] += x[3];
+      x[3] = ((x[3] << rotation[1]) | (x[3] >> (64 - rotation[1]))) ^ x[2];
+      // The permutation {0, 3, 2, 1}.
+      std::swap(x[1], x[3]);
+    }
+  }
+  for (int i = 0; i < 4; ++i) {
+    out[i] = x[i];
+  }
+}
+
+/*!
+ * \brief An interface for generating [tensors of] random numbers.
+ *
+ *  The numbers are made by a counter based generator: block b of 4 random
+ *  words is the Threefry hash of the key, made of the seed, and of the counter
+ *  b. Each block is computed independently, so tensors are filled in parallel
+ *  on the runtime thread pool, with values independent of the number of
+ *  threads. Each fill uses the blocks after those of the previous one.
+ *
+ *  The key and the counters are laid out like the generators of the Relay
+ *  random ops, so that after Seed(seed), SampleUniform fills a float tensor
+ *  whose size is a multiple of 4 with the values of relay.random.uniform
+ *  given relay.random.threefry_key(seed).
+ */
+class RandomEngine {
+ public:
+  /*!
+   * \brief Creates a RandomEngine using a default seed.
+   */
+  RandomEngine() { this->Seed(time(nullptr)); }
+
+  /*!
+   * \brief Creates a RandomEngine, suggesting the use of a provided seed.
+   */
+  explicit RandomEngine(unsigned seed) { this->Seed(seed); }
+
+  /*!
+   * \brief Seeds the underlying RNG, if possible.
+   */
+  inline void Seed(unsigned seed) {
+    key_[0] = seed;
+    key_[1] = key_[2] = key_[3] = 0;
+    counter_ = 0;
+    this->rseed_ = static_cast<unsigned>(seed);
+  }
+
+  /*!
+   * \return the seed associated with the underlying RNG.
+   */
+  inline unsigned GetSeed() const { return rseed_; }
+
+  /*!
+   * \return a random integer sampled from the RNG.
+   */
+  inline unsigned GetRandInt() {
+    unsigned value = 0;
+    Generate(1, [&](int64_t i, uint64_t bits) { value = static_cast<unsigned>(bits); });
+    return value;
+  }
+
+  /*!
+   * \brief Call f(i, bits) for i in [0, size), with bits the i-th random word
+   *  of the fill, possibly in parallel.
+   */
+  template <typename F>
+  void Generate(int64_t size, F f) {
+    GenerateBlocks((size + 3) / 4, [&](int64_t block, const uint64_t bits[4]) {
+      for (int64_t i = block * 4; i < std::min(block * 4 + 4, size); ++i) {
+        f(i, bits[i - block * 4]);
+      }
+    });
+  }
+
+  /*!
+   * \brief Fills a tensor with values drawn from Unif(low, high)
+   */
+  void SampleUniform(DLTensor* data, float low, float high) {
+    ICHECK_GT(high, low) << "high must be bigger than low";
+    ICHECK(data->strides == nullptr);
+
+    DLDataType dtype = data->dtype;
+    int64_t size = 1;
+    for (int i = 0; i < data->ndim; ++i) {
+      size *= data->shape[i];
+    }
+
+    ICHECK(dtype.code == kDLFloat && (dtype.bits == 32 || dtype.bits == 64) && dtype.lanes == 1);
+
+    if (data->device.device_type == kDLCPU) {
+      if (dtype.bits == 32) {
+        float* out = static_cast<float*>(data->data);
+        float scale = high - low;
+        Generate(size, [&](int64_t i, uint64_t bits) {
+          // The fraction of a float in [1, 2), made of the high bits of the low 32 bits.
+          uint32_t mantissa = (static_cast<uint32_t>(bits) >> 9) | 0x3F800000u;
+          float value;
+          std::memcpy(&value, &mantissa, sizeof(value));
+          out[i] = (value - 1.0f) * scale + low;
+        });
+      } else {
+        double* out = static_cast<double*>(data->data);
+        double scale = static_cast<double>(high) - low;
+        Generate(size, [&](int64_t i, uint64_t bits) {
+          out[i] = ToUnitDouble(bits) * scale + low;
+        });
+      }
+    } else {
+      LOG(FATAL) << "Do not support random.uniform on this device yet";
+    }
+  }
+
+  /*!
+   * \brief Fills a tensor with values drawn from Normal(loc, scale**2)
+   */
+  void SampleNormal(DLTensor* data, float loc, float scale) {
+    ICHECK_GT(scale, 0) << "standard deviation must be positive";
+    ICHECK(data->strides == nullptr);
+
+    DLDataType dtype = data->dtype;
+    int64_t size = 1;
+    for (int i = 0; i < data->ndim; ++i) {
+      size *= data->shape[i];
+    }
+
+    ICHECK(dtype.code == kDLFloat && dtype.bits == 32 && dtype.lanes == 1);
+
+    if (data->device.device_type == kDLCPU) {
+      float* out = static_cast<float*>(data->data);
+      // Box-Muller transform of each pair of words of a block.
+      GenerateBlocks((size + 3) / 4, [&](int64_t block, const uint64_t bits[4]) {
+        for (int64_t pair = 0; pair < 2; ++pair) {
+          double radius = std::sqrt(-2.0 * std::log(1.0 - ToUnitDouble(bits[pair * 2])));
+          double angle = 2.0 * kPi * ToUnitDouble(bits[pair * 2 + 1]);
+          int64_t i = block * 4 + pair * 2;
+          if (i < size) out[i] = static_cast<float>(loc + scale * radius * std::cos(angle));
+          if (i + 1 < size) out[i + 1] = static_cast<float>(loc + scale * radius * std::sin(angle));
+        }
+      });
+    } else {
+      LOG(FATAL) << "Do not support random.normal on this device yet";
+    }
+  }
+
+  void RandomFill(DLTensor* data) {
+    int64_t size = 1;
+    for (int i = 0; i < data->ndim; ++i) {
+      size *= data->shape[i];
+    }
+
+    if (data->device.device_type == kDLCPU) {
+      FillData(data, size);
+    } else {
+      runtime::NDArray local = runtime::NDArray::Empty(
+          std::vector<int64_t>{data->shape, data->shape + data->ndim}, data->dtype, {kDLCPU, 0});
+      DLTensor* tensor = const_cast<DLTensor*>(local.operator->());
+      FillData(tensor, size);
+      runtime::NDArray::CopyFromTo(tensor, data);
+    }
+  }
+
+ private:
+  // Tensors with fewer random blocks are filled by the calling thread.
+  static constexpr int64_t kMinParallelBlocks = 1 << 14;
+
+  // A double in [0, 1) made of the high 53 bits.
+  static double ToUnitDouble(uint64_t bits) { return (bits >> 11) * (1.0 / (1ull << 53)); }
+
+  // Call f(block, bits) for the next num_blocks blocks, possibly in parallel.
+  template <typename F>
+  void GenerateBlocks(int64_t num_blocks, F f) {
+    uint64_t first = counter_;
+    counter_ += num_blocks;
+    auto run = [&](int64_t begin, int64_t end) {
+      uint64_t bits[4];
+      for (int64_t block = begin; block < end; ++block) {
+        // Every word of the counter is incremented, like in the Relay ops.
+        uint64_t count = first + block;
+        uint64_t counter[4] = {count, count, count, count};
+        Threefry4x64(key_, counter, bits);
+        f(block, bits);
+      }
+    };
+    if (num_blocks < kMinParallelBlocks) {
+      run(0, num_blocks);
+      return;
+    }
+    std::pair<decltype(run)*, int64_t> closure(&run, num_blocks);
+    auto launch = [](int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+      auto* closure = static_cast<std::pair<decltype(run)*, int64_t>*>(cdata);
+      int64_t begin = closure->second * task_id / penv->num_task;
+      int64_t end = closure->second * (task_id + 1) / penv->num_task;
+      (*closure->first)(begin, end);
+      return 0;
+    };
+    ICHECK_EQ(TVMBackendParallelLaunch(launch, &closure, 0), 0);
+  }
+
+  void FillData(DLTensor* tensor, int64_t size) {
+    // Make the value be 1.0 - 10.0, not (0.0 - 1.0) so that we could satisfy
+    // quantized dtype (uint8 / int8) data non-empty requirement
+    auto dist = [](uint64_t bits) { return 1.0 + 9.0 * ToUnitDouble(bits); };
+    // Use float representation could make us work well on float / int type too.
+    if (tensor->dtype.bits == 1) {
+      bool* out = static_cast<bool*>(tensor->data);
+      Generate(size, [&](int64_t i, uint64_t bits) { out[i] = dist(bits); });
+    } else if (tensor->dtype.bits == 4) {
+      // For uint4/int4 we pack two values into a single byte.
+      // Thus, to ensure both values are non-zero, we use a distribution of 17 - 30.
+      uint8_t* out = reinterpret_cast<uint8_t*>(tensor->data);
+      Generate((size + 1) / 2, [&](int64_t i, uint64_t bits) {
+        out[i] = static_cast<uint8_t>(17.0 + 13.0 * ToUnitDouble(bits));
+      });
+    } else if (tensor->dtype.bits == 8) {
+      uint8_t* out = static_cast<uint8_t*>(tensor->data);
+      Generate(size, [&](int64_t i, uint64_t bits) { out[i] = dist(bits); });
+    } else if (tensor->dtype.bits == 16) {
+      uint16_t* out = static_cast<uint16_t*>(tensor->data);
+      Generate(size, [&](int64_t i, uint64_t bits) {
+        out[i] = __truncXfYf2__<float, uint32_t, 23, uint16_t, uint16_t, 10>(
+            static_cast<float>(dist(bits)));
+      });
+    } else if (tensor->dtype.bits == 32) {
+      float* out = static_cast<float*>(tensor->data);
+      Generate(size, [&](int64_t i, uint64_t bits) { out[i] = dist(bits); });
+    } else if (tensor->dtype.bits == 64) {
+      double* out = static_cast<double*>(tensor->data);
+      Generate(size, [&](int64_t i, uint64_t bits) { out[i] = dist(bits); });
+    } else {
+      LOG(FATAL) << "Doesn't support dtype code " << tensor->dtype.code << " dtype bits "
+                 << tensor->dtype.bits;
+    }
+  }
+
+ private:
+  uint64_t key_[4];
+  // The index of the next random block.
+  uint64_t counter_;
+  unsigned rseed_;
+};
+
+}  // namespace contrib
+}  // namespace tvm
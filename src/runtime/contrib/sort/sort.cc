@@ -22,9 +22,12 @@
  */
 
 #include <dlpack/dlpack.h>
+#include <tvm/runtime/c_backend_api.h>
 #include <tvm/runtime/registry.h>
 
 #include <algorithm>
+#include <cstring>
+#include <utility>
 #include <vector>
 
 namespace tvm {
@@ -32,14 +35,210 @@ namespace contrib {
 
 using namespace runtime;
 
-template <typename DType>
-bool CompareAscend(const std::pair<int64_t, DType>& lhs, const std::pair<int64_t, DType>& rhs) {
-  return lhs.second < rhs.second;
+/*!
+ * \brief Map the values to unsigned keys ordered like the values, so that all
+ *  the types are sorted the same way. -0.0 and 0.0 get the same key, and the
+ *  NaNs a key before or after every number depending on their sign.
+ */
+template <typename DataType>
+struct SortKey;
+
+template <>
+struct SortKey<float> {
+  using Type = uint32_t;
+  static uint32_t Get(float value) {
+    uint32_t bits;
+    value = value == 0 ? 0.0f : value;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+  }
+};
+
+template <>
+struct SortKey<double> {
+  using Type = uint64_t;
+  static uint64_t Get(double value) {
+    uint64_t bits;
+    value = value == 0 ? 0.0 : value;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+  }
+};
+
+template <>
+struct SortKey<int32_t> {
+  using Type = uint32_t;
+  static uint32_t Get(int32_t value) { return static_cast<uint32_t>(value) ^ 0x80000000u; }
+};
+
+template <>
+struct SortKey<int64_t> {
+  using Type = uint64_t;
+  static uint64_t Get(int64_t value) {
+    return static_cast<uint64_t>(value) ^ 0x8000000000000000ull;
+  }
+};
+
+#if (__ARM_FEATURE_FP16_SCALAR_ARITHMETIC == 1)
+template <>
+struct SortKey<__fp16> {
+  using Type = uint32_t;
+  static uint32_t Get(__fp16 value) { return SortKey<float>::Get(static_cast<float>(value)); }
+};
+#endif
+
+/*!
+ * \brief Sort the rows of a tensor one after the other, reusing its buffers.
+ *
+ *  The order is the one of std::stable_sort: equal values keep the order of
+ *  their indices, whether ascending or descending. Large rows are radix sorted
+ *  on their keys, held apart from the indices. When only the first k values
+ *  are needed, they are selected before being sorted.
+ */
+template <typename DataType>
+class RowSorter {
+ public:
+  using Key = typename SortKey<DataType>::Type;
+
+  /*!
+   * \brief Sort a row.
+   * \param data The first value of the row.
+   * \param stride The distance between the values of the row.
+   * \param n The number of values to sort.
+   * \param k The number of sorted values needed, at most n.
+   * \param is_ascend Whether to sort in ascending order.
+   * \return The indices of the first k sorted values in the row.
+   */
+  const std::vector<int64_t>& Sort(const DataType* data, int64_t stride, int64_t n, int64_t k,
+                                   bool is_ascend) {
+    // Descending order is the ascending order of the complemented keys, which
+    // keeps the indices of equal values in order.
+    Key flip = is_ascend ? 0 : ~Key(0);
+    if (k < n / 4 || n < kMinRadixSort) {
+      pairs_.resize(n);
+      for (int64_t i = 0; i < n; ++i) {
+        pairs_[i] = std::make_pair(SortKey<DataType>::Get(data[i * stride]) ^ flip, i);
+      }
+      if (k < n) {
+        std::nth_element(pairs_.begin(), pairs_.begin() + k, pairs_.end());
+      }
+      std::sort(pairs_.begin(), pairs_.begin() + k);
+      indices_.resize(k);
+      for (int64_t i = 0; i < k; ++i) {
+        indices_[i] = pairs_[i].second;
+      }
+    } else {
+      keys_.resize(n);
+      indices_.resize(n);
+      for (int64_t i = 0; i < n; ++i) {
+        keys_[i] = SortKey<DataType>::Get(data[i * stride]) ^ flip;
+        indices_[i] = i;
+      }
+      RadixSort(n);
+      indices_.resize(k);
+    }
+    return indices_;
+  }
+
+ private:
+  // Rows shorter than this are sorted by comparisons.
+  static constexpr int64_t kMinRadixSort = 256;
+  static constexpr int kNumDigits = sizeof(Key);
+
+  // Sort keys_ and indices_ byte by byte, from the least significant one.
+  void RadixSort(int64_t n) {
+    std::vector<int64_t> counts(kNumDigits * 256, 0);
+    for (int64_t i = 0; i < n; ++i) {
+      Key key = keys_[i];
+      for (int d = 0; d < kNumDigits; ++d) {
+        ++counts[d * 256 + ((key >> (d * 8)) & 0xff)];
+      }
+    }
+    tmp_keys_.resize(n);
+    tmp_indices_.resize(n);
+    for (int d = 0; d < kNumDigits; ++d) {
+      int64_t* count = &counts[d * 256];
+      // Skip the bytes shared by all the keys.
+      if (count[(keys_[0] >> (d * 8)) & 0xff] == n) continue;
+      int64_t offset = 0;
+      for (int b = 0; b < 256; ++b) {
+        int64_t c = count[b];
+        count[b] = offset;
+        offset += c;
+      }
+      for (int64_t i = 0; i < n; ++i) {
+        int64_t pos = count[(keys_[i] >> (d * 8)) & 0xff]++;
+        tmp_keys_[pos] = keys_[i];
+        tmp_indices_[pos] = indices_[i];
+      }
+      std::swap(keys_, tmp_keys_);
+      std::swap(indices_, tmp_indices_);
+    }
+  }
+
+  std::vector<Key> keys_, tmp_keys_;
+  std::vector<int64_t> indices_, tmp_indices_;
+  std::vector<std::pair<Key, int64_t>> pairs_;
+};
+
+/*!
+ * \brief Call f(begin, end) on ranges of the rows, in parallel on the runtime
+ *  thread pool when there are enough values for the launch to pay off.
+ * \param num_rows The number of rows.
+ * \param row_size The number of values in a row.
+ * \param f The function sorting a range of rows.
+ */
+template <typename F>
+void ParallelForRows(int64_t num_rows, int64_t row_size, F f) {
+  constexpr int64_t kMinParallelValues = 1 << 14;
+  if (num_rows < 2 || num_rows * row_size < kMinParallelValues) {
+    f(0, num_rows);
+    return;
+  }
+  std::pair<F*, int64_t> closure(&f, num_rows);
+  auto launch = [](int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+    auto* closure = static_cast<std::pair<F*, int64_t>*>(cdata);
+    int64_t begin = closure->second * task_id / penv->num_task;
+    int64_t end = closure->second * (task_id + 1) / penv->num_task;
+    if (begin < end) (*closure->first)(begin, end);
+    return 0;
+  };
+  ICHECK_EQ(TVMBackendParallelLaunch(launch, &closure, 0), 0);
 }
 
-template <typename DType>
-bool CompareDescend(const std::pair<int64_t, DType>& lhs, const std::pair<int64_t, DType>& rhs) {
-  return lhs.second > rhs.second;
+template <typename DataType>
+void argsort_nms(DLTensor* input, DLTensor* sort_num, DLTensor* output, int32_t axis,
+                 bool is_ascend) {
+  auto data_ptr = static_cast<DataType*>(input->data);
+  auto sort_num_ptr = static_cast<int32_t*>(sort_num->data);
+  auto out_ptr = static_cast<int32_t*>(output->data);
+  int64_t axis_mul_before = 1;
+  int64_t axis_mul_after = 1;
+  for (int i = 0; i < input->ndim; ++i) {
+    if (i < axis) {
+      axis_mul_before *= input->shape[i];
+    } else if (i > axis) {
+      axis_mul_after *= input->shape[i];
+    }
+  }
+  int64_t axis_size = input->shape[axis];
+
+  ParallelForRows(axis_mul_before * axis_mul_after, axis_size, [&](int64_t begin, int64_t end) {
+    RowSorter<DataType> sorter;
+    for (int64_t row = begin; row < end; ++row) {
+      int64_t i = row / axis_mul_after;
+      int64_t j = row % axis_mul_after;
+      int64_t current_sort_num = std::min<int64_t>(sort_num_ptr[row], axis_size);
+      current_sort_num = std::max<int64_t>(current_sort_num, 0);
+      int64_t base_idx = i * axis_size * axis_mul_after + j;
+      const std::vector<int64_t>& order = sorter.Sort(
+          data_ptr + base_idx, axis_mul_after, current_sort_num, current_sort_num, is_ascend);
+      for (int64_t k = 0; k < axis_size; ++k) {
+        out_ptr[base_idx + k * axis_mul_after] =
+            static_cast<int32_t>(k < current_sort_num ? order[k] : k);
+      }
+    }
+  });
 }
 
 // Argsort implemented C library sort for nms.
@@ -57,12 +256,6 @@ TVM_REGISTER_GLOBAL("tvm.contrib.sort.argsort_nms").set_body([](TVMArgs args, TV
   bool is_ascend = args[4];
 
   auto dtype = input->dtype;
-  auto data_ptr = static_cast<float*>(input->data);
-  auto sort_num_ptr = static_cast<int32_t*>(sort_num->data);
-  std::vector<std::pair<int32_t, float>> sorter;
-  int64_t axis_mul_before = 1;
-  int64_t axis_mul_after = 1;
-
   if (axis < 0) {
     axis = input->ndim + axis;
   }
@@ -78,60 +271,22 @@ TVM_REGISTER_GLOBAL("tvm.contrib.sort.argsort_nms").set_body([](TVMArgs args, TV
                                   "input ndim "
                                << input->ndim;
 
-  for (int i = 0; i < input->ndim; ++i) {
-    if (i < axis) {
-      axis_mul_before *= input->shape[i];
-    } else if (i > axis) {
-      axis_mul_after *= input->shape[i];
-    }
-  }
-
-  for (int64_t i = 0; i < axis_mul_before; ++i) {
-    for (int64_t j = 0; j < axis_mul_after; ++j) {
-      sorter.clear();
-      int32_t current_sort_num = *(sort_num_ptr + i * axis_mul_after + j);
-      int64_t base_idx = i * input->shape[axis] * axis_mul_after + j;
-      for (int64_t k = 0; k < current_sort_num; ++k) {
-        int64_t full_idx = base_idx + k * axis_mul_after;
-        sorter.emplace_back(std::make_pair(k, *(data_ptr + full_idx)));
-      }
-      if (is_ascend) {
-#if (__ARM_FEATURE_FP16_SCALAR_ARITHMETIC == 1)
-        if (dtype.bits == 16) {
-          std::stable_sort(sorter.begin(), sorter.end(), CompareAscend<__fp16>);
-        } else {
-#endif
-          std::stable_sort(sorter.begin(), sorter.end(), CompareAscend<float>);
-#if (__ARM_FEATURE_FP16_SCALAR_ARITHMETIC == 1)
-        }
-#endif
-      } else {
 #if (__ARM_FEATURE_FP16_SCALAR_ARITHMETIC == 1)
-        if (dtype.bits == 16) {
-          std::stable_sort(sorter.begin(), sorter.end(), CompareDescend<__fp16>);
-        } else {
-#endif
-          std::stable_sort(sorter.begin(), sorter.end(), CompareDescend<float>);
-#if (__ARM_FEATURE_FP16_SCALAR_ARITHMETIC == 1)
-        }
-#endif
-      }
-      for (int32_t k = 0; k < input->shape[axis]; ++k) {
-        *(static_cast<int32_t*>(output->data) + base_idx + k * axis_mul_after) =
-            k < static_cast<int32_t>(sorter.size()) ? sorter[k].first : k;
-      }
-    }
+  if (dtype.bits == 16) {
+    argsort_nms<__fp16>(input, sort_num, output, axis, is_ascend);
+    return;
   }
+#endif
+  argsort_nms<float>(input, sort_num, output, axis, is_ascend);
 });
 
 template <typename DataType, typename OutType>
 void sort_impl(DLTensor* input, DLTensor* output, int32_t axis, bool is_ascend, bool is_argsort) {
   auto data_ptr = static_cast<DataType*>(input->data);
   auto out_ptr = static_cast<OutType*>(output->data);
-  std::vector<std::pair<int64_t, DataType>> sorter;
 
-  int axis_mul_before = 1;
-  int axis_mul_after = 1;
+  int64_t axis_mul_before = 1;
+  int64_t axis_mul_after = 1;
   for (int i = 0; i < input->ndim; ++i) {
     if (i < axis) {
       axis_mul_before *= input->shape[i];
@@ -139,31 +294,28 @@ void sort_impl(DLTensor* input, DLTensor* output, int32_t axis, bool is_ascend,
       axis_mul_after *= input->shape[i];
     }
   }
-
-  for (int i = 0; i < axis_mul_before; ++i) {
-    for (int j = 0; j < axis_mul_after; ++j) {
-      sorter.clear();
-      int64_t base_idx = i * input->shape[axis] * axis_mul_after + j;
-      for (int64_t k = 0; k < input->shape[axis]; ++k) {
-        int64_t full_idx = base_idx + k * axis_mul_after;
-        sorter.emplace_back(std::make_pair(k, data_ptr[full_idx]));
-      }
-      if (is_ascend) {
-        std::stable_sort(sorter.begin(), sorter.end(), CompareAscend<DataType>);
-      } else {
-        std::stable_sort(sorter.begin(), sorter.end(), CompareDescend<DataType>);
-      }
+  int64_t axis_size = input->shape[axis];
+
+  ParallelForRows(axis_mul_before * axis_mul_after, axis_size, [&](int64_t begin, int64_t end) {
+    RowSorter<DataType> sorter;
+    for (int64_t row = begin; row < end; ++row) {
+      int64_t i = row / axis_mul_after;
+      int64_t j = row % axis_mul_after;
+      int64_t base_idx = i * axis_size * axis_mul_after + j;
+      const std::vector<int64_t>& order =
+          sorter.Sort(data_ptr + base_idx, axis_mul_after, axis_size, axis_size, is_ascend);
       if (is_argsort) {
-        for (int64_t k = 0; k < input->shape[axis]; ++k) {
-          out_ptr[base_idx + k * axis_mul_after] = static_cast<OutType>(sorter[k].first);
+        for (int64_t k = 0; k < axis_size; ++k) {
+          out_ptr[base_idx + k * axis_mul_after] = static_cast<OutType>(order[k]);
         }
       } else {
-        for (int64_t k = 0; k < input->shape[axis]; ++k) {
-          out_ptr[base_idx + k * axis_mul_after] = static_cast<OutType>(sorter[k].second);
+        for (int64_t k = 0; k < axis_size; ++k) {
+          out_ptr[base_idx + k * axis_mul_after] =
+              static_cast<OutType>(data_ptr[base_idx + order[k] * axis_mul_after]);
         }
       }
     }
-  }
+  });
 }
 
 template <typename DataType, typename OutType>
@@ -308,10 +460,9 @@ void topk(DLTensor* input, DLTensor* out_values, DLTensor* out_indices, int k, i
       (out_values == nullptr) ? nullptr : static_cast<DataType*>(out_values->data);
   IndicesType* indices_ptr =
       (out_indices == nullptr) ? nullptr : static_cast<IndicesType*>(out_indices->data);
-  std::vector<std::pair<int64_t, DataType>> sorter;
 
-  int axis_mul_before = 1;
-  int axis_mul_after = 1;
+  int64_t axis_mul_before = 1;
+  int64_t axis_mul_after = 1;
   for (int i = 0; i < input->ndim; ++i) {
     if (i < axis) {
       axis_mul_before *= input->shape[i];
@@ -319,36 +470,32 @@ void topk(DLTensor* input, DLTensor* out_values, DLTensor* out_indices, int k, i
       axis_mul_after *= input->shape[i];
     }
   }
+  int64_t axis_size = input->shape[axis];
   if (k < 1) {
-    k = input->shape[axis];
+    k = axis_size;
   }
-
-  for (int i = 0; i < axis_mul_before; ++i) {
-    for (int j = 0; j < axis_mul_after; ++j) {
-      sorter.clear();
-      int64_t src_base_idx = i * input->shape[axis] * axis_mul_after + j;
+  ICHECK_LE(k, axis_size) << "k is larger than the size of the axis";
+
+  ParallelForRows(axis_mul_before * axis_mul_after, axis_size, [&](int64_t begin, int64_t end) {
+    RowSorter<DataType> sorter;
+    for (int64_t row = begin; row < end; ++row) {
+      int64_t i = row / axis_mul_after;
+      int64_t j = row % axis_mul_after;
+      int64_t src_base_idx = i * axis_size * axis_mul_after + j;
       int64_t dst_base_idx = i * k * axis_mul_after + j;
-      for (int64_t kk = 0; kk < input->shape[axis]; ++kk) {
-        int64_t full_idx = src_base_idx + kk * axis_mul_after;
-        sorter.emplace_back(std::make_pair(kk, data_ptr[full_idx]));
-      }
-      if (is_ascend) {
-        std::stable_sort(sorter.begin(), sorter.end(), CompareAscend<DataType>);
-      } else {
-        std::stable_sort(sorter.begin(), sorter.end(), CompareDescend<DataType>);
-      }
-      int64_t cnt = k > 0 ? k : input->shape[axis];
-      for (int64_t kk = 0; kk < cnt; ++kk) {
+      const std::vector<int64_t>& order =
+          sorter.Sort(data_ptr + src_base_idx, axis_mul_after, axis_size, k, is_ascend);
+      for (int64_t kk = 0; kk < k; ++kk) {
         if (indices_ptr != nullptr) {
-          indices_ptr[dst_base_idx + kk * axis_mul_after] =
-              static_cast<IndicesType>(sorter[kk].first);
+          indices_ptr[dst_base_idx + kk * axis_mul_after] = static_cast<IndicesType>(order[kk]);
         }
         if (values_ptr != nullptr) {
-          values_ptr[dst_base_idx + kk * axis_mul_after] = static_cast<DataType>(sorter[kk].second);
+          values_ptr[dst_base_idx + kk * axis_mul_after] =
+              data_ptr[src_base_idx + order[kk] * axis_mul_after];
         }
       }
     }
-  }
+  });
 }
 
 // Argsort implemented C library sort.
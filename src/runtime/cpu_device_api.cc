@@ -21,12 +21,21 @@
  * \file cpu_device_api.cc
  */
 #include <dmlc/thread_local.h>
+#include <tvm/runtime/container/shape_tuple.h>
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/logging.h>
 #include <tvm/runtime/registry.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "workspace_pool.h"
 
@@ -34,8 +43,81 @@
 #include <android/api-level.h>
 #endif
 
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define TVM_CPU_ALLOC_POLICY 1
+#else
+#define TVM_CPU_ALLOC_POLICY 0
+#endif
+
 namespace tvm {
 namespace runtime {
+
+/*!
+ * \brief The placement of the large CPU allocations.
+ *
+ *  The allocations of at least threshold bytes can be backed by huge pages,
+ *  either transparent ones requested through madvise or explicit ones from
+ *  the hugetlbfs pool, falling back to transparent ones when the pool is
+ *  empty. They can also be bound to a NUMA node, the node of the allocating
+ *  thread for numa_node == kLocalNode. The defaults come from the
+ *  environment variables TVM_CPU_HUGEPAGE ("off", "transparent" or
+ *  "explicit"), TVM_CPU_HUGEPAGE_THRESHOLD and TVM_CPU_NUMA_NODE (a node or
+ *  "local"), and are changed with device_api.cpu.set_alloc_policy.
+ *  The policy only applies on Linux.
+ */
+struct CPUAllocPolicy {
+  enum HugePageMode { kOff = 0, kTransparent = 1, kExplicit = 2 };
+  /*! \brief numa_node binding to the node of the allocating thread. */
+  static constexpr int kLocalNode = -2;
+  /*! \brief numa_node for no binding. */
+  static constexpr int kNoNode = -1;
+
+  HugePageMode hugepage{kOff};
+  size_t threshold{kHugePageBytes};
+  int numa_node{kNoNode};
+
+  /*! \brief The size of a huge page. */
+  static constexpr size_t kHugePageBytes = 2 << 20;
+
+  /*! \return Whether the large allocations are placed differently from the others. */
+  bool Active() const { return hugepage != kOff || numa_node != kNoNode; }
+
+  static HugePageMode ParseMode(const std::string& mode) {
+    if (mode == "off") return kOff;
+    if (mode == "transparent") return kTransparent;
+    if (mode == "explicit") return kExplicit;
+    LOG(FATAL) << "Unknown huge page mode " << mode
+               << ", expected \"off\", \"transparent\" or \"explicit\"";
+    return kOff;
+  }
+
+  static CPUAllocPolicy FromEnv() {
+    CPUAllocPolicy policy;
+    if (const char* val = getenv("TVM_CPU_HUGEPAGE")) {
+      policy.hugepage = ParseMode(val);
+    }
+    if (const char* val = getenv("TVM_CPU_HUGEPAGE_THRESHOLD")) {
+      policy.threshold = strtoull(val, nullptr, 10);
+    }
+    if (const char* val = getenv("TVM_CPU_NUMA_NODE")) {
+      policy.numa_node = std::string(val) == "local" ? kLocalNode : atoi(val);
+    }
+    return policy;
+  }
+};
+
+/*! \brief Counters of the CPU allocations since the start of the process. */
+struct CPUAllocStats {
+  std::atomic<int64_t> default_bytes{0};
+  std::atomic<int64_t> transparent_hugepage_bytes{0};
+  std::atomic<int64_t> explicit_hugepage_bytes{0};
+  std::atomic<int64_t> numa_bound_bytes{0};
+  std::atomic<int64_t> numa_bind_failures{0};
+};
+
 class CPUDeviceAPI final : public DeviceAPI {
  public:
   void SetDevice(Device dev) final {}
@@ -45,6 +127,15 @@ class CPUDeviceAPI final : public DeviceAPI {
     }
   }
   void* AllocDataSpace(Device dev, size_t nbytes, size_t alignment, DLDataType type_hint) final {
+#if TVM_CPU_ALLOC_POLICY
+    // Only an atomic load when the policy is off, the threshold is then never reached.
+    if (nbytes >= large_threshold_.load(std::memory_order_relaxed)) {
+      const CPUAllocPolicy* policy = policy_.load(std::memory_order_acquire);
+      if (nbytes >= policy->threshold && policy->Active()) {
+        return AllocLarge(*policy, nbytes, alignment);
+      }
+    }
+#endif
     void* ptr;
 #if _MSC_VER
     ptr = _aligned_malloc(nbytes, alignment);
@@ -57,10 +148,23 @@ class CPUDeviceAPI final : public DeviceAPI {
     int ret = posix_memalign(&ptr, alignment, nbytes);
     if (ret != 0) throw std::bad_alloc();
 #endif
+    stats_.default_bytes += nbytes;
     return ptr;
   }
 
   void FreeDataSpace(Device dev, void* ptr) final {
+#if TVM_CPU_ALLOC_POLICY
+    if (num_mapped_.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = mapped_.find(ptr);
+      if (it != mapped_.end()) {
+        munmap(ptr, it->second);
+        mapped_.erase(it);
+        --num_mapped_;
+        return;
+      }
+    }
+#endif
 #if _MSC_VER
     _aligned_free(ptr);
 #else
@@ -68,11 +172,27 @@ class CPUDeviceAPI final : public DeviceAPI {
 #endif
   }
 
+  /*! \return The placement of the large allocations. */
+  CPUAllocPolicy GetPolicy() const { return *policy_.load(std::memory_order_acquire); }
+  /*! \brief Set the placement of the large allocations. */
+  void SetPolicy(const CPUAllocPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Allocations in flight may still read the previous policy, it is kept alive.
+    policies_.emplace_back(new CPUAllocPolicy(policy));
+    policy_.store(policies_.back().get(), std::memory_order_release);
+    large_threshold_.store(policy.Active() ? policy.threshold : std::numeric_limits<size_t>::max(),
+                           std::memory_order_relaxed);
+  }
+  /*! \return The allocation counters. */
+  const CPUAllocStats& stats() const { return stats_; }
+
   void StreamSync(Device dev, TVMStreamHandle stream) final {}
 
   void* AllocWorkspace(Device dev, size_t size, DLDataType type_hint) final;
   void FreeWorkspace(Device dev, void* data) final;
 
+  CPUDeviceAPI() { SetPolicy(CPUAllocPolicy::FromEnv()); }
+
   static CPUDeviceAPI* Global() {
     // NOTE: explicitly use new to avoid exit-time destruction of global state
     // Global state will be recycled by OS as the process exits.
@@ -86,6 +206,88 @@ class CPUDeviceAPI final : public DeviceAPI {
                       TVMStreamHandle stream) final {
     memcpy(static_cast<char*>(to) + to_offset, static_cast<const char*>(from) + from_offset, size);
   }
+
+ private:
+#if TVM_CPU_ALLOC_POLICY
+  // Allocate whole huge pages, placed as the policy says before they are touched.
+  void* AllocLarge(const CPUAllocPolicy& policy, size_t nbytes, size_t alignment) {
+    size_t size = (nbytes + CPUAllocPolicy::kHugePageBytes - 1) / CPUAllocPolicy::kHugePageBytes *
+                  CPUAllocPolicy::kHugePageBytes;
+    void* ptr = nullptr;
+    bool mapped = false;
+#ifdef MAP_HUGETLB
+    if (policy.hugepage == CPUAllocPolicy::kExplicit) {
+      ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                 -1, 0);
+      if (ptr == MAP_FAILED) {
+        ptr = nullptr;
+      } else {
+        mapped = true;
+      }
+    }
+#endif
+    if (ptr == nullptr) {
+      alignment = std::max(alignment, CPUAllocPolicy::kHugePageBytes);
+      if (posix_memalign(&ptr, alignment, size) != 0) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+      if (policy.hugepage != CPUAllocPolicy::kOff && madvise(ptr, size, MADV_HUGEPAGE) == 0) {
+        stats_.transparent_hugepage_bytes += size;
+      } else {
+        stats_.default_bytes += size;
+      }
+#else
+      stats_.default_bytes += size;
+#endif
+    } else {
+      stats_.explicit_hugepage_bytes += size;
+    }
+    if (policy.numa_node != CPUAllocPolicy::kNoNode) {
+      if (BindToNode(ptr, size, policy.numa_node)) {
+        stats_.numa_bound_bytes += size;
+      } else {
+        ++stats_.numa_bind_failures;
+      }
+    }
+    if (mapped) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      mapped_[ptr] = size;
+      ++num_mapped_;
+    }
+    return ptr;
+  }
+
+  // Bind the pages of a range to a NUMA node, preferring it over the other nodes.
+  static bool BindToNode(void* ptr, size_t size, int node) {
+#if defined(SYS_mbind) && defined(SYS_getcpu)
+    if (node == CPUAllocPolicy::kLocalNode) {
+      unsigned cpu, local_node;
+      if (syscall(SYS_getcpu, &cpu, &local_node, nullptr) != 0) return false;
+      node = static_cast<int>(local_node);
+    }
+    if (node < 0 || node >= 64) return false;
+    // MPOL_PREFERRED from <numaif.h>, which needs libnuma.
+    constexpr int kPreferred = 1;
+    uint64_t nodemask = uint64_t(1) << node;
+    return syscall(SYS_mbind, ptr, size, kPreferred, &nodemask, 64, 0) == 0;
+#else
+    return false;
+#endif
+  }
+
+  /*! \brief The size of the blocks from mmap, freed with munmap. */
+  std::unordered_map<void*, size_t> mapped_;
+  /*! \brief The number of blocks in mapped_, read without the lock. */
+  std::atomic<int> num_mapped_{0};
+#endif
+  /*! \brief The guard of policies_ and mapped_. */
+  std::mutex mutex_;
+  /*! \brief Every policy set, the last one is current. */
+  std::vector<std::unique_ptr<CPUAllocPolicy>> policies_;
+  /*! \brief The current policy, read without the lock. */
+  std::atomic<const CPUAllocPolicy*> policy_{nullptr};
+  /*! \brief The threshold of the current policy, the largest size when it places nothing. */
+  std::atomic<size_t> large_threshold_{std::numeric_limits<size_t>::max()};
+  CPUAllocStats stats_;
 };
 
 struct CPUWorkspacePool : public WorkspacePool {
@@ -104,5 +306,45 @@ TVM_REGISTER_GLOBAL("device_api.cpu").set_body([](TVMArgs args, TVMRetValue* rv)
   DeviceAPI* ptr = CPUDeviceAPI::Global();
   *rv = static_cast<void*>(ptr);
 });
+
+TVM_REGISTER_GLOBAL("device_api.cpu.set_alloc_policy")
+    .set_body_typed([](std::string hugepage, int64_t threshold, int numa_node) {
+      CPUAllocPolicy policy;
+      policy.hugepage = CPUAllocPolicy::ParseMode(hugepage);
+      policy.threshold = static_cast<size_t>(threshold);
+      policy.numa_node = numa_node;
+      CPUDeviceAPI::Global()->SetPolicy(policy);
+    });
+
+TVM_REGISTER_GLOBAL("device_api.cpu.alloc_stat").set_body_typed([](std::string name) {
+  const CPUAllocStats& stats = CPUDeviceAPI::Global()->stats();
+  if (name == "default_bytes") return stats.default_bytes.load();
+  if (name == "transparent_hugepage_bytes") return stats.transparent_hugepage_bytes.load();
+  if (name == "explicit_hugepage_bytes") return stats.explicit_hugepage_bytes.load();
+  if (name == "numa_bound_bytes") return stats.numa_bound_bytes.load();
+  if (name == "numa_bind_failures") return stats.numa_bind_failures.load();
+  LOG(FATAL) << "Unknown CPU allocation counter " << name;
+  return int64_t(0);
+});
+
+TVM_REGISTER_GLOBAL("device_api.cpu.reserve_workspace")
+    .set_body_typed([](int device_id, ShapeTuple sizes) {
+      Device dev{kDLCPU, device_id};
+      dmlc::ThreadLocalStore<CPUWorkspacePool>::Get()->Reserve(
+          dev, std::vector<size_t>(sizes.begin(), sizes.end()));
+    });
+
+// The statistics of the workspace pool of the calling thread.
+TVM_REGISTER_GLOBAL("device_api.cpu.workspace_stat")
+    .set_body_typed([](int device_id, std::string name) {
+      Device dev{kDLCPU, device_id};
+      WorkspacePool::Stats stats = dmlc::ThreadLocalStore<CPUWorkspacePool>::Get()->GetStats(dev);
+      if (name == "bytes_in_use") return static_cast<int64_t>(stats.bytes_in_use);
+      if (name == "peak_bytes_in_use") return static_cast<int64_t>(stats.peak_bytes_in_use);
+      if (name == "bytes_cached") return static_cast<int64_t>(stats.bytes_cached);
+      if (name == "num_device_allocs") return static_cast<int64_t>(stats.num_device_allocs);
+      LOG(FATAL) << "Unknown workspace statistic " << name;
+      return int64_t(0);
+    });
 }  // namespace runtime
 }  // namespace tvm
@@ -24,11 +24,21 @@
 
 #include <dmlc/json.h>
 #include <dmlc/memory_io.h>
+#include <tvm/runtime/device_api.h>
 #include <tvm/runtime/logging.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/serializer.h>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <unordered_map>
 #include <vector>
 
@@ -169,7 +179,8 @@ Map<String, NDArray> LoadParams(dmlc::Stream* strm) {
   Map<String, NDArray> params;
   uint64_t header, reserved;
   ICHECK(strm->Read(&header)) << "Invalid parameters file format";
-  ICHECK(header == kTVMNDArrayListMagic) << "Invalid parameters file format";
+  ICHECK(header == kTVMNDArrayListMagic || header == kTVMNDArrayListAlignedMagic)
+      << "Invalid parameters file format";
   ICHECK(strm->Read(&reserved)) << "Invalid parameters file format";
 
   std::vector<std::string> names;
@@ -179,6 +190,13 @@ Map<String, NDArray> LoadParams(dmlc::Stream* strm) {
   size_t size = static_cast<size_t>(sz);
   ICHECK(size == names.size()) << "Invalid parameters file format";
   for (size_t i = 0; i < size; ++i) {
+    if (header == kTVMNDArrayListAlignedMagic) {
+      uint64_t padding;
+      ICHECK(strm->Read(&padding)) << "Invalid parameters file format";
+      std::string bytes(padding, '\0');
+      ICHECK_EQ(strm->Read(dmlc::BeginPtr(bytes), padding), padding)
+          << "Invalid parameters file format";
+    }
     // The data_entry is allocated on device, NDArray.load always load the array into CPU.
     NDArray temp;
     temp.Load(strm);
@@ -216,6 +234,135 @@ std::string SaveParams(const Map<String, NDArray>& params) {
   return bytes;
 }
 
+std::string SaveParamsAligned(const Map<String, NDArray>& params) {
+  std::vector<std::string> names;
+  std::vector<const DLTensor*> arrays;
+  for (auto& p : params) {
+    names.push_back(p.first);
+    arrays.push_back(p.second.operator->());
+  }
+
+  std::string bytes;
+  dmlc::MemoryStringStream mstrm(&bytes);
+  dmlc::SeekStream* strm = &mstrm;
+  uint64_t header = kTVMNDArrayListAlignedMagic, reserved = 0;
+  strm->Write(header);
+  strm->Write(reserved);
+  strm->Write(names);
+  uint64_t sz = static_cast<uint64_t>(arrays.size());
+  strm->Write(sz);
+  for (size_t i = 0; i < sz; ++i) {
+    // The data follows the padding count and the header written by SaveDLTensor.
+    size_t header_bytes = sizeof(uint64_t) * 2 + sizeof(Device) + sizeof(int) +
+                          sizeof(DLDataType) + sizeof(int64_t) * (arrays[i]->ndim + 1);
+    size_t data_offset = strm->Tell() + sizeof(uint64_t) + header_bytes;
+    uint64_t padding = (kAllocAlignment - data_offset % kAllocAlignment) % kAllocAlignment;
+    strm->Write(padding);
+    std::string zeros(padding, '\0');
+    strm->Write(zeros.data(), padding);
+    tvm::runtime::SaveDLTensor(strm, arrays[i]);
+  }
+  return bytes;
+}
+
+#if !defined(_WIN32)
+namespace {
+/*! \brief A private mapping of a parameters file, unmapped with its last tensor. */
+struct MappedFile {
+  void* addr{nullptr};
+  size_t size{0};
+  ~MappedFile() {
+    if (addr != nullptr) munmap(addr, size);
+  }
+};
+
+void MappedNDArrayDeleter(Object* obj) {
+  auto* container = static_cast<NDArray::Container*>(obj);
+  delete static_cast<std::shared_ptr<MappedFile>*>(container->manager_ctx);
+  delete container;
+}
+}  // namespace
+#endif
+
+Map<String, NDArray> LoadParamsFromFile(const std::string& path) {
+#if defined(_WIN32)
+  std::ifstream fs(path, std::ios::in | std::ios::binary);
+  ICHECK(!fs.fail()) << "Cannot open file " << path;
+  std::stringstream buffer;
+  buffer << fs.rdbuf();
+  return LoadParams(buffer.str());
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  ICHECK_GE(fd, 0) << "Cannot open file " << path;
+  struct stat st;
+  ICHECK_EQ(fstat(fd, &st), 0) << "Cannot stat file " << path;
+  auto mapping = std::make_shared<MappedFile>();
+  mapping->size = static_cast<size_t>(st.st_size);
+  void* addr = mmap(nullptr, mapping->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  ICHECK(addr != MAP_FAILED) << "Cannot map file " << path;
+  mapping->addr = addr;
+
+  dmlc::MemoryFixedSizeStream mstrm(addr, mapping->size);
+  dmlc::SeekStream* strm = &mstrm;
+  uint64_t header, reserved;
+  ICHECK(strm->Read(&header)) << "Invalid parameters file format";
+  if (header != kTVMNDArrayListAlignedMagic || !DMLC_IO_NO_ENDIAN_SWAP) {
+    // the tensors cannot refer to the file, read them
+    strm->Seek(0);
+    return LoadParams(strm);
+  }
+  ICHECK(strm->Read(&reserved)) << "Invalid parameters file format";
+  std::vector<std::string> names;
+  ICHECK(strm->Read(&names)) << "Invalid parameters file format";
+  uint64_t sz;
+  ICHECK(strm->Read(&sz)) << "Invalid parameters file format";
+  size_t size = static_cast<size_t>(sz);
+  ICHECK(size == names.size()) << "Invalid parameters file format";
+
+  Map<String, NDArray> params;
+  for (size_t i = 0; i < size; ++i) {
+    uint64_t padding;
+    ICHECK(strm->Read(&padding)) << "Invalid parameters file format";
+    strm->Seek(strm->Tell() + padding);
+    uint64_t tensor_header, tensor_reserved;
+    Device dev;
+    int ndim;
+    DLDataType dtype;
+    ICHECK(strm->Read(&tensor_header)) << "Invalid DLTensor file format";
+    ICHECK(strm->Read(&tensor_reserved)) << "Invalid DLTensor file format";
+    ICHECK(tensor_header == kTVMNDArrayMagic) << "Invalid DLTensor file format";
+    ICHECK(strm->Read(&dev)) << "Invalid DLTensor file format";
+    ICHECK(strm->Read(&ndim)) << "Invalid DLTensor file format";
+    ICHECK(strm->Read(&dtype)) << "Invalid DLTensor file format";
+    ICHECK_EQ(dev.device_type, kDLCPU) << "Invalid DLTensor device: can only save as CPU tensor";
+    std::vector<int64_t> shape(ndim);
+    if (ndim != 0) {
+      ICHECK(strm->ReadArray(&shape[0], ndim)) << "Invalid DLTensor file format";
+    }
+    int64_t num_elems = 1;
+    for (int64_t extent : shape) {
+      num_elems *= extent;
+    }
+    int64_t data_byte_size;
+    ICHECK(strm->Read(&data_byte_size)) << "Invalid DLTensor file format";
+    ICHECK(data_byte_size == num_elems * ((dtype.bits * dtype.lanes + 7) / 8))
+        << "Invalid DLTensor file format";
+    size_t offset = strm->Tell();
+    ICHECK_LE(offset + data_byte_size, mapping->size) << "Invalid DLTensor file format";
+    ICHECK_EQ(offset % kAllocAlignment, 0) << "Invalid parameters file format";
+
+    auto* container =
+        new NDArray::Container(static_cast<char*>(addr) + offset, shape, dtype, dev);
+    container->manager_ctx = new std::shared_ptr<MappedFile>(mapping);
+    container->SetDeleter(MappedNDArrayDeleter);
+    params.Set(names[i], NDArray(GetObjectPtr<Object>(container)));
+    strm->Seek(offset + data_byte_size);
+  }
+  return params;
+#endif
+}
+
 TVM_REGISTER_GLOBAL("runtime.SaveParams").set_body_typed([](const Map<String, NDArray>& params) {
   std::string s = ::tvm::runtime::SaveParams(params);
   // copy return array so it is owned by the ret value
@@ -226,6 +373,17 @@ TVM_REGISTER_GLOBAL("runtime.SaveParams").set_body_typed([](const Map<String, ND
 TVM_REGISTER_GLOBAL("runtime.LoadParams").set_body_typed([](const String& s) {
   return ::tvm::runtime::LoadParams(s);
 });
+TVM_REGISTER_GLOBAL("runtime.SaveParamsAligned")
+    .set_body_typed([](const Map<String, NDArray>& params) {
+      std::string s = ::tvm::runtime::SaveParamsAligned(params);
+      // copy return array so it is owned by the ret value
+      TVMRetValue rv;
+      rv = TVMByteArray{s.data(), s.size()};
+      return rv;
+    });
+TVM_REGISTER_GLOBAL("runtime.LoadParamsFromFile").set_body_typed([](const String& path) {
+  return ::tvm::runtime::LoadParamsFromFile(path);
+});
 
 }  // namespace runtime
 }  // namespace tvm
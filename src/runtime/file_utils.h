@@ -97,6 +97,14 @@ void LoadMetaDataFromFile(const std::string& file_name,
 void RemoveFile(const std::string& file_name);
 
 constexpr uint64_t kTVMNDArrayListMagic = 0xF7E58D4F05049CB7;
+/*!
+ * \brief Magic number of the aligned parameters format.
+ *
+ *  The format is the one of kTVMNDArrayListMagic, except that each tensor is
+ *  preceded by a uint64_t count of padding bytes and the padding, placed so
+ *  that the data of the tensor starts at a multiple of kAllocAlignment.
+ */
+constexpr uint64_t kTVMNDArrayListAlignedMagic = 0xF7E58D4F05049CB8;
 /*!
  * \brief Load parameters from a string.
  * \param param_blob Serialized string of parameters.
@@ -121,6 +129,23 @@ std::string SaveParams(const Map<String, NDArray>& params);
  * \param params Parameters to save.
  */
 void SaveParams(dmlc::Stream* strm, const Map<String, NDArray>& params);
+/*!
+ * \brief Serialize parameters to a byte array in the aligned format.
+ * \param params Parameters to save.
+ * \return String containing binary parameter data.
+ */
+std::string SaveParamsAligned(const Map<String, NDArray>& params);
+/*!
+ * \brief Load parameters from a file, mapping it in memory.
+ *
+ *  The tensors of a file in the aligned format are CPU arrays referring to the
+ *  mapping, which stays alive as long as one of them. The mapping is private:
+ *  the pages are shared with the page cache, and with the other processes
+ *  mapping the same file, until written. Files in the plain format are read.
+ * \param path The path of the parameters file.
+ * \return Map of parameter name to parameter value.
+ */
+Map<String, NDArray> LoadParamsFromFile(const std::string& path);
 }  // namespace runtime
 }  // namespace tvm
 #endif  // TVM_RUNTIME_FILE_UTILS_H_
@@ -22,7 +22,9 @@
  */
 #include "graph_executor.h"
 
+#include <tvm/runtime/c_backend_api.h>
 #include <tvm/runtime/container/map.h>
+#include <tvm/runtime/container/shape_tuple.h>
 #include <tvm/runtime/container/string.h>
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/ndarray.h>
@@ -30,12 +32,19 @@
 #include <tvm/runtime/profiling.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/serializer.h>
+#include <tvm/runtime/threading_backend.h>
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <numeric>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -52,13 +61,215 @@ inline size_t GetDataAlignment(const DLTensor& arr) {
 }
 }  // namespace details
 
+/*! \brief The threads and scheduling state of the streams. */
+struct GraphExecutor::StreamState {
+  /*! \brief The worker threads, the caller of Run() is the first stream. */
+  std::vector<std::thread> workers;
+  /*! \brief The number of threads the parallel launches of each stream may use. */
+  int launch_concurrency{1};
+  std::mutex mutex;
+  std::condition_variable cv;
+  /*! \brief The operators whose dependencies have all finished. */
+  std::deque<uint32_t> ready;
+  /*! \brief The number of unfinished dependencies of each operator in this run. */
+  std::vector<uint32_t> num_pending;
+  /*! \brief The number of operators left in this run. */
+  size_t num_remaining{0};
+  /*! \brief The first error raised by an operator in this run. */
+  std::exception_ptr error;
+  bool shutdown{false};
+
+  /*!
+   * \brief Run ready operators until shutdown, or for the caller of Run(),
+   *  until every operator of the run has finished.
+   */
+  void Loop(GraphExecutor* exec, bool caller) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      cv.wait(lock, [&] { return shutdown || !ready.empty() || (caller && num_remaining == 0); });
+      if (shutdown || ready.empty()) return;
+      uint32_t nid = ready.front();
+      ready.pop_front();
+      // after a failure the remaining operators are only retired to end the run
+      bool failed = error != nullptr;
+      lock.unlock();
+      std::exception_ptr op_error;
+      if (!failed) {
+        try {
+          exec->op_execs_[nid]();
+        } catch (...) {
+          op_error = std::current_exception();
+        }
+      }
+      lock.lock();
+      if (op_error && !error) error = op_error;
+      bool notify = --num_remaining == 0;
+      for (uint32_t succ : exec->op_succs_[nid]) {
+        if (--num_pending[succ] == 0) {
+          ready.push_back(succ);
+          notify = true;
+        }
+      }
+      if (notify) cv.notify_all();
+    }
+  }
+};
+
+GraphExecutor::GraphExecutor() = default;
+
+GraphExecutor::~GraphExecutor() { SetNumStreams(1); }
+
 /*!
- * \brief Run all the operations one by one.
+ * \brief Run all the operations, one by one unless several streams are set.
  */
 void GraphExecutor::Run() {
-  // setup the array and requirements.
-  for (size_t i = 0; i < op_execs_.size(); ++i) {
-    if (op_execs_[i]) op_execs_[i]();
+  if (streams_) {
+    RunStreams();
+  } else {
+    // setup the array and requirements.
+    for (size_t i = 0; i < op_execs_.size(); ++i) {
+      if (op_execs_[i]) op_execs_[i]();
+    }
+  }
+  // no kernel writes the outputs aliased by a __nop node, copy them to their external buffer
+  for (const NodeEntry& e : outputs_) {
+    uint32_t eid = this->entry_id(e);
+    if (output_external_data_[eid] == nullptr || nodes_[e.node_id].param.func_name != "__nop") {
+      continue;
+    }
+    DLTensor external = this->OutputDLTensor(eid);
+    data_entry_[eid].CopyTo(&external);
+  }
+}
+
+void GraphExecutor::RunStreams() {
+  StreamState* streams = streams_.get();
+  {
+    std::lock_guard<std::mutex> lock(streams->mutex);
+    streams->num_pending = op_num_deps_;
+    streams->num_remaining = 0;
+    streams->error = nullptr;
+    for (uint32_t nid = 0; nid < op_execs_.size(); ++nid) {
+      if (!op_execs_[nid]) continue;
+      ++streams->num_remaining;
+      if (op_num_deps_[nid] == 0) streams->ready.push_back(nid);
+    }
+  }
+  streams->cv.notify_all();
+  // the caller runs the first stream on the first cores of its own pool
+  int prev_concurrency = threading::GetLaunchConcurrency();
+  threading::SetLaunchConcurrency(prev_concurrency > 0
+                                      ? std::min(prev_concurrency, streams->launch_concurrency)
+                                      : streams->launch_concurrency);
+  streams->Loop(this, true);
+  threading::SetLaunchConcurrency(prev_concurrency);
+  if (streams->error) std::rethrow_exception(streams->error);
+}
+
+void GraphExecutor::SetNumStreams(int num_streams) {
+  if (streams_) {
+    {
+      std::lock_guard<std::mutex> lock(streams_->mutex);
+      streams_->shutdown = true;
+    }
+    streams_->cv.notify_all();
+    for (std::thread& worker : streams_->workers) {
+      worker.join();
+    }
+    streams_.reset();
+  }
+  if (num_streams <= 1) return;
+  for (const Device& dev : devices_) {
+    if (dev.device_type != kDLCPU) {
+      LOG(WARNING) << "Concurrent streams are only supported on CPU, running operators in order";
+      return;
+    }
+  }
+  if (op_succs_.empty()) {
+    this->SetupOpDependencies();
+  }
+  streams_.reset(new StreamState());
+  int launch_concurrency = std::max(threading::MaxConcurrency() / num_streams, 1);
+  streams_->launch_concurrency = launch_concurrency;
+  for (int i = 1; i < num_streams; ++i) {
+    streams_->workers.emplace_back([this, i, launch_concurrency]() {
+      // each stream runs its parallel launches on its own cores
+      threading::BindThreadPoolToCores(i * launch_concurrency, launch_concurrency);
+      threading::SetLaunchConcurrency(launch_concurrency);
+      this->ReserveWorkspace();
+      streams_->Loop(this, false);
+    });
+  }
+}
+
+void GraphExecutor::SetupOpDependencies() {
+  uint32_t num_nodes = this->GetNumOfNodes();
+  op_succs_.assign(num_nodes, {});
+  op_num_deps_.assign(num_nodes, 0);
+  // The memory plan only guarantees that entries sharing memory do not
+  // overlap when the operators run in order. Keep that order for each byte
+  // range of a storage: a write waits for the previous writers and for every
+  // reader since then, a read waits for the previous writers, which also
+  // covers the data edges.
+  struct Access {
+    size_t begin;
+    size_t end;
+    int64_t writer;
+    std::vector<uint32_t> readers;
+  };
+  std::vector<std::vector<Access>> accesses(storage_pool_.size());
+  auto range_of = [this](uint32_t eid) {
+    size_t begin = attrs_.storage_offset.empty() ? 0 : attrs_.storage_offset[eid];
+    // Empty entries still order their producer and consumers.
+    size_t size = std::max<size_t>(GetDataSize(*data_entry_[eid].operator->()), 1);
+    return std::make_pair(begin, begin + size);
+  };
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    if (!op_execs_[nid]) continue;
+    const auto& inode = nodes_[nid];
+    std::unordered_set<uint32_t> deps;
+    auto depend_on = [&deps, nid](int64_t pred) {
+      if (pred >= 0 && pred != nid) deps.insert(static_cast<uint32_t>(pred));
+    };
+    for (const auto& e : inode.inputs) {
+      uint32_t eid = this->entry_id(e);
+      auto range = range_of(eid);
+      for (Access& access : accesses[attrs_.storage_id[eid]]) {
+        if (access.begin < range.second && range.first < access.end) {
+          depend_on(access.writer);
+          access.readers.push_back(nid);
+        }
+      }
+    }
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      uint32_t eid = this->entry_id(nid, index);
+      auto range = range_of(eid);
+      for (const Access& access : accesses[attrs_.storage_id[eid]]) {
+        if (access.begin < range.second && range.first < access.end) {
+          depend_on(access.writer);
+          for (uint32_t reader : access.readers) {
+            depend_on(reader);
+          }
+        }
+      }
+    }
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      uint32_t eid = this->entry_id(nid, index);
+      auto range = range_of(eid);
+      // The accesses covered by the write are ordered through it from now on.
+      auto& sid_accesses = accesses[attrs_.storage_id[eid]];
+      sid_accesses.erase(std::remove_if(sid_accesses.begin(), sid_accesses.end(),
+                                        [&range](const Access& access) {
+                                          return range.first <= access.begin &&
+                                                 access.end <= range.second;
+                                        }),
+                         sid_accesses.end());
+      sid_accesses.push_back({range.first, range.second, nid, {}});
+    }
+    for (uint32_t pred : deps) {
+      op_succs_[pred].push_back(nid);
+    }
+    op_num_deps_[nid] = static_cast<uint32_t>(deps.size());
   }
 }
 
@@ -86,6 +297,7 @@ void GraphExecutor::Init(const std::string& graph_json, tvm::runtime::Module mod
   }
   this->SetupStorage();
   this->SetupOpExecs();
+  this->ReserveWorkspace();
   for (size_t i = 0; i < input_nodes_.size(); i++) {
     const uint32_t nid = input_nodes_[i];
     std::string& name = nodes_[nid].name;
@@ -122,23 +334,66 @@ void GraphExecutor::SetInput(int index, DLTensor* data_in) {
 void GraphExecutor::SetInputZeroCopy(int index, DLTensor* data_ref) {
   ICHECK_LT(static_cast<size_t>(index), input_nodes_.size());
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
-  const DLTensor* old_t = data_entry_[eid].operator->();
 
   // check the consistency of input
-  ICHECK_EQ(data_alignment_[eid], details::GetDataAlignment(*data_ref));
-  ICHECK_EQ(reinterpret_cast<size_t>(data_ref->data) % kAllocAlignment, 0);
-  ICHECK_EQ(old_t->ndim, static_cast<size_t>(data_ref->ndim));
-  ICHECK_EQ(old_t->device.device_type, data_ref->device.device_type);
-  ICHECK_EQ(old_t->device.device_id, data_ref->device.device_id);
-  for (auto i = 0; i < data_ref->ndim; ++i) {
-    ICHECK_EQ(old_t->shape[i], data_ref->shape[i]);
-  }
+  CheckExternalDLTensor(data_ref, eid);
 
   // Update the data pointer for each argument of each op
   for (DLTensor* t : input_dltensors_[eid]) {
     t->data = data_ref->data;
   }
 }
+/*!
+ * \brief set index-th output of the graph without copying the data.
+ * \param index The output index.
+ * \param data_ref The output data that is referred.
+ */
+void GraphExecutor::SetOutputZeroCopy(int index, DLTensor* data_ref) {
+  ICHECK_LT(static_cast<size_t>(index), outputs_.size());
+  uint32_t eid = this->entry_id(outputs_[index]);
+  ICHECK(nodes_[outputs_[index].node_id].op_type != "null")
+      << "Output " << index << " is an input or a parameter of the graph";
+
+  // check the consistency of output
+  CheckExternalDLTensor(data_ref, eid);
+  output_external_data_[eid] = data_ref->data;
+  // a __nop node aliases the storage of its input, Run copies the output instead
+  if (nodes_[outputs_[index].node_id].param.func_name == "__nop") return;
+
+  // Update the data pointer for the op writing the output and the ops reading it
+  for (DLTensor* t : output_dltensors_[eid]) {
+    t->data = data_ref->data;
+  }
+}
+/*!
+ * \brief Get the tensor holding the node entry eid of an output, the external one if it is bound.
+ * \param eid The node entry id.
+ */
+DLTensor GraphExecutor::OutputDLTensor(uint32_t eid) const {
+  DLTensor tensor = *data_entry_[eid].operator->();
+  if (output_external_data_[eid] != nullptr) {
+    tensor.data = output_external_data_[eid];
+    tensor.byte_offset = 0;
+  }
+  return tensor;
+}
+/*!
+ * \brief Check that an external tensor can replace the node entry eid.
+ * \param external The external tensor.
+ * \param eid The node entry id.
+ */
+void GraphExecutor::CheckExternalDLTensor(const DLTensor* external, uint32_t eid) const {
+  const DLTensor* internal = data_entry_[eid].operator->();
+
+  ICHECK_EQ(data_alignment_[eid], details::GetDataAlignment(*external));
+  ICHECK_EQ(reinterpret_cast<size_t>(external->data) % kAllocAlignment, 0);
+  ICHECK_EQ(internal->ndim, static_cast<size_t>(external->ndim));
+  ICHECK_EQ(internal->device.device_type, external->device.device_type);
+  ICHECK_EQ(internal->device.device_id, external->device.device_id);
+  for (auto i = 0; i < external->ndim; ++i) {
+    ICHECK_EQ(internal->shape[i], external->shape[i]);
+  }
+}
 /*!
  * \brief Get the number of outputs
  *
@@ -171,7 +426,13 @@ NDArray GraphExecutor::GetInput(int index) const {
 NDArray GraphExecutor::GetOutput(int index) const {
   ICHECK_LT(static_cast<size_t>(index), outputs_.size());
   uint32_t eid = this->entry_id(outputs_[index]);
-  return data_entry_[eid];
+  if (output_external_data_[eid] == nullptr) return data_entry_[eid];
+  // the internal storage is stale once an external buffer is bound
+  const NDArray& data = data_entry_[eid];
+  DLTensor external = this->OutputDLTensor(eid);
+  NDArray ret = NDArray::Empty(data.Shape(), data->dtype, data->device);
+  ret.CopyFrom(&external);
+  return ret;
 }
 /*!
  * \brief Copy index-th output to data_out.
@@ -189,7 +450,8 @@ void GraphExecutor::CopyOutputTo(int index, DLTensor* data_out) {
     ICHECK_EQ(data->shape[j], data_out->shape[j]);
   }
 
-  data_entry_[eid].CopyTo(data_out);
+  DLTensor from = this->OutputDLTensor(eid);
+  NDArray::CopyFromTo(&from, data_out);
 }
 
 /*!
@@ -211,10 +473,50 @@ void GraphExecutor::LoadParams(dmlc::Stream* strm) {
   }
 }
 
+void GraphExecutor::LoadParamsFromFile(const std::string& path) {
+  Map<String, NDArray> params = ::tvm::runtime::LoadParamsFromFile(path);
+  std::unordered_set<uint32_t> shared_eids;
+  for (auto& p : params) {
+    int in_idx = GetInputIndex(p.first);
+    if (in_idx < 0) continue;
+    uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
+    const DLTensor* entry = data_entry_[eid].operator->();
+    const DLTensor* param = p.second.operator->();
+    bool same_layout = entry->ndim == param->ndim &&
+                       DataType(entry->dtype) == DataType(param->dtype) &&
+                       std::equal(entry->shape, entry->shape + entry->ndim, param->shape);
+    // Refer to the mapped file when the entry is on CPU, copy otherwise.
+    if (same_layout && entry->device.device_type == kDLCPU &&
+        reinterpret_cast<size_t>(param->data) % kAllocAlignment == 0) {
+      data_entry_[eid] = p.second;
+      data_alignment_[eid] = details::GetDataAlignment(*param);
+      // Point the arguments of the ops reading the param at the file, as SetInputZeroCopy
+      // does, the other bindings stay in place.
+      for (DLTensor* t : input_dltensors_[eid]) {
+        t->data = param->data;
+        t->byte_offset = param->byte_offset;
+      }
+      shared_eids.insert(eid);
+    } else {
+      data_entry_[eid].CopyFrom(p.second);
+    }
+  }
+  // Release the storage no entry refers to anymore.
+  std::vector<bool> used(storage_pool_.size(), false);
+  for (uint32_t eid = 0; eid < data_entry_.size(); ++eid) {
+    if (shared_eids.count(eid) == 0) used[attrs_.storage_id[eid]] = true;
+  }
+  for (uint32_t eid : shared_eids) {
+    int sid = attrs_.storage_id[eid];
+    if (!used[sid]) storage_pool_[sid] = NDArray();
+  }
+}
+
 void GraphExecutor::ShareParams(const GraphExecutor& other, dmlc::Stream* strm) {
   uint64_t header, reserved;
   ICHECK(strm->Read(&header)) << "Invalid parameters file format";
-  ICHECK(header == kTVMNDArrayListMagic) << "Invalid parameters file format";
+  ICHECK(header == kTVMNDArrayListMagic || header == kTVMNDArrayListAlignedMagic)
+      << "Invalid parameters file format";
   ICHECK(strm->Read(&reserved)) << "Invalid parameters file format";
   std::vector<std::string> names;
   ICHECK(strm->Read(&names)) << "Invalid parameters file format";
@@ -280,6 +582,9 @@ void GraphExecutor::SetupStorage() {
     vtype.push_back(tvm::runtime::String2DLDataType(s_type));
   }
 
+  if (!attrs_.storage_offset.empty()) {
+    ICHECK_EQ(attrs_.storage_offset.size(), attrs_.storage_id.size());
+  }
   // Size and device type of each storage pool entry.
   std::vector<PoolEntry> pool_entry;
   // Find the maximum space size.
@@ -299,6 +604,9 @@ void GraphExecutor::SetupStorage() {
     size_t bits = t.bits * t.lanes;
     ICHECK(bits % 8U == 0U || bits == 1U || bits == 4U);
     size_t bytes = ((bits + 7U) / 8U) * size;
+    if (!attrs_.storage_offset.empty()) {
+      bytes += static_cast<size_t>(attrs_.storage_offset[i]);
+    }
 
     uint32_t sid = static_cast<uint32_t>(storage_id);
     if (sid >= pool_entry.size()) {
@@ -348,7 +656,15 @@ void GraphExecutor::SetupStorage() {
   for (size_t i = 0; i < data_entry_.size(); ++i) {
     int storage_id = attrs_.storage_id[i];
     ICHECK_LT(static_cast<size_t>(storage_id), storage_pool_.size());
-    data_entry_[i] = storage_pool_[storage_id].CreateView(attrs_.shape[i], vtype[i]);
+    size_t offset = attrs_.storage_offset.empty() ? 0 : attrs_.storage_offset[i];
+    if (offset != 0) {
+      DLDeviceType device_type = storage_pool_[storage_id]->device.device_type;
+      // The offset is applied to the data pointer, which is a handle on other devices.
+      ICHECK(device_type == kDLCPU || device_type == kDLCUDA || device_type == kDLCUDAHost ||
+             device_type == kDLCUDAManaged || device_type == kDLROCM)
+          << "Storage offsets are not supported on " << DeviceName(device_type);
+    }
+    data_entry_[i] = storage_pool_[storage_id].CreateView(attrs_.shape[i], vtype[i], offset);
 
     const DLTensor* tmp = data_entry_[i].operator->();
     data_alignment_[i] = details::GetDataAlignment(*tmp);
@@ -357,12 +673,19 @@ void GraphExecutor::SetupStorage() {
 
 void GraphExecutor::SetupOpExecs() {
   op_execs_.resize(this->GetNumOfNodes());
-  input_dltensors_.resize(num_node_entries());
+  // the op arguments of a previous setup are released
+  input_dltensors_.assign(num_node_entries(), {});
+  output_dltensors_.assign(num_node_entries(), {});
+  output_external_data_.assign(num_node_entries(), nullptr);
   std::unordered_set<uint32_t> input_node_eids;
   for (size_t i = 0; i < input_nodes_.size(); i++) {
     uint32_t nid = input_nodes_[i];
     input_node_eids.insert(entry_id(nid, 0));
   }
+  std::unordered_set<uint32_t> output_node_eids;
+  for (size_t i = 0; i < outputs_.size(); i++) {
+    output_node_eids.insert(entry_id(outputs_[i]));
+  }
 
   // setup the array and requirements.
   for (uint32_t nid = 0; nid < this->GetNumOfNodes(); ++nid) {
@@ -388,10 +711,103 @@ void GraphExecutor::SetupOpExecs() {
       if (input_node_eids.count(eid) > 0) {
         input_dltensors_[eid].push_back(static_cast<DLTensor*>(op_args->arg_values[i].v_handle));
       }
+      // check if op input is model output
+      if (output_node_eids.count(eid) > 0) {
+        output_dltensors_[eid].push_back(static_cast<DLTensor*>(op_args->arg_values[i].v_handle));
+      }
+    }
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      uint32_t eid = this->entry_id(nid, index);
+      // check if op output is model output
+      if (output_node_eids.count(eid) > 0) {
+        output_dltensors_[eid].push_back(static_cast<DLTensor*>(
+            op_args->arg_values[inode.inputs.size() + index].v_handle));
+      }
     }
   }
 }
 
+namespace {
+/*! \brief The workspace allocations of the kernels running on a device. */
+struct DeviceWorkspace {
+  Device dev;
+  /*! \brief The allocations of each kernel, which may be live at the same time. */
+  std::vector<ShapeTuple> kernels;
+};
+
+// Reserve the workspace of the kernels in the pool of the calling thread.
+void ReserveWorkspaceOnThread(const DeviceWorkspace& workspace) {
+  const Device& dev = workspace.dev;
+  const PackedFunc* reserve =
+      Registry::Get(std::string("device_api.") + DeviceName(dev.device_type) + ".reserve_workspace");
+  for (const ShapeTuple& sizes : workspace.kernels) {
+    if (reserve != nullptr) {
+      (*reserve)(dev.device_id, sizes);
+      continue;
+    }
+    // Without a reservation hook, the blocks stay cached in the pool once freed.
+    DeviceAPI* api = DeviceAPI::Get(dev);
+    std::vector<void*> blocks;
+    for (int64_t size : sizes) {
+      blocks.push_back(api->AllocWorkspace(dev, static_cast<size_t>(size)));
+    }
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+      api->FreeWorkspace(dev, *it);
+    }
+  }
+}
+
+// Parse the comma-separated sizes of a workspace attribute.
+std::vector<int64_t> ParseWorkspaceBytes(const std::string& value) {
+  std::vector<int64_t> sizes;
+  std::istringstream is(value);
+  std::string size;
+  while (std::getline(is, size, ',')) {
+    sizes.push_back(std::stoll(size));
+  }
+  return sizes;
+}
+}  // namespace
+
+void GraphExecutor::ReserveWorkspace() {
+  std::vector<DeviceWorkspace> serial, parallel;
+  auto add = [](std::vector<DeviceWorkspace>* workspace, Device dev, std::vector<int64_t> sizes) {
+    auto it = std::find_if(workspace->begin(), workspace->end(), [&dev](const DeviceWorkspace& w) {
+      return w.dev.device_type == dev.device_type && w.dev.device_id == dev.device_id;
+    });
+    if (it == workspace->end()) {
+      workspace->push_back(DeviceWorkspace{dev, {}});
+      it = workspace->end() - 1;
+    }
+    it->kernels.push_back(ShapeTuple(std::move(sizes)));
+  };
+  for (uint32_t nid = 0; nid < this->GetNumOfNodes(); ++nid) {
+    const auto& inode = nodes_[nid];
+    if (inode.op_type == "null" || inode.param.num_outputs == 0) continue;
+    Device dev = data_entry_[entry_id(nid, 0)]->device;
+    auto it = inode.param.attrs.find("workspace_bytes");
+    if (it != inode.param.attrs.end()) {
+      add(&serial, dev, ParseWorkspaceBytes(Downcast<String>(it->second)));
+    }
+    it = inode.param.attrs.find("parallel_workspace_bytes");
+    if (it != inode.param.attrs.end()) {
+      add(&parallel, dev, ParseWorkspaceBytes(Downcast<String>(it->second)));
+    }
+  }
+  for (const DeviceWorkspace& workspace : serial) {
+    ReserveWorkspaceOnThread(workspace);
+  }
+  for (const DeviceWorkspace& workspace : parallel) {
+    // Every thread taking a task of a launch, including the calling one, reserves in its own
+    // pool, as for the parallel loops of the kernels.
+    auto reserve = [](int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+      ReserveWorkspaceOnThread(*static_cast<const DeviceWorkspace*>(cdata));
+      return 0;
+    };
+    TVMBackendParallelLaunch(reserve, const_cast<DeviceWorkspace*>(&workspace), 0);
+  }
+}
+
 std::pair<std::function<void()>, std::shared_ptr<GraphExecutor::OpArgs> >
 GraphExecutor::CreateTVMOp(const TVMOpParam& param, const std::vector<DLTensor>& args,
                            size_t num_inputs) {
@@ -463,6 +879,10 @@ PackedFunc GraphExecutor::GetFunction(const std::string& name,
         this->SetInputZeroCopy(args[0], args[1]);
       }
     });
+  } else if (name == "set_output_zero_copy") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->SetOutputZeroCopy(args[0], args[1]);
+    });
   } else if (name == "get_output") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       if (args.num_args == 2) {
@@ -483,6 +903,10 @@ PackedFunc GraphExecutor::GetFunction(const std::string& name,
         *rv = this->GetInput(in_idx);
       }
     });
+  } else if (name == "get_input_index") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      *rv = this->GetInputIndex(args[0].operator String());
+    });
   } else if (name == "get_num_outputs") {
     return PackedFunc(
         [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->NumOutputs(); });
@@ -491,10 +915,17 @@ PackedFunc GraphExecutor::GetFunction(const std::string& name,
         [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->NumInputs(); });
   } else if (name == "run") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->Run(); });
+  } else if (name == "set_num_streams") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->SetNumStreams(args[0]); });
   } else if (name == "load_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       this->LoadParams(args[0].operator std::string());
     });
+  } else if (name == "load_params_from_file") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->LoadParamsFromFile(args[0].operator std::string());
+    });
   } else if (name == "share_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       const auto& module = args[0].operator Module();
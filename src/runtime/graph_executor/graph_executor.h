@@ -85,6 +85,24 @@ class TVM_DLL GraphExecutor : public ModuleNode {
   const char* type_key() const final { return "GraphExecutor"; }
   void Run();
 
+  GraphExecutor();
+  ~GraphExecutor();
+
+  /*!
+   * \brief Set the number of streams that run independent operators concurrently.
+   *
+   *  With more than one stream, Run() starts every operator as soon as the
+   *  operators it depends on have finished, on num_streams threads including
+   *  the caller. The dependencies are the data edges of the graph plus an
+   *  ordering between operators whose entries share storage in the memory
+   *  plan. The parallel launches of each stream use an even share of the CPU
+   *  cores, disjoint from the cores of the other streams: the caller uses the
+   *  first ones and every other stream binds its thread pool to the next ones.
+   *  Only graphs running entirely on CPU use more than one stream.
+   * \param num_streams The number of streams, 1 to run the operators in order.
+   */
+  void SetNumStreams(int num_streams);
+
   /*!
    * \brief Initialize the graph executor with graph and device.
    * \param graph_json The execution graph.
@@ -119,6 +137,16 @@ class TVM_DLL GraphExecutor : public ModuleNode {
    * \param data_ref The input data that is referred.
    */
   void SetInputZeroCopy(int index, DLTensor* data_ref);
+  /*!
+   * \brief set index-th output of the graph without copying the data.
+   *
+   *  The operator producing the output writes into data_ref directly, and the
+   *  operators consuming the output inside the graph read from it. An output
+   *  aliased by a __nop node is copied into data_ref at the end of Run.
+   * \param index The output index.
+   * \param data_ref The output data that is referred.
+   */
+  void SetOutputZeroCopy(int index, DLTensor* data_ref);
   /*!
    * \brief Get the number of outputs
    *
@@ -162,6 +190,18 @@ class TVM_DLL GraphExecutor : public ModuleNode {
    */
   void LoadParams(const std::string& param_blob);
 
+  /*!
+   * \brief Load parameters from a file, see runtime::LoadParamsFromFile.
+   *
+   *  The parameters on CPU refer to the mapping of a file in the aligned
+   *  format instead of being copied, so executors loading the same file,
+   *  in this process or another one, share the memory of the parameters.
+   *  Their planned storage is released, and the zero-copy bindings of the
+   *  inputs and outputs are kept.
+   * \param path The path of the parameters file.
+   */
+  void LoadParamsFromFile(const std::string& path);
+
   /*!
    * \brief Share parameters from pre-existing GraphExecutor instance.
    * \param other A GraphExecutor instance, previously with |LoadParams| called with the
@@ -275,6 +315,8 @@ class TVM_DLL GraphExecutor : public ModuleNode {
   struct GraphAttr {
     size_t storage_num_not_alloctaed{0};
     std::vector<int> storage_id;
+    /*! \brief The byte offset of each entry in its storage, empty if all are zero. */
+    std::vector<int64_t> storage_offset;
     std::vector<int> device_index;
     std::vector<std::string> dltype;
     std::vector<std::vector<int64_t>> shape;
@@ -319,6 +361,14 @@ class TVM_DLL GraphExecutor : public ModuleNode {
           ICHECK(reader->NextArrayItem());
           reader->Read(&device_index);
           ICHECK(!reader->NextArrayItem());
+        } else if (key == "storage_offset") {
+          reader->BeginArray();
+          ICHECK(reader->NextArrayItem());
+          reader->Read(&type);
+          ICHECK_EQ(type, "list_int");
+          ICHECK(reader->NextArrayItem());
+          reader->Read(&storage_offset);
+          ICHECK(!reader->NextArrayItem());
         } else {
           reader->BeginArray();
           ICHECK(reader->NextArrayItem());
@@ -377,6 +427,14 @@ class TVM_DLL GraphExecutor : public ModuleNode {
   void SetupStorage();
   /*! \brief Setup the executors. */
   void SetupOpExecs();
+  /*!
+   * \brief Reserve the workspace allocations recorded in the "workspace_bytes" and
+   *  "parallel_workspace_bytes" attributes of the operators, so that running them
+   *  does not allocate. The workspace pools are per thread: the former are reserved
+   *  in the pool of the calling thread, the latter in the pools of the threads
+   *  running its parallel launches. Called on every thread that runs operators.
+   */
+  void ReserveWorkspace();
   /*!
    * \brief Create an execution function given input.
    * \param attrs The node attributes.
@@ -392,6 +450,16 @@ class TVM_DLL GraphExecutor : public ModuleNode {
   uint32_t entry_id(const NodeEntry& e) const { return entry_id(e.node_id, e.index); }
   // Number of node entries.
   uint32_t num_node_entries() const { return node_row_ptr_.back(); }
+  /*! \brief Check that an external tensor can replace the node entry eid. */
+  void CheckExternalDLTensor(const DLTensor* external, uint32_t eid) const;
+  /*! \brief Get the tensor of the output entry eid, pointing to its external buffer if bound. */
+  DLTensor OutputDLTensor(uint32_t eid) const;
+  /*! \brief Build the dependencies between operators for concurrent runs. */
+  void SetupOpDependencies();
+  /*! \brief Run the operators concurrently on the streams. */
+  void RunStreams();
+  /*! \brief The threads and scheduling state of the streams. */
+  struct StreamState;
   /*! \brief The graph nodes. */
   std::vector<Node> nodes_;
   /*! \brief The argument nodes. */
@@ -400,6 +468,10 @@ class TVM_DLL GraphExecutor : public ModuleNode {
   std::unordered_map<std::string, uint32_t> input_map_;
   /*! \brief Used for quick node input DLTensor* lookup given an input eid. */
   std::vector<std::vector<DLTensor*>> input_dltensors_;
+  /*! \brief Used for quick lookup of the op arguments referring to an output eid. */
+  std::vector<std::vector<DLTensor*>> output_dltensors_;
+  /*! \brief The external buffer bound to each output eid by SetOutputZeroCopy, null if unbound. */
+  std::vector<void*> output_external_data_;
   /*! \brief Used for quick entry indexing. */
   std::vector<uint32_t> node_row_ptr_;
   /*! \brief Output entries. */
@@ -427,6 +499,12 @@ class TVM_DLL GraphExecutor : public ModuleNode {
    * When the module does not include linked parmeters, module_lookup_linked_param_ will be nullptr.
    */
   bool module_lookup_linked_param_valid_;
+  /*! \brief The operators depending on each node, see SetupOpDependencies. */
+  std::vector<std::vector<uint32_t>> op_succs_;
+  /*! \brief The number of operators each node depends on. */
+  std::vector<uint32_t> op_num_deps_;
+  /*! \brief The streams running operators concurrently, null when running in order. */
+  std::unique_ptr<StreamState> streams_;
 };
 
 std::vector<Device> GetAllDevice(const TVMArgs& args, int dev_start_arg);
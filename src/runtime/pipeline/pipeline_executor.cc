@@ -0,0 +1,305 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file pipeline_executor.cc
+ */
+#include "pipeline_executor.h"
+
+#include <tvm/runtime/container/shape_tuple.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace tvm {
+namespace runtime {
+
+PipelineExecutor::~PipelineExecutor() { Stop(); }
+
+void PipelineExecutor::Init(const std::vector<Module>& stages,
+                            const std::vector<Connection>& connections, int queue_size) {
+  ICHECK(!stages.empty()) << "A pipeline needs at least one stage";
+  ICHECK_GT(queue_size, 0);
+  for (const Connection& conn : connections) {
+    if (conn.src_stage == -1) num_inputs_ = std::max(num_inputs_, conn.src_index + 1);
+  }
+  int num_values = num_inputs_;
+  stages_.resize(stages.size());
+  for (size_t i = 0; i < stages.size(); ++i) {
+    Stage& stage = stages_[i];
+    ICHECK_EQ(std::string(stages[i]->type_key()), "GraphExecutor")
+        << "Stage " << i << " of the pipeline is not a graph executor";
+    stage.module = stages[i];
+    stage.exec = static_cast<GraphExecutor*>(stage.module.operator->());
+    stage.input_values.assign(stage.exec->NumInputs(), -1);
+    stage.input_staging.resize(stage.exec->NumInputs());
+    stage.output_used.assign(stage.exec->NumOutputs(), false);
+    value_offset_.push_back(num_values);
+    num_values += stage.exec->NumOutputs();
+  }
+  value_returned_.assign(num_values, false);
+  value_templates_.resize(num_values);
+  free_buffers_.resize(num_values);
+
+  int num_stages = static_cast<int>(stages_.size());
+  for (const Connection& conn : connections) {
+    int v = conn.src_index;
+    if (conn.src_stage != -1) {
+      ICHECK(conn.src_stage >= 0 && conn.src_stage < num_stages)
+          << "Invalid source stage " << conn.src_stage;
+      Stage& src = stages_[conn.src_stage];
+      ICHECK(conn.src_index >= 0 && conn.src_index < src.exec->NumOutputs())
+          << "Stage " << conn.src_stage << " has no output " << conn.src_index;
+      src.output_used[conn.src_index] = true;
+      v = value_offset_[conn.src_stage] + conn.src_index;
+    }
+    ICHECK_GE(v, 0) << "Invalid pipeline input " << conn.src_index;
+    if (conn.dst_stage == -1) {
+      ICHECK_GE(conn.dst_index, 0) << "Invalid pipeline output " << conn.dst_index;
+      if (output_values_.size() <= static_cast<size_t>(conn.dst_index)) {
+        output_values_.resize(conn.dst_index + 1, -1);
+      }
+      ICHECK_EQ(output_values_[conn.dst_index], -1)
+          << "Pipeline output " << conn.dst_index << " is connected twice";
+      output_values_[conn.dst_index] = v;
+      value_returned_[v] = true;
+    } else {
+      ICHECK(conn.dst_stage >= 0 && conn.dst_stage < num_stages)
+          << "Invalid destination stage " << conn.dst_stage;
+      ICHECK_LT(conn.src_stage, conn.dst_stage)
+          << "Connections must go from an earlier to a later stage";
+      Stage& dst = stages_[conn.dst_stage];
+      ICHECK(conn.dst_index >= 0 && conn.dst_index < dst.exec->NumInputs())
+          << "Stage " << conn.dst_stage << " has no input " << conn.dst_index;
+      ICHECK_EQ(dst.input_values[conn.dst_index], -1)
+          << "Input " << conn.dst_index << " of stage " << conn.dst_stage << " is connected twice";
+      dst.input_values[conn.dst_index] = v;
+    }
+  }
+  for (size_t i = 0; i < output_values_.size(); ++i) {
+    ICHECK_GE(output_values_[i], 0) << "Pipeline output " << i << " is not connected";
+  }
+  for (int i = 0; i < num_stages; ++i) {
+    Stage& stage = stages_[i];
+    for (size_t j = 0; j < stage.output_used.size(); ++j) {
+      if (stage.output_used[j]) {
+        value_templates_[value_offset_[i] + j] = stage.exec->GetOutput(j);
+      }
+    }
+  }
+
+  for (Stage& stage : stages_) {
+    stage.queue.reset(new BoundedQueue<std::shared_ptr<Request>>(queue_size));
+  }
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    stages_[i].thread = std::thread([this, i]() { this->RunStage(i); });
+  }
+}
+
+void PipelineExecutor::Submit(const std::vector<NDArray>& inputs) {
+  ICHECK_EQ(inputs.size(), static_cast<size_t>(num_inputs_))
+      << "The pipeline expects " << num_inputs_ << " inputs";
+  auto request = std::make_shared<Request>();
+  request->values.resize(value_templates_.size());
+  std::copy(inputs.begin(), inputs.end(), request->values.begin());
+  {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    ++num_pending_;
+  }
+  stages_[0].queue->Push(std::move(request));
+}
+
+Array<NDArray> PipelineExecutor::GetOutput() {
+  std::shared_ptr<Request> request;
+  {
+    std::unique_lock<std::mutex> lock(result_mutex_);
+    ICHECK_GT(num_pending_, 0) << "The outputs of every submitted input were collected";
+    result_cv_.wait(lock, [this] { return !results_.empty(); });
+    request = std::move(results_.front());
+    results_.pop_front();
+    --num_pending_;
+  }
+  if (request->error) std::rethrow_exception(request->error);
+  Array<NDArray> outputs;
+  for (int v : output_values_) {
+    outputs.push_back(request->values[v]);
+  }
+  return outputs;
+}
+
+int PipelineExecutor::NumPending() {
+  std::lock_guard<std::mutex> lock(result_mutex_);
+  return num_pending_;
+}
+
+void PipelineExecutor::RunStage(size_t index) {
+  // the stages split the cores for the parallel loops of their operators, each stage
+  // pins its thread pool to its own slice so that the stages do not share cores
+  int concurrency = std::max(threading::MaxConcurrency() / static_cast<int>(stages_.size()), 1);
+  threading::BindThreadPoolToCores(static_cast<int>(index) * concurrency, concurrency);
+  threading::SetLaunchConcurrency(concurrency);
+  Stage& stage = stages_[index];
+  std::shared_ptr<Request> request;
+  while (stage.queue->Pop(&request)) {
+    if (!request->error) {
+      try {
+        this->RunRequest(index, request.get());
+      } catch (...) {
+        request->error = std::current_exception();
+      }
+    }
+    if (index + 1 < stages_.size()) {
+      if (!stages_[index + 1].queue->Push(std::move(request))) return;
+    } else {
+      this->Finish(std::move(request));
+    }
+  }
+}
+
+void PipelineExecutor::RunRequest(size_t index, Request* request) {
+  Stage& stage = stages_[index];
+  GraphExecutor* exec = stage.exec;
+  for (size_t i = 0; i < stage.input_values.size(); ++i) {
+    int v = stage.input_values[i];
+    if (v < 0) continue;
+    const NDArray& value = request->values[v];
+    ICHECK(value.defined()) << "Input " << i << " of stage " << index << " is not computed";
+    Device dev = exec->GetInput(i)->device;
+    if (value->device.device_type == dev.device_type &&
+        value->device.device_id == dev.device_id) {
+      exec->SetInputZeroCopy(i, const_cast<DLTensor*>(value.operator->()));
+    } else {
+      NDArray& staging = stage.input_staging[i];
+      if (!staging.defined()) {
+        staging = NDArray::Empty(value.Shape(), value->dtype, dev);
+      }
+      staging.CopyFrom(value);
+      exec->SetInputZeroCopy(i, const_cast<DLTensor*>(staging.operator->()));
+    }
+  }
+  for (size_t j = 0; j < stage.output_used.size(); ++j) {
+    if (!stage.output_used[j]) continue;
+    int v = value_offset_[index] + static_cast<int>(j);
+    request->values[v] = this->AllocBuffer(v);
+    exec->SetOutputZeroCopy(j, const_cast<DLTensor*>(request->values[v].operator->()));
+  }
+  exec->Run();
+  // the next stages read the outputs from other threads
+  for (size_t j = 0; j < stage.output_used.size(); ++j) {
+    if (!stage.output_used[j]) continue;
+    Device dev = request->values[value_offset_[index] + j]->device;
+    if (dev.device_type != kDLCPU) {
+      DeviceAPI::Get(dev)->StreamSync(dev, nullptr);
+    }
+  }
+}
+
+void PipelineExecutor::Finish(std::shared_ptr<Request> request) {
+  {
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+    for (size_t v = num_inputs_; v < request->values.size(); ++v) {
+      if (request->values[v].defined() && !value_returned_[v]) {
+        free_buffers_[v].push_back(std::move(request->values[v]));
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    results_.push_back(std::move(request));
+  }
+  result_cv_.notify_all();
+}
+
+NDArray PipelineExecutor::AllocBuffer(int v) {
+  {
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+    if (!free_buffers_[v].empty()) {
+      NDArray buffer = std::move(free_buffers_[v].back());
+      free_buffers_[v].pop_back();
+      return buffer;
+    }
+  }
+  const NDArray& templ = value_templates_[v];
+  return NDArray::Empty(templ.Shape(), templ->dtype, templ->device);
+}
+
+void PipelineExecutor::Stop() {
+  for (Stage& stage : stages_) {
+    if (stage.queue) stage.queue->Close();
+  }
+  for (Stage& stage : stages_) {
+    if (stage.thread.joinable()) stage.thread.join();
+  }
+}
+
+PackedFunc PipelineExecutor::GetFunction(const std::string& name,
+                                         const ObjectPtr<Object>& sptr_to_self) {
+  if (name == "submit") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::vector<NDArray> inputs;
+      for (int i = 0; i < args.num_args; ++i) {
+        inputs.push_back(args[i]);
+      }
+      this->Submit(inputs);
+    });
+  } else if (name == "get_output") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->GetOutput(); });
+  } else if (name == "num_pending") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->NumPending(); });
+  } else if (name == "get_num_inputs") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->NumInputs(); });
+  } else if (name == "get_num_outputs") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->NumOutputs(); });
+  } else {
+    return PackedFunc();
+  }
+}
+
+// Arguments: the connections flattened as (src_stage, src_index, dst_stage, dst_index)
+// in a ShapeTuple, the queue size, then the graph executor module of each stage.
+TVM_REGISTER_GLOBAL("tvm.pipeline_executor.create").set_body([](TVMArgs args, TVMRetValue* rv) {
+  ICHECK_GE(args.num_args, 3) << "The expected number of arguments for pipeline_executor.create "
+                                 "is at least 3, but it has "
+                              << args.num_args;
+  ShapeTuple wiring = args[0];
+  ICHECK_EQ(wiring.size() % 4, 0) << "Each connection has 4 fields";
+  std::vector<PipelineExecutor::Connection> connections;
+  for (size_t i = 0; i < wiring.size(); i += 4) {
+    connections.push_back({static_cast<int>(wiring[i]), static_cast<int>(wiring[i + 1]),
+                           static_cast<int>(wiring[i + 2]), static_cast<int>(wiring[i + 3])});
+  }
+  int queue_size = args[1];
+  std::vector<Module> stages;
+  for (int i = 2; i < args.num_args; ++i) {
+    stages.push_back(args[i]);
+  }
+  auto exec = make_object<PipelineExecutor>();
+  exec->Init(stages, connections, queue_size);
+  *rv = Module(exec);
+});
+
+}  // namespace runtime
+}  // namespace tvm
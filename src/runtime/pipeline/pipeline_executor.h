@@ -0,0 +1,237 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \brief Pipeline executor running a chain of graph executors, one thread per stage.
+ * \file pipeline_executor.h
+ */
+#ifndef TVM_RUNTIME_PIPELINE_PIPELINE_EXECUTOR_H_
+#define TVM_RUNTIME_PIPELINE_PIPELINE_EXECUTOR_H_
+
+#include <tvm/runtime/container/array.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../graph_executor/graph_executor.h"
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief A FIFO queue holding at most capacity items.
+ *
+ *  Push blocks while the queue is full and Pop while it is empty. Close wakes
+ *  up every waiting thread and makes both fail from then on.
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+  /*!
+   * \brief Append an item, waiting for room.
+   * \return false if the queue was closed.
+   */
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+    if (closed_) return false;
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+  /*!
+   * \brief Remove the oldest item, waiting for one.
+   * \return false if the queue was closed.
+   */
+  bool Pop(T* item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+    if (closed_) return false;
+    *item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+  /*! \brief Close the queue and drop the items left. */
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+      items_.clear();
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+ private:
+  size_t capacity_;
+  bool closed_{false};
+  std::deque<T> items_;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+
+/*!
+ * \brief Pipeline executor.
+ *
+ *  Runs a list of graph executor stages, each on its own thread, with a
+ *  bounded queue in front of every stage. Inputs submitted to the pipeline
+ *  flow through the stages in order, and their outputs are collected in
+ *  submission order, so consecutive inputs are processed by different stages
+ *  at the same time.
+ *
+ *  The wiring is a list of connections from a source to a destination. A
+ *  source is an output of a stage or, with stage -1, an input of the pipeline.
+ *  A destination is an input of a stage or, with stage -1, an output of the
+ *  pipeline. Connections between stages go from an earlier to a later stage.
+ *
+ *  The stages exchange data without copies: every request owns the buffers of
+ *  the stage outputs it uses, which the producing stage writes through
+ *  SetOutputZeroCopy and the consuming stages read through SetInputZeroCopy.
+ *  The buffers of intermediate values are recycled once the request leaves
+ *  the pipeline. A value is copied only when the consuming stage runs on
+ *  another device.
+ */
+class TVM_DLL PipelineExecutor : public ModuleNode {
+ public:
+  /*! \brief A connection, see the class documentation. */
+  struct Connection {
+    int src_stage;
+    int src_index;
+    int dst_stage;
+    int dst_index;
+  };
+
+  ~PipelineExecutor();
+
+  /*!
+   * \brief Get member function to front-end
+   * \param name The name of the function.
+   * \param sptr_to_self The pointer to the module node.
+   * \return The corresponding member function.
+   */
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final;
+
+  const char* type_key() const final { return "PipelineExecutor"; }
+
+  /*!
+   * \brief Initialize the pipeline and start the stage threads.
+   * \param stages The graph executor modules of the stages, owned by the pipeline.
+   * \param connections The wiring of the stages.
+   * \param queue_size The number of requests waiting in front of each stage.
+   */
+  void Init(const std::vector<Module>& stages, const std::vector<Connection>& connections,
+            int queue_size);
+  /*!
+   * \brief Submit the inputs of a request, waiting while the first stage is busy.
+   *  The arrays are read without copies and must not change until the outputs
+   *  of the request are collected.
+   * \param inputs The inputs of the pipeline.
+   */
+  void Submit(const std::vector<NDArray>& inputs);
+  /*!
+   * \brief Get the outputs of the oldest request, waiting for it to finish.
+   *  An error raised by a stage for this request is rethrown here.
+   * \return The outputs of the pipeline.
+   */
+  Array<NDArray> GetOutput();
+  /*! \return The number of submitted requests whose outputs were not collected. */
+  int NumPending();
+  /*! \return The number of inputs of the pipeline. */
+  int NumInputs() const { return num_inputs_; }
+  /*! \return The number of outputs of the pipeline. */
+  int NumOutputs() const { return static_cast<int>(output_values_.size()); }
+
+ private:
+  /*! \brief A request flowing through the stages. */
+  struct Request {
+    /*! \brief The pipeline inputs followed by the stage outputs, see value_offset_. */
+    std::vector<NDArray> values;
+    /*! \brief The first error raised by a stage, the later stages are skipped. */
+    std::exception_ptr error;
+  };
+  /*! \brief A stage of the pipeline. */
+  struct Stage {
+    /*! \brief The module holding the executor. */
+    Module module;
+    /*! \brief The graph executor of the stage. */
+    GraphExecutor* exec;
+    /*! \brief The value read by each input of the stage. */
+    std::vector<int> input_values;
+    /*! \brief The buffers receiving the inputs whose value is on another device. */
+    std::vector<NDArray> input_staging;
+    /*! \brief Whether each output is used after the stage and needs a buffer per request. */
+    std::vector<bool> output_used;
+    /*! \brief The requests waiting for the stage. */
+    std::unique_ptr<BoundedQueue<std::shared_ptr<Request>>> queue;
+    /*! \brief The thread running the stage. */
+    std::thread thread;
+  };
+
+  /*! \brief The loop of the thread running stage index. */
+  void RunStage(size_t index);
+  /*! \brief Run a request on a stage. */
+  void RunRequest(size_t index, Request* request);
+  /*! \brief Hand a request leaving the last stage to GetOutput. */
+  void Finish(std::shared_ptr<Request> request);
+  /*! \brief Get a buffer for value v of a new request. */
+  NDArray AllocBuffer(int v);
+  /*! \brief Close the queues and join the stage threads. */
+  void Stop();
+
+  /*! \brief The stages. */
+  std::vector<Stage> stages_;
+  /*! \brief The number of inputs of the pipeline. */
+  int num_inputs_{0};
+  /*! \brief The id of the value of output 0 of each stage. */
+  std::vector<int> value_offset_;
+  /*! \brief The value of each output of the pipeline. */
+  std::vector<int> output_values_;
+  /*! \brief Whether each value is an output of the pipeline, given to the caller. */
+  std::vector<bool> value_returned_;
+  /*! \brief A tensor describing each stage output value, empty for inputs. */
+  std::vector<NDArray> value_templates_;
+  /*! \brief The guard of free_buffers_. */
+  std::mutex buffer_mutex_;
+  /*! \brief The recycled buffers of each intermediate value. */
+  std::vector<std::vector<NDArray>> free_buffers_;
+  /*! \brief The guard of the requests in flight and the finished ones. */
+  std::mutex result_mutex_;
+  std::condition_variable result_cv_;
+  /*! \brief The finished requests, in submission order. */
+  std::deque<std::shared_ptr<Request>> results_;
+  /*! \brief The number of submitted requests not collected yet. */
+  int num_pending_{0};
+};
+
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_PIPELINE_PIPELINE_EXECUTOR_H_
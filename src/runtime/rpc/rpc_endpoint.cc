@@ -33,6 +33,7 @@
 #include <array>
 #include <chrono>
 #include <cmath>
+#include <exception>
 #include <memory>
 #include <string>
 #include <utility>
@@ -797,46 +798,135 @@ void RPCEndpoint::CallFunc(RPCSession::PackedFuncHandle h, const TVMValue* arg_v
   ICHECK(code == RPCCode::kReturn) << "code=" << RPCCodeToString(code);
 }
 
-void RPCEndpoint::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  RPCCode code = RPCCode::kCopyToRemote;
+void RPCEndpoint::SendDirect(const void* data, uint64_t nbytes) {
+  // Small payloads are cheaper to buffer with the header.
+  constexpr uint64_t kMinDirectBytes = 64 << 10;
+  if (nbytes < kMinDirectBytes) {
+    handler_->WriteArray(static_cast<const char*>(data), nbytes);
+    return;
+  }
+  while (writer_.bytes_available() != 0) {
+    size_t n = writer_.ReadWithCallback(
+        [this](const void* data, size_t size) { return channel_->Send(data, size); },
+        writer_.bytes_available());
+    ICHECK_NE(n, 0U) << "Channel closes before the data is sent";
+  }
+  const char* ptr = static_cast<const char*>(data);
+  while (nbytes != 0) {
+    size_t n = channel_->Send(ptr, nbytes);
+    ICHECK_NE(n, 0U) << "Channel closes before the data is sent";
+    ptr += n;
+    nbytes -= n;
+  }
+}
 
+uint64_t RPCEndpoint::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes,
+                                   const RPCCopyOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t chunk_bytes = options.chunk_bytes != 0 ? options.chunk_bytes : nbytes;
+  int max_inflight = std::max(options.max_inflight, 1);
   uint64_t tensor_total_size_bytes = static_cast<uint64_t>(GetDataSize(*to));
-  ICHECK_LE(to->byte_offset + nbytes, tensor_total_size_bytes)
-      << "CopyToRemote: overflow in tensor size: (byte_offset=" << to->byte_offset
-      << ", nbytes=" << nbytes << ", tensor_total_size=" << tensor_total_size_bytes << ")";
-
-  uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(to, code, nbytes);
-  uint64_t packet_nbytes = overhead + nbytes;
-
-  handler_->Write(packet_nbytes);
-  handler_->Write(code);
-  RPCReference::SendDLTensor(handler_, to);
-  handler_->Write(nbytes);
-  handler_->WriteArray(reinterpret_cast<char*>(from_bytes), nbytes);
-  ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+  ICHECK_LE(nbytes, tensor_total_size_bytes)
+      << "CopyToRemote: overflow in tensor size: (nbytes=" << nbytes
+      << ", tensor_total_size=" << tensor_total_size_bytes << ")";
+  std::string encoded;
+  uint64_t bytes_sent = 0;
+  int inflight = 0;
+  // The first error replied, raised once all the replies are received.
+  std::exception_ptr error;
+  auto wait_reply = [this, &inflight, &error]() {
+    try {
+      ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+    } catch (...) {
+      if (!error) error = std::current_exception();
+    }
+    --inflight;
+  };
+  for (uint64_t offset = 0; offset < nbytes && !error; offset += chunk_bytes) {
+    uint64_t size = std::min(chunk_bytes, nbytes - offset);
+    if (inflight == max_inflight) {
+      wait_reply();
+      if (error) break;
+    }
+    to->byte_offset = offset;
+    char* data = static_cast<char*>(from_bytes) + offset;
+    if (options.zero_rle_func != nullptr && ZeroRunEncode(data, size, size / 2, &encoded)) {
+      // Call the decoder on the remote, which replies like a copy.
+      RPCCode code = RPCCode::kCallFunc;
+      uint64_t handle = reinterpret_cast<uint64_t>(options.zero_rle_func);
+      TVMByteArray arr{encoded.data(), encoded.size()};
+      TVMValue values[3];
+      int type_codes[3];
+      TVMArgsSetter setter(values, type_codes);
+      setter(0, to);
+      setter(1, arr);
+      setter(2, size);
+      uint64_t packet_nbytes = sizeof(code) + sizeof(handle) +
+                               handler_->PackedSeqGetNumBytes(values, type_codes, 3, true);
+      handler_->Write(packet_nbytes);
+      handler_->Write(code);
+      handler_->Write(handle);
+      handler_->SendPackedSeq(values, type_codes, 3, true);
+      bytes_sent += encoded.size();
+    } else {
+      RPCCode code = RPCCode::kCopyToRemote;
+      uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(to, code, size);
+      uint64_t packet_nbytes = overhead + size;
+      handler_->Write(packet_nbytes);
+      handler_->Write(code);
+      RPCReference::SendDLTensor(handler_, to);
+      handler_->Write(size);
+      this->SendDirect(data, size);
+      bytes_sent += size;
+    }
+    ++inflight;
+  }
+  while (inflight != 0) {
+    wait_reply();
+  }
+  if (error) std::rethrow_exception(error);
+  return bytes_sent;
 }
 
-void RPCEndpoint::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes) {
+void RPCEndpoint::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes,
+                                 const RPCCopyOptions& options) {
   std::lock_guard<std::mutex> lock(mutex_);
   RPCCode code = RPCCode::kCopyFromRemote;
-
+  uint64_t chunk_bytes = options.chunk_bytes != 0 ? options.chunk_bytes : nbytes;
+  int max_inflight = std::max(options.max_inflight, 1);
   uint64_t tensor_total_size_bytes = static_cast<uint64_t>(GetDataSize(*from));
-  ICHECK_LE(from->byte_offset + nbytes, tensor_total_size_bytes)
-      << "CopyFromRemote: overflow in tensor size: (byte_offset=" << from->byte_offset
-      << ", nbytes=" << nbytes << ", tensor_total_size=" << tensor_total_size_bytes << ")";
-
-  uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(from, code, nbytes);
-  uint64_t packet_nbytes = overhead;
-
-  handler_->Write(packet_nbytes);
-  handler_->Write(code);
-  RPCReference::SendDLTensor(handler_, from);
-  handler_->Write(nbytes);
-  ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kCopyAck);
-
-  handler_->ReadArray(reinterpret_cast<char*>(to_bytes), nbytes);
-  handler_->FinishCopyAck();
+  ICHECK_LE(nbytes, tensor_total_size_bytes)
+      << "CopyFromRemote: overflow in tensor size: (nbytes=" << nbytes
+      << ", tensor_total_size=" << tensor_total_size_bytes << ")";
+  // The bytes requested and received so far.
+  uint64_t requested = 0, received = 0;
+  std::exception_ptr error;
+  while (received < requested || (received < nbytes && !error)) {
+    // The requests in flight, the last one may be shorter than a chunk.
+    uint64_t inflight = (requested - received) / chunk_bytes;
+    while (requested < nbytes && inflight < static_cast<uint64_t>(max_inflight) && !error) {
+      uint64_t size = std::min(chunk_bytes, nbytes - requested);
+      from->byte_offset = requested;
+      uint64_t packet_nbytes = RemoteCopyCalculatePacketOverheadSize(from, code, size);
+      handler_->Write(packet_nbytes);
+      handler_->Write(code);
+      RPCReference::SendDLTensor(handler_, from);
+      handler_->Write(size);
+      requested += size;
+      ++inflight;
+    }
+    uint64_t size = std::min(chunk_bytes, requested - received);
+    try {
+      ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kCopyAck);
+      handler_->ReadArray(static_cast<char*>(to_bytes) + received, size);
+      handler_->FinishCopyAck();
+    } catch (...) {
+      // Keep receiving the replies of the chunks requested.
+      if (!error) error = std::current_exception();
+    }
+    received += size;
+  }
+  if (error) std::rethrow_exception(error);
 }
 
 // SysCallEventHandler functions
@@ -995,6 +1085,16 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
    */
   explicit RPCClientSession(std::shared_ptr<RPCEndpoint> endpoint) : endpoint_(endpoint) {}
 
+  ~RPCClientSession() {
+    if (zero_rle_handle_ != nullptr) {
+      try {
+        FreeHandle(zero_rle_handle_, kTVMPackedFuncHandle);
+      } catch (const Error& e) {
+        // fault tolerance to remote close
+      }
+    }
+  }
+
   // function overrides
   PackedFuncHandle GetFunction(const std::string& name) final {
     return endpoint_->SysCallRemote(RPCCode::kGetGlobalFunc, name);
@@ -1006,57 +1106,38 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
   }
 
   void CopyToRemote(void* local_from_bytes, DLTensor* remote_to, uint64_t nbytes) final {
-    RPCCode code = RPCCode::kCopyToRemote;
-    uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(remote_to, code, nbytes);
-    uint64_t rpc_max_size = GetRPCMaxTransferSize();
-    ICHECK_GT(rpc_max_size, overhead) << "CopyToRemote: Invalid block size!";
-    const uint64_t block_size = rpc_max_size - overhead;
-    uint64_t block_count = 0;
-    const uint64_t num_blocks = nbytes / block_size;
-    void* from_bytes;
-
-    for (block_count = 0; block_count < num_blocks; block_count++) {
-      remote_to->byte_offset = block_count * block_size;
-      from_bytes = reinterpret_cast<void*>(
-          (reinterpret_cast<uint8_t*>(local_from_bytes) + block_count * block_size));
-      endpoint_->CopyToRemote(from_bytes, remote_to, block_size);
-    }
-
-    const uint64_t remainder_bytes = nbytes % block_size;
-    if (remainder_bytes != 0) {
-      remote_to->byte_offset = block_count * block_size;
-      from_bytes = reinterpret_cast<void*>(
-          (reinterpret_cast<uint8_t*>(local_from_bytes) + block_count * block_size));
-      endpoint_->CopyToRemote(from_bytes, remote_to, remainder_bytes);
+    RPCCopyOptions options = GetCopyOptions(remote_to, RPCCode::kCopyToRemote, nbytes);
+    if (compress_ && DMLC_IO_NO_ENDIAN_SWAP) {
+      if (!zero_rle_looked_up_) {
+        zero_rle_handle_ = GetFunction("tvm.rpc.server.CopyToRemoteZeroRLE");
+        zero_rle_looked_up_ = true;
+      }
+      options.zero_rle_func = zero_rle_handle_;
     }
+    copy_bytes_sent_ += endpoint_->CopyToRemote(local_from_bytes, remote_to, nbytes, options);
   }
 
   void CopyFromRemote(DLTensor* remote_from, void* local_to_bytes, uint64_t nbytes) final {
-    RPCCode code = RPCCode::kCopyFromRemote;
-    uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(remote_from, code, nbytes);
-    uint64_t rpc_max_size = GetRPCMaxTransferSize();
-    ICHECK_GT(rpc_max_size, overhead) << "CopyFromRemote: Invalid block size!";
-    const uint64_t block_size = rpc_max_size - overhead;
-    uint64_t block_count = 0;
-    const uint64_t num_blocks = nbytes / block_size;
-    void* to_bytes;
-
-    for (block_count = 0; block_count < num_blocks; block_count++) {
-      remote_from->byte_offset = block_count * block_size;
-      to_bytes = reinterpret_cast<void*>(
-          (reinterpret_cast<uint8_t*>(local_to_bytes) + block_count * block_size));
-      endpoint_->CopyFromRemote(remote_from, to_bytes, block_size);
-    }
+    RPCCopyOptions options = GetCopyOptions(remote_from, RPCCode::kCopyFromRemote, nbytes);
+    endpoint_->CopyFromRemote(remote_from, local_to_bytes, nbytes, options);
+  }
 
-    const uint64_t remainder_bytes = nbytes % block_size;
-    if (remainder_bytes != 0) {
-      remote_from->byte_offset = block_count * block_size;
-      to_bytes = reinterpret_cast<void*>(
-          (reinterpret_cast<uint8_t*>(local_to_bytes) + block_count * block_size));
-      endpoint_->CopyFromRemote(remote_from, to_bytes, remainder_bytes);
-    }
+  /*!
+   * \brief Set how the arrays are copied, see RPCCopyOptions.
+   * \param chunk_bytes The largest chunk, 0 for no other bound than the one of the remote.
+   * \param max_inflight The number of requests sent ahead of the replies.
+   * \param compress Whether to encode the zero runs of the arrays copied to
+   *  the remote, when the remote supports it.
+   */
+  void SetCopyOptions(uint64_t chunk_bytes, int max_inflight, bool compress) {
+    chunk_bytes_ = chunk_bytes;
+    max_inflight_ = std::max(max_inflight, 1);
+    compress_ = compress;
   }
 
+  /*! \return The bytes of array data sent by CopyToRemote so far. */
+  uint64_t CopyBytesSent() const { return copy_bytes_sent_; }
+
   void FreeHandle(void* handle, int type_code) final {
     endpoint_->SysCallRemote(RPCCode::kFreeHandle, handle, type_code);
   }
@@ -1132,6 +1213,7 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
     if (rpc_func == nullptr) {
       rpc_chunk_max_size_bytes_ = (int64_t)kRPCMaxTransferSizeBytesDefault;
     } else {
+      crt_server_ = true;
       CallFunc(rpc_func, nullptr, nullptr, 0, [this](TVMArgs args) {
         // Use args[1] as return value, args[0] is tcode
         // Look at RPCWrappedFunc in src/runtime/rpc/rpc_module.cc
@@ -1144,8 +1226,32 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
     return (uint64_t)rpc_chunk_max_size_bytes_;
   }
 
+  RPCCopyOptions GetCopyOptions(DLTensor* tensor, RPCCode code, uint64_t nbytes) {
+    uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(tensor, code, nbytes);
+    uint64_t rpc_max_size = GetRPCMaxTransferSize();
+    ICHECK_GT(rpc_max_size, overhead) << RPCCodeToString(code) << ": Invalid block size!";
+    RPCCopyOptions options;
+    options.chunk_bytes = rpc_max_size - overhead;
+    if (chunk_bytes_ != 0) {
+      options.chunk_bytes = std::min(options.chunk_bytes, chunk_bytes_);
+    }
+    // The micro runtime servers only buffer one packet.
+    options.max_inflight = crt_server_ ? 1 : max_inflight_;
+    return options;
+  }
+
   std::shared_ptr<RPCEndpoint> endpoint_;
   int64_t rpc_chunk_max_size_bytes_ = -1;
+  // Whether the remote is a micro runtime server, which bounds the packet size.
+  bool crt_server_{false};
+  // The copy options set by SetCopyOptions.
+  uint64_t chunk_bytes_{0};
+  int max_inflight_{4};
+  bool compress_{false};
+  // Whether the decoder of the zero runs was looked up, and its handle.
+  bool zero_rle_looked_up_{false};
+  PackedFuncHandle zero_rle_handle_{nullptr};
+  uint64_t copy_bytes_sent_{0};
 };
 
 std::shared_ptr<RPCSession> CreateClientSession(std::shared_ptr<RPCEndpoint> endpoint) {
@@ -1161,5 +1267,85 @@ uint64_t RemoteCopyCalculatePacketOverheadSize(DLTensor* tensor, RPCCode code, u
   return overhead;
 }
 
+bool ZeroRunEncode(const char* data, uint64_t nbytes, uint64_t max_bytes, std::string* out) {
+  // Shorter zero runs cost more in record headers than they save.
+  constexpr uint64_t kMinZeroRun = 32;
+  out->clear();
+  uint64_t pos = 0;
+  while (pos < nbytes) {
+    uint64_t zeros = pos;
+    while (zeros < nbytes && data[zeros] == 0) ++zeros;
+    // The literals end at the next long enough zero run.
+    uint64_t end = zeros, run = 0;
+    while (end + run < nbytes) {
+      if (data[end + run] == 0) {
+        if (++run == kMinZeroRun) break;
+      } else {
+        end += run + 1;
+        run = 0;
+      }
+    }
+    if (run < kMinZeroRun) end = nbytes;
+    uint64_t header[2] = {zeros - pos, end - zeros};
+    if (out->size() + sizeof(header) + header[1] > max_bytes) return false;
+    out->append(reinterpret_cast<const char*>(header), sizeof(header));
+    out->append(data + zeros, end - zeros);
+    pos = end;
+  }
+  return true;
+}
+
+void ZeroRunDecode(const char* data, size_t size, char* out, uint64_t nbytes) {
+  uint64_t pos = 0;
+  size_t read = 0;
+  while (read < size) {
+    uint64_t header[2];
+    ICHECK_LE(read + sizeof(header), size) << "Invalid zero run encoding";
+    memcpy(header, data + read, sizeof(header));
+    read += sizeof(header);
+    if (!DMLC_IO_NO_ENDIAN_SWAP) {
+      dmlc::ByteSwap(header, sizeof(uint64_t), 2);
+    }
+    ICHECK(header[0] <= nbytes - pos && header[1] <= nbytes - pos - header[0] &&
+           header[1] <= size - read)
+        << "Invalid zero run encoding";
+    memset(out + pos, 0, header[0]);
+    pos += header[0];
+    memcpy(out + pos, data + read, header[1]);
+    pos += header[1];
+    read += header[1];
+  }
+  ICHECK_EQ(pos, nbytes) << "Invalid zero run encoding";
+}
+
+TVM_REGISTER_GLOBAL("tvm.rpc.server.CopyToRemoteZeroRLE")
+    .set_body_typed([](DLTensor* to, std::string data, int64_t nbytes) {
+      ICHECK_LE(static_cast<uint64_t>(nbytes), GetDataSize(*to));
+      bool direct = to->device.device_type == kDLCPU;
+      std::vector<char> buffer(direct ? 0 : nbytes);
+      char* out = direct ? static_cast<char*>(to->data) + to->byte_offset : buffer.data();
+      ZeroRunDecode(data.data(), data.size(), out, nbytes);
+      if (!DMLC_IO_NO_ENDIAN_SWAP) {
+        size_t elem_bytes = (to->dtype.bits * to->dtype.lanes + 7) / 8;
+        dmlc::ByteSwap(out, elem_bytes, nbytes / elem_bytes);
+      }
+      if (!direct) {
+        LocalSession().CopyToRemote(buffer.data(), to, nbytes);
+      }
+    });
+
+TVM_REGISTER_GLOBAL("rpc.SetCopyOptions")
+    .set_body_typed([](Module sess, int64_t chunk_bytes, int max_inflight, bool compress) {
+      auto client = std::dynamic_pointer_cast<RPCClientSession>(RPCModuleGetSession(sess));
+      ICHECK(client != nullptr) << "Copy options are only supported by RPC client sessions";
+      client->SetCopyOptions(chunk_bytes, max_inflight, compress);
+    });
+
+TVM_REGISTER_GLOBAL("rpc.CopyBytesSent").set_body_typed([](Module sess) {
+  auto client = std::dynamic_pointer_cast<RPCClientSession>(RPCModuleGetSession(sess));
+  ICHECK(client != nullptr) << "Copy statistics are only kept by RPC client sessions";
+  return static_cast<int64_t>(client->CopyBytesSent());
+});
+
 }  // namespace runtime
 }  // namespace tvm
@@ -61,6 +61,25 @@ enum class TrackerCode : int {
   kGetPendingMatchKeys = 7
 };
 
+/*!
+ * \brief How the client copies arrays to and from the remote.
+ *
+ *  A copy is split in chunks of at most chunk_bytes, each sent as its own
+ *  request, with up to max_inflight requests sent before the first reply is
+ *  awaited. The transfer of a chunk thus overlaps the handling of the
+ *  previous ones on the remote, whose buffers only hold a chunk. When
+ *  zero_rle_func is set, the chunks sent mostly made of zero runs are
+ *  encoded by ZeroRunEncode and decoded on the remote by that function.
+ */
+struct RPCCopyOptions {
+  /*! \brief The largest chunk, a copy is a single chunk when 0. */
+  uint64_t chunk_bytes{0};
+  /*! \brief The number of requests sent ahead of the replies. */
+  int max_inflight{1};
+  /*! \brief The remote handle of tvm.rpc.server.CopyToRemoteZeroRLE, or nullptr. */
+  RPCSession::PackedFuncHandle zero_rle_func{nullptr};
+};
+
 /*!
  * \brief Communication endpoints to connect local and remote RPC sessions.
  *        An endpoint can either be a client or a server.
@@ -134,8 +153,11 @@ class RPCEndpoint {
    * \param nbytes The size of the memory in bytes.
    * \param dev_to The target device.
    * \param type_hint Hint of content data type.
+   * \param options How to split the copy.
+   * \return The bytes of array data sent, after the zero runs are encoded.
    */
-  void CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes);
+  uint64_t CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes,
+                        const RPCCopyOptions& options = RPCCopyOptions());
   /*!
    * \brief Copy bytes from remote array content.
    * \param from The source host data.
@@ -145,8 +167,10 @@ class RPCEndpoint {
    * \param nbytes The size of the memory in bytes.
    * \param dev_from The source device.
    * \param type_hint Hint of content data type.
+   * \param options How to split the copy, zero_rle_func is not used.
    */
-  void CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes);
+  void CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes,
+                      const RPCCopyOptions& options = RPCCopyOptions());
 
   /*!
    * \brief Call a remote defined system function with arguments.
@@ -172,6 +196,9 @@ class RPCEndpoint {
   // Handle events until receives a return
   // Also flushes channels so that the function advances.
   RPCCode HandleUntilReturnEvent(bool client_mode, RPCSession::FEncodeReturn setreturn);
+  // Send the data after the buffered bytes, large data is sent from its memory
+  // without going through the writer.
+  void SendDirect(const void* data, uint64_t nbytes);
   // Initalization
   void Init();
   // Shutdown
@@ -214,6 +241,27 @@ inline TVMRetValue RPCEndpoint::SysCallRemote(RPCCode code, Args&&... args) {
  */
 uint64_t RemoteCopyCalculatePacketOverheadSize(DLTensor* tensor, RPCCode code, uint64_t nbytes);
 
+/*!
+ * \brief Encode bytes as a sequence of records, each made of the length of a
+ *  zero run, the length of the literal bytes following it, as uint64_t, and
+ *  the literal bytes. Short zero runs are kept in the literals.
+ * \param data The bytes.
+ * \param nbytes The number of bytes.
+ * \param max_bytes Give up once the encoding is longer than max_bytes.
+ * \param out The encoding.
+ * \return Whether the encoding is at most max_bytes long.
+ */
+bool ZeroRunEncode(const char* data, uint64_t nbytes, uint64_t max_bytes, std::string* out);
+
+/*!
+ * \brief Decode the bytes encoded by ZeroRunEncode.
+ * \param data The encoding.
+ * \param size The size of the encoding.
+ * \param out The buffer receiving the bytes.
+ * \param nbytes The size of out, which must be the number of bytes encoded.
+ */
+void ZeroRunDecode(const char* data, size_t size, char* out, uint64_t nbytes);
+
 }  // namespace runtime
 }  // namespace tvm
 #endif  // TVM_RUNTIME_RPC_RPC_ENDPOINT_H_
@@ -88,7 +88,6 @@ void LocalSession::CallFunc(RPCSession::PackedFuncHandle func, const TVMValue* a
 }
 
 void LocalSession::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes) {
-  ICHECK_EQ(nbytes, GetDataSize(*to));
   DLTensor from;
   from.data = from_bytes;
   from.device = {kDLCPU, 0};
@@ -97,6 +96,22 @@ void LocalSession::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes)
   from.dtype = to->dtype;
   from.strides = nullptr;
   from.byte_offset = 0;
+  // A chunk of a larger copy, see RPCCopyOptions, is copied as flat bytes.
+  DLTensor chunk;
+  int64_t chunk_shape = static_cast<int64_t>(nbytes);
+  if (nbytes != GetDataSize(*to)) {
+    ICHECK(IsContiguous(*to)) << "Only a contiguous array can be copied in chunks";
+    ICHECK_LT(nbytes, GetDataSize(*to));
+    chunk = *to;
+    chunk.ndim = 1;
+    chunk.shape = &chunk_shape;
+    chunk.dtype = DLDataType{kDLUInt, 8, 1};
+    chunk.strides = nullptr;
+    from.ndim = 1;
+    from.shape = &chunk_shape;
+    from.dtype = chunk.dtype;
+    to = &chunk;
+  }
   Device dev_to = to->device;
   this->GetDeviceAPI(dev_to)->CopyDataFromTo(&from, to, nullptr);
   // Copy can happen asynchrously
@@ -105,7 +120,6 @@ void LocalSession::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes)
 }
 
 void LocalSession::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes) {
-  ICHECK_EQ(nbytes, GetDataSize(*from));
   DLTensor to;
   to.data = to_bytes;
   to.device = {kDLCPU, 0};
@@ -114,6 +128,21 @@ void LocalSession::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbyte
   to.dtype = from->dtype;
   to.strides = nullptr;
   to.byte_offset = 0;
+  DLTensor chunk;
+  int64_t chunk_shape = static_cast<int64_t>(nbytes);
+  if (nbytes != GetDataSize(*from)) {
+    ICHECK(IsContiguous(*from)) << "Only a contiguous array can be copied in chunks";
+    ICHECK_LT(nbytes, GetDataSize(*from));
+    chunk = *from;
+    chunk.ndim = 1;
+    chunk.shape = &chunk_shape;
+    chunk.dtype = DLDataType{kDLUInt, 8, 1};
+    chunk.strides = nullptr;
+    to.ndim = 1;
+    to.shape = &chunk_shape;
+    to.dtype = chunk.dtype;
+    from = &chunk;
+  }
 
   Device dev_from = from->device;
   this->GetDeviceAPI(dev_from)->CopyDataFromTo(from, &to, nullptr);
@@ -58,6 +58,32 @@ uint32_t GetSpinCount() {
   return atoi(val);
 }
 
+constexpr int kDefaultStealGrain = 4;
+
+bool GetWorkStealing() {
+  const char* val = getenv("TVM_THREAD_POOL_WORK_STEALING");
+  return val != nullptr && atoi(val) != 0;
+}
+
+int GetStealGrain() {
+  const char* val = getenv("TVM_THREAD_POOL_STEAL_GRAIN");
+  if (!val) {
+    return kDefaultStealGrain;
+  }
+  return std::max(atoi(val), 1);
+}
+
+bool GetSharedPool() {
+  const char* val = getenv("TVM_THREAD_POOL_SHARED");
+  return val != nullptr && atoi(val) != 0;
+}
+
+// The bound set by threading::SetLaunchConcurrency on the calling thread, 0 if unbounded.
+int& LaunchConcurrency() {
+  static thread_local int nthreads = 0;
+  return nthreads;
+}
+
 }  // namespace
 
 // stride in the page, fit to cache line.
@@ -74,14 +100,17 @@ class ParallelLauncher {
     this->cdata = cdata;
     this->flambda = flambda;
     this->env.num_task = num_task;
+    this->work_stealing = false;
     has_error_.store(false);
+    num_active_slots_.store(0);
     // reshape
     if (static_cast<size_t>(num_task) > par_errors_.size()) {
       par_errors_.resize(num_task + 1);
-      if (need_sync) {
-        delete[] sync_counter_;
-        sync_counter_ = new std::atomic<int>[num_task * kSyncStride];
-      }
+    }
+    if (need_sync && num_task > sync_counter_size_) {
+      delete[] sync_counter_;
+      sync_counter_ = new std::atomic<int>[num_task * kSyncStride];
+      sync_counter_size_ = num_task;
     }
     if (need_sync) {
       for (int i = 0; i < num_task; ++i) {
@@ -95,7 +124,9 @@ class ParallelLauncher {
   ~ParallelLauncher() { delete[] sync_counter_; }
   // Wait n jobs to finish
   int WaitForJobs() {
-    while (num_pending_.load() != 0) {
+    // Stealing workers may still be scanning the ranges after the last task finished,
+    // wait for them to leave before the launcher can be reused.
+    while (num_pending_.load() != 0 || num_active_slots_.load() != 0) {
       tvm::runtime::threading::Yield();
     }
     if (!has_error_.load()) return 0;
@@ -117,6 +148,46 @@ class ParallelLauncher {
   }
   // Signal that one job has finished.
   void SignalJobFinish() { num_pending_.fetch_sub(1); }
+  // Run a single task and signal its completion.
+  void RunTask(int32_t task_id) {
+    if ((*flambda)(task_id, &env, cdata) == 0) {
+      SignalJobFinish();
+    } else {
+      SignalJobError(task_id);
+    }
+  }
+  /*!
+   * \brief Split the tasks into contiguous ranges, one per stealing slot.
+   * \param num_slots The number of workers taking part in the launch.
+   */
+  void InitStealRanges(int num_slots) {
+    if (static_cast<size_t>(num_slots) > steal_ranges_.size()) {
+      steal_ranges_.reset(new StealRange[num_slots], num_slots);
+    }
+    int num_task = env.num_task;
+    for (int i = 0; i < num_slots; ++i) {
+      uint32_t begin = static_cast<uint32_t>(static_cast<int64_t>(num_task) * i / num_slots);
+      uint32_t end = static_cast<uint32_t>(static_cast<int64_t>(num_task) * (i + 1) / num_slots);
+      steal_ranges_[i].range.store(PackRange(begin, end), std::memory_order_relaxed);
+    }
+    num_steal_slots_ = num_slots;
+    num_active_slots_.store(num_slots);
+    work_stealing = true;
+  }
+  /*!
+   * \brief Run tasks of a work-stealing launch until no task is left.
+   *
+   *  The slot first drains its own range from the front, then steals the back
+   *  half of the range of another slot.
+   * \param slot The stealing slot of the calling worker.
+   */
+  void RunStealTasks(int slot) {
+    int32_t task_id;
+    while (PopTask(slot, &task_id) || StealTask(slot, &task_id)) {
+      RunTask(task_id);
+    }
+    num_active_slots_.fetch_sub(1);
+  }
   // Get thread local version of the store.
   static ParallelLauncher* ThreadLocal() { return dmlc::ThreadLocalStore<ParallelLauncher>::Get(); }
   // The parallel lambda
@@ -128,18 +199,94 @@ class ParallelLauncher {
   // Whether this thread is worker of the pool.
   // used to prevent recursive launch.
   bool is_worker{false};
+  // Whether the current launch is scheduled by work stealing.
+  bool work_stealing{false};
+  // The workers reserved by the current launch of a shared pool.
+  std::vector<int> reserved_workers;
 
  private:
+  /*! \brief Task range [begin, end) packed in one word, padded to a cache line. */
+  struct StealRange {
+    std::atomic<uint64_t> range{0};
+    char pad[kL1CacheBytes - sizeof(std::atomic<uint64_t>)];
+  };
+  /*! \brief Array of steal ranges that remembers its capacity. */
+  class StealRangeArray {
+   public:
+    ~StealRangeArray() { delete[] data_; }
+    void reset(StealRange* data, size_t size) {
+      delete[] data_;
+      data_ = data;
+      size_ = size;
+    }
+    size_t size() const { return size_; }
+    StealRange& operator[](size_t i) { return data_[i]; }
+
+   private:
+    StealRange* data_{nullptr};
+    size_t size_{0};
+  };
+
+  static uint64_t PackRange(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(end) << 32) | begin;
+  }
+  // Take the first task of the slot's own range.
+  bool PopTask(int slot, int32_t* task_id) {
+    std::atomic<uint64_t>& range = steal_ranges_[slot].range;
+    uint64_t cur = range.load();
+    while (true) {
+      uint32_t begin = static_cast<uint32_t>(cur), end = static_cast<uint32_t>(cur >> 32);
+      if (begin >= end) return false;
+      if (range.compare_exchange_weak(cur, PackRange(begin + 1, end))) {
+        *task_id = static_cast<int32_t>(begin);
+        return true;
+      }
+    }
+  }
+  // Steal the back half of another slot's range, run its first task and keep the rest.
+  bool StealTask(int slot, int32_t* task_id) {
+    for (int k = 1; k < num_steal_slots_; ++k) {
+      std::atomic<uint64_t>& victim = steal_ranges_[(slot + k) % num_steal_slots_].range;
+      uint64_t cur = victim.load();
+      while (true) {
+        uint32_t begin = static_cast<uint32_t>(cur), end = static_cast<uint32_t>(cur >> 32);
+        if (begin >= end) break;
+        uint32_t mid = end - (end - begin + 1) / 2;
+        if (victim.compare_exchange_weak(cur, PackRange(begin, mid))) {
+          // Our own range is empty here, thieves never modify an empty range.
+          steal_ranges_[slot].range.store(PackRange(mid + 1, end));
+          *task_id = static_cast<int32_t>(mid);
+          return true;
+        }
+      }
+    }
+    return false;
+  }
   // The pending jobs.
   std::atomic<int32_t> num_pending_;
   // Whether error has been countered.
   std::atomic<bool> has_error_;
   // The counter page.
   std::atomic<int32_t>* sync_counter_{nullptr};
+  // The number of tasks the counter page can host.
+  int sync_counter_size_{0};
+  // The task ranges of work-stealing launches, one per slot.
+  StealRangeArray steal_ranges_;
+  // The number of slots of the current work-stealing launch.
+  int num_steal_slots_{0};
+  // The number of slots still running or stealing tasks.
+  std::atomic<int32_t> num_active_slots_{0};
   // The error message
   std::vector<std::string> par_errors_;
 };
 
+/*! \brief Thread local launchers of the shared pool, indexed by nesting depth. */
+struct NestedLaunchers {
+  std::vector<std::unique_ptr<ParallelLauncher> > launchers;
+  size_t depth{0};
+  static NestedLaunchers* ThreadLocal() { return dmlc::ThreadLocalStore<NestedLaunchers>::Get(); }
+};
+
 /*! \brief Lock-free single-producer-single-consumer queue for each thread */
 class SpscTaskQueue {
  public:
@@ -257,11 +404,14 @@ class SpscTaskQueue {
 // The thread pool
 class ThreadPool {
  public:
-  ThreadPool() : num_workers_(tvm::runtime::threading::MaxConcurrency()) {
+  explicit ThreadPool(bool shared = false)
+      : num_workers_(tvm::runtime::threading::MaxConcurrency()), shared_(shared) {
     const char* exclude_worker0 = getenv("TVM_EXCLUDE_WORKER0");
     if (exclude_worker0 && atoi(exclude_worker0) == 0) {
       exclude_worker0_ = false;
     }
+    work_stealing_ = GetWorkStealing();
+    steal_grain_ = GetStealGrain();
     Init();
   }
 
@@ -273,6 +423,7 @@ class ThreadPool {
   }
 
   void Reset() {
+    std::unique_lock<std::mutex> lock = DrainLaunches();
     for (std::unique_ptr<SpscTaskQueue>& q : queues_) {
       q->SignalForKill();
     }
@@ -282,11 +433,17 @@ class ThreadPool {
   }
 
   int Launch(FTVMParallelLambda flambda, void* cdata, int num_task, int need_sync) {
+    if (shared_) {
+      return LaunchShared(flambda, cdata, num_task, need_sync);
+    }
     ParallelLauncher* launcher = ParallelLauncher::ThreadLocal();
     ICHECK(!launcher->is_worker)
         << "Cannot launch parallel job inside worker, consider fuse then parallel";
+    if (work_stealing_) {
+      return LaunchWorkStealing(launcher, flambda, cdata, num_task, need_sync);
+    }
     if (num_task == 0) {
-      num_task = num_workers_used_;
+      num_task = NumLaunchWorkers();
     }
     if (need_sync != 0) {
       ICHECK_LE(num_task, num_workers_used_)
@@ -316,16 +473,158 @@ class ThreadPool {
 
   static ThreadPool* ThreadLocal() { return dmlc::ThreadLocalStore<ThreadPool>::Get(); }
 
-  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads) {
+  static ThreadPool* Global() {
+    static ThreadPool inst(true);
+    return &inst;
+  }
+
+  // The pool serving the calling thread, process-wide when TVM_THREAD_POOL_SHARED is set.
+  static ThreadPool* Current() {
+    static bool shared = GetSharedPool();
+    return shared ? Global() : ThreadLocal();
+  }
+
+  void UpdateScheduler(bool work_stealing, int steal_grain) {
+    std::unique_lock<std::mutex> lock = DrainLaunches();
+    work_stealing_ = work_stealing;
+    if (steal_grain > 0) {
+      steal_grain_ = steal_grain;
+    }
+  }
+
+  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads,
+                                 int numa_node = 0) {
+    std::unique_lock<std::mutex> lock = DrainLaunches();
     // this will also reset the affinity of the ThreadGroup
     // may use less than the MaxConcurrency number of workers
-    num_workers_used_ = threads_->Configure(mode, nthreads, exclude_worker0_);
+    num_workers_used_ = threads_->Configure(mode, nthreads, exclude_worker0_, numa_node);
     // if MaxConcurrency restricted the number of workers (e.g., due to
     // hyperthreading), respect the restriction
     num_workers_used_ = std::min(num_workers_, num_workers_used_);
+    InitFreeWorkers();
+  }
+
+  void BindToCores(int first, int nthreads) {
+    std::unique_lock<std::mutex> lock = DrainLaunches();
+    num_workers_used_ = threads_->ConfigureCores(first, nthreads, exclude_worker0_);
+    num_workers_used_ = std::min(num_workers_, num_workers_used_);
+    InitFreeWorkers();
   }
 
+  int NumWorkersUsed() const { return num_workers_used_; }
+
  private:
+  /*!
+   * \brief Launch the tasks on workers reserved from a process-wide pool.
+   *
+   *  Each concurrent caller, including nested launches from inside a worker,
+   *  is granted a fair share of the workers in use and runs the first slot
+   *  itself. When no worker is free the launch degrades to running all tasks
+   *  on the calling thread, so callers never wait for each other, except a
+   *  launch with a barrier, which waits until one worker per task is free. A
+   *  reconfiguration of the pool waits until the launches holding workers
+   *  have returned them, see DrainLaunches.
+   */
+  int LaunchShared(FTVMParallelLambda flambda, void* cdata, int num_task, int need_sync) {
+    // a task may launch again on the same thread, use one launcher per nesting level
+    NestedLaunchers* nested = NestedLaunchers::ThreadLocal();
+    if (nested->depth == nested->launchers.size()) {
+      nested->launchers.emplace_back(new ParallelLauncher());
+    }
+    ParallelLauncher* launcher = nested->launchers[nested->depth++].get();
+    std::vector<int>& workers = launcher->reserved_workers;
+    // while a reconfiguration waits for the launches to drain, new ones run on the caller
+    bool active = false;
+    {
+      std::unique_lock<std::mutex> lock(free_mutex_);
+      // A barrier needs every task live at once. When the pool is large enough, the launch
+      // waits until one worker per task is free, otherwise it runs without a barrier. A nested
+      // launch cannot wait for the workers held by the enclosing ones.
+      bool barrier = need_sync != 0 && num_task > 1 && num_task <= num_workers_used_;
+      if (barrier && nested->depth == 1 && !ParallelLauncher::ThreadLocal()->is_worker) {
+        free_cv_.wait(lock, [&] {
+          return num_task > num_workers_used_ ||
+                 (!draining_ && static_cast<int>(free_workers_.size()) + 1 >= num_task);
+        });
+      }
+      if (!draining_) {
+        active = true;
+        int num_callers = ++num_active_callers_;
+        int budget = std::max(std::min(num_workers_used_ / num_callers, NumLaunchWorkers()), 1);
+        if (num_task != 0) {
+          budget = barrier ? num_task : std::min(budget, num_task);
+        }
+        while (static_cast<int>(workers.size()) + 1 < budget && !free_workers_.empty()) {
+          workers.push_back(free_workers_.back());
+          free_workers_.pop_back();
+        }
+      }
+    }
+    int num_slots = static_cast<int>(workers.size()) + 1;
+    if (num_task == 0) {
+      num_task = num_slots * (work_stealing_ ? steal_grain_ : 1);
+    }
+    bool sync = need_sync != 0 && num_task <= num_slots;
+    launcher->Init(flambda, cdata, num_task, sync);
+    launcher->InitStealRanges(num_slots);
+    SpscTaskQueue::Task tsk;
+    tsk.launcher = launcher;
+    for (int i = 1; i < num_slots; ++i) {
+      tsk.task_id = i;
+      queues_[workers[i - 1]]->Push(tsk);
+    }
+    launcher->RunStealTasks(0);
+    int res = launcher->WaitForJobs();
+    if (active) {
+      std::lock_guard<std::mutex> lock(free_mutex_);
+      free_workers_.insert(free_workers_.end(), workers.begin(), workers.end());
+      if (--num_active_callers_ == 0) {
+        drained_cv_.notify_all();
+      }
+      free_cv_.notify_all();
+    }
+    workers.clear();
+    --nested->depth;
+    return res;
+  }
+
+  /*!
+   * \brief Launch the tasks with per-worker ranges that idle workers can steal from.
+   *
+   *  When the number of tasks is left to the runtime, the job is split into
+   *  steal_grain_ tasks per worker so that a slow chunk can be rebalanced.
+   *  Parallel barriers require all tasks to be live at once, so they are only
+   *  available when there are no more tasks than workers.
+   */
+  int LaunchWorkStealing(ParallelLauncher* launcher, FTVMParallelLambda flambda, void* cdata,
+                         int num_task, int need_sync) {
+    int num_workers = NumLaunchWorkers();
+    if (num_task == 0) {
+      num_task = num_workers * steal_grain_;
+    }
+    bool sync = need_sync != 0 && num_task <= num_workers;
+    int num_slots = std::min(num_task, num_workers);
+    launcher->Init(flambda, cdata, num_task, sync);
+    launcher->InitStealRanges(num_slots);
+    SpscTaskQueue::Task tsk;
+    tsk.launcher = launcher;
+    // the task id of a work-stealing task is the slot of the worker
+    for (int i = exclude_worker0_; i < num_slots; ++i) {
+      tsk.task_id = i;
+      queues_[i]->Push(tsk);
+    }
+    if (exclude_worker0_) {
+      launcher->RunStealTasks(0);
+    }
+    return launcher->WaitForJobs();
+  }
+
+  // The number of workers a launch from the calling thread may use.
+  int NumLaunchWorkers() const {
+    int limit = LaunchConcurrency();
+    return limit > 0 ? std::min(limit, num_workers_used_) : num_workers_used_;
+  }
+
   // Shared initialization code
   void Init() {
     for (int i = 0; i < num_workers_; ++i) {
@@ -337,6 +636,37 @@ class ThreadPool {
             num_workers_, [this](int worker_id) { this->RunWorker(worker_id); },
             exclude_worker0_ /* include_main_thread */));
     num_workers_used_ = threads_->Configure(threading::ThreadGroup::kBig, 0, exclude_worker0_);
+    InitFreeWorkers();
+  }
+
+  /*!
+   * \brief Wait until no launch holds workers of the shared pool.
+   * \return The lock on free_mutex_, which keeps new launches out until it is released.
+   */
+  std::unique_lock<std::mutex> DrainLaunches() {
+    std::unique_lock<std::mutex> lock(free_mutex_);
+    if (shared_) {
+      ICHECK(NestedLaunchers::ThreadLocal()->depth == 0 &&
+             !ParallelLauncher::ThreadLocal()->is_worker)
+          << "Cannot reconfigure the shared thread pool from inside a parallel launch";
+      draining_ = true;
+      drained_cv_.wait(lock, [this] { return num_active_callers_ == 0; });
+      draining_ = false;
+      // the launches with a barrier wait for the reconfiguration to finish
+      free_cv_.notify_all();
+    }
+    return lock;
+  }
+
+  // Put every worker in use back on the free list of the shared pool.
+  // Other threads may launch, the caller holds free_mutex_ from DrainLaunches.
+  void InitFreeWorkers() {
+    free_workers_.clear();
+    // when worker0 is taken by the callers, it has no thread to reserve
+    for (int i = num_workers_used_ - 1; i >= static_cast<int>(exclude_worker0_); --i) {
+      free_workers_.push_back(i);
+    }
+    free_cv_.notify_all();
   }
 
   // Internal worker function.
@@ -350,6 +680,10 @@ class ThreadPool {
     static size_t spin_count = GetSpinCount();
     while (queue->Pop(&task, spin_count)) {
       ICHECK(task.launcher != nullptr);
+      if (task.launcher->work_stealing) {
+        task.launcher->RunStealTasks(task.task_id);
+        continue;
+      }
       TVMParallelGroupEnv* penv = &(task.launcher->env);
       void* cdata = task.launcher->cdata;
       if ((*task.launcher->flambda)(task.task_id, penv, cdata) == 0) {
@@ -364,6 +698,24 @@ class ThreadPool {
   int num_workers_used_;
   // if or not to exclude worker 0 and use main to run task 0
   bool exclude_worker0_{true};
+  // whether to schedule launches by work stealing
+  bool work_stealing_{false};
+  // number of tasks per worker when work stealing picks the number of tasks
+  int steal_grain_{kDefaultStealGrain};
+  // whether the pool is shared by all threads of the process
+  bool shared_{false};
+  // number of launches holding workers of the shared pool
+  int num_active_callers_{0};
+  // workers of the shared pool not reserved by any launch
+  std::vector<int> free_workers_;
+  // protects free_workers_ and num_active_callers_
+  std::mutex free_mutex_;
+  // whether a reconfiguration waits for the launches to return their workers
+  bool draining_{false};
+  // notified when the last launch returns its workers
+  std::condition_variable drained_cv_;
+  // notified when workers are returned to free_workers_
+  std::condition_variable free_cv_;
   std::vector<std::unique_ptr<SpscTaskQueue> > queues_;
   std::unique_ptr<tvm::runtime::threading::ThreadGroup> threads_;
 };
@@ -372,11 +724,43 @@ TVM_REGISTER_GLOBAL("runtime.config_threadpool").set_body([](TVMArgs args, TVMRe
   threading::ThreadGroup::AffinityMode mode =
       static_cast<threading::ThreadGroup::AffinityMode>(static_cast<int>(args[0]));
   int nthreads = args[1];
-  ThreadPool::ThreadLocal()->UpdateWorkerConfiguration(mode, nthreads);
+  int numa_node = args.size() > 2 ? static_cast<int>(args[2]) : 0;
+  ThreadPool::Current()->UpdateWorkerConfiguration(mode, nthreads, numa_node);
 });
 
+TVM_REGISTER_GLOBAL("runtime.num_numa_nodes").set_body_typed([]() {
+  return threading::NumNumaNodes();
+});
+
+TVM_REGISTER_GLOBAL("runtime.config_threadpool_scheduler")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      bool work_stealing = static_cast<int>(args[0]) != 0;
+      int steal_grain = args.size() > 1 ? static_cast<int>(args[1]) : 0;
+      ThreadPool::Current()->UpdateScheduler(work_stealing, steal_grain);
+    });
+
 namespace threading {
-void ResetThreadPool() { tvm::runtime::ThreadPool::ThreadLocal()->Reset(); }
+void ResetThreadPool() { tvm::runtime::ThreadPool::Current()->Reset(); }
+
+void SetLaunchConcurrency(int nthreads) { LaunchConcurrency() = std::max(nthreads, 0); }
+
+int GetLaunchConcurrency() { return LaunchConcurrency(); }
+
+int BindThreadPoolToCores(int first, int nthreads) {
+  if (GetSharedPool()) return 0;
+  ThreadPool* pool = ThreadPool::ThreadLocal();
+  pool->BindToCores(first, nthreads);
+  return pool->NumWorkersUsed();
+}
+
+int BindThreadPoolToNumaNode(int numa_node, int nthreads) {
+  ICHECK(!GetSharedPool())
+      << "The thread pool is shared by all threads, unset TVM_THREAD_POOL_SHARED to bind it";
+  ICHECK(numa_node >= 0 && numa_node < NumNumaNodes()) << "Invalid NUMA node " << numa_node;
+  ThreadPool* pool = ThreadPool::ThreadLocal();
+  pool->UpdateWorkerConfiguration(ThreadGroup::kNumaNode, nthreads, numa_node);
+  return pool->NumWorkersUsed();
+}
 }  // namespace threading
 
 }  // namespace runtime
@@ -393,9 +777,11 @@ int TVMBackendParallelLaunch(FTVMParallelLambda flambda, void* cdata, int num_ta
     return 0;
   } else {
 #if !TVM_THREADPOOL_USE_OPENMP
-    int res = tvm::runtime::ThreadPool::ThreadLocal()->Launch(flambda, cdata, num_task, 1);
+    int res = tvm::runtime::ThreadPool::Current()->Launch(flambda, cdata, num_task, 1);
     return res;
 #else
+    int limit = tvm::runtime::LaunchConcurrency();
+    if (limit > 0) num_workers = std::min(num_workers, limit);
     if (num_task == 0) num_task = num_workers;
     omp_set_num_threads(num_task);
 #pragma omp parallel num_threads(num_task)
@@ -416,6 +802,9 @@ int TVMBackendParallelBarrier(int task_id, TVMParallelGroupEnv* penv) {
   using tvm::runtime::kSyncStride;
   int num_task = penv->num_task;
   std::atomic<int>* sync_counter = reinterpret_cast<std::atomic<int>*>(penv->sync_handle);
+  ICHECK(sync_counter != nullptr)
+      << "Parallel barrier requires no more tasks than workers, "
+      << "set TVM_THREAD_POOL_STEAL_GRAIN=1 when using the work-stealing scheduler";
   int old_counter = sync_counter[task_id * kSyncStride].fetch_add(1, std::memory_order_release);
   for (int i = 0; i < num_task; ++i) {
     if (i != task_id) {
@@ -25,6 +25,7 @@
 #include <tvm/runtime/threading_backend.h>
 
 #include <algorithm>
+#include <string>
 #include <thread>
 #if defined(__linux__) || defined(__ANDROID__)
 #include <fstream>
@@ -60,7 +61,10 @@ class ThreadGroup::Impl {
     }
   }
 
-  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0) {
+  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0, int numa_node) {
+    if (mode == kNumaNode || mode == kPhysical) {
+      return ConfigureTopology(mode, nthreads, exclude_worker0, numa_node);
+    }
     int num_workers_used = 0;
     if (mode == kLittle) {
       num_workers_used = little_count_;
@@ -93,6 +97,21 @@ class ThreadGroup::Impl {
     return num_workers_used;
   }
 
+  int ConfigureCores(int first, int nthreads, bool exclude_worker0) {
+    ICHECK_GE(first, 0);
+    ICHECK_GE(nthreads, 1);
+    std::vector<unsigned int> cpus;
+    for (int i = 0; i < nthreads; ++i) {
+      cpus.push_back(sorted_order_[(first + i) % sorted_order_.size()]);
+    }
+    int num_workers_used = std::min(num_workers_, nthreads);
+    const char* val = getenv("TVM_BIND_THREADS");
+    if (val == nullptr || atoi(val) == 1) {
+      SetAffinity(cpus, num_workers_used, exclude_worker0);
+    }
+    return num_workers_used;
+  }
+
  private:
   // bind worker threads to disjoint cores
   // if worker 0 is offloaded to main, i.e. exclude_worker0 is true,
@@ -140,6 +159,60 @@ class ThreadGroup::Impl {
 #endif
   }
 
+  // Use the CPUs of a NUMA node or the physical cores.
+  int ConfigureTopology(AffinityMode mode, int nthreads, bool exclude_worker0, int numa_node) {
+    // One CPU per physical core first, then their SMT siblings for kNumaNode.
+    std::vector<unsigned int> cpus;
+    int num_physical = 0;
+    for (bool physical : {true, false}) {
+      for (const CPUInfo& cpu : CPUTopology()) {
+        if (mode == kNumaNode && cpu.numa_node != numa_node) continue;
+        if ((cpu.core == cpu.id) != physical) continue;
+        cpus.push_back(cpu.id);
+        num_physical += physical;
+      }
+      if (mode == kPhysical) break;
+    }
+    ICHECK(!cpus.empty()) << "NUMA node " << numa_node << " has no CPU";
+    int num_workers_used = std::min(num_workers_, nthreads ? nthreads : num_physical);
+
+    const char* val = getenv("TVM_BIND_THREADS");
+    if (val == nullptr || atoi(val) == 1) {
+      SetAffinity(cpus, num_workers_used, exclude_worker0);
+    }
+    return num_workers_used;
+  }
+
+  // Bind the workers to cpus in order, the workers beyond the CPUs wrap around.
+  // The main thread may run on the CPUs of the workers in use.
+  void SetAffinity(const std::vector<unsigned int>& cpus, int num_workers_used,
+                   bool exclude_worker0) {
+#if defined(__linux__) || defined(__ANDROID__)
+    for (unsigned i = 0; i < threads_.size(); ++i) {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(cpus[(i + exclude_worker0) % cpus.size()], &cpuset);
+#if defined(__ANDROID__)
+      sched_setaffinity(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
+#else
+      pthread_setaffinity_np(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
+#endif
+    }
+    if (exclude_worker0) {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      for (size_t i = 0; i < cpus.size() && i < static_cast<size_t>(num_workers_used); ++i) {
+        CPU_SET(cpus[i], &cpuset);
+      }
+#if defined(__ANDROID__)
+      sched_setaffinity(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#else
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#endif
+    }
+#endif
+  }
+
   void SetMasterThreadFullCpuAffinity(bool reverse) {
 #if defined(__linux__) || defined(__ANDROID__)
     cpu_set_t cpuset;
@@ -231,8 +304,72 @@ ThreadGroup::ThreadGroup(int num_workers, std::function<void(int)> worker_callba
 ThreadGroup::~ThreadGroup() { delete impl_; }
 void ThreadGroup::Join() { impl_->Join(); }
 
-int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0) {
-  return impl_->Configure(mode, nthreads, exclude_worker0);
+int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0, int numa_node) {
+  return impl_->Configure(mode, nthreads, exclude_worker0, numa_node);
+}
+
+int ThreadGroup::ConfigureCores(int first, int nthreads, bool exclude_worker0) {
+  return impl_->ConfigureCores(first, nthreads, exclude_worker0);
+}
+
+#if defined(__linux__) || defined(__ANDROID__)
+namespace {
+// Read a list of ids such as "0-3,8-11", empty if the file is missing.
+std::vector<unsigned int> ReadIdList(const std::string& path) {
+  std::vector<unsigned int> ids;
+  std::ifstream ifs(path);
+  std::string list;
+  if (!(ifs >> list)) return ids;
+  std::istringstream is(list);
+  std::string range;
+  while (std::getline(is, range, ',')) {
+    size_t dash = range.find('-');
+    unsigned int begin = std::stoul(range.substr(0, dash));
+    unsigned int end = dash == std::string::npos ? begin : std::stoul(range.substr(dash + 1));
+    for (unsigned int id = begin; id <= end; ++id) {
+      ids.push_back(id);
+    }
+  }
+  return ids;
+}
+}  // namespace
+#endif
+
+const std::vector<CPUInfo>& CPUTopology() {
+  static std::vector<CPUInfo> topology = [] {
+    std::vector<CPUInfo> cpus;
+    unsigned int threads = std::max(std::thread::hardware_concurrency(), 1U);
+    for (unsigned int i = 0; i < threads; ++i) {
+      cpus.push_back(CPUInfo{i, 0, 0, i});
+    }
+#if defined(__linux__) || defined(__ANDROID__)
+    const std::string root = "/sys/devices/system/";
+    for (CPUInfo& cpu : cpus) {
+      std::string dir = root + "cpu/cpu" + std::to_string(cpu.id) + "/topology/";
+      std::ifstream ifs(dir + "physical_package_id");
+      if (!(ifs >> cpu.package) || cpu.package < 0) cpu.package = 0;
+      std::vector<unsigned int> siblings = ReadIdList(dir + "thread_siblings_list");
+      if (!siblings.empty()) {
+        cpu.core = *std::min_element(siblings.begin(), siblings.end());
+      }
+    }
+    for (unsigned int node : ReadIdList(root + "node/online")) {
+      for (unsigned int id : ReadIdList(root + "node/node" + std::to_string(node) + "/cpulist")) {
+        if (id < cpus.size()) cpus[id].numa_node = static_cast<int>(node);
+      }
+    }
+#endif
+    return cpus;
+  }();
+  return topology;
+}
+
+int NumNumaNodes() {
+  int num_nodes = 1;
+  for (const CPUInfo& cpu : CPUTopology()) {
+    num_nodes = std::max(num_nodes, cpu.numa_node + 1);
+  }
+  return num_nodes;
 }
 
 void Yield() { std::this_thread::yield(); }
@@ -0,0 +1,373 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file runtime/best_fit_allocator.h
+ */
+#ifndef TVM_RUNTIME_VM_BEST_FIT_ALLOCATOR_H_
+#define TVM_RUNTIME_VM_BEST_FIT_ALLOCATOR_H_
+
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/vm/memory_manager.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+namespace vm {
+
+/*!
+ * \brief An allocator carving size-classed blocks out of large device segments.
+ *
+ *  Requests are rounded up to a size class (four classes per power of two) and
+ *  served by the smallest free block that fits. On devices with a flat address
+ *  space blocks are split off segments and coalesced with their free neighbours
+ *  when released, elsewhere each block is a whole device allocation. Fully free
+ *  segments are kept up to a cache limit and trimmed in least recently used order.
+ *  Small buffers are recycled through a per-thread cache without taking the lock.
+ */
+class BestFitAllocator final : public Allocator {
+ public:
+  /*! \brief The granularity and alignment of blocks inside a segment. */
+  static constexpr size_t kMinBlockSize = 256;
+  /*! \brief The size of the segments requested from the device. */
+  static constexpr size_t kSegmentSize = 2 << 20;
+  /*! \brief The largest buffer recycled through the per-thread cache. */
+  static constexpr size_t kThreadCacheMaxBytes = 1 << 20;
+  /*! \brief The number of buffers a thread caches per allocator. */
+  static constexpr size_t kThreadCacheSlots = 16;
+
+  /*!
+   * \brief Create the allocator.
+   * \param dev The device to allocate on.
+   * \param cache_limit The bytes of fully free segments kept for reuse, defaults to the
+   *        TVM_VM_ALLOCATOR_CACHE_LIMIT environment variable or no limit.
+   */
+  explicit BestFitAllocator(Device dev, size_t cache_limit = DefaultCacheLimit())
+      : Allocator(kBestFit),
+        device_(dev),
+        cache_limit_(cache_limit),
+        splittable_(dev.device_type == kDLCPU || dev.device_type == kDLCUDA ||
+                    dev.device_type == kDLCUDAHost || dev.device_type == kDLROCM),
+        id_(NextId()) {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    Registry()[id_] = this;
+  }
+
+  ~BestFitAllocator() {
+    {
+      std::lock_guard<std::mutex> lock(RegistryMutex());
+      Registry().erase(id_);
+    }
+    std::lock_guard<std::recursive_mutex> lock(mu_);
+    for (auto& kv : segments_) {
+      for (Block* block = kv.second->head; block != nullptr;) {
+        Block* next = block->next;
+        delete block;
+        block = next;
+      }
+      DeviceAPI::Get(device_)->FreeDataSpace(device_, kv.second->data);
+    }
+  }
+
+  Buffer Alloc(size_t nbytes, size_t alignment, DLDataType type_hint) override {
+    size_t size = SizeClass(nbytes);
+    if (size <= kThreadCacheMaxBytes && alignment <= kMinBlockSize) {
+      std::vector<Buffer>& cache = ThreadCache::Get()->buffers[id_];
+      for (auto it = cache.rbegin(); it != cache.rend(); ++it) {
+        if (it->size == size) {
+          Buffer ret = *it;
+          cache.erase(std::next(it).base());
+          return ret;
+        }
+      }
+    }
+    std::lock_guard<std::recursive_mutex> lock(mu_);
+    Block* block = FindFreeBlock(size, alignment);
+    if (block == nullptr) {
+      block = NewSegment(size, alignment, type_hint)->head;
+    }
+    free_blocks_.erase({block->size, block});
+    block->free = false;
+    Split(block, size);
+    live_blocks_[BlockData(block)] = block;
+    UpdatePeak(allocated_memory_.fetch_add(block->size, std::memory_order_relaxed) + block->size);
+    Buffer buf;
+    buf.device = device_;
+    buf.size = block->size;
+    buf.data = BlockData(block);
+    DLOG(INFO) << "allocate " << buf.size << " B, used memory " << used_memory_ << " B";
+    return buf;
+  }
+
+  void Free(const Buffer& buffer) override {
+    if (buffer.size <= kThreadCacheMaxBytes) {
+      std::vector<Buffer>& cache = ThreadCache::Get()->buffers[id_];
+      if (cache.size() < kThreadCacheSlots) {
+        cache.push_back(buffer);
+        return;
+      }
+    }
+    std::lock_guard<std::recursive_mutex> lock(mu_);
+    FreeBlock(buffer);
+    Trim(cache_limit_);
+  }
+
+  /*! \return The bytes held from the device. */
+  size_t UsedMemory() const override { return used_memory_.load(std::memory_order_relaxed); }
+  /*! \return The bytes of blocks currently handed out, including the ones in thread caches. */
+  size_t AllocatedMemory() const override { return allocated_memory_.load(std::memory_order_relaxed); }
+  /*! \return The largest value AllocatedMemory has reached. */
+  size_t PeakMemory() const override { return peak_memory_.load(std::memory_order_relaxed); }
+
+  /*! \brief Return the fully free segments to the device, after flushing the calling
+   *   thread's cache. */
+  void ReleaseAll() {
+    std::lock_guard<std::recursive_mutex> lock(mu_);
+    std::vector<Buffer>& cache = ThreadCache::Get()->buffers[id_];
+    for (const Buffer& buf : cache) {
+      FreeBlock(buf);
+    }
+    cache.clear();
+    Trim(0);
+    DLOG(INFO) << "release all free segments";
+  }
+
+  /*! \return The size class of a request, rounding up by at most a quarter. */
+  static size_t SizeClass(size_t nbytes) {
+    size_t size = std::max(nbytes, kMinBlockSize);
+    size_t step = kMinBlockSize;
+    while ((step << 3) <= size) step <<= 1;
+    return (size + step - 1) / step * step;
+  }
+
+ private:
+  struct Segment;
+  /*! \brief A range of a segment, linked with its neighbours in address order. */
+  struct Block {
+    Segment* segment;
+    size_t offset;
+    size_t size;
+    bool free;
+    Block* prev;
+    Block* next;
+  };
+  /*! \brief A device allocation. */
+  struct Segment {
+    void* data;
+    size_t size;
+    Block* head;
+    /*! \brief The position in the LRU list of fully free segments, if there. */
+    std::list<Segment*>::iterator lru_pos;
+    bool in_lru{false};
+  };
+  /*! \brief The buffers a thread keeps for reuse, indexed by allocator id. */
+  struct ThreadCache {
+    // Return the cached buffers to the allocators still alive when the thread exits,
+    // the ones of destroyed allocators went away with their segments.
+    ~ThreadCache() {
+      std::lock_guard<std::mutex> lock(RegistryMutex());
+      for (auto& kv : buffers) {
+        auto it = Registry().find(kv.first);
+        if (it == Registry().end()) continue;
+        BestFitAllocator* alloc = it->second;
+        std::lock_guard<std::recursive_mutex> alloc_lock(alloc->mu_);
+        for (const Buffer& buf : kv.second) {
+          alloc->FreeBlock(buf);
+        }
+        alloc->Trim(alloc->cache_limit_);
+      }
+      buffers.clear();
+    }
+    static ThreadCache* Get() {
+      static thread_local ThreadCache inst;
+      return &inst;
+    }
+    std::unordered_map<uint64_t, std::vector<Buffer>> buffers;
+  };
+
+  static size_t DefaultCacheLimit() {
+    const char* val = getenv("TVM_VM_ALLOCATOR_CACHE_LIMIT");
+    if (val == nullptr) return std::numeric_limits<size_t>::max();
+    return static_cast<size_t>(strtoull(val, nullptr, 10));
+  }
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1);
+  }
+  static std::unordered_map<uint64_t, BestFitAllocator*>& Registry() {
+    static auto* inst = new std::unordered_map<uint64_t, BestFitAllocator*>();
+    return *inst;
+  }
+  static std::mutex& RegistryMutex() {
+    static auto* inst = new std::mutex();
+    return *inst;
+  }
+
+  // Raise peak_memory_ to allocated unless another thread raised it further.
+  void UpdatePeak(size_t allocated) {
+    size_t peak = peak_memory_.load(std::memory_order_relaxed);
+    while (allocated > peak &&
+           !peak_memory_.compare_exchange_weak(peak, allocated, std::memory_order_relaxed)) {
+    }
+  }
+
+  void* BlockData(Block* block) const {
+    return static_cast<char*>(block->segment->data) + block->offset;
+  }
+
+  // The smallest free block fitting the request, or nullptr.
+  Block* FindFreeBlock(size_t size, size_t alignment) {
+    auto it = free_blocks_.lower_bound({size, nullptr});
+    for (; it != free_blocks_.end(); ++it) {
+      Block* block = it->second;
+      // unsplittable blocks are only reused when they waste less than the request
+      if (!splittable_ && block->size > 2 * size) return nullptr;
+      if (!splittable_ || reinterpret_cast<uintptr_t>(BlockData(block)) % alignment == 0) {
+        return block;
+      }
+    }
+    return nullptr;
+  }
+
+  Segment* NewSegment(size_t size, size_t alignment, DLDataType type_hint) {
+    size_t seg_size = splittable_ ? (size + kSegmentSize - 1) / kSegmentSize * kSegmentSize : size;
+    size_t seg_align = std::max(alignment, kMinBlockSize);
+    void* data;
+    try {
+      data = DeviceAPI::Get(device_)->AllocDataSpace(device_, seg_size, seg_align, type_hint);
+    } catch (InternalError& err) {
+      LOG(WARNING) << "BestFitAllocator got InternalError during allocation: " << err.message();
+      LOG(WARNING) << "Trying to release all unused memory and reallocate...";
+      Trim(0);
+      data = DeviceAPI::Get(device_)->AllocDataSpace(device_, seg_size, seg_align, type_hint);
+    }
+    std::unique_ptr<Segment> seg(new Segment());
+    seg->data = data;
+    seg->size = seg_size;
+    seg->head = new Block{seg.get(), 0, seg_size, true, nullptr, nullptr};
+    free_blocks_.insert({seg_size, seg->head});
+    used_memory_.fetch_add(seg_size, std::memory_order_relaxed);
+    Segment* ret = seg.get();
+    segments_[data] = std::move(seg);
+    return ret;
+  }
+
+  // Cut the tail beyond size off an allocated block as a new free block.
+  void Split(Block* block, size_t size) {
+    Segment* seg = block->segment;
+    if (seg->in_lru) {
+      lru_.erase(seg->lru_pos);
+      seg->in_lru = false;
+      cached_segment_bytes_ -= seg->size;
+    }
+    if (!splittable_ || block->size - size < kMinBlockSize) return;
+    Block* rest =
+        new Block{seg, block->offset + size, block->size - size, true, block, block->next};
+    if (block->next != nullptr) block->next->prev = rest;
+    block->next = rest;
+    block->size = size;
+    free_blocks_.insert({rest->size, rest});
+  }
+
+  void FreeBlock(const Buffer& buffer) {
+    auto it = live_blocks_.find(buffer.data);
+    ICHECK(it != live_blocks_.end()) << "Free a buffer not allocated by BestFitAllocator";
+    Block* block = it->second;
+    live_blocks_.erase(it);
+    allocated_memory_.fetch_sub(block->size, std::memory_order_relaxed);
+    block->free = true;
+    // coalesce with the free neighbours
+    if (block->next != nullptr && block->next->free) {
+      Block* next = block->next;
+      free_blocks_.erase({next->size, next});
+      block->size += next->size;
+      block->next = next->next;
+      if (next->next != nullptr) next->next->prev = block;
+      delete next;
+    }
+    if (block->prev != nullptr && block->prev->free) {
+      Block* prev = block->prev;
+      free_blocks_.erase({prev->size, prev});
+      prev->size += block->size;
+      prev->next = block->next;
+      if (block->next != nullptr) block->next->prev = prev;
+      delete block;
+      block = prev;
+    }
+    free_blocks_.insert({block->size, block});
+    Segment* seg = block->segment;
+    if (block->prev == nullptr && block->next == nullptr) {
+      seg->lru_pos = lru_.insert(lru_.end(), seg);
+      seg->in_lru = true;
+      cached_segment_bytes_ += seg->size;
+    }
+    DLOG(INFO) << "reclaim buffer " << buffer.size;
+  }
+
+  // Release least recently used free segments until at most limit bytes of them are cached.
+  void Trim(size_t limit) {
+    while (!lru_.empty() && cached_segment_bytes_ > limit) {
+      Segment* seg = lru_.front();
+      lru_.pop_front();
+      cached_segment_bytes_ -= seg->size;
+      free_blocks_.erase({seg->head->size, seg->head});
+      delete seg->head;
+      used_memory_.fetch_sub(seg->size, std::memory_order_relaxed);
+      void* data = seg->data;
+      DeviceAPI::Get(device_)->FreeDataSpace(device_, data);
+      segments_.erase(data);
+    }
+  }
+
+  Device device_;
+  size_t cache_limit_;
+  bool splittable_;
+  uint64_t id_;
+  std::atomic<size_t> used_memory_{0};
+  std::atomic<size_t> allocated_memory_{0};
+  std::atomic<size_t> peak_memory_{0};
+  /*! \brief The bytes of the segments in lru_. */
+  size_t cached_segment_bytes_{0};
+  /*! \brief The free blocks ordered by size for best-fit lookup. */
+  std::set<std::pair<size_t, Block*>> free_blocks_;
+  /*! \brief The allocated blocks by data pointer. */
+  std::unordered_map<void*, Block*> live_blocks_;
+  /*! \brief The segments by data pointer. */
+  std::unordered_map<void*, std::unique_ptr<Segment>> segments_;
+  /*! \brief The fully free segments, least recently freed first. */
+  std::list<Segment*> lru_;
+  std::recursive_mutex mu_;
+};
+
+}  // namespace vm
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_VM_BEST_FIT_ALLOCATOR_H_
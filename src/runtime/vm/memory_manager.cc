@@ -21,11 +21,14 @@
  * \file tvm/runtime/vm/memory_manager.cc
  * \brief Allocate and manage memory for the runtime.
  */
+#include <tvm/runtime/registry.h>
 #include <tvm/runtime/vm/memory_manager.h>
 
 #include <memory>
+#include <string>
 #include <utility>
 
+#include "best_fit_allocator.h"
 #include "naive_allocator.h"
 #include "pooled_allocator.h"
 
@@ -130,6 +133,12 @@ Allocator* MemoryManager::GetOrCreateAllocator(Device dev, AllocatorType type) {
         alloc.reset(new PooledAllocator(dev));
         break;
       }
+      case kBestFit: {
+        DLOG(INFO) << "New best-fit allocator for " << DeviceName(dev.device_type) << "("
+                   << dev.device_id << ")";
+        alloc.reset(new BestFitAllocator(dev));
+        break;
+      }
       default:
         LOG(FATAL) << "Unknown allocator type: " << type;
     }
@@ -170,6 +179,25 @@ NDArray Allocator::Empty(std::vector<int64_t> shape, DLDataType dtype, DLDevice
   return NDArray(GetObjectPtr<Object>(container));
 }
 
+TVM_REGISTER_GLOBAL("runtime.vm.AllocatorMemoryStats").set_body([](TVMArgs args, TVMRetValue* rv) {
+  Device dev;
+  dev.device_type = static_cast<DLDeviceType>(args[0].operator int());
+  dev.device_id = args[1];
+  std::string key = args[2];
+  Allocator* alloc = MemoryManager::GetAllocator(dev);
+  if (key == "used") {
+    *rv = static_cast<int64_t>(alloc->UsedMemory());
+  } else if (key == "allocated") {
+    *rv = static_cast<int64_t>(alloc->AllocatedMemory());
+  } else if (key == "peak") {
+    *rv = static_cast<int64_t>(alloc->PeakMemory());
+  } else if (key == "type") {
+    *rv = static_cast<int>(alloc->type());
+  } else {
+    LOG(FATAL) << "Unknown allocator memory stat " << key;
+  }
+});
+
 }  // namespace vm
 }  // namespace runtime
 }  // namespace tvm
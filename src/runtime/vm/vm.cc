@@ -175,6 +175,10 @@ PackedFunc VirtualMachine::GetFunction(const std::string& name,
       }
       this->Init(devices, alloc_types);
     });
+  } else if (name == "create_context") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      *rv = Module(CreateContext(sptr_to_self));
+    });
   } else if (name == "set_input") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       ICHECK(exec_) << "The executable is not created yet.";
@@ -342,6 +346,28 @@ void VirtualMachine::LoadExecutable(const Executable* exec) {
   }
 }
 
+ObjectPtr<VirtualMachine> VirtualMachine::CreateContext(const ObjectPtr<Object>& sptr_to_self) {
+  ICHECK(exec_) << "The executable is not created yet.";
+  ICHECK(!devices_.empty()) << "The VM must be initialized before creating contexts.";
+  // Materialize all the constants up front so that contexts only ever read the
+  // shared pool and hold references to the same device arrays.
+  const_pool_.resize(exec_->constants.size());
+  for (size_t i = 0; i < exec_->constants.size(); ++i) {
+    if (!const_pool_[i].defined()) {
+      Device dev = GetDevice(exec_->const_device_type[i]);
+      const_pool_[i] = CopyTo(exec_->constants[i], dev);
+    }
+  }
+  auto context = make_object<VirtualMachine>();
+  context->exec_ = exec_;
+  context->packed_funcs_ = packed_funcs_;
+  context->devices_ = devices_;
+  context->allocators_ = allocators_;
+  context->const_pool_ = const_pool_;
+  context->parent_ = sptr_to_self;
+  return context;
+}
+
 void VirtualMachine::Init(const std::vector<Device>& devs,
                           const std::vector<AllocatorType>& alloc_types) {
   ICHECK_EQ(devs.size(), alloc_types.size());
@@ -358,11 +384,19 @@ void VirtualMachine::Init(const std::vector<Device>& devs,
   }
 }
 
+// Dispatch the VM instructions through a table of label addresses (threaded
+// code) on compilers supporting computed goto.
+#if defined(__GNUC__) && !defined(TVM_VM_DISABLE_COMPUTED_GOTO)
+#define TVM_VM_COMPUTED_GOTO 1
+#else
+#define TVM_VM_COMPUTED_GOTO 0
+#endif
+
 inline void VirtualMachine::WriteRegister(Index r, const ObjectRef& val) {
   frames_.back().register_file[r] = val;
 }
 
-inline ObjectRef VirtualMachine::ReadRegister(Index r) const {
+inline const ObjectRef& VirtualMachine::ReadRegister(Index r) const {
   return frames_.back().register_file[r];
 }
 
@@ -403,23 +437,56 @@ void VirtualMachine::RunLoop() {
   ICHECK(this->code_);
   pc_ = 0;
   Index frame_start = frames_.size();
+  // The instruction being executed.
+  const Instruction* next = nullptr;
+#if TVM_VM_COMPUTED_GOTO
+  // Handler addresses indexed by opcode. Every handler jumps straight to the
+  // handler of the following instruction, so each opcode gets its own
+  // indirect branch instead of sharing the single one of the switch, which
+  // is only used for the first dispatch. Handlers dispatch after their block
+  // is closed since a computed goto does not destroy the locals it leaves.
+  static void* const kDispatchTable[] = {
+      &&op_Move, &&op_Ret, &&op_Invoke, &&op_InvokeClosure, &&op_InvokePacked, &&op_AllocTensor,
+      &&op_AllocTensorReg, &&op_AllocADT, &&op_AllocClosure, &&op_GetField, &&op_If,
+      &&op_LoadConst, &&op_Goto, &&op_GetTag, &&op_LoadConsti, &&op_Fatal, &&op_AllocStorage,
+      &&op_ShapeOf, &&op_ReshapeTensor, &&op_DeviceCopy};
+  constexpr size_t kNumOpcodes = sizeof(kDispatchTable) / sizeof(kDispatchTable[0]);
+  static_assert(kNumOpcodes == static_cast<size_t>(Opcode::DeviceCopy) + 1,
+                "The dispatch table must list every opcode in order");
+#define TVM_VM_CASE(name) \
+  case Opcode::name:      \
+  op_##name:
+#define TVM_VM_DISPATCH()                                \
+  do {                                                   \
+    next = &code_[pc_];                                  \
+    DLOG(INFO) << "Executing(" << pc_ << "): " << *next; \
+    size_t opcode = static_cast<size_t>(next->op);       \
+    if (opcode >= kNumOpcodes) goto op_unknown;          \
+    goto* kDispatchTable[opcode];                        \
+  } while (0)
+#else
+#define TVM_VM_CASE(name) case Opcode::name:
+#define TVM_VM_DISPATCH() goto main_loop
+#endif
   while (true) {
+#if !TVM_VM_COMPUTED_GOTO
   main_loop:
-    auto const& instr = code_[this->pc_];
-    DLOG(INFO) << "Executing(" << pc_ << "): " << instr;
-
-    switch (instr.op) {
-      case Opcode::Move: {
-        ObjectRef from_obj;
-        from_obj = ReadRegister(instr.from);
-        WriteRegister(instr.dst, from_obj);
+#endif
+    next = &code_[this->pc_];
+    DLOG(INFO) << "Executing(" << pc_ << "): " << *next;
+
+    switch (next->op) {
+      TVM_VM_CASE(Move) {
+        const Instruction& instr = *next;
+        WriteRegister(instr.dst, ReadRegister(instr.from));
         pc_++;
-        goto main_loop;
       }
-      case Opcode::Fatal: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(Fatal) {
         throw std::runtime_error("VM encountered fatal error");
       }
-      case Opcode::LoadConst: {
+      TVM_VM_CASE(LoadConst) {
+        const Instruction& instr = *next;
         auto constant_obj = exec_->constants[instr.const_index];
         // We cache the allocated object in the constant pool. To measure, the
         // first iteration will set the pool up. The other iterations will
@@ -434,43 +501,47 @@ void VirtualMachine::RunLoop() {
         }
         WriteRegister(instr.dst, const_pool_[instr.const_index]);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::LoadConsti: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(LoadConsti) {
+        const Instruction& instr = *next;
         auto tensor = NDArray::Empty({1}, {kDLInt, 64, 1}, {kDLCPU, 0});
         reinterpret_cast<int64_t*>(tensor->data)[0] = instr.load_consti.val;
         WriteRegister(instr.dst, tensor);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::Invoke: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(Invoke) {
+        const Instruction& instr = *next;
         std::vector<ObjectRef> args;
         for (Index i = 0; i < instr.num_args; ++i) {
           args.push_back(ReadRegister(instr.invoke_args_registers[i]));
         }
         InvokeGlobal(exec_->functions[instr.func_index], args);
         frames_.back().caller_return_register = instr.dst;
-        goto main_loop;
       }
-      case Opcode::InvokePacked: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(InvokePacked) {
+        const Instruction& instr = *next;
         DLOG(INFO) << "InvokedPacked " << instr.packed_index << " arity=" << instr.arity;
         ICHECK_LE(instr.packed_index, packed_funcs_.size());
         const auto& func = packed_funcs_[instr.packed_index];
         const auto& arity = instr.arity;
         std::vector<ObjectRef> args;
+        args.reserve(arity);
         for (Index i = 0; i < arity; ++i) {
           DLOG(INFO) << "arg" << i << " $" << instr.packed_args[i];
-          auto arg = ReadRegister(instr.packed_args[i]);
-          args.push_back(arg);
+          args.push_back(ReadRegister(instr.packed_args[i]));
         }
 
         // We no longer need to write the registers back, we write directly
         // through the registers mutably.
         InvokePacked(instr.packed_index, func, arity, instr.output_size, args);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::InvokeClosure: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(InvokeClosure) {
+        const Instruction& instr = *next;
         auto object = ReadRegister(instr.closure);
         const auto* closure = object.as<VMClosureObj>();
         ICHECK(closure);
@@ -483,17 +554,19 @@ void VirtualMachine::RunLoop() {
         }
         InvokeGlobal(exec_->functions[closure->func_index], args);
         frames_.back().caller_return_register = instr.dst;
-        goto main_loop;
       }
-      case Opcode::GetField: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(GetField) {
+        const Instruction& instr = *next;
         auto object = ReadRegister(instr.object);
         const auto& tuple = Downcast<ADT>(object);
         auto field = tuple[instr.field_index];
         WriteRegister(instr.dst, field);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::GetTag: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(GetTag) {
+        const Instruction& instr = *next;
         auto object = ReadRegister(instr.get_tag.object);
         const auto& adt = Downcast<ADT>(object);
         auto tag = adt.tag();
@@ -501,13 +574,15 @@ void VirtualMachine::RunLoop() {
         reinterpret_cast<int32_t*>(tag_tensor->data)[0] = tag;
         WriteRegister(instr.dst, tag_tensor);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::Goto: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(Goto) {
+        const Instruction& instr = *next;
         pc_ += instr.pc_offset;
-        goto main_loop;
       }
-      case Opcode::If: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(If) {
+        const Instruction& instr = *next;
         int32_t test_val = LoadScalarInt(instr.if_op.test);
         int32_t target_val = LoadScalarInt(instr.if_op.target);
 
@@ -518,10 +593,10 @@ void VirtualMachine::RunLoop() {
           ICHECK_NE(instr.if_op.false_offset, 0);
           pc_ += instr.if_op.false_offset;
         }
-
-        goto main_loop;
       }
-      case Opcode::AllocTensor: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(AllocTensor) {
+        const Instruction& instr = *next;
         auto shape = std::vector<int64_t>(instr.alloc_tensor.ndim);
 
         for (uint32_t i = 0; i < instr.alloc_tensor.ndim; ++i) {
@@ -535,9 +610,10 @@ void VirtualMachine::RunLoop() {
 
         WriteRegister(instr.dst, obj);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::AllocTensorReg: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(AllocTensorReg) {
+        const Instruction& instr = *next;
         Device cpu_dev = GetDevice(static_cast<Index>(kDLCPU));
         auto shape_obj = ReadRegister(instr.alloc_tensor_reg.shape_register);
         NDArray shape_tensor = Downcast<NDArray>(CopyTo(shape_obj, cpu_dev));
@@ -549,9 +625,10 @@ void VirtualMachine::RunLoop() {
 
         WriteRegister(instr.dst, obj);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::AllocADT: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(AllocADT) {
+        const Instruction& instr = *next;
         std::vector<ObjectRef> fields;
         for (Index i = 0; i < instr.num_fields; ++i) {
           fields.push_back(ReadRegister(instr.datatype_fields[i]));
@@ -559,18 +636,20 @@ void VirtualMachine::RunLoop() {
         ObjectRef obj = ADT(instr.constructor_tag, fields);
         WriteRegister(instr.dst, obj);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::AllocClosure: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(AllocClosure) {
+        const Instruction& instr = *next;
         std::vector<ObjectRef> free_vars;
         for (Index i = 0; i < instr.num_freevar; i++) {
           free_vars.push_back(ReadRegister(instr.free_vars[i]));
         }
         WriteRegister(instr.dst, VMClosure(instr.func_index, free_vars));
         pc_++;
-        goto main_loop;
       }
-      case Opcode::AllocStorage: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(AllocStorage) {
+        const Instruction& instr = *next;
         auto size = LoadScalarInt(instr.alloc_storage.allocation_size);
         auto alignment = instr.alloc_storage.alignment;
 
@@ -588,9 +667,22 @@ void VirtualMachine::RunLoop() {
         Storage storage(storage_obj);
         WriteRegister(instr.dst, storage);
         pc_++;
-        goto main_loop;
+        // The storage is almost always followed by the tensor placed in it, execute
+        // both as one superinstruction without another dispatch or register read.
+        const Instruction& alloc_tensor = code_[pc_];
+        if (alloc_tensor.op == Opcode::AllocTensor &&
+            alloc_tensor.alloc_tensor.storage == instr.dst) {
+          const int64_t* dims = alloc_tensor.alloc_tensor.shape;
+          std::vector<int64_t> shape(dims, dims + alloc_tensor.alloc_tensor.ndim);
+          auto offset = LoadScalarInt(alloc_tensor.alloc_tensor.offset);
+          WriteRegister(alloc_tensor.dst,
+                        storage->AllocNDArray(offset, shape, alloc_tensor.alloc_tensor.dtype));
+          pc_++;
+        }
       }
-      case Opcode::ShapeOf: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(ShapeOf) {
+        const Instruction& instr = *next;
         auto input = ReadRegister(instr.shape_of.tensor);
         NDArray input_array = Downcast<NDArray>(input);
         int ndim = input_array->ndim;
@@ -600,9 +692,10 @@ void VirtualMachine::RunLoop() {
         }
         WriteRegister(instr.dst, out_tensor);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::Ret: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(Ret) {
+        const Instruction& instr = *next;
         // If we have hit the point from which we started
         // running, we should return to the caller breaking
         // the dispatch loop.
@@ -611,13 +704,13 @@ void VirtualMachine::RunLoop() {
 
         if (PopFrame() == frame_start) {
           return;
-          // Otherwise we are just returning from a local call.
-        } else {
-          WriteRegister(caller_return_register, return_register_);
-          goto main_loop;
         }
+        // Otherwise we are just returning from a local call.
+        WriteRegister(caller_return_register, return_register_);
       }
-      case Opcode::ReshapeTensor: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(ReshapeTensor) {
+        const Instruction& instr = *next;
         Device cpu_dev = GetDevice(static_cast<Index>(kDLCPU));
         auto tensor_obj = ReadRegister(instr.reshape_tensor.tensor);
         NDArray tensor_arr = Downcast<NDArray>(tensor_obj);
@@ -634,9 +727,10 @@ void VirtualMachine::RunLoop() {
         auto out_tensor = tensor_arr.CreateView(shape, tensor_arr->dtype);
         WriteRegister(instr.dst, out_tensor);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::DeviceCopy: {
+      TVM_VM_DISPATCH();
+      TVM_VM_CASE(DeviceCopy) {
+        const Instruction& instr = *next;
         auto tensor_src = ReadRegister(instr.src);
         NDArray src_data = Downcast<NDArray>(tensor_src);
         Device src_dev = src_data->device;
@@ -649,12 +743,17 @@ void VirtualMachine::RunLoop() {
         NDArray dst_data = src_data.CopyTo(dst_dev);
         WriteRegister(instr.dst, dst_data);
         pc_++;
-        goto main_loop;
       }
+      TVM_VM_DISPATCH();
       default:
-        LOG(FATAL) << "Unknown instruction opcode: " << int(instr.op);
+#if TVM_VM_COMPUTED_GOTO
+      op_unknown:
+#endif
+        LOG(FATAL) << "Unknown instruction opcode: " << static_cast<int>(next->op);
     }
   }
+#undef TVM_VM_CASE
+#undef TVM_VM_DISPATCH
 }
 
 runtime::Module CreateVirtualMachine(const Executable* exec) {
@@ -23,114 +23,195 @@
  */
 #include "workspace_pool.h"
 
+#include <tvm/runtime/logging.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <unordered_map>
 
 namespace tvm {
 namespace runtime {
 
 // page size.
 constexpr size_t kWorkspacePageSize = 4 << 10;
+// number of size classes, the largest class is 512MB.
+constexpr int kNumSizeClasses = 64;
 
 class WorkspacePool::Pool {
  public:
-  // constructor
-  Pool() {
-    // safe guard header on each list.
-    Entry e;
-    e.data = nullptr;
-    e.size = 0;
-    free_list_.push_back(e);
-    allocated_.push_back(e);
-  }
   // allocate from pool
   void* Alloc(Device dev, DeviceAPI* device, size_t nbytes) {
-    // Allocate align to page.
-    nbytes = (nbytes + (kWorkspacePageSize - 1)) / kWorkspacePageSize * kWorkspacePageSize;
-    if (nbytes == 0) nbytes = kWorkspacePageSize;
+    int cls = SizeClass(nbytes);
     Entry e;
-    DLDataType type;
-    type.code = kDLUInt;
-    type.bits = 8;
-    type.lanes = 1;
-    if (free_list_.size() == 2) {
-      e = free_list_.back();
-      free_list_.pop_back();
-      if (e.size < nbytes) {
-        // resize the page
-        device->FreeDataSpace(dev, e.data);
-        e.data = device->AllocDataSpace(dev, nbytes, kTempAllocaAlignment, type);
-        e.size = nbytes;
-      }
-    } else if (free_list_.size() == 1) {
-      e.data = device->AllocDataSpace(dev, nbytes, kTempAllocaAlignment, type);
-      e.size = nbytes;
-    } else {
-      if (free_list_.back().size >= nbytes) {
-        // find smallest fit
-        auto it = free_list_.end() - 2;
-        for (; it->size >= nbytes; --it) {
-        }
-        e = *(it + 1);
-        free_list_.erase(it + 1);
-      } else {
-        // resize the page
-        e = free_list_.back();
-        free_list_.pop_back();
-        device->FreeDataSpace(dev, e.data);
-        e.data = device->AllocDataSpace(dev, nbytes, kTempAllocaAlignment, type);
-        e.size = nbytes;
-      }
+    if (!TakeFree(cls, nbytes, &e)) {
+      // No cached block fits, give the largest one back to the device so that
+      // the pool does not keep growing with the sizes requested.
+      ReleaseLargest(dev, device);
+      e = NewBlock(dev, device, cls, nbytes);
     }
-    allocated_.push_back(e);
+    allocated_[e.data] = e.size;
+    stats_.bytes_in_use += e.size;
+    stats_.peak_bytes_in_use = std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
     return e.data;
   }
   // free resource back to pool
   void Free(void* data) {
-    Entry e;
-    if (allocated_.back().data == data) {
-      // quick path, last allocated.
-      e = allocated_.back();
-      allocated_.pop_back();
-    } else {
-      int index = static_cast<int>(allocated_.size()) - 2;
-      for (; index > 0 && allocated_[index].data != data; --index) {
+    auto it = allocated_.find(data);
+    ICHECK(it != allocated_.end()) << "trying to free things that has not been allocated";
+    Entry e{it->first, it->second};
+    allocated_.erase(it);
+    stats_.bytes_in_use -= e.size;
+    PutFree(e);
+  }
+  // cache blocks serving allocations of all the sizes at once
+  void Reserve(Device dev, DeviceAPI* device, std::vector<size_t> sizes) {
+    // Larger sizes first, each takes the smallest cached block that fits.
+    std::sort(sizes.begin(), sizes.end(), std::greater<size_t>());
+    std::vector<Entry> blocks;
+    for (size_t nbytes : sizes) {
+      int cls = SizeClass(nbytes);
+      Entry e;
+      if (!TakeFree(cls, nbytes, &e)) {
+        // Unlike Alloc, keep the cached blocks, they may be reserved for other kernels.
+        e = NewBlock(dev, device, cls, nbytes);
       }
-      ICHECK_GT(index, 0) << "trying to free things that has not been allocated";
-      e = allocated_[index];
-      allocated_.erase(allocated_.begin() + index);
+      blocks.push_back(e);
     }
-    if (free_list_.back().size < e.size) {
-      free_list_.push_back(e);
-    } else if (free_list_.size() == 2) {
-      free_list_.push_back(free_list_.back());
-      free_list_[1] = e;
-    } else {
-      size_t i = free_list_.size() - 1;
-      free_list_.resize(free_list_.size() + 1);
-      for (; e.size < free_list_[i].size; --i) {
-        free_list_[i + 1] = free_list_[i];
-      }
-      free_list_[i + 1] = e;
+    for (const Entry& e : blocks) {
+      PutFree(e);
     }
   }
   // Release all resources
   void Release(Device dev, DeviceAPI* device) {
-    for (size_t i = 1; i < free_list_.size(); ++i) {
-      device->FreeDataSpace(dev, free_list_[i].data);
+    for (auto& blocks : free_) {
+      for (void* data : blocks) {
+        device->FreeDataSpace(dev, data);
+      }
+      blocks.clear();
+    }
+    for (const Entry& e : large_free_) {
+      device->FreeDataSpace(dev, e.data);
     }
-    free_list_.clear();
+    large_free_.clear();
+    nonempty_ = 0;
+    stats_.bytes_cached = 0;
   }
 
+  const Stats& stats() const { return stats_; }
+
  private:
   /*! \brief a single entry in the pool */
   struct Entry {
     void* data;
     size_t size;
   };
-  /*! \brief List of free items, sorted from small to big size */
-  std::vector<Entry> free_list_;
-  /*! \brief List of allocated items */
-  std::vector<Entry> allocated_;
+  // Size class of an allocation, -1 if it is larger than all classes. Up to
+  // four pages each page count is a class, then every power of two is split
+  // in four classes.
+  static int SizeClass(size_t nbytes) {
+    size_t pages = std::max<size_t>((nbytes + kWorkspacePageSize - 1) / kWorkspacePageSize, 1);
+    if (pages <= 4) return static_cast<int>(pages - 1);
+    int log2 = 0;
+    for (size_t v = pages - 1; v > 1; v >>= 1) ++log2;
+    int cls = 4 * (log2 - 1) + static_cast<int>(((pages - 1) >> (log2 - 2)) - 4);
+    return cls < kNumSizeClasses ? cls : -1;
+  }
+  // Bytes of the blocks of a size class.
+  static size_t ClassBytes(int cls) {
+    if (cls < 4) return (cls + 1) * kWorkspacePageSize;
+    int log2 = cls / 4 + 1;
+    return (static_cast<size_t>(cls % 4 + 5) << (log2 - 2)) * kWorkspacePageSize;
+  }
+  // Take the smallest cached block serving an allocation of nbytes in class cls.
+  bool TakeFree(int cls, size_t nbytes, Entry* e) {
+    if (cls >= 0) {
+      uint64_t mask = nonempty_ >> cls;
+      if (mask != 0) {
+        while ((mask & 1) == 0) {
+          mask >>= 1;
+          ++cls;
+        }
+        e->data = free_[cls].back();
+        e->size = ClassBytes(cls);
+        free_[cls].pop_back();
+        if (free_[cls].empty()) nonempty_ &= ~(uint64_t(1) << cls);
+        stats_.bytes_cached -= e->size;
+        return true;
+      }
+    }
+    // Large blocks are few, take the smallest fit.
+    size_t best = large_free_.size();
+    for (size_t i = 0; i < large_free_.size(); ++i) {
+      if (large_free_[i].size >= nbytes &&
+          (best == large_free_.size() || large_free_[i].size < large_free_[best].size)) {
+        best = i;
+      }
+    }
+    if (best == large_free_.size()) return false;
+    *e = large_free_[best];
+    large_free_[best] = large_free_.back();
+    large_free_.pop_back();
+    stats_.bytes_cached -= e->size;
+    return true;
+  }
+  // Put a block into the free list of its class.
+  void PutFree(const Entry& e) {
+    int cls = SizeClass(e.size);
+    if (cls >= 0 && ClassBytes(cls) == e.size) {
+      free_[cls].push_back(e.data);
+      nonempty_ |= uint64_t(1) << cls;
+    } else {
+      large_free_.push_back(e);
+    }
+    stats_.bytes_cached += e.size;
+  }
+  // Give the largest cached block back to the device.
+  void ReleaseLargest(Device dev, DeviceAPI* device) {
+    Entry e;
+    if (!large_free_.empty()) {
+      size_t largest = 0;
+      for (size_t i = 1; i < large_free_.size(); ++i) {
+        if (large_free_[i].size > large_free_[largest].size) largest = i;
+      }
+      e = large_free_[largest];
+      large_free_[largest] = large_free_.back();
+      large_free_.pop_back();
+      stats_.bytes_cached -= e.size;
+    } else if (nonempty_ != 0) {
+      int cls = kNumSizeClasses - 1;
+      while ((nonempty_ >> cls & 1) == 0) --cls;
+      if (!TakeFree(cls, 0, &e)) return;
+    } else {
+      return;
+    }
+    device->FreeDataSpace(dev, e.data);
+  }
+  // Allocate a block for class cls from the device.
+  Entry NewBlock(Device dev, DeviceAPI* device, int cls, size_t nbytes) {
+    DLDataType type;
+    type.code = kDLUInt;
+    type.bits = 8;
+    type.lanes = 1;
+    Entry e;
+    e.size = cls >= 0 ? ClassBytes(cls)
+                      : (nbytes + kWorkspacePageSize - 1) / kWorkspacePageSize * kWorkspacePageSize;
+    e.data = device->AllocDataSpace(dev, e.size, kTempAllocaAlignment, type);
+    ++stats_.num_device_allocs;
+    return e;
+  }
+
+  /*! \brief The free blocks of each size class. */
+  std::vector<void*> free_[kNumSizeClasses];
+  /*! \brief Bit i is set when free_[i] is not empty. */
+  uint64_t nonempty_{0};
+  /*! \brief The free blocks larger than all size classes. */
+  std::vector<Entry> large_free_;
+  /*! \brief The size of each allocated block. */
+  std::unordered_map<void*, size_t> allocated_;
+  /*! \brief The statistics. */
+  Stats stats_;
 };
 
 WorkspacePool::WorkspacePool(DLDeviceType device_type, DeviceAPI* device)
@@ -163,5 +244,22 @@ void WorkspacePool::FreeWorkspace(Device dev, void* ptr) {
   array_[dev.device_id]->Free(ptr);
 }
 
+void WorkspacePool::Reserve(Device dev, const std::vector<size_t>& sizes) {
+  if (static_cast<size_t>(dev.device_id) >= array_.size()) {
+    array_.resize(dev.device_id + 1, nullptr);
+  }
+  if (array_[dev.device_id] == nullptr) {
+    array_[dev.device_id] = new Pool();
+  }
+  array_[dev.device_id]->Reserve(dev, device_, sizes);
+}
+
+WorkspacePool::Stats WorkspacePool::GetStats(Device dev) const {
+  if (static_cast<size_t>(dev.device_id) >= array_.size() || array_[dev.device_id] == nullptr) {
+    return Stats();
+  }
+  return array_[dev.device_id]->stats();
+}
+
 }  // namespace runtime
 }  // namespace tvm
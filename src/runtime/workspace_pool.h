@@ -26,6 +26,7 @@
 
 #include <tvm/runtime/device_api.h>
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -41,6 +42,11 @@ namespace runtime {
  *  - Only a few allocation will happen, and space will be released after use.
  *  - The release order is usually in reverse order of allocate
  *  - Repeative pattern of same allocations over different runs.
+ *
+ *  Blocks are rounded up to size classes, four per power of two, and the
+ *  freed blocks are cached in a free list per class, so allocation and free
+ *  take constant time. A pool is owned by a single thread and is not
+ *  thread-safe, the device APIs keep one pool per thread.
  */
 class TVM_DLL WorkspacePool {
  public:
@@ -65,6 +71,30 @@ class TVM_DLL WorkspacePool {
    * \param ptr The pointer to be freed.
    */
   void FreeWorkspace(Device dev, void* ptr);
+  /*!
+   * \brief Make sure that allocations of the given sizes, live at the same time,
+   *  are served from the pool, allocating blocks for those that no cached block fits.
+   * \param dev The device of allocation.
+   * \param sizes The sizes to be reserved.
+   */
+  void Reserve(Device dev, const std::vector<size_t>& sizes);
+
+  /*! \brief Statistics of the workspace of a device. */
+  struct Stats {
+    /*! \brief The bytes of the blocks given out and not freed yet. */
+    size_t bytes_in_use{0};
+    /*! \brief The largest value bytes_in_use ever reached. */
+    size_t peak_bytes_in_use{0};
+    /*! \brief The bytes of the freed blocks kept in the pool. */
+    size_t bytes_cached{0};
+    /*! \brief The number of blocks allocated from the device. */
+    size_t num_device_allocs{0};
+  };
+  /*!
+   * \brief Get the statistics of the workspace of a device.
+   * \param dev The device.
+   */
+  Stats GetStats(Device dev) const;
 
  private:
   class Pool;
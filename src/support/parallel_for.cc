@@ -24,7 +24,13 @@
 #include <tvm/runtime/logging.h>
 #include <tvm/support/parallel_for.h>
 
-#include <future>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -47,51 +53,171 @@ std::vector<std::vector<int>> rr_partitioner(int begin, int end, int step, int n
   return ret;
 }
 
-void parallel_for(int begin, int end, const std::function<void(int)>& f, int step,
-                  const PartitionerFuncType partitioner) {
-  static bool GLOBAL_PARALLEL_FOR_FLAG{false};
-  static std::mutex M_GLOBAL_PARALLEL_FOR_FLAG;
-  {
-    std::unique_lock<std::mutex> l(M_GLOBAL_PARALLEL_FOR_FLAG);
-    ICHECK(!GLOBAL_PARALLEL_FOR_FLAG) << "There's another parallel_for running. Maybe you're "
-                                      << "currently inside another parallel_for loop.";
-    GLOBAL_PARALLEL_FOR_FLAG = true;
-  }
+namespace {
+
+/*! \brief A loop of tasks shared by the caller and the pool workers that join it. */
+struct ParallelJob {
+  ParallelJob(int num_tasks, int chunk, int max_threads, const std::function<void(int, int)>& f)
+      : num_tasks(num_tasks), chunk(chunk), max_threads(max_threads), f(f) {}
+
+  /*! \return Whether another thread can still take part in the job. */
+  bool Joinable() const { return num_joined.load() < max_threads && next.load() < num_tasks; }
 
-  int default_num_threads = std::thread::hardware_concurrency();
-  const auto& run_partitions = partitioner(begin, end, step, default_num_threads);
-
-  std::vector<std::thread> threads;
-  threads.reserve(run_partitions.size());
-  std::vector<std::future<void>> res_vec;
-  res_vec.reserve(run_partitions.size());
-  for (const auto& run_partition : run_partitions) {
-    std::packaged_task<void(const std::vector<int>&, const std::function<void(int)>&)> task(
-        [](const std::vector<int>& run_pattition, const std::function<void(int)>& f) {
-          for (const auto& i : run_pattition) {
-            f(i);
+  /*! \brief Run chunks of tasks until the job is exhausted. */
+  void Run() {
+    int thread_id = num_joined.fetch_add(1);
+    if (thread_id < max_threads) {
+      for (int i = next.fetch_add(chunk); i < num_tasks; i = next.fetch_add(chunk)) {
+        for (int task_id = i; task_id < std::min(i + chunk, num_tasks); ++task_id) {
+          try {
+            f(thread_id, task_id);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+            // stop handing out the remaining tasks
+            next.store(num_tasks);
+            break;
           }
-        });
-    res_vec.emplace_back(task.get_future());
-    threads.emplace_back(std::move(task), run_partition, f);
+        }
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--num_running == 0) cv.notify_all();
+  }
+
+  const int num_tasks;
+  const int chunk;
+  const int max_threads;
+  const std::function<void(int, int)>& f;
+  std::atomic<int> next{0};
+  std::atomic<int> num_joined{0};
+  // the threads that entered Run and have not left it, guarded by mutex
+  int num_running{0};
+  std::exception_ptr error;
+  std::mutex mutex;
+  std::condition_variable cv;
+};
+
+/*!
+ * \brief A persistent pool of compiler threads serving parallel_for.
+ *
+ *  The caller of a loop always takes part in it, idle workers join as long as
+ *  the loop has tasks left. A loop issued from inside another loop is simply
+ *  another job, so nesting neither deadlocks nor oversubscribes the pool.
+ */
+class ParallelForPool {
+ public:
+  static ParallelForPool* Global() {
+    // Intentionally leaked, joining the workers from static destructors can hang at exit.
+    static ParallelForPool* inst = new ParallelForPool(MaxThreads() - 1);
+    return inst;
+  }
+
+  static int MaxThreads() {
+    return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  }
+
+  void Run(int num_tasks, int chunk, int max_threads, const std::function<void(int, int)>& f) {
+    auto job = std::make_shared<ParallelJob>(num_tasks, chunk, max_threads, f);
+    job->num_running = 1;
+    if (max_threads > 1 && !workers_.empty()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(job);
+      cv_.notify_all();
+    }
+    job->Run();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = std::find(jobs_.begin(), jobs_.end(), job);
+      if (it != jobs_.end()) jobs_.erase(it);
+    }
+    // wait for the workers which joined the job to leave it
+    {
+      std::unique_lock<std::mutex> lock(job->mutex);
+      job->cv.wait(lock, [&job] { return job->num_running == 0; });
+    }
+    if (job->error) {
+      std::rethrow_exception(job->error);
+    }
   }
 
-  for (auto&& thread : threads) {
-    thread.join();
+ private:
+  explicit ParallelForPool(int num_workers) {
+    for (int i = 0; i < num_workers; ++i) {
+      workers_.emplace_back([this] { this->RunWorker(); });
+      workers_.back().detach();
+    }
   }
-  {
-    std::unique_lock<std::mutex> l(M_GLOBAL_PARALLEL_FOR_FLAG);
-    ICHECK(GLOBAL_PARALLEL_FOR_FLAG);
-    GLOBAL_PARALLEL_FOR_FLAG = false;
+
+  void RunWorker() {
+    while (true) {
+      std::shared_ptr<ParallelJob> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this, &job] {
+          // drop the jobs which cannot take one more thread
+          while (!jobs_.empty() && !jobs_.front()->Joinable()) {
+            jobs_.pop_front();
+          }
+          if (jobs_.empty()) return false;
+          job = jobs_.front();
+          return true;
+        });
+        std::lock_guard<std::mutex> job_lock(job->mutex);
+        ++job->num_running;
+      }
+      job->Run();
+    }
   }
+
+  std::vector<std::thread> workers_;
+  std::deque<std::shared_ptr<ParallelJob>> jobs_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+}  // namespace
+
+void parallel_for(int begin, int end, const std::function<void(int)>& f, int step,
+                  const PartitionerFuncType partitioner) {
+  ICHECK_GT(step, 0) << "Infinite loop condition with begin: " << begin << " end: " << end
+                     << " step: " << step;
+  ParallelForPool* pool = ParallelForPool::Global();
   try {
-    for (auto&& i : res_vec) {
-      i.get();
+    if (partitioner != nullptr) {
+      // each partition is handed out as a whole to one thread
+      const auto& run_partitions = partitioner(begin, end, step, ParallelForPool::MaxThreads());
+      pool->Run(run_partitions.size(), 1, ParallelForPool::MaxThreads(),
+                [&run_partitions, &f](int thread_id, int task_id) {
+                  for (int i : run_partitions[task_id]) {
+                    f(i);
+                  }
+                });
+    } else {
+      int num_tasks = std::max((end - begin + step - 1) / step, 0);
+      // fixed-size chunks, about eight per thread so that idle threads balance the load
+      int chunk = std::max(num_tasks / (ParallelForPool::MaxThreads() * 8), 1);
+      pool->Run(num_tasks, chunk, ParallelForPool::MaxThreads(),
+                [begin, step, &f](int thread_id, int task_id) { f(begin + task_id * step); });
     }
   } catch (const std::exception& e) {
     LOG(FATAL) << "Parallel_for error with " << e.what();
   }
 }
 
+void parallel_for_dynamic(int begin, int end, int num_threads,
+                          const std::function<void(int thread_id, int task_id)>& f) {
+  ICHECK_GE(num_threads, 1) << "The number of threads must be positive, but got " << num_threads;
+  int num_tasks = std::max(end - begin, 0);
+  try {
+    ParallelForPool::Global()->Run(num_tasks, 1, num_threads,
+                                   [begin, &f](int thread_id, int task_id) {
+                                     f(thread_id, begin + task_id);
+                                   });
+  } catch (const std::exception& e) {
+    LOG(FATAL) << "RuntimeError: parallel_for_dynamic error with " << e.what();
+  }
+}
+
 }  // namespace support
 }  // namespace tvm
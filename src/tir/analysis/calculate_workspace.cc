@@ -27,6 +27,8 @@
 #include <tvm/tir/function.h>
 #include <tvm/tir/stmt_functor.h>
 
+#include "../transforms/ir_utils.h"
+
 namespace tvm {
 namespace tir {
 
@@ -83,10 +85,58 @@ size_t CalculateWorkspaceBytes(const PrimFunc& func, const Integer& workspace_by
   return wc(func);
 }
 
+class WorkspaceAllocationCollector : public StmtExprVisitor {
+ public:
+  WorkspaceAllocationCollector(int64_t byte_alignment, bool in_parallel_loop)
+      : byte_alignment_(byte_alignment), in_parallel_loop_(in_parallel_loop) {}
+  Array<Integer> operator()(const PrimFunc& func) {
+    this->VisitStmt(func->body);
+    return sizes_;
+  }
+
+ private:
+  void VisitStmt_(const ForNode* op) override {
+    if (op->kind == ForKind::kParallel) ++parallel_depth_;
+    StmtExprVisitor::VisitStmt_(op);
+    if (op->kind == ForKind::kParallel) --parallel_depth_;
+  }
+  void VisitStmt_(const AllocateNode* op) override {
+    // Only the global allocations are requested from the workspace pool at run time.
+    String scope = GetPtrStorageScope(op->buffer_var);
+    if ((scope.empty() || scope == "global") && (parallel_depth_ > 0) == in_parallel_loop_) {
+      int64_t num_bytes = op->dtype.bytes();
+      for (const auto& ext : op->extents) {
+        const auto* imm = ext.as<IntImmNode>();
+        // Dynamic allocations are left to the first run.
+        num_bytes = imm != nullptr ? num_bytes * imm->value : 0;
+      }
+      if (num_bytes > 0) {
+        int64_t aligned = (num_bytes + byte_alignment_ - 1) / byte_alignment_ * byte_alignment_;
+        sizes_.push_back(Integer(IntImm(DataType::Int(64), aligned)));
+      }
+    }
+    StmtExprVisitor::VisitStmt_(op);
+  }
+
+  int64_t byte_alignment_;
+  bool in_parallel_loop_;
+  int parallel_depth_ = 0;
+  Array<Integer> sizes_;
+};
+
+Array<Integer> CalculateWorkspaceAllocations(const PrimFunc& func,
+                                             const Integer& workspace_byte_alignment,
+                                             bool in_parallel_loop) {
+  return WorkspaceAllocationCollector(workspace_byte_alignment->value, in_parallel_loop)(func);
+}
+
 TVM_REGISTER_GLOBAL("tir.analysis.calculate_workspace_bytes")
     .set_body_typed([](PrimFunc func, Integer workspace_byte_alignment) {
       return static_cast<int>(CalculateWorkspaceBytes(func, workspace_byte_alignment));
     });
 
+TVM_REGISTER_GLOBAL("tir.analysis.calculate_workspace_allocations")
+    .set_body_typed(CalculateWorkspaceAllocations);
+
 }  // namespace tir
 }  // namespace tvm
@@ -0,0 +1,111 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+// The allocation policy only applies on Linux.
+#if defined(__linux__) && !defined(__ANDROID__)
+
+static int64_t AllocStat(const std::string& name) {
+  const PackedFunc* f = Registry::Get("device_api.cpu.alloc_stat");
+  return (*f)(name);
+}
+
+static int64_t HugePageBytes() {
+  return AllocStat("transparent_hugepage_bytes") + AllocStat("explicit_hugepage_bytes");
+}
+
+TEST(CPUAllocPolicy, HugePages) {
+  const PackedFunc* set_policy = Registry::Get("device_api.cpu.set_alloc_policy");
+  ASSERT_NE(set_policy, nullptr);
+  int64_t threshold = 1 << 20;
+  for (std::string mode : {"transparent", "explicit"}) {
+    (*set_policy)(mode, threshold, -1);
+    int64_t before = HugePageBytes() + AllocStat("default_bytes");
+    {
+      NDArray large = NDArray::Empty({3 << 20}, DLDataType{kDLUInt, 8, 1}, Device{kDLCPU, 0});
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(large->data) % (2 << 20), 0U);
+      static_cast<uint8_t*>(large->data)[(3 << 20) - 1] = 1;
+    }
+    // Rounded up to whole huge pages, which fall back to small ones when unavailable.
+    EXPECT_EQ(HugePageBytes() + AllocStat("default_bytes") - before, 4 << 20);
+  }
+  (*set_policy)(std::string("off"), threshold, -1);
+  int64_t before = HugePageBytes();
+  NDArray small = NDArray::Empty({3 << 20}, DLDataType{kDLUInt, 8, 1}, Device{kDLCPU, 0});
+  EXPECT_EQ(HugePageBytes(), before);
+}
+
+TEST(CPUAllocPolicy, NumaNode) {
+  const PackedFunc* set_policy = Registry::Get("device_api.cpu.set_alloc_policy");
+  // Bind to the node of this thread.
+  (*set_policy)(std::string("off"), 1 << 20, -2);
+  int64_t bound = AllocStat("numa_bound_bytes");
+  int64_t failures = AllocStat("numa_bind_failures");
+  {
+    NDArray large = NDArray::Empty({1 << 20}, DLDataType{kDLFloat, 32, 1}, Device{kDLCPU, 0});
+  }
+  EXPECT_TRUE(AllocStat("numa_bound_bytes") == bound + (4 << 20) ||
+              AllocStat("numa_bind_failures") == failures + 1);
+  (*set_policy)(std::string("off"), 1 << 20, -1);
+}
+
+TEST(CPUAllocPolicy, SetWhileAllocating) {
+  const PackedFunc* set_policy = Registry::Get("device_api.cpu.set_alloc_policy");
+  std::atomic<bool> stop(false);
+  std::vector<std::unique_ptr<std::thread>> ts;
+  for (int i = 0; i < 4; ++i) {
+    ts.emplace_back(new std::thread([&]() {
+      while (!stop.load()) {
+        NDArray small = NDArray::Empty({1 << 10}, DLDataType{kDLFloat, 32, 1}, Device{kDLCPU, 0});
+        NDArray large = NDArray::Empty({1 << 20}, DLDataType{kDLFloat, 32, 1}, Device{kDLCPU, 0});
+        static_cast<float*>(large->data)[(1 << 20) - 1] = 1;
+      }
+    }));
+  }
+  // The allocations read the policy without locking, each sees a whole one.
+  for (int i = 0; i < 100; ++i) {
+    (*set_policy)(std::string(i % 2 ? "transparent" : "off"), 1 << 20, i % 3 ? -1 : -2);
+  }
+  stop.store(true);
+  for (auto& t : ts) {
+    t->join();
+  }
+  (*set_policy)(std::string("off"), 1 << 20, -1);
+}
+
+#endif
+}  // namespace runtime
+}  // namespace tvm
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
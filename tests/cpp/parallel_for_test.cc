@@ -91,20 +91,50 @@ TEST(ParallelFor, NestedWithNormalForLoop) {
 }
 
 TEST(Parallelfor, NestedWithParallelFor) {
-  // Currently do not support using nested parallel_for
   using tvm::support::parallel_for;
 
-  bool exception = false;
-  try {
-    parallel_for(0, 100, [](int i) {
-      parallel_for(0, 100, [](int j) {
-        // Blank loop
-      });
-    });
-  } catch (const std::exception& e) {
-    exception = true;
+  int a[100][100];
+  parallel_for(0, 100, [&a](int i) {
+    parallel_for(0, 100, [&a, i](int j) { a[i][j] = i * j; });
+  });
+  for (int i = 0; i < 100; i++) {
+    for (int j = 0; j < 100; j++) {
+      ICHECK_EQ(a[i][j], i * j);
+    }
+  }
+}
+
+TEST(ParallelFor, Partitioner) {
+  using tvm::support::parallel_for;
+  using tvm::support::rr_partitioner;
+
+  int a[1000] = {0};
+  parallel_for(
+      0, 1000, [&a](int i) { a[i] = i; }, 1, rr_partitioner);
+  for (int i = 0; i < 1000; i++) {
+    ICHECK_EQ(a[i], i);
+  }
+}
+
+TEST(ParallelFor, Dynamic) {
+  using tvm::support::parallel_for_dynamic;
+
+  int num_threads = 4;
+  int a[1000];
+  std::vector<int> count(num_threads, 0);
+  parallel_for_dynamic(0, 1000, num_threads, [&a, &count, num_threads](int thread_id, int i) {
+    ICHECK_LT(thread_id, num_threads);
+    count[thread_id]++;
+    a[i] = i;
+  });
+  int total = 0;
+  for (int c : count) {
+    total += c;
+  }
+  ICHECK_EQ(total, 1000);
+  for (int i = 0; i < 1000; i++) {
+    ICHECK_EQ(a[i], i);
   }
-  ICHECK(exception);
 }
 
 TEST(ParallelFor, Exception) {
@@ -163,6 +163,21 @@ TEST(Relay, BuildModule) {
   for (int i = 0; i < 6; ++i) {
     ICHECK_LT(fabs(pY3[i] - (i + (i + 3) + (i + 4))), 1e-4);
   }
+  // write the output into an external buffer, get_output must see its data
+  auto set_output_f = run_mod.GetFunction("set_output_zero_copy", false);
+  auto D = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto pD = (float*)D->data;
+  set_output_f(0, const_cast<DLTensor*>(D.operator->()));
+  for (int i = 0; i < 6; ++i) {
+    pB[i] = i + 5;
+  }
+  run_f();
+  tvm::runtime::NDArray Y4 = get_output_f(0);
+  auto pY4 = (float*)Y4->data;
+  for (int i = 0; i < 6; ++i) {
+    ICHECK_LT(fabs(pD[i] - (i + (i + 5) + (i + 4))), 1e-4);
+    ICHECK_LT(fabs(pY4[i] - pD[i]), 1e-4);
+  }
 }
 
 TEST(Relay, GetExprRefCount) {
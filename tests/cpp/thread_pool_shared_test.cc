@@ -0,0 +1,143 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// The process-wide pool is selected on first use, main sets TVM_THREAD_POOL_SHARED before.
+
+constexpr size_t N = 128;
+
+static FTVMParallelLambda atomic_add_task_id = [](int task_id, TVMParallelGroupEnv* penv,
+                                                  void* cdata) -> int {
+  auto* data = reinterpret_cast<std::atomic<size_t>*>(cdata);
+  const size_t N_per_task = (N + penv->num_task - 1) / penv->num_task;
+  for (size_t i = task_id * N_per_task; i < N && i < (task_id + 1) * N_per_task; ++i) {
+    data->fetch_add(i, std::memory_order_relaxed);
+  }
+  return 0;
+};
+
+// Every task checks a nested launch of the whole sum before adding its own part.
+static FTVMParallelLambda nested_add_task_id = [](int task_id, TVMParallelGroupEnv* penv,
+                                                  void* cdata) -> int {
+  std::atomic<size_t> inner(0);
+  if (TVMBackendParallelLaunch(atomic_add_task_id, &inner, 0) != 0 ||
+      inner.load(std::memory_order_relaxed) != N * (N - 1) / 2) {
+    return -1;
+  }
+  return atomic_add_task_id(task_id, penv, cdata);
+};
+
+// Every task checks that all tasks have arrived at the barrier, then adds its own part.
+static FTVMParallelLambda barrier_add_task_id = [](int task_id, TVMParallelGroupEnv* penv,
+                                                   void* cdata) -> int {
+  auto* data = reinterpret_cast<std::atomic<size_t>*>(cdata);
+  data[1].fetch_add(1);
+  TVMBackendParallelBarrier(task_id, penv);
+  if (data[1].load() != static_cast<size_t>(penv->num_task)) {
+    return -1;
+  }
+  return atomic_add_task_id(task_id, penv, data);
+};
+
+static void LaunchFromThreads(size_t num_threads, size_t num_jobs_per_thread,
+                              FTVMParallelLambda flambda, int num_task, size_t expected) {
+  std::vector<std::unique_ptr<std::thread>> ts;
+  for (size_t i = 0; i < num_threads; ++i) {
+    ts.emplace_back(new std::thread([=]() {
+      for (size_t j = 0; j < num_jobs_per_thread; ++j) {
+        std::atomic<size_t> acc[2] = {{0}, {0}};
+        EXPECT_EQ(TVMBackendParallelLaunch(flambda, acc, num_task), 0);
+        EXPECT_EQ(acc[0].load(std::memory_order_relaxed), expected);
+      }
+    }));
+  }
+  for (auto& t : ts) {
+    t->join();
+  }
+}
+
+TEST(ThreadPoolShared, ConcurrentLaunches) {
+  LaunchFromThreads(4, 20, atomic_add_task_id, 0, N * (N - 1) / 2);
+}
+
+TEST(ThreadPoolShared, ConcurrentBarriers) {
+  const tvm::runtime::PackedFunc* config =
+      tvm::runtime::Registry::Get("runtime.config_threadpool");
+  ASSERT_NE(config, nullptr);
+  int num_task = tvm::runtime::threading::MaxConcurrency();
+  (*config)(static_cast<int>(tvm::runtime::threading::ThreadGroup::kBig), num_task);
+  // Each launch waits until it holds one worker per task.
+  LaunchFromThreads(4, 20, barrier_add_task_id, num_task, N * (N - 1) / 2);
+  (*config)(static_cast<int>(tvm::runtime::threading::ThreadGroup::kBig), 0);
+}
+
+TEST(ThreadPoolShared, NestedLaunches) {
+  // The inner launches run on the workers of the outer one and reserve the remaining workers.
+  for (int num_task : {1, 4, 16}) {
+    std::atomic<size_t> acc(0);
+    EXPECT_EQ(TVMBackendParallelLaunch(nested_add_task_id, &acc, num_task), 0);
+    EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+  }
+  LaunchFromThreads(3, 10, nested_add_task_id, 2, N * (N - 1) / 2);
+}
+
+TEST(ThreadPoolShared, ReconfigureWhileLaunching) {
+  const tvm::runtime::PackedFunc* config =
+      tvm::runtime::Registry::Get("runtime.config_threadpool");
+  ASSERT_NE(config, nullptr);
+  std::atomic<bool> stop(false);
+  std::vector<std::unique_ptr<std::thread>> ts;
+  for (size_t i = 0; i < 3; ++i) {
+    ts.emplace_back(new std::thread([&]() {
+      while (!stop.load()) {
+        std::atomic<size_t> acc(0);
+        EXPECT_EQ(TVMBackendParallelLaunch(nested_add_task_id, &acc, 2), 0);
+        EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+      }
+    }));
+  }
+  // Each reconfiguration waits for the launches in flight to return their workers.
+  for (int i = 0; i < 20; ++i) {
+    (*config)(static_cast<int>(tvm::runtime::threading::ThreadGroup::kBig), i % 2 + 1);
+    (*config)(static_cast<int>(tvm::runtime::threading::ThreadGroup::kBig), 0);
+  }
+  tvm::runtime::threading::ResetThreadPool();
+  stop.store(true);
+  for (auto& t : ts) {
+    t->join();
+  }
+  LaunchFromThreads(2, 5, atomic_add_task_id, 0, N * (N - 1) / 2);
+}
+
+int main(int argc, char** argv) {
+  setenv("TVM_THREAD_POOL_SHARED", "1", 1);
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -19,10 +19,13 @@
 
 #include <gtest/gtest.h>
 #include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
 
 #include <atomic>
 #include <memory>
 #include <thread>
+#include <vector>
 
 constexpr size_t N = 128;
 
@@ -64,6 +67,49 @@ TEST(ThreadingBackend, TVMBackendParallelLaunchMultipleThreads) {
   }
 }
 
+TEST(ThreadingBackend, TVMBackendParallelLaunchWorkStealing) {
+  const tvm::runtime::PackedFunc* config =
+      tvm::runtime::Registry::Get("runtime.config_threadpool_scheduler");
+  ASSERT_NE(config, nullptr);
+  (*config)(1, 4);
+  // Let the runtime split the job, then ask for more tasks than there are workers.
+  for (int num_task : {0, 17}) {
+    std::atomic<size_t> acc(0);
+    EXPECT_EQ(TVMBackendParallelLaunch(atomic_add_task_id, &acc, num_task), 0);
+    EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+  }
+  (*config)(0);
+}
+
+TEST(ThreadingBackend, CPUTopology) {
+  const auto& cpus = tvm::runtime::threading::CPUTopology();
+  ASSERT_FALSE(cpus.empty());
+  int num_nodes = tvm::runtime::threading::NumNumaNodes();
+  for (size_t i = 0; i < cpus.size(); ++i) {
+    EXPECT_EQ(cpus[i].id, i);
+    EXPECT_LE(cpus[i].core, cpus[i].id);
+    EXPECT_EQ(cpus[cpus[i].core].core, cpus[i].core);
+    EXPECT_GE(cpus[i].numa_node, 0);
+    EXPECT_LT(cpus[i].numa_node, num_nodes);
+  }
+}
+
+TEST(ThreadingBackend, BindThreadPoolToNumaNode) {
+  // One thread per node, each with a pool of its own.
+  std::vector<std::unique_ptr<std::thread>> ts;
+  for (int node = 0; node < tvm::runtime::threading::NumNumaNodes(); ++node) {
+    ts.emplace_back(new std::thread([node]() {
+      EXPECT_GE(tvm::runtime::threading::BindThreadPoolToNumaNode(node), 1);
+      std::atomic<size_t> acc(0);
+      TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
+      EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+    }));
+  }
+  for (auto& t : ts) {
+    t->join();
+  }
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
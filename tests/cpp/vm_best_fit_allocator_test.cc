@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../../src/runtime/vm/best_fit_allocator.h"
+
+using namespace tvm::runtime;
+using namespace tvm::runtime::vm;
+
+static const DLDataType kFloat32{kDLFloat, 32, 1};
+static const Device kCPU{kDLCPU, 0};
+
+TEST(BestFitAllocator, SizeClass) {
+  EXPECT_EQ(BestFitAllocator::SizeClass(1), 256U);
+  EXPECT_EQ(BestFitAllocator::SizeClass(2048), 2048U);
+  EXPECT_EQ(BestFitAllocator::SizeClass(2049), 2560U);
+  EXPECT_EQ(BestFitAllocator::SizeClass(5000), 5120U);
+}
+
+TEST(BestFitAllocator, BestFit) {
+  BestFitAllocator alloc(kCPU);
+  const size_t mb = 1 << 20;
+  // Larger than the thread cache, so each free goes back to its segment.
+  Buffer small = alloc.Alloc(mb * 3 / 2, 64, kFloat32);
+  Buffer large = alloc.Alloc(mb * 3, 64, kFloat32);
+  EXPECT_EQ(alloc.UsedMemory(), 6 * mb);
+  alloc.Free(large);
+  alloc.Free(small);
+  EXPECT_EQ(alloc.AllocatedMemory(), 0U);
+  // The smallest free segment serves the request.
+  Buffer buf = alloc.Alloc(mb * 5 / 4, 64, kFloat32);
+  EXPECT_EQ(buf.data, small.data);
+  EXPECT_EQ(alloc.UsedMemory(), 6 * mb);
+  EXPECT_EQ(alloc.PeakMemory(), small.size + large.size);
+  alloc.Free(buf);
+  alloc.ReleaseAll();
+  EXPECT_EQ(alloc.UsedMemory(), 0U);
+}
+
+TEST(BestFitAllocator, ReuseAndCoalesce) {
+  BestFitAllocator alloc(kCPU);
+  Buffer a = alloc.Alloc(1000, 64, kFloat32);
+  Buffer b = alloc.Alloc(3000, 64, kFloat32);
+  EXPECT_EQ(static_cast<char*>(b.data), static_cast<char*>(a.data) + a.size);
+  alloc.Free(a);
+  // Small buffers of the same size class are recycled by the thread.
+  Buffer c = alloc.Alloc(900, 64, kFloat32);
+  EXPECT_EQ(c.data, a.data);
+  alloc.Free(c);
+  alloc.Free(b);
+  EXPECT_EQ(alloc.AllocatedMemory(), a.size + b.size);
+  // Flushing the cache coalesces the blocks back into a fully free segment.
+  alloc.ReleaseAll();
+  EXPECT_EQ(alloc.AllocatedMemory(), 0U);
+  EXPECT_EQ(alloc.UsedMemory(), 0U);
+}
+
+TEST(BestFitAllocator, ThreadExitReturnsCache) {
+  BestFitAllocator alloc(kCPU, 0);
+  std::thread t([&]() {
+    Buffer buf = alloc.Alloc(1024, 64, kFloat32);
+    alloc.Free(buf);
+    // The buffer stays in the cache of this thread until it exits.
+    EXPECT_EQ(alloc.AllocatedMemory(), buf.size);
+  });
+  t.join();
+  EXPECT_EQ(alloc.AllocatedMemory(), 0U);
+  EXPECT_EQ(alloc.UsedMemory(), 0U);
+}
+
+TEST(BestFitAllocator, ConcurrentPeak) {
+  BestFitAllocator alloc(kCPU);
+  const size_t num_threads = 4, num_buffers = 8;
+  const size_t size = BestFitAllocator::kThreadCacheMaxBytes * 2;
+  std::vector<std::unique_ptr<std::thread>> ts;
+  for (size_t i = 0; i < num_threads; ++i) {
+    ts.emplace_back(new std::thread([&]() {
+      std::vector<Buffer> bufs;
+      for (size_t j = 0; j < num_buffers; ++j) {
+        bufs.push_back(alloc.Alloc(size, 64, kFloat32));
+      }
+      for (const Buffer& buf : bufs) {
+        alloc.Free(buf);
+      }
+    }));
+  }
+  for (auto& t : ts) {
+    t->join();
+  }
+  EXPECT_EQ(alloc.AllocatedMemory(), 0U);
+  EXPECT_GE(alloc.PeakMemory(), num_buffers * size);
+  EXPECT_LE(alloc.PeakMemory(), num_threads * num_buffers * size);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
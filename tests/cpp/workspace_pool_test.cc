@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+
+#include <vector>
+
+#include "../../src/runtime/workspace_pool.h"
+
+namespace tvm {
+namespace runtime {
+
+TEST(WorkspacePool, ReuseFreedBlocks) {
+  Device dev{kDLCPU, 0};
+  WorkspacePool pool(kDLCPU, DeviceAPI::Get(dev));
+  std::vector<size_t> sizes{100, 4096, 5000, 70000, 1 << 20};
+  for (int run = 0; run < 3; ++run) {
+    std::vector<void*> ptrs;
+    for (size_t size : sizes) {
+      void* ptr = pool.AllocWorkspace(dev, size);
+      ASSERT_NE(ptr, nullptr);
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % kTempAllocaAlignment, 0U);
+      ptrs.push_back(ptr);
+    }
+    // Free out of order.
+    for (size_t i = 0; i < ptrs.size(); i += 2) pool.FreeWorkspace(dev, ptrs[i]);
+    for (size_t i = 1; i < ptrs.size(); i += 2) pool.FreeWorkspace(dev, ptrs[i]);
+  }
+  WorkspacePool::Stats stats = pool.GetStats(dev);
+  EXPECT_EQ(stats.num_device_allocs, sizes.size());
+  EXPECT_EQ(stats.bytes_in_use, 0U);
+  EXPECT_EQ(stats.bytes_cached, stats.peak_bytes_in_use);
+  EXPECT_GE(stats.peak_bytes_in_use, 100U + 4096U + 5000U + 70000U + (1U << 20));
+}
+
+TEST(WorkspacePool, ReuseLargerBlock) {
+  Device dev{kDLCPU, 0};
+  WorkspacePool pool(kDLCPU, DeviceAPI::Get(dev));
+  pool.FreeWorkspace(dev, pool.AllocWorkspace(dev, 300000));
+  EXPECT_EQ(pool.GetStats(dev).num_device_allocs, 1U);
+  EXPECT_EQ(pool.GetStats(dev).bytes_in_use, 0U);
+  // A smaller size class is served by the cached block.
+  void* ptr = pool.AllocWorkspace(dev, 250000);
+  EXPECT_EQ(pool.GetStats(dev).num_device_allocs, 1U);
+  pool.FreeWorkspace(dev, ptr);
+  // Larger than all size classes.
+  ptr = pool.AllocWorkspace(dev, size_t(600) << 20);
+  pool.FreeWorkspace(dev, ptr);
+  EXPECT_EQ(pool.AllocWorkspace(dev, size_t(590) << 20), ptr);
+  pool.FreeWorkspace(dev, ptr);
+  EXPECT_EQ(pool.GetStats(dev).num_device_allocs, 2U);
+}
+
+TEST(WorkspacePool, Reserve) {
+  Device dev{kDLCPU, 0};
+  WorkspacePool pool(kDLCPU, DeviceAPI::Get(dev));
+  pool.Reserve(dev, {5000, 300000, 5000});
+  EXPECT_EQ(pool.GetStats(dev).num_device_allocs, 3U);
+  EXPECT_EQ(pool.GetStats(dev).bytes_in_use, 0U);
+  // The reserved blocks are kept, a smaller reservation reuses them.
+  pool.Reserve(dev, {4096, 200000});
+  EXPECT_EQ(pool.GetStats(dev).num_device_allocs, 3U);
+  // The allocations of the reserved sizes live at once, in any order, are served from the pool.
+  std::vector<void*> ptrs;
+  for (size_t size : {5000, 5000, 300000}) {
+    ptrs.push_back(pool.AllocWorkspace(dev, size));
+  }
+  EXPECT_EQ(pool.GetStats(dev).num_device_allocs, 3U);
+  for (void* ptr : ptrs) pool.FreeWorkspace(dev, ptr);
+  // Only the missing blocks are allocated.
+  pool.Reserve(dev, {5000, 5000, 300000, 5000});
+  EXPECT_EQ(pool.GetStats(dev).num_device_allocs, 4U);
+}
+
+}  // namespace runtime
+}  // namespace tvm
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
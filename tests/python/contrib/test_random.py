@@ -152,8 +152,48 @@ def test_random_fill():
         test_rpc(dtype)
 
 
+def test_random_fill_deterministic():
+    if not tvm.get_global_func("tvm.contrib.random.random_fill", True):
+        print("skip because extern function is not available")
+        return
+    # Large enough to be filled in parallel.
+    shape = (1024, 1024)
+    config_threadpool = tvm.get_global_func("runtime.config_threadpool")
+    random_fill = tvm.get_global_func("tvm.contrib.random.random_fill")
+    results = []
+    for nthreads in [1, 4]:
+        config_threadpool(1, nthreads)
+        random.seed(7)
+        value = tvm.nd.empty(shape, "float32", tvm.cpu())
+        random_fill(value)
+        results.append(value.numpy())
+    config_threadpool(1, 0)
+    np.testing.assert_equal(results[0], results[1])
+    # The next fill uses other random numbers.
+    random_fill(value)
+    assert not np.array_equal(value.numpy(), results[1])
+
+
+@tvm.testing.requires_llvm
+def test_uniform_matches_relay():
+    if not tvm.get_global_func("tvm.contrib.random.uniform", True):
+        print("skip because extern function is not available")
+        return
+    seed, shape, low, high = 11, (1000,), -2.0, 3.0
+    key = tvm.relay.random.threefry_key(seed)
+    expr = tvm.relay.random.uniform(key, shape, "float32", low, high)[1]
+    expected = tvm.relay.create_executor().evaluate(expr).numpy()
+
+    random.seed(seed)
+    value = tvm.nd.empty(shape, "float32", tvm.cpu())
+    tvm.get_global_func("tvm.contrib.random.uniform")(low, high, value)
+    tvm.testing.assert_allclose(value.numpy(), expected, rtol=1e-6, atol=1e-6)
+
+
 if __name__ == "__main__":
     test_randint()
     test_uniform()
     test_normal()
     test_random_fill()
+    test_random_fill_deterministic()
+    test_uniform_matches_relay()
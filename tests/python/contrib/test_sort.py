@@ -91,6 +91,41 @@ def test_sort_np():
     tvm.testing.assert_allclose(c.numpy(), np_out, rtol=1e-5)
 
 
+def test_sort_large():
+    # Enough rows to be sorted in parallel, long enough for the radix sort.
+    dev = tvm.cpu(0)
+    shape = (6, 3000, 5)
+    axis = 1
+    data_np = np.random.randint(-50, 50, size=shape)
+    data_np[0, :100, 0] = 0
+    for dtype in ["float32", "float64", "int32", "int64"]:
+        x_np = data_np.astype(dtype)
+        if dtype.startswith("float"):
+            x_np[0, :50, 0] = -0.0
+        x = tvm.nd.array(x_np, dev)
+        for is_ascend in [True, False]:
+            key = x_np if is_ascend else -x_np
+            ref_indices = np.argsort(key, axis=axis, kind="stable")
+            ref_values = np.take_along_axis(x_np, ref_indices, axis=axis)
+
+            indices = tvm.nd.empty(shape, "int32", dev)
+            tvm.get_global_func("tvm.contrib.sort.argsort")(x, indices, axis, is_ascend)
+            np.testing.assert_equal(indices.numpy(), ref_indices)
+            values = tvm.nd.empty(shape, dtype, dev)
+            tvm.get_global_func("tvm.contrib.sort.sort")(x, values, axis, is_ascend)
+            np.testing.assert_equal(values.numpy(), ref_values)
+
+            for k in [1, 20, 1000, 3000]:
+                out_shape = (shape[0], k, shape[2])
+                values = tvm.nd.empty(out_shape, dtype, dev)
+                indices = tvm.nd.empty(out_shape, "int64", dev)
+                tvm.get_global_func("tvm.contrib.sort.topk")(
+                    x, values, indices, k, axis, "both", is_ascend
+                )
+                np.testing.assert_equal(indices.numpy(), ref_indices[:, :k, :])
+                np.testing.assert_equal(values.numpy(), ref_values[:, :k, :])
+
+
 def test_sort_by_key_gpu():
     size = 6
     keys = te.placeholder((size,), name="keys", dtype="int32")
@@ -126,4 +161,5 @@ def test_sort_by_key_gpu():
 if __name__ == "__main__":
     test_sort()
     test_sort_np()
+    test_sort_large()
     test_sort_by_key_gpu()
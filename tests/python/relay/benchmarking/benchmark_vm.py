@@ -153,7 +153,39 @@ def test_densenet():
     benchmark_execution(mod, params, model="densenet")
 
 
+def test_dispatch_overhead(num_iters=10000, measure=True):
+    """Measure the per-instruction interpreter overhead on a loop of scalar ops."""
+    mod = tvm.IRModule()
+    loop = relay.GlobalVar("loop")
+    i = relay.var("i", shape=(), dtype="int32")
+    acc = relay.var("acc", shape=(), dtype="int32")
+    sb = relay.ScopeBuilder()
+    with sb.if_scope(relay.less(i, relay.const(num_iters))):
+        sb.ret(loop(i + relay.const(1), acc + i))
+    with sb.else_scope():
+        sb.ret(acc)
+    mod[loop] = relay.Function([i, acc], sb.get())
+    mod["main"] = relay.Function([], loop(relay.const(0), relay.const(0)))
+
+    with tvm.transform.PassContext(opt_level=3):
+        exe = vm.compile(mod, "llvm")
+    rly_vm = vm_rt.VirtualMachine(exe, tvm.cpu())
+    assert rly_vm.invoke("main").numpy() == sum(range(num_iters))
+
+    if measure:
+        # Every iteration runs one pass over the loop function.
+        func = [f for f in exe.bytecode.split("VM Function[") if "]: loop(" in f][0]
+        num_instrs = int(func.split("# instruction count = ")[1].split()[0])
+        ftimer = rly_vm.module.time_evaluator("invoke", tvm.cpu(), number=5, repeat=5)
+        cost = np.mean(ftimer("main").results) / num_iters
+        print(
+            "VM loop iteration: %.2f us, about %.1f ns per instruction (%d instructions)"
+            % (cost * 1e6, cost * 1e9 / num_instrs, num_instrs)
+        )
+
+
 if __name__ == "__main__":
+    test_dispatch_overhead()
     test_resnet()
     test_vgg()
     test_squeezenet()
@@ -21,6 +21,7 @@ import tvm.testing
 from tvm import relay
 from tvm import autotvm
 from tvm import topi
+from tvm.contrib import graph_executor, utils
 from tvm.relay.testing import run_infer_type
 from tvm.relay.testing.temp_op_attr import TempOpAttr
 import tvm.testing
@@ -259,6 +260,50 @@ def test_compile_nhwc_pack():
     relay.build(mod, target="llvm")
 
 
+def test_compile_cache_dir():
+    x = relay.var("x", shape=(4, 8))
+    w = relay.var("w", shape=(8, 8))
+    y = relay.nn.softmax(relay.nn.relu(relay.nn.dense(x, w)) + relay.const(1.0))
+    mod = tvm.IRModule.from_expr(relay.Function([x, w], y))
+    x_data = np.random.uniform(size=(4, 8)).astype("float32")
+    w_data = np.random.uniform(size=(8, 8)).astype("float32")
+    cache_dir = utils.tempdir()
+
+    def build(lower_pass=None):
+        relay.backend.compile_engine.reset_compile_cache_stats()
+        config = {"relay.backend.compile_cache_dir": cache_dir.temp_dir}
+        if lower_pass is not None:
+            config["tir.add_lower_pass"] = [(1, lower_pass)]
+        with tvm.transform.PassContext(opt_level=3, config=config):
+            lib = relay.build(mod, "llvm")
+        m = graph_executor.GraphModule(lib["default"](tvm.cpu(0)))
+        m.set_input(x=x_data, w=w_data)
+        m.run()
+        stats = relay.backend.compile_engine.compile_cache_stats()
+        return m.get_output(0).numpy(), lib.get_graph_json(), stats
+
+    ref, ref_graph, stats = build()
+    assert stats["hits"] == 0 and stats["misses"] > 0
+    assert len(cache_dir.listdir()) == stats["misses"]
+    out, graph, stats = build()
+    assert stats["hits"] == len(cache_dir.listdir()) and stats["misses"] == 0
+    assert graph == ref_graph
+    tvm.testing.assert_allclose(out, ref)
+
+    # Custom lower passes cannot be told apart in the key, so they bypass the cache.
+    num_entries = len(cache_dir.listdir())
+    out, _, stats = build(tvm.tir.transform.Simplify())
+    assert stats["hits"] == 0 and stats["misses"] == 0
+    assert len(cache_dir.listdir()) == num_entries
+    tvm.testing.assert_allclose(out, ref)
+
+    # The configs picked by AutoTVM are part of the key.
+    with autotvm.apply_history_best([]):
+        out, _, stats = build()
+    assert stats["hits"] == 0 and stats["misses"] > 0
+    tvm.testing.assert_allclose(out, ref)
+
+
 if __name__ == "__main__":
     test_get_valid_implementations()
     test_select_implementation()
@@ -268,3 +313,4 @@ if __name__ == "__main__":
     test_compile_tuple_dup()
     test_compile_full()
     test_compile_nhwc_pack()
+    test_compile_cache_dir()
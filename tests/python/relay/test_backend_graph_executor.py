@@ -158,6 +158,81 @@ def test_plan_memory():
     )
 
 
+def test_plan_memory_offsets():
+    # a and b are live together, then both die before the larger c is computed. The
+    # blocks grow c into the storage of a, while an arena places c over both.
+    x = relay.var("x", shape=(1, 4096))
+    a = relay.exp(x)
+    b = relay.sigmoid(x)
+    c = relay.broadcast_to(relay.nn.dense(a, b), (8192, 1))
+    func = relay.Function([x], relay.sum(c))
+    mod = tvm.IRModule.from_expr(func)
+
+    fused = relay.transform.FuseOps(0)(relay.transform.InferType()(mod))
+    fused = relay.transform.InferType()(fused)
+    block_bytes = relay.backend._backend.GraphPlanMemoryTotalBytes(fused["main"], False)
+    offset_bytes = relay.backend._backend.GraphPlanMemoryTotalBytes(fused["main"], True)
+    assert offset_bytes < block_bytes
+
+    x_data = np.random.uniform(-1, 1, size=(1, 4096)).astype("float32")
+
+    def run(config):
+        # No fusion, so that every tensor above is planned.
+        with tvm.transform.PassContext(opt_level=0, config=config):
+            lib = relay.build(mod, "llvm")
+        m = graph_executor.GraphModule(lib["default"](tvm.cpu(0)))
+        m.set_input(x=x_data)
+        m.run()
+        return m.get_output(0).numpy(), json.loads(lib.get_graph_json())
+
+    def planned_bytes(graph):
+        attrs = graph["attrs"]
+        storage_ids = attrs["storage_id"][1]
+        offsets = attrs.get("storage_offset", [None, [0] * len(storage_ids)])[1]
+        storage_bytes = {}
+        for shape, dtype, sid, offset in zip(
+            attrs["shape"][1], attrs["dltype"][1], storage_ids, offsets
+        ):
+            nbytes = offset + int(np.prod(shape)) * np.dtype(dtype).itemsize
+            storage_bytes[sid] = max(storage_bytes.get(sid, 0), nbytes)
+        return sum(storage_bytes.values())
+
+    ref, ref_graph = run({})
+    out, graph = run({"relay.GraphPlanMemory.use_offsets": True})
+    assert "storage_offset" not in ref_graph["attrs"]
+    assert len(graph["attrs"]["storage_offset"][1]) == len(graph["attrs"]["storage_id"][1])
+    assert planned_bytes(graph) < planned_bytes(ref_graph)
+    tvm.testing.assert_allclose(out, ref, rtol=1e-5, atol=1e-5)
+
+
+def test_workspace_bytes():
+    x = relay.var("x", shape=(64, 1024))
+    mod = tvm.IRModule.from_expr(relay.Function([x], relay.nn.softmax(x)))
+    lib = relay.build(mod, "llvm")
+    graph = json.loads(lib.get_graph_json())
+    workspace = []
+    for node in graph["nodes"]:
+        for key in ["workspace_bytes", "parallel_workspace_bytes"]:
+            if key in node.get("attrs", {}):
+                workspace += [int(size) for size in node["attrs"][key].split(",")]
+    # softmax keeps the exponentials of a row in a temporary buffer.
+    assert workspace and all(size > 0 for size in workspace)
+
+    # The executor reserves the workspace, so running it does not allocate from the device.
+    workspace_stat = tvm.get_global_func("device_api.cpu.workspace_stat")
+    m = graph_executor.GraphModule(lib["default"](tvm.cpu(0)))
+    num_device_allocs = workspace_stat(0, "num_device_allocs")
+    assert workspace_stat(0, "bytes_cached") >= max(workspace)
+    x_data = np.random.uniform(-1, 1, size=(64, 1024)).astype("float32")
+    m.set_input(x=x_data)
+    m.run()
+    assert workspace_stat(0, "num_device_allocs") == num_device_allocs
+    assert workspace_stat(0, "bytes_in_use") == 0
+    ref = np.exp(x_data - x_data.max(axis=1, keepdims=True))
+    ref /= ref.sum(axis=1, keepdims=True)
+    tvm.testing.assert_allclose(m.get_output(0).numpy(), ref, rtol=1e-5, atol=1e-5)
+
+
 def test_reshape_nop():
     # test that reshape can be turned into nop
     x = relay.var("x", shape=(10, 4))
@@ -287,5 +362,31 @@ def test_graph_executor_nested_tuples():
     tvm.testing.assert_allclose(out[1][1][1].numpy(), data[3])
 
 
+def test_parallel_lowering():
+    x = relay.var("x", shape=(8, 16))
+    w = relay.var("w", shape=(16, 16))
+    y = relay.nn.relu(relay.nn.dense(x, w))
+    y = relay.exp(relay.sum(y, axis=1, keepdims=True)) + relay.sigmoid(y)
+    y = relay.nn.softmax(relay.nn.dense(y, w))
+    mod = tvm.IRModule.from_expr(relay.Function([x, w], y))
+    x_data = np.random.uniform(size=(8, 16)).astype("float32")
+    w_data = np.random.uniform(-0.1, 0.1, size=(16, 16)).astype("float32")
+
+    def run(config):
+        with tvm.transform.PassContext(opt_level=3, config=config):
+            lib = relay.build(mod, "llvm")
+        m = graph_executor.GraphModule(lib["default"](tvm.cpu(0)))
+        m.set_input(x=x_data, w=w_data)
+        m.run()
+        return m.get_output(0).numpy(), lib.get_graph_json()
+
+    ref, ref_graph = run({"relay.backend.parallel_lowering": False})
+    for config in [{}, {"tir.llvm_codegen_partitions": 3}]:
+        out, graph = run(config)
+        # The functions get the same names as with the sequential lowering.
+        assert graph == ref_graph
+        tvm.testing.assert_allclose(out, ref, rtol=1e-5, atol=1e-5)
+
+
 if __name__ == "__main__":
     sys.exit(pytest.main([file] + sys.argv[1:]))
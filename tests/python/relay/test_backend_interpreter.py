@@ -127,6 +127,25 @@ def test_loop():
     check_eval(sum_up, [i_data, accum_data], sum(range(1, 11)), mod=mod)
 
 
+def test_recursive_calls():
+    # fib calls itself twice, with let bound locals live across the calls.
+    mod = tvm.IRModule()
+    fib = relay.GlobalVar("fib")
+    n = relay.var("n", shape=[], dtype="int32")
+    a = relay.var("a", shape=[], dtype="int32")
+    b = relay.var("b", shape=[], dtype="int32")
+    sb = ScopeBuilder()
+    with sb.if_scope(relay.less(n, relay.const(2, "int32"))):
+        sb.ret(n)
+    with sb.else_scope():
+        body = relay.add(a, b)
+        body = relay.Let(b, relay.Call(fib, [relay.subtract(n, relay.const(2, "int32"))]), body)
+        body = relay.Let(a, relay.Call(fib, [relay.subtract(n, relay.const(1, "int32"))]), body)
+        sb.ret(body)
+    mod[fib] = relay.Function([n], sb.get())
+    check_eval(fib, [np.array(15, dtype="int32")], 610, mod=mod)
+
+
 def test_ref():
     mod = tvm.IRModule()
     three_with_ref = relay.GlobalVar("three_with_ref")
@@ -78,6 +78,30 @@ def test_fold_const():
     assert tvm.ir.structural_equal(zz, zexpected)
 
 
+def test_fold_same_op_calls():
+    # The calls differ only by the data of their constants, so they share a kernel.
+    datas = [np.random.uniform(size=(4, 5)).astype("float32") for _ in range(3)]
+    x = relay.var("x", shape=(4, 5))
+
+    def before():
+        y = x
+        for data in datas:
+            c = relay.const(data)
+            y = relay.add(y, relay.transpose(relay.transpose(c) * relay.const(2.0)))
+        parts = relay.split(relay.concatenate([relay.const(d) for d in datas], axis=0), 3)
+        return relay.Function([x], relay.Tuple([y, parts[1]]))
+
+    def expected():
+        y = x
+        for data in datas:
+            y = relay.add(y, relay.const(data * 2.0))
+        return relay.Function([x], relay.Tuple([y, relay.const(datas[1])]))
+
+    zz = run_opt_pass(before(), transform.FoldConstant())
+    zexpected = run_opt_pass(expected(), transform.InferType())
+    assert tvm.ir.structural_equal(zz, zexpected)
+
+
 def test_fold_let():
     c_data = np.array(1).astype("float32")
     t = relay.TensorType([1], "float32")
@@ -300,6 +324,7 @@ def test_fold_dropout():
 
 if __name__ == "__main__":
     test_fold_const()
+    test_fold_same_op_calls()
     test_fold_let()
     test_fold_tuple()
     test_fold_concat()
@@ -15,9 +15,11 @@
 # specific language governing permissions and limitations
 # under the License.
 import numpy as np
+import pytest
 
 import tvm
 from tvm import relay
+from tvm.contrib import graph_executor
 from tvm.relay import transform
 from tvm.relay.testing import run_opt_pass
 import tvm.testing
@@ -784,6 +786,175 @@ def test_fuse_dynamic_squeeze_slice_take():
     assert np.allclose(result.numpy(), np_result)
 
 
+def test_fuse_cost_model():
+    """Test fusing producers into compute-heavy ops with the cost model"""
+    dshape = (1, 16, 32, 32)
+    wshape = (16, 16, 3, 3)
+
+    def pool(x):
+        return relay.nn.max_pool2d(x, pool_size=(3, 3), strides=(2, 2), padding=(1, 1))
+
+    def conv(x, w):
+        return relay.nn.conv2d(x, w, kernel_size=(3, 3), padding=(1, 1), channels=16)
+
+    def before(op, producer, args):
+        y = op(producer(args[0]), *args[1:])
+        return relay.Function(args, y)
+
+    def expected(op, producer, args):
+        params = [relay.var("p%d" % i, a.type_annotation) for i, a in enumerate(args)]
+        f = relay.Function(params, op(producer(params[0]), *params[1:]))
+        f = f.with_attr("Primitive", tvm.tir.IntImm("int32", 1))
+        f = f.with_attr("relay.fused_producer", tvm.tir.IntImm("int32", 1))
+        return relay.Function(args, relay.Call(f, args))
+
+    def fuse(func, config):
+        with tvm.transform.PassContext(config=config):
+            return run_opt_pass(func, transform.FuseOps())
+
+    def transpose(x):
+        return relay.transpose(x, (0, 2, 3, 1))
+
+    x = relay.var("x", shape=dshape)
+    w = relay.var("w", shape=wshape)
+    cost_model = {"relay.FuseOps.cost_model": True}
+
+    # The pooling window reads each input about twice, cheaper than storing the relu.
+    fused = fuse(before(pool, relay.nn.relu, [x]), cost_model)
+    assert not tvm.ir.structural_equal(fused, fuse(before(pool, relay.nn.relu, [x]), {}))
+    after = run_opt_pass(expected(pool, relay.nn.relu, [x]), transform.InferType())
+    assert tvm.ir.structural_equal(fused, after)
+
+    # A reduction reads each input once, so it is fused even when nothing may be recomputed.
+    no_recompute = {**cost_model, "relay.FuseOps.flops_per_byte": 0}
+    fused = fuse(before(relay.sum, transpose, [x]), no_recompute)
+    assert not tvm.ir.structural_equal(fused, fuse(before(relay.sum, transpose, [x]), {}))
+    after = run_opt_pass(expected(relay.sum, transpose, [x]), transform.InferType())
+    assert tvm.ir.structural_equal(fused, after)
+    fused = fuse(before(pool, relay.nn.relu, [x]), no_recompute)
+    assert tvm.ir.structural_equal(fused, fuse(before(pool, relay.nn.relu, [x]), {}))
+
+    # The convolution reads each input once per weight of an input channel, the relu is only
+    # recomputed when operations are cheap enough.
+    fused = fuse(before(conv, relay.nn.relu, [x, w]), cost_model)
+    assert tvm.ir.structural_equal(fused, fuse(before(conv, relay.nn.relu, [x, w]), {}))
+    cheap_flops = {**cost_model, "relay.FuseOps.flops_per_byte": 1024}
+    fused = fuse(before(conv, relay.nn.relu, [x, w]), cheap_flops)
+    after = run_opt_pass(expected(conv, relay.nn.relu, [x, w]), transform.InferType())
+    assert tvm.ir.structural_equal(fused, after)
+
+    with pytest.raises(tvm.TVMError):
+        fuse(before(pool, relay.nn.relu, [x]), {**cost_model, "relay.FuseOps.flops_per_byte": -1})
+
+
+def test_fuse_cost_model_anchors():
+    """Test fusing a conv2d or dense into the one consuming it with the cost model"""
+    cost_model = {"relay.FuseOps.cost_model": True}
+
+    def fuse(func, config, target="llvm"):
+        with tvm.target.Target(target), tvm.transform.PassContext(config=config):
+            return run_opt_pass(func, transform.FuseOps())
+
+    def fused_functions(func):
+        calls = []
+
+        def visit(expr):
+            if isinstance(expr, relay.Call) and isinstance(expr.op, relay.Function):
+                calls.append(expr.op)
+
+        relay.analysis.post_order_visit(func, visit)
+        return calls
+
+    def dense_dense():
+        x = relay.var("x", shape=(4, 64))
+        w1 = relay.var("w1", shape=(32, 64))
+        w2 = relay.var("w2", shape=(16, 32))
+        y = relay.nn.relu(relay.nn.dense(x, w1))
+        return relay.Function([x, w1, w2], relay.nn.dense(y, w2))
+
+    def conv_conv(kernel_size):
+        x = relay.var("x", shape=(1, 16, 32, 32))
+        w1 = relay.var("w1", shape=(16, 16, 3, 3))
+        w2 = relay.var("w2", shape=(16, 16, kernel_size, kernel_size))
+        y = relay.nn.relu(relay.nn.conv2d(x, w1, kernel_size=(3, 3), padding=(1, 1)))
+        padding = (kernel_size // 2, kernel_size // 2)
+        return relay.Function(
+            [x, w1, w2], relay.nn.conv2d(y, w2, kernel_size=kernel_size, padding=padding)
+        )
+
+    # Each output row of the dense reads its own input row, nothing is recomputed.
+    funcs = fused_functions(fuse(dense_dense(), cost_model))
+    assert len(funcs) == 1 and funcs[0].attrs["relay.fused_producer"] == 1
+    assert len(fused_functions(fuse(dense_dense(), {}))) == 2
+    # A 1x1 convolution does not recompute the rows either.
+    assert len(fused_functions(fuse(conv_conv(1), cost_model))) == 1
+    # A 3x3 window recomputes each row of the first convolution three times.
+    assert len(fused_functions(fuse(conv_conv(3), cost_model))) == 2
+    # Only the CPU schedules tile across the layers.
+    assert len(fused_functions(fuse(dense_dense(), cost_model, "cuda"))) == 2
+
+
+@tvm.testing.uses_gpu
+def test_fuse_cost_model_build():
+    """Test building and running the functions fused with the cost model"""
+    dshape = (1, 16, 32, 32)
+    x = relay.var("x", shape=dshape)
+    relu = relay.nn.relu(x)
+    pooled = relay.nn.max_pool2d(relu, pool_size=(3, 3), strides=(2, 2), padding=(1, 1))
+    y = relay.Tuple(
+        [
+            pooled,
+            relay.nn.global_avg_pool2d(relay.nn.relu(pooled)),
+            relay.sum(relay.transpose(x, (0, 2, 3, 1)), axis=[1, 2]),
+        ]
+    )
+    mod = tvm.IRModule.from_expr(relay.Function([x], y))
+    x_data = np.random.uniform(-1, 1, size=dshape).astype("float32")
+
+    def run(mod, inputs, target, dev, config):
+        with tvm.transform.PassContext(opt_level=3, config=config):
+            lib = relay.build(mod, target)
+        module = graph_executor.GraphModule(lib["default"](dev))
+        module.set_input(**inputs)
+        module.run()
+        return [module.get_output(i).numpy() for i in range(module.get_num_outputs())]
+
+    def check(mod, inputs, targets, config):
+        for target, dev in targets:
+            expected = run(mod, inputs, target, dev, {})
+            results = run(mod, inputs, target, dev, config)
+            for result, ref in zip(results, expected):
+                tvm.testing.assert_allclose(result, ref, rtol=1e-5, atol=1e-5)
+
+    check(mod, {"x": x_data}, tvm.testing.enabled_targets(), {"relay.FuseOps.cost_model": True})
+    # The relu is inlined into the convolution.
+    w = relay.var("w", shape=(16, 16, 3, 3))
+    conv = relay.nn.conv2d(relu, w, kernel_size=(3, 3), padding=(1, 1))
+    mod = tvm.IRModule.from_expr(relay.Function([x, w], conv))
+    w_data = np.random.uniform(-1, 1, size=(16, 16, 3, 3)).astype("float32")
+    config = {"relay.FuseOps.cost_model": True, "relay.FuseOps.flops_per_byte": 1024}
+    check(mod, {"x": x_data, "w": w_data}, tvm.testing.enabled_targets(), config)
+
+    # Anchors fused across the layers, on CPU.
+    w1 = relay.var("w1", shape=(8, 16, 1, 1))
+    y = relay.nn.relu(relay.nn.conv2d(relu, w, kernel_size=(3, 3), padding=(1, 1)))
+    y = relay.nn.conv2d(y, w1, kernel_size=(1, 1), strides=(2, 2))
+    mod = tvm.IRModule.from_expr(relay.Function([x, w, w1], y))
+    w1_data = np.random.uniform(-1, 1, size=(8, 16, 1, 1)).astype("float32")
+    inputs = {"x": x_data, "w": w_data, "w1": w1_data}
+    check(mod, inputs, [("llvm", tvm.cpu())], {"relay.FuseOps.cost_model": True})
+    a = relay.var("a", shape=(4, 64))
+    b1 = relay.var("b1", shape=(32, 64))
+    b2 = relay.var("b2", shape=(16, 32))
+    y = relay.nn.dense(relay.nn.relu(relay.nn.dense(a, b1)), b2)
+    mod = tvm.IRModule.from_expr(relay.Function([a, b1, b2], y))
+    inputs = {
+        name: np.random.uniform(-1, 1, size=shape).astype("float32")
+        for name, shape in [("a", (4, 64)), ("b1", (32, 64)), ("b2", (16, 32))]
+    }
+    check(mod, inputs, [("llvm", tvm.cpu())], {"relay.FuseOps.cost_model": True})
+
+
 if __name__ == "__main__":
     test_fuse_simple()
     test_conv2d_fuse()
@@ -804,3 +975,6 @@ if __name__ == "__main__":
     test_fuse_gather_nd()
     test_fuse_bcast_reduce_scalar()
     test_fuse_max_diamond()
+    test_fuse_cost_model()
+    test_fuse_cost_model_anchors()
+    test_fuse_cost_model_build()
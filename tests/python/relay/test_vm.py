@@ -17,6 +17,7 @@
 import numpy as np
 import pytest
 import time
+import threading
 
 import tvm
 from tvm import runtime
@@ -27,6 +28,7 @@ from tvm.relay.prelude import Prelude
 from tvm.relay.loops import while_loop
 from tvm.relay import testing
 from tvm.contrib import utils
+from tvm.contrib.popen_pool import PopenWorker
 from tvm import rpc
 import tvm.testing
 from tvm.relay.transform import InferType
@@ -703,6 +705,109 @@ def test_vm_optimize_dynamic():
     assert "shape_func" in opt_mod.astext(False)
 
 
+def test_vm_best_fit_allocator():
+    def check():
+        dtype = "float32"
+        x = relay.var("x", shape=(relay.Any(), 4), dtype=dtype)
+        mod = tvm.IRModule()
+        mod["main"] = relay.Function([x], relay.add(x, x))
+        exe = relay.vm.compile(mod, target="llvm")
+        dev = tvm.cpu()
+        vm_factory = runtime.vm.VirtualMachine(exe, dev, memory_cfg="best_fit")
+        stats = tvm.get_global_func("runtime.vm.AllocatorMemoryStats")
+
+        def stat(key):
+            return stats(dev.device_type, dev.device_id, key)
+
+        assert stat("type") == runtime.vm.VirtualMachine.BEST_FIT_ALLOCATOR
+        used = None
+        for n in [1000, 1, 7, 300, 5, 1000, 999]:
+            x_data = np.random.rand(n, 4).astype(dtype)
+            res = vm_factory.invoke("main", x_data)
+            tvm.testing.assert_allclose(res.numpy(), x_data + x_data)
+            del res
+            # The buffers of the largest run are reused by the smaller ones.
+            if used is None:
+                used = stat("used")
+            assert stat("used") == used
+        assert stat("peak") >= stat("allocated")
+        assert stat("peak") <= used
+
+    # The allocator of a device is created once per process, the other tests hold a pooled one.
+    proc = PopenWorker()
+    proc.send(check)
+    proc.recv()
+
+
+def test_vm_coalesce_storage():
+    def compile_chain(shape, disabled_pass=None, config=None):
+        x = relay.var("x", shape=shape, dtype="float32")
+        y = x
+        for _ in range(4):
+            y = relay.nn.softmax(relay.exp(y))
+        mod = tvm.IRModule()
+        mod["main"] = relay.Function([x], y)
+        with tvm.transform.PassContext(opt_level=3, disabled_pass=disabled_pass, config=config):
+            return relay.vm.compile(mod, target="llvm")
+
+    def check(exe, x_np):
+        y_np = x_np
+        for _ in range(4):
+            y_np = np.exp(y_np)
+            y_np = np.exp(y_np - y_np.max(axis=-1, keepdims=True))
+            y_np = y_np / y_np.sum(axis=-1, keepdims=True)
+        vm = runtime.vm.VirtualMachine(exe, tvm.cpu())
+        tvm.testing.assert_allclose(vm.invoke("main", x_np).numpy(), y_np, rtol=1e-5)
+
+    x_np = np.random.uniform(size=(4, 16)).astype("float32")
+    baseline = compile_chain((4, 16), disabled_pass=["CoalesceStorage"])
+    exe = compile_chain((4, 16))
+    assert exe.bytecode.count("alloc_storage") < baseline.bytecode.count("alloc_storage")
+    check(exe, x_np)
+
+    # Symbolic sizes are only coalesced under an upper bound, checked at runtime.
+    shape = (relay.Any(), 16)
+    baseline = compile_chain(shape)
+    exe = compile_chain(shape, config={"relay.CoalesceStorage.dim_upper_bound": 8})
+    assert exe.bytecode.count("if ") > baseline.bytecode.count("if ")
+    check(exe, x_np)
+    # A larger input than the bound gets storage of its own.
+    check(exe, np.random.uniform(size=(12, 16)).astype("float32"))
+
+
+def test_vm_create_context():
+    dtype = "float32"
+    x = relay.var("x", shape=(10, 10), dtype=dtype)
+    w = relay.const(np.random.rand(10, 10).astype(dtype))
+    mod = tvm.IRModule()
+    mod["main"] = relay.Function([x], relay.nn.dense(x, w) + x)
+    exe = relay.vm.compile(mod, target="llvm")
+    vm = runtime.vm.VirtualMachine(exe, tvm.cpu())
+
+    def run(context, results, idx):
+        x_data = np.random.rand(10, 10).astype(dtype)
+        ref = np.dot(x_data, w.data.numpy().T) + x_data
+        for _ in range(10):
+            res = context.invoke("main", x_data).numpy()
+            # Count the correct runs, every one of them has to match.
+            results[idx] += int(np.allclose(res, ref, rtol=1e-5))
+
+    contexts = [vm.create_context() for _ in range(4)]
+    results = [0] * len(contexts)
+    threads = [
+        threading.Thread(target=run, args=(context, results, i))
+        for i, context in enumerate(contexts)
+    ]
+    for thread in threads:
+        thread.start()
+    main_results = [0]
+    run(vm, main_results, 0)
+    for thread in threads:
+        thread.join()
+    assert main_results == [10]
+    assert results == [10] * len(contexts)
+
+
 def test_vm_optimize():
     mod, params = testing.synthetic.get_workload()
     comp = relay.vm.VMCompiler()
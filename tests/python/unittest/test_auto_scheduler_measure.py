@@ -19,6 +19,7 @@
 import json
 
 import multiprocessing
+import os
 import numpy as np
 import tvm
 from tvm import topi
@@ -203,6 +204,81 @@ def test_recover_measure_input():
         assert str(correct_inp.state) == str(inp.state)
 
 
+def test_record_store():
+    inputs, results = [], []
+    for n, cost in [(128, 0.3), (256, 0.2), (128, 0.1), (128, 0.05)]:
+        task = auto_scheduler.SearchTask(
+            func=matmul_auto_scheduler_test, args=(n, n, n), target="llvm"
+        )
+        inputs.append(auto_scheduler.measure.MeasureInput(task, task.compute_dag.init_state))
+        error_no = 1 if cost == 0.05 else 0
+        results.append(auto_scheduler.measure.MeasureResult([cost], error_no, "", 0.2, 1))
+    key = inputs[0].task.workload_key
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        json_file = tmpdir + "/records.json"
+        bin_file = tmpdir + "/records.bin"
+        auto_scheduler.save_records(json_file, inputs[:2], results[:2])
+        auto_scheduler.convert_record_file(json_file, bin_file)
+        store = auto_scheduler.RecordStore(bin_file)
+        store.append(inputs[2:], results[2:])
+        assert len(store) == 4
+
+        # The index is rebuilt from the file
+        store = auto_scheduler.RecordStore(bin_file)
+        assert len(store) == 4
+        assert len(store.query(key)) == 3
+        assert len(store.query(key, target="cuda")) == 0
+        inp, res = store.query_best(key, target="llvm")
+        assert res.costs[0].value == 0.1
+        assert store.query_best("missing")[0] is None
+        assert len(store.best_records()) == 2
+
+        inp, res = auto_scheduler.load_best_record(bin_file, key)
+        assert res.costs[0].value == 0.1
+        assert len(list(auto_scheduler.load_records(bin_file))) == 4
+
+        # Back to json
+        bin_file2 = tmpdir + "/records2.bin"
+        auto_scheduler.save_records(bin_file2, inputs, results)
+        json_file2 = tmpdir + "/records2.json"
+        auto_scheduler.convert_record_file(bin_file2, json_file2)
+        with open(json_file2) as f:
+            lines = f.read().splitlines()
+        expected = [
+            auto_scheduler.measure_record.dump_record_to_string(i, r).strip()
+            for i, r in zip(inputs, results)
+        ]
+        assert lines == expected
+
+        context = auto_scheduler.ApplyHistoryBest(bin_file)
+        entry = context.best_by_targetkey["cpu"]
+        assert sum(len(v) for v in entry.values()) == 2
+
+        # Converting again replaces the output
+        auto_scheduler.convert_record_file(bin_file2, json_file2)
+        with open(json_file2) as f:
+            assert f.read().splitlines() == expected
+
+        # A record cut in the middle is skipped by readers, and dropped before appending after it
+        bin_file3 = tmpdir + "/records3.bin"
+        auto_scheduler.save_records(bin_file3, inputs[:2], results[:2])
+        size = os.path.getsize(bin_file3)
+        with open(bin_file3, "r+b") as f:
+            f.truncate(size - 10)
+        store = auto_scheduler.RecordStore(bin_file3)
+        assert len(store) == 1
+        assert os.path.getsize(bin_file3) == size - 10
+        store.append(inputs[2:], results[2:])
+        store = auto_scheduler.RecordStore(bin_file3)
+        assert len(store) == 3
+        assert len(list(auto_scheduler.load_records(bin_file3))) == 3
+        with open(bin_file3, "r+b") as f:
+            f.truncate(os.path.getsize(bin_file3) - 10)
+        auto_scheduler.save_records(bin_file3, inputs[:1], results[:1])
+        assert len(auto_scheduler.RecordStore(bin_file3)) == 3
+
+
 def test_workload_dis_factor():
     calc = auto_scheduler.utils.calc_workload_dis_factor
     decode = auto_scheduler.utils.decode_workload_key
@@ -420,6 +496,7 @@ if __name__ == "__main__":
     test_record_follow_split_follow_fused_split()
     test_record_pragma_storage_align_rfactor()
     test_recover_measure_input()
+    test_record_store()
     test_workload_dis_factor()
     test_measure_local_builder_runner()
     test_dag_measure_local_builder_runner()
@@ -14,9 +14,13 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
+import os
+import tempfile
+
+import numpy as np
 import tvm
 import pytest
-from tvm import te
+from tvm import te, relay
 
 
 def test_const_saveload_json():
@@ -30,6 +34,31 @@ def test_const_saveload_json():
     tvm.ir.assert_structural_equal(zz, z, map_free_vars=True)
 
 
+def test_saveload_binary():
+    x = relay.var("x", shape=(4, 8))
+    w = relay.const(np.random.uniform(size=(16, 8)).astype("float32"))
+    y = relay.nn.dense(x, w) + relay.const(float("inf"))
+    func = relay.Function([x], relay.nn.relu(y)).with_attr("key", "value")
+    mod = relay.transform.InferType()(tvm.IRModule.from_expr(func))
+    smap = tvm.runtime.convert({tvm.tir.const(1): "a", tvm.tir.const(2.5): [1, 2]})
+
+    for node in [mod, smap, tvm.runtime.convert(["x", {"y": 1}])]:
+        data = tvm.ir.save_binary(node)
+        assert len(data) < len(tvm.ir.save_json(node))
+        tvm.ir.assert_structural_equal(tvm.ir.load_binary(data), node, map_free_vars=True)
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        path = os.path.join(tmpdir, "mod.bin")
+        tvm.ir.save_binary(mod, path)
+        loaded = tvm.ir.load_binary(path)
+        tvm.ir.assert_structural_equal(loaded, mod, map_free_vars=True)
+        const = loaded["main"].body.args[0].args[0].args[1]
+        np.testing.assert_equal(const.data.numpy(), w.data.numpy())
+
+    with pytest.raises(tvm.error.TVMError):
+        tvm.ir.load_binary(bytearray(16))
+
+
 def _test_infinity_value(value, dtype):
     x = tvm.tir.const(value, dtype)
     json_str = tvm.ir.save_json(x)
@@ -166,6 +195,7 @@ if __name__ == "__main__":
     test_make_node()
     test_make_smap()
     test_const_saveload_json()
+    test_saveload_binary()
     test_make_sum()
     test_pass_config()
     test_dict()
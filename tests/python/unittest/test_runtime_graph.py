@@ -139,6 +139,28 @@ def test_load_unexpected_params():
     rt_mod.load_params(runtime.save_param_dict(new_params))
 
 
+@tvm.testing.requires_llvm
+def test_graph_num_streams():
+    shape = (8, 16)
+    x = relay.var("x", shape=shape)
+    branches = [relay.nn.relu(x * relay.const(float(i + 1))) for i in range(4)]
+    y = relay.add(relay.add(branches[0], branches[1]), relay.add(branches[2], branches[3]))
+    y = relay.exp(relay.negative(y)) + branches[0]
+    mod = tvm.IRModule.from_expr(relay.Function([x], y))
+    lib = relay.build(mod, "llvm")
+
+    data = np.random.uniform(-1, 1, size=shape).astype("float32")
+    gmod = graph_executor.GraphModule(lib["default"](tvm.cpu(0)))
+    gmod.run(x=data)
+    expected = gmod.get_output(0).numpy()
+    for num_streams in [2, 4, 1]:
+        gmod.set_num_streams(num_streams)
+        for _ in range(3):
+            gmod.run(x=data)
+            tvm.testing.assert_allclose(gmod.get_output(0).numpy(), expected)
+
+
 if __name__ == "__main__":
     test_graph_simple()
     test_load_unexpected_params()
+    test_graph_num_streams()
@@ -609,11 +609,59 @@ def test_multiple_imported_modules():
     module_main.get_function("func_b", query_imports=True)
 
 
+@tvm.testing.requires_llvm
+def test_load_params_from_file():
+    mod, params = relay.testing.synthetic.get_workload()
+    with relay.build_config(opt_level=3):
+        complied_graph_lib = relay.build_module.build(mod, "llvm", params=params)
+    graph_params = complied_graph_lib.get_params()
+    lib_no_params = complied_graph_lib["remove_params"]()
+
+    from tvm.contrib import utils
+
+    temp = utils.tempdir()
+    data = np.random.uniform(-1, 1, size=input_shape(mod)).astype("float32")
+    dev = tvm.cpu(0)
+    for aligned in [True, False]:
+        path_params = temp.relpath("deploy_param_%d.params" % aligned)
+        with open(path_params, "wb") as fo:
+            fo.write(runtime.save_param_dict(graph_params, aligned=aligned))
+
+        loaded_params = runtime.load_param_dict_from_file(path_params)
+        assert set(loaded_params.keys()) == set(graph_params.keys())
+        for name, value in graph_params.items():
+            tvm.testing.assert_allclose(loaded_params[name].numpy(), value.numpy())
+        # the aligned format can also be read from bytes
+        with open(path_params, "rb") as fi:
+            loaded_params = runtime.load_param_dict(fi.read())
+        assert set(loaded_params.keys()) == set(graph_params.keys())
+
+        # executors loading the same file
+        for _ in range(2):
+            gmod = graph_executor.GraphModule(lib_no_params["default"](dev))
+            gmod.load_params_from_file(path_params)
+            gmod.set_input("data", data)
+            gmod.run()
+            out = gmod.get_output(0).numpy()
+            tvm.testing.assert_allclose(out, verify(data), atol=1e-5)
+
+        # the zero-copy bindings made before loading are kept
+        gmod = graph_executor.GraphModule(lib_no_params["default"](dev))
+        data_nd = tvm.nd.array(data, dev)
+        out = tvm.nd.empty(gmod.get_output(0).shape, dtype="float32", device=dev)
+        gmod.module["set_input_zero_copy"]("data", data_nd)
+        gmod.module["set_output_zero_copy"](0, out)
+        gmod.load_params_from_file(path_params)
+        gmod.run()
+        tvm.testing.assert_allclose(out.numpy(), verify(data), atol=1e-5)
+
+
 if __name__ == "__main__":
     test_legacy_compatibility()
     test_cpu()
     test_gpu()
     test_mod_export()
     test_remove_package_params()
+    test_load_params_from_file()
     test_debug_graph_executor()
     test_multiple_imported_modules()
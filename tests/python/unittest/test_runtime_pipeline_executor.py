@@ -0,0 +1,94 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import numpy as np
+import tvm
+import tvm.testing
+from tvm import relay
+from tvm.contrib import pipeline_executor
+
+
+def build_stages(shape):
+    # stage 0: (relu(x * 2), x + 1)
+    x = relay.var("x", shape=shape)
+    stage0 = relay.Function(
+        [x], relay.Tuple([relay.nn.relu(x * relay.const(2.0)), x + relay.const(1.0)])
+    )
+    # stage 1: a - b
+    a = relay.var("a", shape=shape)
+    b = relay.var("b", shape=shape)
+    stage1 = relay.Function([a, b], relay.subtract(a, b))
+    # stage 2: exp(c) + d
+    c = relay.var("c", shape=shape)
+    d = relay.var("d", shape=shape)
+    stage2 = relay.Function([c, d], relay.exp(c) + d)
+    return [relay.build(tvm.IRModule.from_expr(f), "llvm") for f in [stage0, stage1, stage2]]
+
+
+def reference(data):
+    y0 = np.maximum(data * 2, 0)
+    y1 = data + 1
+    return np.exp(y0 - y1) + y1, y0
+
+
+@tvm.testing.requires_llvm
+def test_pipeline():
+    shape = (4, 16)
+    libs = build_stages(shape)
+    connections = [
+        ((-1, 0), (0, "x")),
+        ((0, 0), (1, "a")),
+        ((0, 1), (1, "b")),
+        ((1, 0), (2, "c")),
+        ((0, 1), (2, "d")),
+        ((2, 0), (-1, 0)),
+        ((0, 0), (-1, 1)),
+    ]
+    pipe = pipeline_executor.create(libs, tvm.cpu(0), connections, queue_size=2)
+    assert pipe.get_num_inputs() == 1
+    assert pipe.get_num_outputs() == 2
+
+    inputs = [np.random.uniform(-1, 1, size=shape).astype("float32") for _ in range(16)]
+    window = 4
+    for i, data in enumerate(inputs):
+        pipe.submit(tvm.nd.array(data))
+        if i >= window:
+            outputs = pipe.get_output()
+            for out, ref in zip(outputs, reference(inputs[i - window])):
+                tvm.testing.assert_allclose(out.numpy(), ref, rtol=1e-5)
+    assert pipe.num_pending == window
+    for data in inputs[-window:]:
+        outputs = pipe.get_output()
+        for out, ref in zip(outputs, reference(data)):
+            tvm.testing.assert_allclose(out.numpy(), ref, rtol=1e-5)
+    assert pipe.num_pending == 0
+
+
+@tvm.testing.requires_llvm
+def test_pipeline_invalid_wiring():
+    libs = build_stages((4, 16))[:2]
+    # stage 1 cannot feed stage 0
+    connections = [((-1, 0), (0, "x")), ((1, 0), (0, "x")), ((1, 0), (-1, 0))]
+    try:
+        pipeline_executor.create(libs, tvm.cpu(0), connections)
+        assert False, "a backward connection must be rejected"
+    except tvm.TVMError:
+        pass
+
+
+if __name__ == "__main__":
+    test_pipeline()
+    test_pipeline_invalid_wiring()
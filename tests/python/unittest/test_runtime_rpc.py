@@ -138,6 +138,32 @@ def test_rpc_large_array():
     np.testing.assert_equal(b.numpy(), b_np)
 
 
+@tvm.testing.requires_rpc
+def test_rpc_copy_options():
+    server = rpc.Server()
+    remote = rpc.connect("127.0.0.1", server.port)
+    dev = remote.cpu(0)
+    dense_np = np.random.uniform(size=(1000, 300)).astype("float32")
+    sparse_np = np.zeros((1000, 300), dtype="float32")
+    sparse_np[::7, ::13] = 1.0
+    bytes_sent = tvm.get_global_func("rpc.CopyBytesSent")
+    for chunk_bytes, max_inflight, compress in [(0, 1, False), (4096, 4, False), (100000, 3, True)]:
+        remote.set_copy_options(chunk_bytes, max_inflight, compress)
+        for x_np in [dense_np, sparse_np]:
+            x = tvm.nd.array(x_np, dev)
+            np.testing.assert_equal(x.numpy(), x_np)
+            y = tvm.nd.empty(x_np.shape, "float32", dev)
+            sent = bytes_sent(remote._sess)
+            y.copyfrom(x_np)
+            sent = bytes_sent(remote._sess) - sent
+            np.testing.assert_equal(y.numpy(), x_np)
+            # Only the sparse array is sent with its zero runs encoded.
+            if compress and x_np is sparse_np:
+                assert sent < x_np.nbytes // 10
+            else:
+                assert sent == x_np.nbytes
+
+
 @tvm.testing.requires_rpc
 def test_rpc_echo():
     def check(remote):
@@ -279,6 +279,26 @@ def test_multiple_func():
     check_llvm()
 
 
+@tvm.testing.requires_llvm
+def test_llvm_codegen_partitions():
+    n = 64
+    A = te.placeholder((n,), name="A")
+    B = te.compute(A.shape, lambda i: A[i] * 2.0, name="B")
+    s = te.create_schedule(B.op)
+    funcs = [tvm.lower(s, [A, B], name="fmul%d" % i) for i in range(5)]
+    with tvm.transform.PassContext(config={"tir.llvm_codegen_partitions": 2}):
+        m = tvm.build(funcs, "llvm")
+    assert len(m.imported_modules) == 1
+
+    dev = tvm.cpu(0)
+    a = tvm.nd.array(np.random.uniform(size=n).astype(A.dtype), dev)
+    b = tvm.nd.array(np.zeros(n, dtype=B.dtype), dev)
+    for i in range(5):
+        # Half of the functions are in the imported module.
+        m.get_function("fmul%d" % i, query_imports=True)(a, b)
+        tvm.testing.assert_allclose(b.numpy(), a.numpy() * 2.0)
+
+
 @tvm.testing.requires_llvm
 def test_llvm_condition():
     def check_llvm(n, offset):
@@ -107,6 +107,51 @@ def test_prim_func():
     tvm.ir.assert_structural_equal(mod0, mod1)
 
 
+def test_module_functions():
+    def make_mod(c):
+        x = te.var("x")
+        y = te.var("y")
+        funcs = {}
+        for i in range(4):
+            body = tvm.tir.Evaluate(x + y * i + (c if i == 2 else 0))
+            funcs["f%d" % i] = tvm.tir.PrimFunc([x, y], body)
+        return tvm.IRModule(funcs)
+
+    mod0 = make_mod(1)
+    mod1 = tvm.ir.load_json(tvm.ir.save_json(mod0))
+    assert consistent_equal(mod0, mod1)
+    assert consistent_equal(mod0, mod1, map_free_vars=True)
+    assert not consistent_equal(mod0, make_mod(2))
+
+
+def test_hash_cache():
+    x = te.var("x")
+    y = te.var("y")
+    const = tvm.tir.const(0)
+    for i in range(32):
+        const = tvm.tir.Add(const, tvm.tir.const(i))
+    func = tvm.tir.PrimFunc([x, y], tvm.tir.Evaluate(x + const * y))
+    mod = tvm.IRModule({"f": func, "g": func.with_attr("k", 1)})
+    objs = [const, func, mod, tvm.tir.Evaluate(const + 1)]
+    expected = [(tvm.ir.structural_hash(obj), tvm.ir.structural_hash(obj, True)) for obj in objs]
+
+    tvm.ir.set_structural_hash_cache(1000)
+    try:
+        for _ in range(2):
+            for obj, hashes in zip(objs, expected):
+                assert tvm.ir.structural_hash(obj) == hashes[0]
+                assert tvm.ir.structural_hash(obj, True) == hashes[1]
+        # the cached hash of the constant is used inside a new function
+        func1 = tvm.tir.PrimFunc([y, x], tvm.tir.Evaluate(y + const * x))
+        assert consistent_equal(func, func1)
+        # a copy on write copies the cached object, whose hash stays valid
+        func2 = func.with_attr("k", 2)
+        assert tvm.ir.structural_hash(func) == expected[1][0]
+        assert not consistent_equal(func, func2)
+    finally:
+        tvm.ir.set_structural_hash_cache(0)
+
+
 def test_array():
     x = np.arange(10)
     nx = tvm.nd.array(x)
@@ -184,6 +229,8 @@ def test_buffer_load_store():
 if __name__ == "__main__":
     test_exprs()
     test_prim_func()
+    test_module_functions()
+    test_hash_cache()
     test_attrs()
     test_array()
     test_env_func()